@@ -0,0 +1,310 @@
+// Micro and macro benchmarks for the PokerEnv hot paths (Google Benchmark).
+//
+//   env_bench [--benchmark_filter=<regex>] [--benchmark_out=<file.json>]
+//
+// Built against the same sources as the env, e.g.
+//   g++ -O2 -std=c++17 -DNDEBUG -Isrc benchmarks/env_bench.cpp src/*.cpp <phevaluator>
+//       -lbenchmark -lpthread -o env_bench
+// and run per release with
+//   ./env_bench --benchmark_out=bench-<version>.json --benchmark_out_format=json
+//       --benchmark_repetitions=5 --benchmark_report_aggregates_only=true
+// The JSON carries the machine context Google Benchmark records (CPU, caches,
+// build type) next to every result and the counters below, so files from
+// different releases can be compared directly.
+//
+// Micro: BM_Reset, BM_Step, BM_GetLegalActions, BM_ObservationForTransformer,
+// BM_HandPotential (the lazy per-seat equity that replaced
+// _updateHandPotentialForAllPlayers; warm = shared EquityCache populated,
+// cold = cleared before every call), BM_Showdown (the last call of a hand
+// that reaches a showdown) and BM_EvaluateHandsBatch. Benchmarks that need a
+// particular state restore it with copy_state_from first; BM_CopyStateFrom
+// measures that part alone.
+//
+// Macro: BM_SelfPlayHands (uniform random legal actions, 2/6/9 seats),
+// BM_AllInSidePotHands (unequal stacks, everyone takes the largest legal
+// action, so most hands end in multi-way all-ins with side pots) and
+// BM_CustomCardReset (string-card reset + playing the hand out). They report
+// hands/s and actions/s as rate counters.
+//
+// Every env is seeded (game_settings.seed), so runs are reproducible.
+#include "PokerEnv_notorch.h"
+#include "EquityCache.h"
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr uint64_t BENCH_SEED = 20240601;
+constexpr int SMALL_BLIND = 1;
+constexpr int BIG_BLIND = 2;
+constexpr int STACK = 200;
+constexpr int SNAPSHOTS = 64;
+
+const std::vector<float>& betMenu() {
+    static const std::vector<float> menu = {0.5f, 1.0f, 2.0f};
+    return menu;
+}
+
+std::unique_ptr<PokerEnv> makeEnv(int nSeats, uint64_t seed = BENCH_SEED) {
+    nlohmann::json config;
+    config["game_settings"]["seed"] = seed;
+    return std::unique_ptr<PokerEnv>(
+        new PokerEnv(config, nSeats, betMenu(), false, SMALL_BLIND, BIG_BLIND, 0, STACK));
+}
+
+int randomLegalAction(PokerEnv& env, std::mt19937& rng) {
+    const std::vector<int> legal = env.getLegalActions();
+    if (legal.empty()) return 1;
+    return legal[std::uniform_int_distribution<size_t>(0, legal.size() - 1)(rng)];
+}
+
+int largestLegalAction(PokerEnv& env) {
+    const std::vector<int> legal = env.getLegalActions();
+    return legal.empty() ? 1 : legal.back();
+}
+
+// Plays one hand with `policy`; returns the number of actions taken.
+template <class Policy>
+int playHand(PokerEnv& env, Policy&& policy) {
+    int actions = 0;
+    bool done = false;
+    while (!done) {
+        done = std::get<3>(env.step(policy(env)));
+        ++actions;
+    }
+    return actions;
+}
+
+// States right after `checkCalls` check/call actions of a fresh hand, one per seed.
+std::vector<std::unique_ptr<PokerEnv>> snapshotsAfter(int nSeats, int checkCalls) {
+    std::vector<std::unique_ptr<PokerEnv>> snapshots;
+    for (int k = 0; k < SNAPSHOTS; ++k) {
+        auto env = makeEnv(nSeats, BENCH_SEED + k);
+        env->reset();
+        for (int i = 0; i < checkCalls; ++i) {
+            if (std::get<3>(env->step(1))) env->reset();
+        }
+        snapshots.push_back(std::move(env));
+    }
+    return snapshots;
+}
+
+// States one check/call away from a showdown (everyone calls down).
+std::vector<std::unique_ptr<PokerEnv>> showdownSnapshots(int nSeats) {
+    std::vector<std::unique_ptr<PokerEnv>> snapshots;
+    for (int k = 0; k < SNAPSHOTS; ++k) {
+        auto env = makeEnv(nSeats, BENCH_SEED + k);
+        env->reset();
+        auto before = env->clone();
+        while (!std::get<3>(env->step(1))) before->copy_state_from(*env);
+        snapshots.push_back(std::move(before));
+    }
+    return snapshots;
+}
+
+// First flop decision of every snapshot (everyone limps preflop).
+std::vector<std::unique_ptr<PokerEnv>> flopSnapshots(int nSeats) {
+    std::vector<std::unique_ptr<PokerEnv>> snapshots;
+    for (int k = 0; k < SNAPSHOTS; ++k) {
+        auto env = makeEnv(nSeats, BENCH_SEED + k);
+        env->reset();
+        while (env->getCurrentRound() == PREFLOP) {
+            if (std::get<3>(env->step(1))) env->reset();
+        }
+        snapshots.push_back(std::move(env));
+    }
+    return snapshots;
+}
+
+void seatArgs(benchmark::internal::Benchmark* b) {
+    b->Arg(2)->Arg(6)->Arg(9)->ArgName("seats");
+}
+
+void setRate(benchmark::State& state, int64_t hands, int64_t actions) {
+    state.counters["hands_per_s"] = benchmark::Counter(static_cast<double>(hands), benchmark::Counter::kIsRate);
+    state.counters["actions_per_s"] = benchmark::Counter(static_cast<double>(actions), benchmark::Counter::kIsRate);
+}
+
+} // namespace
+
+// ================================
+// Micro benchmarks
+// ================================
+
+static void BM_Reset(benchmark::State& state) {
+    auto env = makeEnv(static_cast<int>(state.range(0)));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(env->reset());
+    }
+}
+BENCHMARK(BM_Reset)->Apply(seatArgs);
+
+// One random legal action; a finished hand is reset (not timed separately).
+static void BM_Step(benchmark::State& state) {
+    auto env = makeEnv(static_cast<int>(state.range(0)));
+    std::mt19937 rng(BENCH_SEED);
+    env->reset();
+    int64_t hands = 0;
+    for (auto _ : state) {
+        auto result = env->step(randomLegalAction(*env, rng));
+        if (std::get<3>(result)) {
+            env->reset();
+            ++hands;
+        }
+        benchmark::DoNotOptimize(result);
+    }
+    state.counters["hands"] = static_cast<double>(hands);
+}
+BENCHMARK(BM_Step)->Apply(seatArgs);
+
+static void BM_CopyStateFrom(benchmark::State& state) {
+    const int nSeats = static_cast<int>(state.range(0));
+    const auto snapshots = snapshotsAfter(nSeats, 3);
+    auto env = makeEnv(nSeats);
+    size_t k = 0;
+    for (auto _ : state) {
+        env->copy_state_from(*snapshots[k++ % snapshots.size()]);
+        benchmark::ClobberMemory();
+    }
+}
+BENCHMARK(BM_CopyStateFrom)->Apply(seatArgs);
+
+// Legal actions are cached per decision; restoring a state drops the cache,
+// so every iteration scans. Includes one copy_state_from.
+static void BM_GetLegalActions(benchmark::State& state) {
+    const int nSeats = static_cast<int>(state.range(0));
+    const auto snapshots = snapshotsAfter(nSeats, 3);
+    auto env = makeEnv(nSeats);
+    size_t k = 0;
+    for (auto _ : state) {
+        env->copy_state_from(*snapshots[k++ % snapshots.size()]);
+        benchmark::DoNotOptimize(env->getLegalActions());
+    }
+}
+BENCHMARK(BM_GetLegalActions)->Apply(seatArgs);
+
+static void BM_ObservationForTransformer(benchmark::State& state) {
+    const int nSeats = static_cast<int>(state.range(0));
+    auto env = makeEnv(nSeats);
+    env->reset();
+    for (int i = 0; i < nSeats + 2; ++i) {
+        if (std::get<3>(env->step(1))) env->reset();
+    }
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(env->getObservationForTransformer());
+    }
+}
+BENCHMARK(BM_ObservationForTransformer)->Apply(seatArgs);
+
+// Arg 1: 0 = warm EquityCache, 1 = cleared before every evaluation.
+static void BM_HandPotential(benchmark::State& state) {
+    const int nSeats = static_cast<int>(state.range(0));
+    const bool cold = state.range(1) != 0;
+    const auto snapshots = flopSnapshots(nSeats);
+    auto env = makeEnv(nSeats);
+    size_t k = 0;
+    for (auto _ : state) {
+        if (cold) {
+            state.PauseTiming();
+            EquityCache::shared().clear();
+            state.ResumeTiming();
+        }
+        env->copy_state_from(*snapshots[k++ % snapshots.size()]);
+        benchmark::DoNotOptimize(env->getCurrentPlayerHandPotential());
+    }
+}
+BENCHMARK(BM_HandPotential)->ArgsProduct({{2, 6, 9}, {0, 1}})->ArgNames({"seats", "cold"});
+
+// The final call of a hand everyone checks/calls down: betting close, pot
+// collection, one showdown evaluation per live seat and the awards.
+static void BM_Showdown(benchmark::State& state) {
+    const int nSeats = static_cast<int>(state.range(0));
+    const auto snapshots = showdownSnapshots(nSeats);
+    auto env = makeEnv(nSeats);
+    size_t k = 0;
+    for (auto _ : state) {
+        env->copy_state_from(*snapshots[k++ % snapshots.size()]);
+        benchmark::DoNotOptimize(env->step(1));
+    }
+}
+BENCHMARK(BM_Showdown)->Apply(seatArgs);
+
+// Arg: hands per call.
+static void BM_EvaluateHandsBatch(benchmark::State& state) {
+    const size_t nHands = static_cast<size_t>(state.range(0));
+    std::mt19937 rng(BENCH_SEED);
+    std::vector<CardId> cards(nHands * 7);
+    for (size_t h = 0; h < nHands; ++h) {
+        CardId deck[52];
+        for (int c = 0; c < 52; ++c) deck[c] = static_cast<CardId>(c);
+        for (int c = 0; c < 7; ++c) {
+            std::swap(deck[c], deck[c + std::uniform_int_distribution<int>(0, 51 - c)(rng)]);
+            cards[h * 7 + c] = deck[c];
+        }
+    }
+    std::vector<int32_t> ranks(nHands);
+    for (auto _ : state) {
+        PokerEnv::evaluate_hands_batch(cards.data(), nHands, ranks.data());
+        benchmark::DoNotOptimize(ranks.data());
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(nHands));
+}
+BENCHMARK(BM_EvaluateHandsBatch)->Arg(16)->Arg(1024)->ArgName("hands");
+
+// ================================
+// Macro scenarios
+// ================================
+
+// One hand of uniform random legal actions per iteration, reset included.
+static void BM_SelfPlayHands(benchmark::State& state) {
+    auto env = makeEnv(static_cast<int>(state.range(0)));
+    std::mt19937 rng(BENCH_SEED);
+    int64_t hands = 0, actions = 0;
+    for (auto _ : state) {
+        env->reset();
+        actions += playHand(*env, [&rng](PokerEnv& e) { return randomLegalAction(e, rng); });
+        ++hands;
+    }
+    setRate(state, hands, actions);
+}
+BENCHMARK(BM_SelfPlayHands)->Apply(seatArgs);
+
+// Unequal stacks and maximum aggression: all-ins, side pots, showdowns.
+static void BM_AllInSidePotHands(benchmark::State& state) {
+    const int nSeats = static_cast<int>(state.range(0));
+    auto env = makeEnv(nSeats);
+    std::vector<int> stacks(nSeats);
+    for (int i = 0; i < nSeats; ++i) stacks[i] = STACK / 4 + i * (STACK / nSeats);
+    int64_t hands = 0, actions = 0;
+    for (auto _ : state) {
+        env->reset(true, {}, {}, "", {}, {}, stacks, 1000);
+        actions += playHand(*env, largestLegalAction);
+        ++hands;
+    }
+    setRate(state, hands, actions);
+}
+BENCHMARK(BM_AllInSidePotHands)->Arg(6)->Arg(9)->ArgName("seats");
+
+// Fixed hole cards and flop given as strings, then checked/called down.
+static void BM_CustomCardReset(benchmark::State& state) {
+    const int nSeats = static_cast<int>(state.range(0));
+    static const char* HOLE[] = {"AsKd", "QhQc", "Jd10d", "9s8s", "7h7c", "6d5c", "4s4h", "3c2d", "AhKh"};
+    std::vector<std::string> holeCards(HOLE, HOLE + nSeats);
+    auto env = makeEnv(nSeats);
+    int64_t hands = 0, actions = 0;
+    for (auto _ : state) {
+        env->reset(false, holeCards, {}, "2c 7d 9h", {}, {}, {}, 1000);
+        actions += playHand(*env, [](PokerEnv&) { return 1; });
+        ++hands;
+    }
+    setRate(state, hands, actions);
+}
+BENCHMARK(BM_CustomCardReset)->Apply(seatArgs);
+
+BENCHMARK_MAIN();
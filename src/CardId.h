@@ -0,0 +1,123 @@
+#ifndef CARD_ID_H
+#define CARD_ID_H
+
+#include "FastRng.h"
+
+#include <cstdint>
+
+// ================================
+// Value-type card representation
+// ================================
+// A card is a single byte: id = value * 4 + suit, with value 0-12 (Two..Ace)
+// and suit 0-3 in Card::Suit order (Diamonds, Clubs, Hearts, Spades). This is
+// the same integer phevaluator expects and the one the *_py accessors and the
+// custom-card reset() overloads already use, so ids can be handed to the
+// evaluator or to Python without conversion.
+
+using CardId = uint8_t;
+
+constexpr int N_CARD_IDS = 52;
+constexpr CardId NO_CARD = 0xFF;
+
+constexpr CardId makeCardId(int value, int suit) {
+    return static_cast<CardId>(value * 4 + suit);
+}
+constexpr int cardIdValue(CardId id) { return id >> 2; }
+constexpr int cardIdSuit(CardId id) { return id & 3; }
+constexpr bool isValidCardId(int id) { return id >= 0 && id < N_CARD_IDS; }
+
+// Bit `id` of a 64-bit card set.
+constexpr uint64_t cardIdBit(CardId id) { return uint64_t{1} << id; }
+
+// ================================
+// CardDeck
+// ================================
+// Fixed-size deck of card ids, stored inline (no heap). cards[0, count) are
+// the undealt cards and cards are dealt from the back. pos[] is the inverse
+// permutation, so a specific card can be pulled out in O(1) when a scenario
+// pins hole or board cards.
+struct CardDeck {
+    CardId cards[N_CARD_IDS];
+    uint8_t pos[N_CARD_IDS];
+    int count = 0;
+
+    CardDeck() { fill(); }
+
+    // Restores all 52 cards in id order.
+    void fill() {
+        for (int i = 0; i < N_CARD_IDS; ++i) {
+            cards[i] = static_cast<CardId>(i);
+            pos[i] = static_cast<uint8_t>(i);
+        }
+        count = N_CARD_IDS;
+    }
+
+    // Empties the deck; append() then rebuilds it card by card (state loading).
+    void clear() {
+        for (int i = 0; i < N_CARD_IDS; ++i) pos[i] = N_CARD_IDS;
+        count = 0;
+    }
+
+    bool append(CardId id) {
+        if (!isValidCardId(id) || contains(id)) return false;
+        pos[id] = static_cast<uint8_t>(count);
+        cards[count++] = id;
+        return true;
+    }
+
+    int remaining() const { return count; }
+
+    bool contains(CardId id) const {
+        return isValidCardId(id) && pos[id] < count && cards[pos[id]] == id;
+    }
+
+    // Fisher-Yates over the undealt cards.
+    void shuffle(FastRng& rng) { shuffleTop(rng, count); }
+
+    // Partial Fisher-Yates: only the next k cards to be dealt (the back of
+    // the deck) are drawn, each uniformly from the cards not yet placed, so
+    // dealing k cards costs k draws instead of 52. The rest stay unordered.
+    void shuffleTop(FastRng& rng, int k) {
+        const int stop = k >= count ? 1 : count - k;
+        for (int i = count - 1; i >= stop; --i) _swap(i, static_cast<int>(rng.below(static_cast<uint32_t>(i + 1))));
+    }
+
+    // Deals the next card, NO_CARD once the deck is empty.
+    CardId draw() {
+        if (count <= 0) return NO_CARD;
+        return cards[--count];
+    }
+
+    void burn() { draw(); }
+
+    // Takes a specific card out of the undealt set. Returns false if it was
+    // already dealt/removed, which is how duplicate scenario cards are caught.
+    bool remove(CardId id) {
+        if (!contains(id)) return false;
+        _swap(pos[id], count - 1);
+        --count;
+        return true;
+    }
+
+    // Makes a specific undealt card the (depth + 1)-th to be dealt (depth 0 =
+    // next draw). Placing several cards at distinct depths leaves each where
+    // it was put; the displaced card takes the old slot. Used to stack a
+    // recorded board for replay.
+    bool placeAt(CardId id, int depth) {
+        if (!contains(id) || depth < 0 || depth >= count) return false;
+        _swap(pos[id], count - 1 - depth);
+        return true;
+    }
+
+private:
+    void _swap(int i, int j) {
+        const CardId a = cards[i];
+        const CardId b = cards[j];
+        cards[i] = b;
+        cards[j] = a;
+        pos[b] = static_cast<uint8_t>(i);
+        pos[a] = static_cast<uint8_t>(j);
+    }
+};
+
+#endif // CARD_ID_H
@@ -0,0 +1,235 @@
+#include "CardParse.h"
+
+#include <array>
+
+namespace CardParse {
+
+namespace {
+
+constexpr int8_t NONE = -1;
+
+// Leading byte pair and final byte of the UTF-8 suit glyphs (U+2660-U+2663).
+constexpr unsigned char GLYPH_LEAD0 = 0xE2;
+constexpr unsigned char GLYPH_LEAD1 = 0x99;
+constexpr size_t GLYPH_LEN = 3;
+
+struct Tables {
+    std::array<int8_t, 256> value{};      // single value characters
+    std::array<int8_t, 256> asciiSuit{};
+    std::array<int8_t, 256> glyphSuit{};  // by final byte
+    std::array<bool, 256> lineSeparator{};
+    std::array<bool, 256> space{};        // std::isspace in the "C" locale
+};
+
+constexpr Tables buildTables() {
+    Tables t{};
+    for (int i = 0; i < 256; ++i) {
+        t.value[i] = NONE;
+        t.asciiSuit[i] = NONE;
+        t.glyphSuit[i] = NONE;
+    }
+    const char* values = "23456789TJQKA";
+    for (int v = 0; v < 13; ++v) {
+        const char upper = values[v];
+        t.value[static_cast<unsigned char>(upper)] = static_cast<int8_t>(v);
+        if (upper >= 'A' && upper <= 'Z') t.value[static_cast<unsigned char>(upper - 'A' + 'a')] = static_cast<int8_t>(v);
+    }
+    // Card::Suit order: Diamonds, Clubs, Hearts, Spades.
+    t.asciiSuit['d'] = t.asciiSuit['D'] = 0;
+    t.asciiSuit['c'] = t.asciiSuit['C'] = 1;
+    t.asciiSuit['h'] = t.asciiSuit['H'] = 2;
+    t.asciiSuit['s'] = t.asciiSuit['S'] = 3;
+    t.glyphSuit[0xA2] = 0; // ♢
+    t.glyphSuit[0xA3] = 1; // ♣
+    t.glyphSuit[0xA1] = 2; // ♡
+    t.glyphSuit[0xA0] = 3; // ♠
+
+    const char* spaces = " \t\n\v\f\r";
+    for (const char* c = spaces; *c; ++c) {
+        t.space[static_cast<unsigned char>(*c)] = true;
+        t.lineSeparator[static_cast<unsigned char>(*c)] = true;
+    }
+    const char* separators = ",;:[](){}'\"|";
+    for (const char* c = separators; *c; ++c) t.lineSeparator[static_cast<unsigned char>(*c)] = true;
+    return t;
+}
+
+constexpr Tables TABLES = buildTables();
+
+inline unsigned char byteAt(std::string_view s, size_t i) { return static_cast<unsigned char>(s[i]); }
+
+// Length of the suit suffix of s (0 if none) and its suit.
+inline size_t suitSuffix(std::string_view s, int& suit) {
+    const size_t n = s.size();
+    if (n >= GLYPH_LEN && byteAt(s, n - 3) == GLYPH_LEAD0 && byteAt(s, n - 2) == GLYPH_LEAD1 &&
+        TABLES.glyphSuit[byteAt(s, n - 1)] != NONE) {
+        suit = TABLES.glyphSuit[byteAt(s, n - 1)];
+        return GLYPH_LEN;
+    }
+    if (n >= 1 && TABLES.asciiSuit[byteAt(s, n - 1)] != NONE) {
+        suit = TABLES.asciiSuit[byteAt(s, n - 1)];
+        return 1;
+    }
+    return 0;
+}
+
+inline int valueOf(std::string_view v) {
+    if (v.size() == 1) return TABLES.value[byteAt(v, 0)];
+    if (v.size() == 2 && v[0] == '1' && v[1] == '0') return TABLES.value['T'];
+    return NONE;
+}
+
+// Longest card (MAX_CARD_CHARS down to 2 bytes) starting at s[pos]; 0 if none.
+inline size_t longestCardAt(std::string_view s, size_t pos, CardId& out) {
+    const size_t remaining = s.size() - pos;
+    for (size_t len = remaining < MAX_CARD_CHARS ? remaining : MAX_CARD_CHARS; len >= 2; --len) {
+        if (parseCard(s.substr(pos, len), out) == Status::Ok) return len;
+    }
+    return 0;
+}
+
+// Greedy concatenated parse of s into at most `limit` cards; stops early
+// (leaving the rest unread) once limit cards are read.
+Status parseConcatenated(std::string_view s, CardId* out, int limit, int& n) {
+    n = 0;
+    size_t pos = 0;
+    while (pos < s.size() && n < limit) {
+        const size_t len = longestCardAt(s, pos, out[n]);
+        if (len == 0) return Status::BadValue;
+        pos += len;
+        ++n;
+    }
+    return Status::Ok;
+}
+
+bool validBoardCount(int n) { return n == 0 || n == 3 || n == 4 || n == 5; }
+
+} // namespace
+
+const char* statusMessage(Status status) {
+    switch (status) {
+        case Status::Ok: return "ok";
+        case Status::Empty: return "empty card string";
+        case Status::BadSuit: return "invalid suit in card string";
+        case Status::BadValue: return "invalid value in card string";
+        case Status::BadSplit: return "cannot split string into two cards";
+        case Status::BadCount: return "board must have 0, 3, 4 or 5 cards";
+        case Status::Overflow: return "more cards than the output can hold";
+    }
+    return "unknown error";
+}
+
+Status parseCard(std::string_view s, CardId& out) {
+    if (s.empty()) return Status::Empty;
+    int suit = 0;
+    const size_t suitLen = suitSuffix(s, suit);
+    if (suitLen == 0) return Status::BadSuit;
+    if (s.size() <= suitLen) return Status::BadValue;
+    const int value = valueOf(s.substr(0, s.size() - suitLen));
+    if (value == NONE) return Status::BadValue;
+    out = makeCardId(value, suit);
+    return Status::Ok;
+}
+
+Status parseHoleCards(std::string_view s, CardId out[2]) {
+    if (s.empty()) return Status::Empty;
+
+    const size_t space = s.find(' ');
+    if (space != std::string_view::npos) {
+        const size_t second = s.find_first_not_of(' ', space);
+        if (second == std::string_view::npos) return Status::BadSplit;
+        const Status st = parseCard(s.substr(0, space), out[0]);
+        if (st != Status::Ok) return st;
+        return parseCard(s.substr(second), out[1]);
+    }
+
+    for (size_t len1 = 2; len1 <= MAX_CARD_CHARS && len1 < s.size(); ++len1) {
+        const size_t len2 = s.size() - len1;
+        if (len2 < 2 || len2 > MAX_CARD_CHARS) continue;
+        if (parseCard(s.substr(0, len1), out[0]) == Status::Ok && parseCard(s.substr(len1), out[1]) == Status::Ok) {
+            return Status::Ok;
+        }
+    }
+    return Status::BadSplit;
+}
+
+Status parseBoard(std::string_view s, CardId out[MAX_BOARD_CARDS], int& nOut) {
+    nOut = 0;
+    if (s.empty()) return Status::Ok;
+
+    const bool hasSpaces = s.find(' ') != std::string_view::npos;
+    if (hasSpaces) {
+        // Whitespace-separated tokens, accepted when there are 3-5 and all parse.
+        int nTokens = 0;
+        bool allCards = true;
+        CardId tokens[MAX_BOARD_CARDS];
+        for (size_t pos = 0; pos < s.size();) {
+            while (pos < s.size() && TABLES.space[byteAt(s, pos)]) ++pos;
+            if (pos == s.size()) break;
+            size_t end = pos;
+            while (end < s.size() && !TABLES.space[byteAt(s, end)]) ++end;
+            if (nTokens < MAX_BOARD_CARDS && parseCard(s.substr(pos, end - pos), tokens[nTokens]) != Status::Ok) {
+                allCards = false;
+            }
+            ++nTokens;
+            pos = end;
+        }
+        if (allCards && nTokens >= 3 && nTokens <= MAX_BOARD_CARDS) {
+            for (int i = 0; i < nTokens; ++i) out[i] = tokens[i];
+            nOut = nTokens;
+            return Status::Ok;
+        }
+    }
+
+    // Concatenated cards, with whitespace dropped if the string had spaces.
+    // At most five cards of at most MAX_CARD_CHARS bytes are ever read.
+    char buffer[MAX_BOARD_CARDS * MAX_CARD_CHARS];
+    std::string_view concatenated = s;
+    if (hasSpaces) {
+        size_t n = 0;
+        for (size_t i = 0; i < s.size() && n < sizeof(buffer); ++i) {
+            if (!TABLES.space[byteAt(s, i)]) buffer[n++] = s[i];
+        }
+        concatenated = std::string_view(buffer, n);
+    }
+    if (concatenated.empty()) return Status::Ok;
+
+    int n = 0;
+    const Status st = parseConcatenated(concatenated, out, MAX_BOARD_CARDS, n);
+    if (st != Status::Ok) return st;
+    if (!validBoardCount(n)) return Status::BadCount;
+    nOut = n;
+    return Status::Ok;
+}
+
+Status parseLine(std::string_view line, CardId* out, int capacity, int& nOut, size_t& errorPos) {
+    nOut = 0;
+    errorPos = 0;
+    size_t pos = 0;
+    while (pos < line.size()) {
+        if (TABLES.lineSeparator[byteAt(line, pos)]) {
+            ++pos;
+            continue;
+        }
+        size_t end = pos;
+        while (end < line.size() && !TABLES.lineSeparator[byteAt(line, end)]) ++end;
+        const std::string_view token = line.substr(0, end);
+        while (pos < end) {
+            CardId card;
+            const size_t len = longestCardAt(token, pos, card);
+            if (len == 0) {
+                errorPos = pos;
+                return Status::BadValue;
+            }
+            if (nOut == capacity) {
+                errorPos = pos;
+                return Status::Overflow;
+            }
+            out[nOut++] = card;
+            pos += len;
+        }
+    }
+    return Status::Ok;
+}
+
+} // namespace CardParse
@@ -0,0 +1,58 @@
+#ifndef CARD_PARSE_H
+#define CARD_PARSE_H
+
+#include "CardId.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+// ================================
+// Card string parsing
+// ================================
+// Allocation-free, exception-free parsing of the card strings PokerEnv
+// accepts: a value ("2"-"9", "T"/"t", "10", "J", "Q", "K", "A", single
+// letters in either case) followed by a suit, either one ASCII letter
+// (d/c/h/s, either case) or one of the glyphs of Card::SuitString
+// ("♢", "♣", "♡", "♠"). Every lookup is a 256-entry table.
+//
+// parseHoleCards and parseBoard split strings exactly like the PokerEnv
+// string overloads always have (first space, or the first two-card split;
+// tokens, or the longest card at each position), so results match the old
+// std::string / std::istringstream code for every input. parseLine is the
+// batch form for log ingestion: it reads every card of a line in one pass.
+namespace CardParse {
+
+enum class Status : uint8_t {
+    Ok = 0,
+    Empty,      // nothing to parse
+    BadSuit,    // no suit suffix
+    BadValue,   // value part missing or not a card value
+    BadSplit,   // two-card string with no valid split
+    BadCount,   // board not 0, 3, 4 or 5 cards
+    Overflow,   // more cards than the output holds
+};
+
+const char* statusMessage(Status status);
+
+constexpr int MAX_CARD_CHARS = 5;  // "10♠"
+constexpr int MAX_BOARD_CARDS = 5;
+
+// Exactly one card, the whole of s.
+Status parseCard(std::string_view s, CardId& out);
+
+// Two hole cards: "As Kd" (split at the first space) or "AsKd", "10♠K♡".
+Status parseHoleCards(std::string_view s, CardId out[2]);
+
+// A board of 0, 3, 4 or 5 cards, space separated or concatenated. On error
+// nOut is 0.
+Status parseBoard(std::string_view s, CardId out[MAX_BOARD_CARDS], int& nOut);
+
+// Every card of a line, in order. Cards are separated by whitespace or any
+// of , ; : [ ] ( ) { } ' " | or written back to back. On error nOut holds
+// the cards read so far and errorPos the byte offset of the bad token.
+Status parseLine(std::string_view line, CardId* out, int capacity, int& nOut, size_t& errorPos);
+
+} // namespace CardParse
+
+#endif // CARD_PARSE_H
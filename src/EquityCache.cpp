@@ -0,0 +1,153 @@
+#include "EquityCache.h"
+
+#include <algorithm>
+
+namespace {
+
+uint64_t mix64(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ull;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+uint64_t packValue(const EquityCache::Value& v) {
+    return static_cast<uint64_t>(static_cast<uint32_t>(v.equityVsAll)) |
+           (static_cast<uint64_t>(static_cast<uint32_t>(v.equityVsPairSets)) << 32);
+}
+
+EquityCache::Value unpackValue(uint64_t packed) {
+    EquityCache::Value v;
+    v.equityVsAll = static_cast<int32_t>(static_cast<uint32_t>(packed));
+    v.equityVsPairSets = static_cast<int32_t>(static_cast<uint32_t>(packed >> 32));
+    return v;
+}
+
+} // namespace
+
+EquityCache::EquityCache(size_t capacity) {
+    size_t sets = 1;
+    while (sets * WAYS < capacity) sets <<= 1;
+    nSets_ = sets;
+    sets_.reset(new Set[nSets_]);
+    clockHands_.reset(new std::atomic<uint8_t>[nSets_]);
+    for (size_t i = 0; i < nSets_; ++i) clockHands_[i].store(0, std::memory_order_relaxed);
+}
+
+EquityCache& EquityCache::shared() {
+    static EquityCache cache;
+    return cache;
+}
+
+EquityCache::Key EquityCache::makeKey(const CardId* hole, int nHole, const CardId* board, int nBoard) {
+    uint32_t signature[4] = {0, 0, 0, 0}; // (board ranks << 13) | hole ranks, per suit
+    for (int i = 0; i < nBoard; ++i) signature[cardIdSuit(board[i])] |= 1u << (13 + cardIdValue(board[i]));
+    for (int i = 0; i < nHole; ++i) signature[cardIdSuit(hole[i])] |= 1u << cardIdValue(hole[i]);
+    std::sort(signature, signature + 4, [](uint32_t a, uint32_t b) { return a > b; });
+
+    Key key;
+    key.lo = signature[0] | (static_cast<uint64_t>(signature[1]) << 32);
+    key.hi = signature[2] | (static_cast<uint64_t>(signature[3]) << 32);
+    return key;
+}
+
+size_t EquityCache::setIndex(const Key& key) const {
+    return static_cast<size_t>(mix64(key.lo ^ mix64(key.hi)) & (nSets_ - 1));
+}
+
+bool EquityCache::find(const Key& key, Value& out) {
+    Set& set = sets_[setIndex(key)];
+    for (Entry& e : set.ways) {
+        const uint32_t before = e.seq.load(std::memory_order_acquire);
+        if (before & 1u) continue; // being written
+        const uint64_t lo = e.keyLo.load(std::memory_order_relaxed);
+        const uint64_t hi = e.keyHi.load(std::memory_order_relaxed);
+        const uint64_t value = e.value.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (e.seq.load(std::memory_order_relaxed) != before) continue;
+
+        if (lo == key.lo && hi == key.hi) {
+            if (!e.referenced.load(std::memory_order_relaxed)) {
+                e.referenced.store(1, std::memory_order_relaxed);
+            }
+            out = unpackValue(value);
+            hits_.add();
+            return true;
+        }
+    }
+    misses_.add();
+    return false;
+}
+
+void EquityCache::insert(const Key& key, const Value& value) {
+    const size_t index = setIndex(key);
+    Set& set = sets_[index];
+    std::atomic<uint8_t>& hand = clockHands_[index];
+
+    Entry* victim = nullptr;
+    for (Entry& e : set.ways) {
+        const uint64_t lo = e.keyLo.load(std::memory_order_relaxed);
+        const uint64_t hi = e.keyHi.load(std::memory_order_relaxed);
+        if (lo == key.lo && hi == key.hi) return; // another env got there first
+        if (!victim && lo == 0 && hi == 0) victim = &e;
+    }
+
+    const bool evicting = victim == nullptr;
+    if (evicting) {
+        // CLOCK: a referenced entry loses its bit and survives one more sweep.
+        for (int i = 0; i < 2 * WAYS && !victim; ++i) {
+            Entry& e = set.ways[hand.fetch_add(1, std::memory_order_relaxed) % WAYS];
+            if (!e.referenced.exchange(0, std::memory_order_relaxed)) victim = &e;
+        }
+        if (!victim) victim = &set.ways[hand.fetch_add(1, std::memory_order_relaxed) % WAYS];
+    }
+
+    uint32_t seq = victim->seq.load(std::memory_order_relaxed);
+    if ((seq & 1u) || !victim->seq.compare_exchange_strong(seq, seq + 1, std::memory_order_acquire,
+                                                           std::memory_order_relaxed)) {
+        return; // another writer owns the entry; this result is simply not cached
+    }
+    std::atomic_thread_fence(std::memory_order_release);
+    victim->keyLo.store(key.lo, std::memory_order_relaxed);
+    victim->keyHi.store(key.hi, std::memory_order_relaxed);
+    victim->value.store(packValue(value), std::memory_order_relaxed);
+    victim->referenced.store(0, std::memory_order_relaxed);
+    victim->seq.store(seq + 2, std::memory_order_release);
+
+    inserts_.add();
+    if (evicting) evictions_.add();
+}
+
+EquityCache::Stats EquityCache::stats() const {
+    Stats s;
+    s.hits = hits_.get();
+    s.misses = misses_.get();
+    s.inserts = inserts_.get();
+    s.evictions = evictions_.get();
+    s.capacity = capacity();
+    return s;
+}
+
+void EquityCache::resetStats() {
+    for (Counter* c : {&hits_, &misses_, &inserts_, &evictions_}) {
+        c->n.store(0, std::memory_order_relaxed);
+    }
+}
+
+void EquityCache::clear() {
+    for (size_t i = 0; i < nSets_; ++i) {
+        for (Entry& e : sets_[i].ways) {
+            uint32_t seq = e.seq.load(std::memory_order_relaxed);
+            if ((seq & 1u) || !e.seq.compare_exchange_strong(seq, seq + 1, std::memory_order_acquire,
+                                                             std::memory_order_relaxed)) {
+                continue;
+            }
+            std::atomic_thread_fence(std::memory_order_release);
+            e.keyLo.store(0, std::memory_order_relaxed);
+            e.keyHi.store(0, std::memory_order_relaxed);
+            e.value.store(0, std::memory_order_relaxed);
+            e.referenced.store(0, std::memory_order_relaxed);
+            e.seq.store(seq + 2, std::memory_order_release);
+        }
+    }
+}
@@ -0,0 +1,104 @@
+#ifndef EQUITY_CACHE_H
+#define EQUITY_CACHE_H
+
+#include "CardId.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// ================================
+// Suit-isomorphic equity cache
+// ================================
+// Process-wide (hole, board) -> multidimensional equity cache used by
+// PokerEnv::_computeHandPotential. Two situations that differ
+// only by a relabelling of suits have the same equities, so entries are keyed
+// by a canonical form: for each suit the pair (board ranks, hole ranks) as two
+// 13-bit masks, the four pairs sorted. Suits with equal pairs are
+// interchangeable, which makes the key exact; the board-only suit map of
+// _getCanonicalSuitMap_static leaves such ties (e.g. the suits absent from
+// the board) to input order.
+//
+// The table is set-associative (WAYS entries per set) with a fixed number of
+// entries; when a set is full CLOCK picks the victim. Lookups take no lock:
+// every entry is guarded by a sequence counter, and a reader that races a
+// writer simply misses. Writers claim an entry by moving its counter to odd
+// and drop their insert if another writer holds it.
+class EquityCache {
+public:
+    struct Key {
+        uint64_t lo = 0;
+        uint64_t hi = 0;
+    };
+
+    struct Value {
+        int32_t equityVsAll = 0;       // 0-10000
+        int32_t equityVsPairSets = 0;  // 0-10000
+    };
+
+    struct Stats {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t inserts = 0;
+        uint64_t evictions = 0;
+        size_t capacity = 0;
+
+        double hitRate() const {
+            const uint64_t lookups = hits + misses;
+            return lookups ? static_cast<double>(hits) / static_cast<double>(lookups) : 0.0;
+        }
+    };
+
+    static constexpr int WAYS = 4;
+    static constexpr size_t DEFAULT_CAPACITY = size_t{1} << 17; // entries, 32 bytes each
+
+    // capacity is rounded up to a power of two number of sets.
+    explicit EquityCache(size_t capacity = DEFAULT_CAPACITY);
+
+    EquityCache(const EquityCache&) = delete;
+    EquityCache& operator=(const EquityCache&) = delete;
+
+    // The cache all envs share.
+    static EquityCache& shared();
+
+    static Key makeKey(const CardId* hole, int nHole, const CardId* board, int nBoard);
+
+    bool find(const Key& key, Value& out);
+    void insert(const Key& key, const Value& value);
+
+    Stats stats() const;
+    void resetStats();
+    // Not safe against concurrent insert(); lookups racing it just miss.
+    void clear();
+    size_t capacity() const { return nSets_ * WAYS; }
+
+private:
+    struct Entry {
+        std::atomic<uint32_t> seq{0};  // odd while a writer owns the entry
+        std::atomic<uint8_t> referenced{0};
+        std::atomic<uint64_t> keyLo{0};
+        std::atomic<uint64_t> keyHi{0};
+        std::atomic<uint64_t> value{0};
+    };
+
+    struct alignas(64) Set {
+        Entry ways[WAYS];
+    };
+
+    struct alignas(64) Counter {
+        std::atomic<uint64_t> n{0};
+        void add() { n.fetch_add(1, std::memory_order_relaxed); }
+        uint64_t get() const { return n.load(std::memory_order_relaxed); }
+    };
+
+    size_t setIndex(const Key& key) const;
+
+    std::unique_ptr<Set[]> sets_;
+    std::unique_ptr<std::atomic<uint8_t>[]> clockHands_; // per set
+    size_t nSets_ = 0;
+
+    Counter hits_, misses_, inserts_, evictions_;
+};
+
+#endif // EQUITY_CACHE_H
@@ -0,0 +1,319 @@
+#include "EquityEngine.h"
+#include "HandEvalBatch.h"
+#include "WorkStealingPool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+
+namespace EquityEngine {
+
+namespace {
+
+constexpr int N_HOLE = 2;
+constexpr int FULL_BOARD = 5;
+constexpr int MAX_PLAYERS = MAX_OPPONENTS + 1;
+
+// Give up on a chunk whose deals keep colliding: the ranges can then only be
+// dealt together with vanishing probability.
+constexpr uint64_t MAX_REJECTIONS_PER_SAMPLE = 1000;
+
+// A range restricted to the hands the dead cards leave live, with the
+// running weight total for inverse-CDF sampling.
+struct LiveRange {
+    std::vector<uint16_t> hands;  // range indices
+    std::vector<float> weights;
+    std::vector<double> cumulative;
+    double total = 0.0;
+};
+
+struct Accumulator {
+    double sum = 0.0;     // of pot share (times outcome weight when exhaustive)
+    double sumSq = 0.0;
+    double weight = 0.0;  // outcomes, or total outcome weight when exhaustive
+    uint64_t count = 0;
+
+    void merge(const Accumulator& o) {
+        sum += o.sum;
+        sumSq += o.sumSq;
+        weight += o.weight;
+        count += o.count;
+    }
+};
+
+uint64_t handMask(int rangeIdx) {
+    return cardIdBit(RangeLut::rangeCard1(rangeIdx)) | cardIdBit(RangeLut::rangeCard2(rangeIdx));
+}
+
+uint64_t splitmix64(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ull;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+double binomial(int n, int k) {
+    if (k < 0 || k > n) return 0.0;
+    double r = 1.0;
+    for (int i = 1; i <= k; ++i) r = r * (n - k + i) / i;
+    return r;
+}
+
+// Pot share of player 0 given every player's 7 cards, laid out
+// [nPlayers][CARDS_PER_HAND].
+double heroShare(const CardId* hands, int nPlayers) {
+    int32_t ranks[MAX_PLAYERS];
+    HandEvalBatch::evaluate7(hands, static_cast<size_t>(nPlayers), ranks);
+    int tied = 1;
+    for (int p = 1; p < nPlayers; ++p) {
+        if (ranks[p] < ranks[0]) return 0.0;
+        if (ranks[p] == ranks[0]) ++tied;
+    }
+    return 1.0 / tied;
+}
+
+class Evaluation {
+public:
+    Evaluation(const CardId hole[2], const CardId* board, int nBoard, const std::vector<RangeWeights>& ranges)
+        : nBoard_(nBoard), nPlayers_(static_cast<int>(ranges.size()) + 1) {
+        hole_[0] = hole[0];
+        hole_[1] = hole[1];
+        for (int i = 0; i < nBoard; ++i) board_[i] = board[i];
+        dead_ = cardIdBit(hole[0]) | cardIdBit(hole[1]);
+        for (int i = 0; i < nBoard; ++i) dead_ |= cardIdBit(board[i]);
+
+        ranges_.resize(ranges.size());
+        for (size_t o = 0; o < ranges.size(); ++o) {
+            LiveRange& live = ranges_[o];
+            for (int idx = 0; idx < RangeLut::N_RANGE_IDX; ++idx) {
+                const float w = ranges[o][idx];
+                if (w <= 0.0f || (handMask(idx) & dead_)) continue;
+                live.hands.push_back(static_cast<uint16_t>(idx));
+                live.weights.push_back(w);
+                live.total += w;
+                live.cumulative.push_back(live.total);
+            }
+            if (live.hands.empty()) {
+                throw std::invalid_argument("EquityEngine: range of opponent " + std::to_string(o) +
+                                            " has no hand left after removing the dead cards");
+            }
+        }
+    }
+
+    int runoutCards() const { return FULL_BOARD - nBoard_; }
+
+    double outcomeCount() const {
+        double n = binomial(N_CARD_IDS - N_HOLE * nPlayers_ - nBoard_, runoutCards());
+        for (const LiveRange& live : ranges_) n *= static_cast<double>(live.hands.size());
+        return n;
+    }
+
+    // Every opponent deal whose first opponent holds ranges_[0].hands[first],
+    // with every runout.
+    Accumulator enumerate(size_t first) const {
+        Accumulator acc;
+        CardId hands[MAX_PLAYERS][HandEvalBatch::CARDS_PER_HAND];
+        const int idx = ranges_[0].hands[first];
+        _setHole(hands, 1, idx);
+        _enumerateFrom(1, dead_ | handMask(idx), ranges_[0].weights[first], hands, acc);
+        return acc;
+    }
+
+    // CHUNK_SAMPLES (or fewer) deals from stream `chunk`.
+    Accumulator sample(uint64_t chunk, uint64_t nSamples, uint64_t seed) const {
+        std::mt19937_64 rng(splitmix64(seed ^ splitmix64(chunk)));
+        Accumulator acc;
+        CardId hands[MAX_PLAYERS][HandEvalBatch::CARDS_PER_HAND];
+        CardId runout[FULL_BOARD];
+        uint64_t rejections = 0;
+        while (acc.count < nSamples) {
+            uint64_t used = dead_;
+            bool collided = false;
+            for (size_t o = 0; o < ranges_.size() && !collided; ++o) {
+                const int idx = _draw(ranges_[o], rng);
+                collided = (handMask(idx) & used) != 0;
+                used |= handMask(idx);
+                _setHole(hands, static_cast<int>(o) + 1, idx);
+            }
+            if (collided) {
+                if (++rejections > MAX_REJECTIONS_PER_SAMPLE * (acc.count + 1)) {
+                    throw std::invalid_argument("EquityEngine: opponent ranges can almost never be dealt together");
+                }
+                continue;
+            }
+            for (int i = 0; i < runoutCards(); ++i) {
+                CardId c;
+                do {
+                    c = static_cast<CardId>(((rng() >> 32) * N_CARD_IDS) >> 32);
+                } while (used & cardIdBit(c));
+                used |= cardIdBit(c);
+                runout[i] = c;
+            }
+            const double share = _showdown(hands, runout);
+            acc.sum += share;
+            acc.sumSq += share * share;
+            acc.weight += 1.0;
+            ++acc.count;
+        }
+        return acc;
+    }
+
+    size_t firstRangeSize() const { return ranges_[0].hands.size(); }
+
+private:
+    void _setHole(CardId hands[][HandEvalBatch::CARDS_PER_HAND], int player, int idx) const {
+        hands[player][0] = RangeLut::rangeCard1(idx);
+        hands[player][1] = RangeLut::rangeCard2(idx);
+    }
+
+    static int _draw(const LiveRange& live, std::mt19937_64& rng) {
+        const double u = static_cast<double>(rng() >> 11) * 0x1.0p-53 * live.total;
+        const size_t i = std::upper_bound(live.cumulative.begin(), live.cumulative.end(), u) - live.cumulative.begin();
+        return live.hands[std::min(i, live.hands.size() - 1)];
+    }
+
+    // Fills in board and hero cards and ranks everyone.
+    double _showdown(CardId hands[][HandEvalBatch::CARDS_PER_HAND], const CardId* runout) const {
+        hands[0][0] = hole_[0];
+        hands[0][1] = hole_[1];
+        for (int p = 0; p < nPlayers_; ++p) {
+            for (int i = 0; i < nBoard_; ++i) hands[p][N_HOLE + i] = board_[i];
+            for (int i = 0; i < runoutCards(); ++i) hands[p][N_HOLE + nBoard_ + i] = runout[i];
+        }
+        return heroShare(&hands[0][0], nPlayers_);
+    }
+
+    void _enumerateFrom(int opponent, uint64_t used, double weight,
+                        CardId hands[][HandEvalBatch::CARDS_PER_HAND], Accumulator& acc) const {
+        if (opponent < static_cast<int>(ranges_.size())) {
+            const LiveRange& live = ranges_[opponent];
+            for (size_t h = 0; h < live.hands.size(); ++h) {
+                const uint64_t mask = handMask(live.hands[h]);
+                if (mask & used) continue;
+                _setHole(hands, opponent + 1, live.hands[h]);
+                _enumerateFrom(opponent + 1, used | mask, weight * live.weights[h], hands, acc);
+            }
+            return;
+        }
+
+        // All opponents dealt: every runout of the remaining deck.
+        CardId deck[N_CARD_IDS];
+        int nDeck = 0;
+        for (int c = 0; c < N_CARD_IDS; ++c) {
+            if (!(used & cardIdBit(static_cast<CardId>(c)))) deck[nDeck++] = static_cast<CardId>(c);
+        }
+        const int k = runoutCards();
+        int pick[FULL_BOARD];
+        for (int i = 0; i < k; ++i) pick[i] = i;
+        CardId runout[FULL_BOARD];
+        for (;;) {
+            for (int i = 0; i < k; ++i) runout[i] = deck[pick[i]];
+            const double share = _showdown(hands, runout);
+            acc.sum += weight * share;
+            acc.weight += weight;
+            ++acc.count;
+
+            int i = k - 1;
+            while (i >= 0 && pick[i] == nDeck - k + i) --i;
+            if (i < 0) break;
+            ++pick[i];
+            for (int j = i + 1; j < k; ++j) pick[j] = pick[j - 1] + 1;
+        }
+    }
+
+    CardId hole_[N_HOLE];
+    CardId board_[FULL_BOARD];
+    int nBoard_;
+    int nPlayers_;
+    uint64_t dead_ = 0;
+    std::vector<LiveRange> ranges_;
+};
+
+void validate(const CardId hole[2], const CardId* board, int nBoard, const std::vector<RangeWeights>& ranges) {
+    if (nBoard < 0 || nBoard > FULL_BOARD) {
+        throw std::invalid_argument("EquityEngine: board must hold 0-5 cards, got " + std::to_string(nBoard));
+    }
+    if (ranges.empty() || ranges.size() > static_cast<size_t>(MAX_OPPONENTS)) {
+        throw std::invalid_argument("EquityEngine: need 1-" + std::to_string(MAX_OPPONENTS) +
+                                    " opponent ranges, got " + std::to_string(ranges.size()));
+    }
+    uint64_t seen = 0;
+    for (int i = 0; i < N_HOLE + nBoard; ++i) {
+        const CardId c = i < N_HOLE ? hole[i] : board[i - N_HOLE];
+        if (!isValidCardId(c) || (seen & cardIdBit(c))) {
+            throw std::invalid_argument("EquityEngine: invalid or repeated card id " + std::to_string(c));
+        }
+        seen |= cardIdBit(c);
+    }
+    for (size_t o = 0; o < ranges.size(); ++o) {
+        if (ranges[o].size() != static_cast<size_t>(RangeLut::N_RANGE_IDX)) {
+            throw std::invalid_argument("EquityEngine: range " + std::to_string(o) + " has " +
+                                        std::to_string(ranges[o].size()) + " weights, expected " +
+                                        std::to_string(RangeLut::N_RANGE_IDX));
+        }
+        for (float w : ranges[o]) {
+            if (!(w >= 0.0f) || std::isinf(w)) {
+                throw std::invalid_argument("EquityEngine: range " + std::to_string(o) +
+                                            " has a negative or non-finite weight");
+            }
+        }
+    }
+}
+
+} // namespace
+
+RangeWeights uniformRange() { return RangeWeights(RangeLut::N_RANGE_IDX, 1.0f); }
+
+Result compute(const CardId hole[2], const CardId* board, int nBoard,
+               const std::vector<RangeWeights>& opponentRanges, const Options& options) {
+    validate(hole, board, nBoard, opponentRanges);
+    const Evaluation evaluation(hole, board, nBoard, opponentRanges);
+
+    std::unique_ptr<WorkStealingPool> ownPool;
+    WorkStealingPool* pool = options.pool;
+    if (!pool) {
+        ownPool.reset(new WorkStealingPool(std::max(1, options.nThreads)));
+        pool = ownPool.get();
+    }
+
+    Result result;
+    Accumulator total;
+    if (evaluation.outcomeCount() <= static_cast<double>(options.exhaustiveLimit)) {
+        std::vector<Accumulator> parts(evaluation.firstRangeSize());
+        pool->parallel_for(parts.size(), [&](size_t i) { parts[i] = evaluation.enumerate(i); });
+        for (const Accumulator& part : parts) total.merge(part);
+        if (total.weight <= 0.0) {
+            throw std::invalid_argument("EquityEngine: opponent ranges cannot be dealt together");
+        }
+        result.equity = total.sum / total.weight;
+        result.exhaustive = true;
+    } else {
+        const uint64_t budget = std::max<uint64_t>(options.maxSamples, 1);
+        const size_t nChunks = static_cast<size_t>((budget + CHUNK_SAMPLES - 1) / CHUNK_SAMPLES);
+        const auto deadline = std::chrono::steady_clock::now() +
+                              std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                  std::chrono::duration<double>(options.maxSeconds));
+        std::vector<Accumulator> parts(nChunks);
+        pool->parallel_for(nChunks, [&](size_t c) {
+            // The first chunk always runs so a result is never empty.
+            if (c > 0 && options.maxSeconds > 0.0 && std::chrono::steady_clock::now() >= deadline) return;
+            const uint64_t n = std::min<uint64_t>(CHUNK_SAMPLES, budget - c * CHUNK_SAMPLES);
+            parts[c] = evaluation.sample(c, n, options.seed);
+        });
+        for (const Accumulator& part : parts) total.merge(part);
+        const double n = static_cast<double>(total.count);
+        result.equity = total.sum / n;
+        if (total.count > 1) {
+            const double variance = std::max(0.0, (total.sumSq - n * result.equity * result.equity) / (n - 1.0));
+            result.stdError = std::sqrt(variance / n);
+        }
+    }
+    result.samples = total.count;
+    return result;
+}
+
+} // namespace EquityEngine
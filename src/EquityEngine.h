@@ -0,0 +1,66 @@
+#ifndef EQUITY_ENGINE_H
+#define EQUITY_ENGINE_H
+
+#include "CardId.h"
+#include "RangeLut.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class WorkStealingPool;
+
+// ================================
+// Equity against weighted ranges
+// ================================
+// Equity of one hole pair against N opponents, each holding a weighted range
+// over the 1326 range indices (RangeLut), on a board of 0-5 cards. Equity is
+// the expected pot share: a win counts 1, a k-way tie 1/k. Opponent hands are
+// drawn with probability proportional to the product of their weights, over
+// deals that share no card with each other, the hero or the board.
+//
+// When the number of (opponent hands, runout) outcomes fits
+// Options::exhaustiveLimit (typically a turn or river, or a heads-up flop)
+// every outcome is enumerated and the result is exact. Otherwise deals are
+// sampled in chunks of CHUNK_SAMPLES until the sample or time budget runs
+// out. Chunk c draws from a stream derived from (seed, c) and chunks are
+// merged in order, so a sample-limited run gives the same answer for a seed
+// whatever the thread count. Work runs on a WorkStealingPool; hands are
+// ranked with HandEvalBatch.
+namespace EquityEngine {
+
+// Weight per range index; hands blocked by the dead cards are ignored.
+using RangeWeights = std::vector<float>;
+
+constexpr int MAX_OPPONENTS = 22; // 2 * 23 hole cards + 5 board cards fill a deck
+constexpr uint64_t CHUNK_SAMPLES = 1024;
+
+struct Options {
+    uint64_t maxSamples = 100000;         // Monte Carlo deals
+    double maxSeconds = 0.0;              // > 0 also stops sampling after this long
+    uint64_t seed = 0;
+    int nThreads = 1;                     // used when pool is null
+    WorkStealingPool* pool = nullptr;     // run on an existing pool instead
+    uint64_t exhaustiveLimit = 2000000;   // enumerate when outcomes <= this
+};
+
+struct Result {
+    double equity = 0.0;
+    double stdError = 0.0;   // 0 when exhaustive
+    uint64_t samples = 0;    // outcomes enumerated or deals sampled
+    bool exhaustive = false;
+};
+
+// A range holding every hand with weight 1.
+RangeWeights uniformRange();
+
+// hole must be two distinct valid ids, board nBoard (0-5) more, and every
+// range RangeLut::N_RANGE_IDX non-negative weights. Throws
+// std::invalid_argument on malformed input or a range the dead cards block
+// entirely.
+Result compute(const CardId hole[2], const CardId* board, int nBoard,
+               const std::vector<RangeWeights>& opponentRanges, const Options& options);
+
+} // namespace EquityEngine
+
+#endif // EQUITY_ENGINE_H
@@ -0,0 +1,318 @@
+#include "EquityTable.h"
+#include "RangeLut.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#if defined(_WIN32)
+#include <memory>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace EquityTable {
+
+namespace {
+
+constexpr int MAX_BOARD = TURN_CARDS;
+
+struct Binomials {
+    uint32_t c[N_CARD_IDS + 1][MAX_BOARD + 1];
+};
+
+constexpr Binomials buildBinomials() {
+    Binomials b{};
+    for (int n = 0; n <= N_CARD_IDS; ++n) {
+        b.c[n][0] = 1;
+        for (int k = 1; k <= MAX_BOARD; ++k) {
+            b.c[n][k] = n == 0 ? 0 : b.c[n - 1][k - 1] + b.c[n - 1][k];
+        }
+    }
+    return b;
+}
+
+constexpr Binomials BINOMIALS = buildBinomials();
+
+constexpr uint32_t boardCombos(int nBoard) { return BINOMIALS.c[N_CARD_IDS][nBoard]; }
+
+static_assert(static_cast<uint64_t>(RangeLut::N_RANGE_IDX) * BINOMIALS.c[N_CARD_IDS][TURN_CARDS] < (uint64_t{1} << 32),
+              "turn keys must fit 32 bits");
+
+int streetOf(int nBoard) { return nBoard == FLOP_CARDS ? 0 : nBoard == TURN_CARDS ? 1 : -1; }
+
+uint32_t colexIndex(const CardId* sortedBoard, int nBoard) {
+    uint32_t idx = 0;
+    for (int i = 0; i < nBoard; ++i) idx += BINOMIALS.c[sortedBoard[i]][i + 1];
+    return idx;
+}
+
+// Inverse of colexIndex: ascending card ids.
+void colexDecode(uint32_t idx, int nBoard, CardId* board) {
+    int c = N_CARD_IDS - 1;
+    for (int k = nBoard; k >= 1; --k) {
+        while (BINOMIALS.c[c][k] > idx) --c;
+        board[k - 1] = static_cast<CardId>(c);
+        idx -= BINOMIALS.c[c][k];
+        --c;
+    }
+}
+
+// Next n-subset of 0..51 in colex order; false after the last one.
+bool nextCombo(CardId* b, int n) {
+    for (int i = 0; i < n; ++i) {
+        const int limit = i + 1 < n ? b[i + 1] : N_CARD_IDS;
+        if (b[i] + 1 < limit) {
+            ++b[i];
+            for (int j = 0; j < i; ++j) b[j] = static_cast<CardId>(j);
+            return true;
+        }
+    }
+    return false;
+}
+
+size_t alignUp8(size_t n) { return (n + 7) & ~static_cast<size_t>(7); }
+
+size_t streetBytes(uint32_t count) {
+    return alignUp8(sizeof(uint32_t) * (RangeLut::N_RANGE_IDX + 1)) + alignUp8(sizeof(uint32_t) * count) +
+           sizeof(Entry) * count;
+}
+
+// Class representatives of one street, ascending by key: the (hole, board)
+// combinations that are already in canonical form.
+std::vector<uint32_t> enumerateClasses(int nBoard) {
+    std::vector<uint32_t> keys;
+    for (int holeIdx = 0; holeIdx < RangeLut::N_RANGE_IDX; ++holeIdx) {
+        const CardId hole[2] = {RangeLut::rangeCard1(holeIdx), RangeLut::rangeCard2(holeIdx)};
+        const uint64_t holeMask = cardIdBit(hole[0]) | cardIdBit(hole[1]);
+        CardId board[MAX_BOARD];
+        for (int i = 0; i < nBoard; ++i) board[i] = static_cast<CardId>(i);
+        do {
+            bool overlaps = false;
+            for (int i = 0; i < nBoard; ++i) overlaps |= (holeMask & cardIdBit(board[i])) != 0;
+            if (overlaps) continue;
+            const uint32_t raw = static_cast<uint32_t>(holeIdx) * boardCombos(nBoard) + colexIndex(board, nBoard);
+            if (canonicalKey(hole, board, nBoard) == raw) keys.push_back(raw);
+        } while (nextCombo(board, nBoard));
+    }
+    return keys;
+}
+
+} // namespace
+
+uint32_t canonicalKey(const CardId hole[2], const CardId* board, int nBoard) {
+    uint32_t signature[4] = {0, 0, 0, 0}; // (board ranks << 13) | hole ranks, per suit
+    for (int i = 0; i < nBoard; ++i) signature[cardIdSuit(board[i])] |= 1u << (13 + cardIdValue(board[i]));
+    for (int i = 0; i < 2; ++i) signature[cardIdSuit(hole[i])] |= 1u << cardIdValue(hole[i]);
+
+    int order[4] = {0, 1, 2, 3};
+    std::stable_sort(order, order + 4, [&signature](int a, int b) { return signature[a] > signature[b]; });
+    int newSuit[4];
+    for (int i = 0; i < 4; ++i) newSuit[order[i]] = i;
+
+    auto relabel = [&newSuit](CardId c) { return makeCardId(cardIdValue(c), newSuit[cardIdSuit(c)]); };
+    CardId canonBoard[MAX_BOARD];
+    for (int i = 0; i < nBoard; ++i) canonBoard[i] = relabel(board[i]);
+    std::sort(canonBoard, canonBoard + nBoard);
+
+    const uint32_t holeIdx = static_cast<uint32_t>(RangeLut::rangeIdx(relabel(hole[0]), relabel(hole[1])));
+    return holeIdx * boardCombos(nBoard) + colexIndex(canonBoard, nBoard);
+}
+
+// ================================
+// Table (reader)
+// ================================
+
+Table::Table(const std::string& path) : path_(path) {
+#if defined(_WIN32)
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if (!in) throw std::runtime_error("EquityTable: cannot open " + path);
+    size_ = static_cast<size_t>(in.tellg());
+    uint8_t* buf = new uint8_t[size_];
+    in.seekg(0);
+    in.read(reinterpret_cast<char*>(buf), static_cast<std::streamsize>(size_));
+    data_ = buf;
+#else
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) throw std::runtime_error("EquityTable: cannot open " + path);
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || st.st_size <= 0) {
+        ::close(fd);
+        throw std::runtime_error("EquityTable: cannot stat " + path);
+    }
+    size_ = static_cast<size_t>(st.st_size);
+    void* mapped = ::mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED) throw std::runtime_error("EquityTable: cannot mmap " + path);
+    data_ = static_cast<const uint8_t*>(mapped);
+#endif
+
+    FileHeader header;
+    bool ok = size_ >= sizeof(header);
+    if (ok) {
+        std::memcpy(&header, data_, sizeof(header));
+        ok = header.magic == MAGIC && header.version == VERSION && header.byteOrder == BYTE_ORDER_MARK &&
+             header.entrySize == sizeof(Entry);
+    }
+    for (int s = 0; ok && s < 2; ++s) {
+        const StreetHeader& sh = header.streets[s];
+        if (sh.offset == 0) continue; // street not in the file
+        if (sh.offset % 8 != 0 || sh.offset > size_ || streetBytes(sh.count) > size_ - sh.offset) {
+            ok = false;
+            break;
+        }
+        Street& street = streets_[s];
+        const uint8_t* base = data_ + sh.offset;
+        street.count = sh.count;
+        street.holeStart = reinterpret_cast<const uint32_t*>(base);
+        street.keys = reinterpret_cast<const uint32_t*>(base + alignUp8(sizeof(uint32_t) * (RangeLut::N_RANGE_IDX + 1)));
+        street.entries = reinterpret_cast<const Entry*>(reinterpret_cast<const uint8_t*>(street.keys) +
+                                                        alignUp8(sizeof(uint32_t) * sh.count));
+        // find() searches keys[holeStart[h], holeStart[h + 1]), so the index
+        // must start at 0, never decrease and end at count.
+        ok = street.holeStart[0] == 0 && street.holeStart[RangeLut::N_RANGE_IDX] == sh.count;
+        for (int h = 0; ok && h < RangeLut::N_RANGE_IDX; ++h) {
+            ok = street.holeStart[h] <= street.holeStart[h + 1];
+        }
+    }
+    if (!ok || streets_[0].count == 0) {
+        unmap();
+        throw std::runtime_error("EquityTable: " + path + " is not a valid equity table (version " +
+                                 std::to_string(VERSION) + ")");
+    }
+}
+
+Table::~Table() { unmap(); }
+
+void Table::unmap() {
+    if (!data_) return;
+#if defined(_WIN32)
+    delete[] data_;
+#else
+    ::munmap(const_cast<uint8_t*>(data_), size_);
+#endif
+    data_ = nullptr;
+}
+
+bool Table::find(const CardId hole[2], const CardId* board, int nBoard, Entry& out) const {
+    const int s = streetOf(nBoard);
+    if (s < 0 || streets_[s].count == 0) return false;
+    const Street& street = streets_[s];
+
+    const uint32_t key = canonicalKey(hole, board, nBoard);
+    const uint32_t holeIdx = key / boardCombos(nBoard);
+    const uint32_t* first = street.keys + street.holeStart[holeIdx];
+    const uint32_t* last = street.keys + street.holeStart[holeIdx + 1];
+    const uint32_t* it = std::lower_bound(first, last, key);
+    if (it == last || *it != key) return false;
+    out = street.entries[it - street.keys];
+    return true;
+}
+
+size_t Table::classCount(int nBoard) const {
+    const int s = streetOf(nBoard);
+    return s < 0 ? 0 : streets_[s].count;
+}
+
+// ================================
+// Shared instance
+// ================================
+
+namespace {
+std::atomic<const Table*> g_shared{nullptr};
+std::mutex g_sharedMutex;
+} // namespace
+
+const Table* shared() { return g_shared.load(std::memory_order_acquire); }
+
+void installShared(const std::string& path) {
+    std::lock_guard<std::mutex> lock(g_sharedMutex);
+    const Table* current = g_shared.load(std::memory_order_relaxed);
+    if (current && current->path() == path) return;
+    // A replaced table is never unmapped: envs on other threads may be
+    // mid-lookup in it.
+    g_shared.store(new Table(path), std::memory_order_release);
+}
+
+// ================================
+// Generator
+// ================================
+
+size_t generate(const std::string& path, bool includeTurn, int nThreads, const EvaluateFn& evaluate) {
+    if (nThreads < 1) nThreads = 1;
+    const int nStreets = includeTurn ? 2 : 1;
+
+    FileHeader header{};
+    header.magic = MAGIC;
+    header.version = VERSION;
+    header.byteOrder = BYTE_ORDER_MARK;
+    header.entrySize = sizeof(Entry);
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) throw std::runtime_error("EquityTable::generate: cannot write " + path);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header)); // rewritten at the end
+
+    auto pad8 = [&out]() {
+        static const char zeros[8] = {};
+        const std::streamoff pos = out.tellp();
+        out.write(zeros, static_cast<std::streamsize>(alignUp8(static_cast<size_t>(pos)) - static_cast<size_t>(pos)));
+    };
+
+    size_t total = 0;
+    for (int s = 0; s < nStreets; ++s) {
+        const int nBoard = s == 0 ? FLOP_CARDS : TURN_CARDS;
+        const std::vector<uint32_t> keys = enumerateClasses(nBoard);
+
+        std::vector<uint32_t> holeStart(RangeLut::N_RANGE_IDX + 1, 0);
+        for (uint32_t key : keys) ++holeStart[key / boardCombos(nBoard) + 1];
+        for (int h = 0; h < RangeLut::N_RANGE_IDX; ++h) holeStart[h + 1] += holeStart[h];
+
+        std::vector<Entry> entries(keys.size());
+        std::atomic<size_t> next{0};
+        constexpr size_t CHUNK = 1024;
+        auto worker = [&]() {
+            for (;;) {
+                const size_t begin = next.fetch_add(CHUNK);
+                if (begin >= keys.size()) return;
+                const size_t end = std::min(begin + CHUNK, keys.size());
+                for (size_t i = begin; i < end; ++i) {
+                    const uint32_t holeIdx = keys[i] / boardCombos(nBoard);
+                    const CardId hole[2] = {RangeLut::rangeCard1(static_cast<int>(holeIdx)),
+                                            RangeLut::rangeCard2(static_cast<int>(holeIdx))};
+                    CardId board[MAX_BOARD];
+                    colexDecode(keys[i] % boardCombos(nBoard), nBoard, board);
+                    entries[i] = evaluate(hole, board, nBoard);
+                }
+            }
+        };
+        std::vector<std::thread> threads;
+        for (int t = 1; t < nThreads; ++t) threads.emplace_back(worker);
+        worker();
+        for (std::thread& t : threads) t.join();
+
+        pad8();
+        header.streets[s].offset = static_cast<uint64_t>(out.tellp());
+        header.streets[s].count = static_cast<uint32_t>(keys.size());
+        out.write(reinterpret_cast<const char*>(holeStart.data()), static_cast<std::streamsize>(sizeof(uint32_t) * holeStart.size()));
+        pad8();
+        out.write(reinterpret_cast<const char*>(keys.data()), static_cast<std::streamsize>(sizeof(uint32_t) * keys.size()));
+        pad8();
+        out.write(reinterpret_cast<const char*>(entries.data()), static_cast<std::streamsize>(sizeof(Entry) * entries.size()));
+        total += keys.size();
+    }
+
+    out.seekp(0);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    if (!out) throw std::runtime_error("EquityTable::generate: write to " + path + " failed");
+    return total;
+}
+
+} // namespace EquityTable
@@ -0,0 +1,123 @@
+#ifndef EQUITY_TABLE_H
+#define EQUITY_TABLE_H
+
+#include "CardId.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+// ================================
+// Precomputed flop/turn equity table
+// ================================
+// Read-only file with the hand-potential features of every suit-isomorphic
+// (hole, flop) and, optionally, (hole, flop, turn) class, generated offline
+// (PokerEnv::generate_equity_table, tools/gen_equity_table.cpp). At runtime it
+// is mmapped, so all worker processes on a node share one copy through the
+// page cache.
+//
+// A situation is canonicalised by relabelling suits in order of their
+// (board ranks, hole ranks) masks and sorting hole and board cards; its key is
+//   rangeIdx(hole) * C(52, nBoard) + colex index of the board,
+// which fits 32 bits for a 4-card board. File layout (host byte order):
+//   FileHeader
+//   per street (flop, then turn if present):
+//     uint32_t holeStart[N_RANGE_IDX + 1]   first entry of each hole index
+//                                           (0 first, non-decreasing, count last)
+//     uint32_t keys[count]                  ascending
+//     Entry    entries[count]
+// Every section starts on an 8-byte boundary.
+namespace EquityTable {
+
+constexpr uint32_t MAGIC = 0x51454B50; // "PKEQ"
+constexpr uint16_t VERSION = 2;
+constexpr uint16_t BYTE_ORDER_MARK = 0x0102;
+
+constexpr int FLOP_CARDS = 3;
+constexpr int TURN_CARDS = 4;
+
+// equity values are 0-10000; INVALID_EQUITY marks a class whose live
+// evaluation failed or was out of range (the env then uses its baseline).
+constexpr uint16_t INVALID_EQUITY = 0xFFFF;
+// potential of a class whose evaluate_holdem_with_potential failed; lookups
+// then evaluate the hand live instead.
+constexpr int32_t INVALID_POTENTIAL = INT32_MIN;
+
+struct Entry {
+    uint16_t equityVsAll;       // evaluate_holdem_multidimensional
+    uint16_t equityVsPairSets;
+    int32_t potential;          // evaluate_holdem_with_potential, or INVALID_POTENTIAL
+};
+static_assert(sizeof(Entry) == 8, "Entry layout changed; bump VERSION");
+
+struct StreetHeader {
+    uint64_t offset;   // of holeStart; 0 if the street is absent
+    uint32_t count;    // classes
+    uint32_t pad;
+};
+
+struct FileHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t byteOrder;
+    uint32_t entrySize;
+    uint32_t pad;
+    StreetHeader streets[2]; // flop, turn
+};
+static_assert(sizeof(FileHeader) == 48, "FileHeader layout changed; bump VERSION");
+
+// Canonical key of (hole[2], board[nBoard]), nBoard 3 or 4.
+uint32_t canonicalKey(const CardId hole[2], const CardId* board, int nBoard);
+
+// A mapped table. Lookups are const and need no locking.
+class Table {
+public:
+    // Maps path read-only; throws std::runtime_error if it is missing or not
+    // a valid table.
+    explicit Table(const std::string& path);
+    ~Table();
+
+    Table(const Table&) = delete;
+    Table& operator=(const Table&) = delete;
+
+    // False if the board is not a flop/turn the file covers.
+    bool find(const CardId hole[2], const CardId* board, int nBoard, Entry& out) const;
+
+    bool hasTurn() const { return streets_[1].count != 0; }
+    size_t classCount(int nBoard) const;
+    const std::string& path() const { return path_; }
+
+private:
+    struct Street {
+        const uint32_t* holeStart = nullptr;
+        const uint32_t* keys = nullptr;
+        const Entry* entries = nullptr;
+        uint32_t count = 0;
+    };
+
+    void unmap();
+
+    std::string path_;
+    const uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+    Street streets_[2];
+};
+
+// Process-wide table used by PokerEnv; nullptr until installShared succeeds.
+const Table* shared();
+// Loads path as the shared table. Loading the path already installed is a
+// no-op; a different path replaces it for later lookups (the old mapping
+// stays valid for readers still holding it).
+void installShared(const std::string& path);
+
+// Value of one canonical class: hole[2] and board[nBoard] as card ids.
+using EvaluateFn = std::function<Entry(const CardId* hole, const CardId* board, int nBoard)>;
+
+// Enumerates every class of the requested streets, evaluates them on
+// nThreads threads and writes the file. Returns the number of classes.
+size_t generate(const std::string& path, bool includeTurn, int nThreads, const EvaluateFn& evaluate);
+
+} // namespace EquityTable
+
+#endif // EQUITY_TABLE_H
@@ -0,0 +1,108 @@
+#ifndef FAST_RNG_H
+#define FAST_RNG_H
+
+#include <cstdint>
+#include <limits>
+
+// ================================
+// Per-env random number generator
+// ================================
+// xoshiro256** (Blackman & Vigna): 32 bytes of state instead of the ~5 KB of
+// std::mt19937, a handful of instructions per draw, and a fixed output
+// sequence for a given seed on every platform and standard library.
+// uniformInt replaces std::uniform_int_distribution (whose output differs
+// between implementations) with Lemire's multiply-and-reject method.
+//
+// Seeds go through splitmix64, so nearby seeds (0, 1, 2 ...) give unrelated
+// states. streamSeed(base, i) derives the seed of table i of a batch from one
+// base seed; jump() advances 2^128 draws for provably disjoint streams.
+// Satisfies UniformRandomBitGenerator, so it also works with <random>.
+class FastRng {
+public:
+    using result_type = uint64_t;
+
+    explicit FastRng(uint64_t seedValue = 0) { seed(seedValue); }
+
+    void seed(uint64_t seedValue) {
+        uint64_t sm = seedValue;
+        for (uint64_t& word : s_) word = splitmix64(sm);
+    }
+
+    // Seed of stream `stream` under base seed `base` (one per table).
+    static uint64_t streamSeed(uint64_t base, uint64_t stream) {
+        uint64_t sm = base ^ (stream * 0xD1B54A32D192ED03ull);
+        splitmix64(sm);
+        return splitmix64(sm);
+    }
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+    result_type operator()() {
+        const uint64_t result = rotl(s_[1] * 5, 7) * 9;
+        const uint64_t t = s_[1] << 17;
+        s_[2] ^= s_[0];
+        s_[3] ^= s_[1];
+        s_[1] ^= s_[2];
+        s_[0] ^= s_[3];
+        s_[2] ^= t;
+        s_[3] = rotl(s_[3], 45);
+        return result;
+    }
+
+    // Uniform in [lo, hi], hi >= lo.
+    int uniformInt(int lo, int hi) {
+        const uint64_t range = static_cast<uint64_t>(static_cast<int64_t>(hi) - lo) + 1;
+        if (range > 0xFFFFFFFFull) return static_cast<int>(static_cast<uint32_t>((*this)() >> 32));
+        return lo + static_cast<int>(below(static_cast<uint32_t>(range)));
+    }
+
+    // Uniform in [0, n), n > 0.
+    uint32_t below(uint32_t n) {
+        uint64_t m = ((*this)() >> 32) * n;
+        uint32_t low = static_cast<uint32_t>(m);
+        if (low < n) {
+            const uint32_t threshold = (0u - n) % n;
+            while (low < threshold) {
+                m = ((*this)() >> 32) * n;
+                low = static_cast<uint32_t>(m);
+            }
+        }
+        return static_cast<uint32_t>(m >> 32);
+    }
+
+    // Equivalent to 2^128 calls of operator().
+    void jump() {
+        static constexpr uint64_t JUMP[] = {0x180EC6D33CFD0ABAull, 0xD5A61266F0C9392Cull,
+                                           0xA9582618E03FC9AAull, 0x39ABDC4529B1661Cull};
+        uint64_t next[4] = {0, 0, 0, 0};
+        for (uint64_t word : JUMP) {
+            for (int b = 0; b < 64; ++b) {
+                if (word & (uint64_t{1} << b)) {
+                    for (int i = 0; i < 4; ++i) next[i] ^= s_[i];
+                }
+                (*this)();
+            }
+        }
+        for (int i = 0; i < 4; ++i) s_[i] = next[i];
+    }
+
+    bool operator==(const FastRng& other) const {
+        return s_[0] == other.s_[0] && s_[1] == other.s_[1] && s_[2] == other.s_[2] && s_[3] == other.s_[3];
+    }
+    bool operator!=(const FastRng& other) const { return !(*this == other); }
+
+private:
+    static uint64_t rotl(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+
+    static uint64_t splitmix64(uint64_t& state) {
+        uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+    uint64_t s_[4];
+};
+
+#endif // FAST_RNG_H
@@ -0,0 +1,37 @@
+#ifndef HAND_ARENA_H
+#define HAND_ARENA_H
+
+#include <cstddef>
+#include <memory_resource>
+
+// ================================
+// HandArena
+// ================================
+// Per-env monotonic arena for containers that live until the env rewinds it
+// (the hole-card lists of PlayerWinningInfo). Allocation is a pointer bump
+// into an inline buffer, deallocation is a no-op, and rewind() drops
+// everything at once, so settling a hand never touches the shared heap and
+// envs stepped on different threads never contend on the allocator. Only if
+// a hand outgrows INLINE_BYTES do further chunks come from the heap.
+//
+// Not thread-safe, like the env that owns it. Every container allocated from
+// it must be destroyed or cleared before rewind().
+class HandArena {
+public:
+    static constexpr size_t INLINE_BYTES = 2048;
+
+    HandArena() : resource_(buffer_, sizeof(buffer_)) {}
+
+    HandArena(const HandArena&) = delete;
+    HandArena& operator=(const HandArena&) = delete;
+
+    std::pmr::memory_resource* resource() { return &resource_; }
+
+    void rewind() { resource_.release(); }
+
+private:
+    alignas(std::max_align_t) unsigned char buffer_[INLINE_BYTES];
+    std::pmr::monotonic_buffer_resource resource_;
+};
+
+#endif // HAND_ARENA_H
@@ -0,0 +1,101 @@
+#ifndef HAND_DESCRIPTION_H
+#define HAND_DESCRIPTION_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// ================================
+// Interned pot / hand descriptions
+// ================================
+// PlayerWinningInfo stores which pot was won and with what as small ids; the
+// text is looked up only when something is printed or serialized. Names are
+// static, so the string_views returned here never dangle.
+//
+// Hand ids double as the PokerStateBin codes, so the order of NAMES is part of
+// the snapshot format: append only.
+namespace HandDescription {
+
+enum Id : uint8_t {
+    WON_BY_DEFAULT = 0,
+    INVALID_RANK,
+    STRAIGHT_FLUSH,
+    FOUR_OF_A_KIND,
+    FULL_HOUSE,
+    FLUSH,
+    STRAIGHT,
+    THREE_OF_A_KIND,
+    TWO_PAIR,
+    ONE_PAIR,
+    HIGH_CARD,
+    N_IDS,
+};
+
+// Hand or pot id that does not name anything (an unrecognised string).
+constexpr uint8_t UNKNOWN = 0xFF;
+
+constexpr std::string_view NAMES[N_IDS] = {
+    "Won by Default", "Invalid Rank", "Straight Flush", "Four of a Kind", "Full House", "Flush",
+    "Straight", "Three of a Kind", "Two Pair", "One Pair", "High Card",
+};
+
+// phevaluator rank (1 = best .. 7462 = worst) to its hand category.
+constexpr Id fromRank(int phevaluatorRank) {
+    if (phevaluatorRank <= 0 || phevaluatorRank > 7462) return INVALID_RANK;
+    if (phevaluatorRank <= 10) return STRAIGHT_FLUSH;
+    if (phevaluatorRank <= 166) return FOUR_OF_A_KIND;
+    if (phevaluatorRank <= 322) return FULL_HOUSE;
+    if (phevaluatorRank <= 1599) return FLUSH;
+    if (phevaluatorRank <= 1609) return STRAIGHT;
+    // Cater's ranges: 3K (1610-2467), 2P (2468-3325), 1P (3326-6185), HC (6186-7462)
+    if (phevaluatorRank <= 2467) return THREE_OF_A_KIND;
+    if (phevaluatorRank <= 3325) return TWO_PAIR;
+    if (phevaluatorRank <= 6185) return ONE_PAIR;
+    return HIGH_CARD;
+}
+
+constexpr std::string_view name(uint8_t id) {
+    return id < N_IDS ? NAMES[id] : std::string_view();
+}
+
+// Also accepts "Won by default", the spelling older builds wrote for a pot
+// won uncontested, so their JSON snapshots and logs keep the id.
+inline uint8_t idOf(std::string_view desc) {
+    for (uint8_t i = 0; i < N_IDS; ++i) {
+        if (desc == NAMES[i]) return i;
+    }
+    if (desc == "Won by default") return WON_BY_DEFAULT;
+    return UNKNOWN;
+}
+
+// --- Pots: 0 is the main pot, k the k-th side pot ("Side Pot k") ---
+constexpr uint8_t MAIN_POT = 0;
+constexpr int MAX_POT_INDEX = 64; // well above Showdown::MAX_SEATS side pots
+
+inline std::string_view potName(uint8_t potIndex) {
+    struct Table {
+        std::string names[MAX_POT_INDEX + 1];
+        Table() {
+            names[MAIN_POT] = "Main Pot";
+            for (int k = 1; k <= MAX_POT_INDEX; ++k) names[k] = "Side Pot " + std::to_string(k);
+        }
+    };
+    static const Table table;
+    return potIndex <= MAX_POT_INDEX ? std::string_view(table.names[potIndex]) : std::string_view();
+}
+
+inline uint8_t potIndexOf(std::string_view desc) {
+    if (desc == "Main Pot") return MAIN_POT;
+    constexpr std::string_view sidePrefix = "Side Pot ";
+    if (desc.substr(0, sidePrefix.size()) != sidePrefix || desc.size() == sidePrefix.size()) return UNKNOWN;
+    int k = 0;
+    for (char c : desc.substr(sidePrefix.size())) {
+        if (c < '0' || c > '9' || k > MAX_POT_INDEX) return UNKNOWN;
+        k = k * 10 + (c - '0');
+    }
+    return k > 0 && k <= MAX_POT_INDEX ? static_cast<uint8_t>(k) : UNKNOWN;
+}
+
+} // namespace HandDescription
+
+#endif // HAND_DESCRIPTION_H
@@ -0,0 +1,276 @@
+#include "HandEvalBatch.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace HandEvalBatch {
+
+namespace {
+
+constexpr int NUM_RANKS = 13;
+constexpr int N_MASKS = 1 << NUM_RANKS;
+
+// First rank of each category (see HandDescription::fromRank).
+constexpr int32_t STRAIGHT_FLUSH_BASE = 1;
+constexpr int32_t QUADS_BASE = 11;
+constexpr int32_t FULL_HOUSE_BASE = 167;
+constexpr int32_t FLUSH_BASE = 323;
+constexpr int32_t STRAIGHT_BASE = 1600;
+constexpr int32_t TRIPS_BASE = 1610;
+constexpr int32_t TWO_PAIR_BASE = 2468;
+constexpr int32_t PAIR_BASE = 3326;
+constexpr int32_t HIGH_CARD_BASE = 6186;
+
+// Per 13-bit rank mask (bit r = rank r, Two = 0 ... Ace = 12).
+struct MaskTables {
+    uint8_t nBits[N_MASKS];
+    int8_t topBit[N_MASKS];       // -1 for the empty mask
+    int8_t straight[N_MASKS];     // 0 = ace-high straight ... 9 = wheel, -1 if none
+    uint16_t top5[N_MASKS];       // index of the best five ranks among the 1277
+                                  // non-straight five-rank sets, strongest first
+};
+
+constexpr int binomial(int n, int k) {
+    if (k < 0 || k > n) return 0;
+    int r = 1;
+    for (int i = 1; i <= k; ++i) r = r * (n - k + i) / i;
+    return r;
+}
+
+constexpr MaskTables buildMaskTables() {
+    MaskTables t{};
+    for (int m = 0; m < N_MASKS; ++m) {
+        int n = 0;
+        int top = -1;
+        for (int r = 0; r < NUM_RANKS; ++r) {
+            if (m & (1 << r)) {
+                ++n;
+                top = r;
+            }
+        }
+        t.nBits[m] = static_cast<uint8_t>(n);
+        t.topBit[m] = static_cast<int8_t>(top);
+
+        t.straight[m] = -1;
+        for (int high = 12; high >= 4; --high) {
+            const int window = 0x1F << (high - 4);
+            if ((m & window) == window) {
+                t.straight[m] = static_cast<int8_t>(12 - high);
+                break;
+            }
+        }
+        if (t.straight[m] < 0 && (m & 0x100F) == 0x100F) t.straight[m] = 9; // A-2-3-4-5
+    }
+
+    // Five-rank sets: a larger mask is the lexicographically stronger hand.
+    int next = 0;
+    for (int m = N_MASKS - 1; m >= 0; --m) {
+        if (t.nBits[m] == 5 && t.straight[m] < 0) t.top5[m] = static_cast<uint16_t>(next++);
+    }
+    for (int m = 0; m < N_MASKS; ++m) {
+        if (t.nBits[m] <= 5) continue;
+        int rest = m;
+        int best = 0;
+        for (int i = 0; i < 5; ++i) {
+            best |= 1 << t.topBit[rest];
+            rest &= ~(1 << t.topBit[rest]);
+        }
+        t.top5[m] = t.top5[best];
+    }
+    return t;
+}
+
+constexpr MaskTables TABLES = buildMaskTables();
+
+static_assert(TABLES.top5[0x1E80] == 0, "AKQJ9 must be the strongest non-straight");
+static_assert(TABLES.top5[0x002F] == 1276, "7-5-4-3-2 must be the weakest high card");
+
+inline int bitOf(int rank) { return 1 << rank; }
+
+// Position of `rank` once the ranks in `excluded` are removed.
+inline int compressedRank(int rank, int excluded) {
+    return rank - TABLES.nBits[excluded & (bitOf(rank) - 1)];
+}
+
+// Strength index (0 = strongest) of the k-rank set `mask` among all k-rank
+// sets drawn from the ranks not in `excluded` (n of them).
+inline int kickerIndex(int mask, int excluded, int n, int k) {
+    int colex = 0;
+    for (int i = 0; i < k; ++i) {
+        const int r = TABLES.topBit[mask];
+        colex += binomial(compressedRank(r, excluded), k - i);
+        mask &= ~bitOf(r);
+    }
+    return binomial(n, k) - 1 - colex;
+}
+
+inline int topRanks(int mask, int k) {
+    int out = 0;
+    for (int i = 0; i < k; ++i) {
+        const int r = TABLES.topBit[mask];
+        out |= bitOf(r);
+        mask &= ~bitOf(r);
+    }
+    return out;
+}
+
+// Ranks one hand from its per-suit rank masks.
+inline int32_t rankFromMasks(uint32_t s0, uint32_t s1, uint32_t s2, uint32_t s3) {
+    const uint32_t suits[4] = {s0, s1, s2, s3};
+    for (uint32_t s : suits) {
+        // With seven cards a flush excludes quads and full houses.
+        if (TABLES.nBits[s] >= 5) {
+            const int sf = TABLES.straight[s];
+            return sf >= 0 ? STRAIGHT_FLUSH_BASE + sf : FLUSH_BASE + TABLES.top5[s];
+        }
+    }
+
+    const int all = static_cast<int>(s0 | s1 | s2 | s3);
+    const int quads = static_cast<int>(s0 & s1 & s2 & s3);
+    const int atLeast3 = static_cast<int>((s0 & s1 & s2) | (s0 & s1 & s3) | (s0 & s2 & s3) | (s1 & s2 & s3));
+    const int atLeast2 = static_cast<int>((s0 & s1) | (s0 & s2) | (s0 & s3) | (s1 & s2) | (s1 & s3) | (s2 & s3));
+
+    if (quads) {
+        const int q = TABLES.topBit[quads];
+        const int kicker = TABLES.topBit[all & ~bitOf(q)];
+        return QUADS_BASE + (12 - q) * 12 + kickerIndex(bitOf(kicker), bitOf(q), 12, 1);
+    }
+
+    const int trips = atLeast3;
+    const int pairs = atLeast2 & ~atLeast3;
+    if (trips) {
+        const int t = TABLES.topBit[trips];
+        const int rest = (trips & ~bitOf(t)) | pairs;
+        if (rest) {
+            const int p = TABLES.topBit[rest];
+            return FULL_HOUSE_BASE + (12 - t) * 12 + kickerIndex(bitOf(p), bitOf(t), 12, 1);
+        }
+    }
+
+    const int straight = TABLES.straight[all];
+    if (straight >= 0) return STRAIGHT_BASE + straight;
+
+    if (trips) {
+        const int t = TABLES.topBit[trips];
+        const int kickers = topRanks(all & ~bitOf(t), 2);
+        return TRIPS_BASE + (12 - t) * 66 + kickerIndex(kickers, bitOf(t), 12, 2);
+    }
+    if (TABLES.nBits[pairs] >= 2) {
+        const int twoPair = topRanks(pairs, 2);
+        const int kicker = TABLES.topBit[all & ~twoPair];
+        return TWO_PAIR_BASE + kickerIndex(twoPair, 0, 13, 2) * 11 + kickerIndex(bitOf(kicker), twoPair, 11, 1);
+    }
+    if (pairs) {
+        const int p = TABLES.topBit[pairs];
+        const int kickers = topRanks(all & ~bitOf(p), 3);
+        return PAIR_BASE + (12 - p) * 220 + kickerIndex(kickers, bitOf(p), 12, 3);
+    }
+    return HIGH_CARD_BASE + TABLES.top5[all];
+}
+
+// ================================
+// Block kernels: per-suit rank masks of LANES hands
+// ================================
+// ids[j][lane] is card j of hand `lane`; masks[s][lane] receives the ranks
+// that hand holds in suit s.
+
+#if defined(__AVX2__)
+
+void suitMasks(const int32_t ids[CARDS_PER_HAND][LANES], uint32_t masks[4][LANES]) {
+    const __m256i one = _mm256_set1_epi32(1);
+    const __m256i three = _mm256_set1_epi32(3);
+    __m256i m[4] = {_mm256_setzero_si256(), _mm256_setzero_si256(), _mm256_setzero_si256(), _mm256_setzero_si256()};
+    for (int j = 0; j < CARDS_PER_HAND; ++j) {
+        const __m256i id = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(ids[j]));
+        const __m256i bit = _mm256_sllv_epi32(one, _mm256_srli_epi32(id, 2));
+        const __m256i suit = _mm256_and_si256(id, three);
+        for (int s = 0; s < 4; ++s) {
+            const __m256i inSuit = _mm256_cmpeq_epi32(suit, _mm256_set1_epi32(s));
+            m[s] = _mm256_or_si256(m[s], _mm256_and_si256(bit, inSuit));
+        }
+    }
+    for (int s = 0; s < 4; ++s) {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(masks[s]), m[s]);
+    }
+}
+
+constexpr const char* KERNEL_NAME = "avx2";
+
+#elif defined(__ARM_NEON)
+
+void suitMasks(const int32_t ids[CARDS_PER_HAND][LANES], uint32_t masks[4][LANES]) {
+    const uint32x4_t one = vdupq_n_u32(1);
+    const uint32x4_t three = vdupq_n_u32(3);
+    for (int half = 0; half < LANES; half += 4) {
+        uint32x4_t m[4] = {vdupq_n_u32(0), vdupq_n_u32(0), vdupq_n_u32(0), vdupq_n_u32(0)};
+        for (int j = 0; j < CARDS_PER_HAND; ++j) {
+            const uint32x4_t id = vreinterpretq_u32_s32(vld1q_s32(ids[j] + half));
+            const uint32x4_t bit = vshlq_u32(one, vreinterpretq_s32_u32(vshrq_n_u32(id, 2)));
+            const uint32x4_t suit = vandq_u32(id, three);
+            for (int s = 0; s < 4; ++s) {
+                const uint32x4_t inSuit = vceqq_u32(suit, vdupq_n_u32(static_cast<uint32_t>(s)));
+                m[s] = vorrq_u32(m[s], vandq_u32(bit, inSuit));
+            }
+        }
+        for (int s = 0; s < 4; ++s) vst1q_u32(masks[s] + half, m[s]);
+    }
+}
+
+constexpr const char* KERNEL_NAME = "neon";
+
+#else
+
+void suitMasks(const int32_t ids[CARDS_PER_HAND][LANES], uint32_t masks[4][LANES]) {
+    for (int s = 0; s < 4; ++s) {
+        for (int lane = 0; lane < LANES; ++lane) masks[s][lane] = 0;
+    }
+    for (int j = 0; j < CARDS_PER_HAND; ++j) {
+        for (int lane = 0; lane < LANES; ++lane) {
+            const int32_t id = ids[j][lane];
+            masks[id & 3][lane] |= 1u << (id >> 2);
+        }
+    }
+}
+
+constexpr const char* KERNEL_NAME = "scalar";
+
+#endif
+
+// Ranks hands [0, n) of a block, n <= LANES. Unused lanes are padded with
+// a valid hand and their ranks dropped.
+void evaluateBlock(const CardId* cards, int n, int32_t* ranks) {
+    alignas(32) int32_t ids[CARDS_PER_HAND][LANES];
+    alignas(32) uint32_t masks[4][LANES];
+    for (int lane = 0; lane < LANES; ++lane) {
+        const CardId* hand = cards + static_cast<size_t>(lane < n ? lane : 0) * CARDS_PER_HAND;
+        for (int j = 0; j < CARDS_PER_HAND; ++j) ids[j][lane] = hand[j];
+    }
+    suitMasks(ids, masks);
+    for (int lane = 0; lane < n; ++lane) {
+        ranks[lane] = rankFromMasks(masks[0][lane], masks[1][lane], masks[2][lane], masks[3][lane]);
+    }
+}
+
+} // namespace
+
+void evaluate7(const CardId* cards, size_t nHands, int32_t* ranks) {
+    for (size_t i = 0; i < nHands; i += LANES) {
+        const int n = nHands - i < static_cast<size_t>(LANES) ? static_cast<int>(nHands - i) : LANES;
+        evaluateBlock(cards + i * CARDS_PER_HAND, n, ranks + i);
+    }
+}
+
+int32_t evaluate7(const CardId cards[CARDS_PER_HAND]) {
+    uint32_t masks[4] = {0, 0, 0, 0};
+    for (int j = 0; j < CARDS_PER_HAND; ++j) {
+        masks[cardIdSuit(cards[j])] |= 1u << cardIdValue(cards[j]);
+    }
+    return rankFromMasks(masks[0], masks[1], masks[2], masks[3]);
+}
+
+const char* kernelName() { return KERNEL_NAME; }
+
+} // namespace HandEvalBatch
@@ -0,0 +1,35 @@
+#ifndef HAND_EVAL_BATCH_H
+#define HAND_EVAL_BATCH_H
+
+#include "CardId.h"
+
+#include <cstddef>
+#include <cstdint>
+
+// ================================
+// Batched 7-card evaluator
+// ================================
+// Evaluates many 7-card hands per call and returns the same ranks as
+// phevaluator's evaluate_7cards (1 = royal flush ... 7462 = worst high card,
+// Cactus Kev equivalence classes). Hands are processed in blocks of LANES:
+// the per-suit rank masks and pair/trips/quads bit sets of a block are built
+// with AVX2 or NEON when the compiler targets them (scalar otherwise), and
+// each lane is then ranked from those masks with a few 8192-entry tables.
+namespace HandEvalBatch {
+
+constexpr int LANES = 8;
+constexpr int CARDS_PER_HAND = 7;
+
+// cards is [nHands][CARDS_PER_HAND] card ids; every hand must hold 7 distinct
+// valid ids. ranks receives nHands values.
+void evaluate7(const CardId* cards, size_t nHands, int32_t* ranks);
+
+// One hand, same result as evaluate7 on it.
+int32_t evaluate7(const CardId cards[CARDS_PER_HAND]);
+
+// "avx2", "neon" or "scalar": the block kernel this build uses.
+const char* kernelName();
+
+} // namespace HandEvalBatch
+
+#endif // HAND_EVAL_BATCH_H
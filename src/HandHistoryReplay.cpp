@@ -0,0 +1,412 @@
+#include "HandHistoryReplay.h"
+#include "CardParse.h"
+#include "ObservationLayout.h"
+#include "PokerLog.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <string_view>
+
+namespace {
+
+constexpr const char* STREET_KEYS[] = {"preflop", "flop", "turn", "river"};
+
+bool parseCardJson(const nlohmann::json& j, CardId& out) {
+    if (!j.is_string()) return false;
+    const std::string& s = j.get_ref<const std::string&>();
+    return CardParse::parseCard(std::string_view(s), out) == CardParse::Status::Ok;
+}
+
+bool parseActionType(const std::string& name, int& type) {
+    if (name == "fold") {
+        type = FOLD;
+    } else if (name == "check" || name == "call") {
+        type = CHECK_CALL;
+    } else if (name == "raise" || name == "bet") {
+        type = BET_RAISE;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+HandHistoryReplay::HandHistoryReplay(const std::string& path,
+                                     const nlohmann::json& config,
+                                     int nSeats,
+                                     const std::vector<float>& bet_sizes_as_frac_of_pot,
+                                     bool uniform_action_interpolation,
+                                     int smallBlind,
+                                     int bigBlind,
+                                     int ante,
+                                     int defaultStackSize,
+                                     int batchSize,
+                                     int maxSequenceLength,
+                                     size_t queueCapacity)
+    : env_(new PokerEnv(config, nSeats, bet_sizes_as_frac_of_pot, uniform_action_interpolation,
+                        smallBlind, bigBlind, ante, defaultStackSize)),
+      nSeats_(nSeats),
+      nActions_(2 + static_cast<int>(bet_sizes_as_frac_of_pot.size())),
+      maxSeqLen_(maxSequenceLength),
+      stateDim_(static_cast<int>(ObservationLayout::stateDim(nSeats))),
+      actionDim_(static_cast<int>(ObservationLayout::rowDim(nSeats, 2 + static_cast<int>(bet_sizes_as_frac_of_pot.size())))),
+      batchSize_(batchSize > 0 ? static_cast<size_t>(batchSize) : 0),
+      queue_(queueCapacity)
+{
+    if (batchSize <= 0) {
+        throw std::invalid_argument("HandHistoryReplay: batchSize must be positive, got " + std::to_string(batchSize));
+    }
+    if (maxSequenceLength <= 0) {
+        throw std::invalid_argument("HandHistoryReplay: maxSequenceLength must be positive, got " +
+                                    std::to_string(maxSequenceLength));
+    }
+    file_.open(path, std::ios::binary);
+    if (!file_) {
+        throw std::runtime_error("HandHistoryReplay: cannot open " + path);
+    }
+    _grow(batchSize_);
+    reader_ = std::thread(&HandHistoryReplay::_readerLoop, this);
+}
+
+HandHistoryReplay::~HandHistoryReplay() {
+    stop_.store(true, std::memory_order_relaxed);
+    if (reader_.joinable()) reader_.join();
+}
+
+// ================================
+// Reader thread
+// ================================
+
+// Cuts complete top-level objects out of the byte stream: a '{' at depth 0
+// opens one, its matching '}' closes it, braces inside strings don't count.
+// Everything between objects ('[', ',', ']', newlines) is skipped, which
+// covers both a JSON array and JSON Lines. Only the unfinished object is
+// kept across chunks.
+void HandHistoryReplay::_readerLoop() {
+    try {
+        std::string buf;
+        size_t scan = 0;
+        size_t objStart = std::string::npos;
+        int depth = 0;
+        bool inString = false;
+        bool escaped = false;
+        while (!stop_.load(std::memory_order_relaxed)) {
+            const size_t old = buf.size();
+            buf.resize(old + READ_CHUNK_BYTES);
+            file_.read(&buf[old], static_cast<std::streamsize>(READ_CHUNK_BYTES));
+            const size_t got = static_cast<size_t>(file_.gcount());
+            buf.resize(old + got);
+            if (got == 0) break;
+            bytesRead_.fetch_add(got, std::memory_order_relaxed);
+
+            for (; scan < buf.size(); ++scan) {
+                const char c = buf[scan];
+                if (inString) {
+                    if (escaped) escaped = false;
+                    else if (c == '\\') escaped = true;
+                    else if (c == '"') inString = false;
+                } else if (c == '"') {
+                    inString = depth > 0;
+                } else if (c == '{') {
+                    if (depth++ == 0) objStart = scan;
+                } else if (c == '}' && depth > 0) {
+                    if (--depth == 0) {
+                        _emitObject(buf.data() + objStart, buf.data() + scan + 1);
+                        objStart = std::string::npos;
+                        if (stop_.load(std::memory_order_relaxed)) break;
+                    }
+                }
+            }
+
+            const size_t consumed = objStart == std::string::npos ? scan : objStart;
+            buf.erase(0, consumed);
+            scan -= consumed;
+            if (objStart != std::string::npos) objStart = 0;
+        }
+        if (depth > 0 && !stop_.load(std::memory_order_relaxed)) {
+            parseErrors_.fetch_add(1, std::memory_order_relaxed); // truncated last hand
+        }
+    } catch (const std::exception& e) {
+        POKER_LOG_ERROR("HandHistoryReplay: reader stopped: " << e.what());
+    }
+    readerDone_.store(true, std::memory_order_release);
+}
+
+void HandHistoryReplay::_emitObject(const char* begin, const char* end) {
+    const int ordinal = nextOrdinal_++;
+    Hand hand;
+    std::string error;
+    try {
+        const nlohmann::json j = nlohmann::json::parse(begin, end);
+        if (!parseHand(j, hand, error)) {
+            POKER_LOG_WARN("HandHistoryReplay: hand " << ordinal << " skipped: " << error);
+            parseErrors_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+    } catch (const nlohmann::json::exception& e) {
+        POKER_LOG_WARN("HandHistoryReplay: hand " << ordinal << " is not valid JSON: " << e.what());
+        parseErrors_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    hand.ordinal = ordinal;
+    handsRead_.fetch_add(1, std::memory_order_relaxed);
+
+    while (!queue_.try_push(std::move(hand))) {
+        if (stop_.load(std::memory_order_relaxed)) return;
+        std::this_thread::yield();
+    }
+}
+
+bool HandHistoryReplay::parseHand(const nlohmann::json& j, Hand& out, std::string& error) {
+    if (!j.is_object() || !j.contains("private_cards") || !j["private_cards"].is_array() ||
+        !j.contains("actions") || !j["actions"].is_object()) {
+        error = "missing private_cards or actions";
+        return false;
+    }
+
+    const auto& privateCards = j["private_cards"];
+    out.nSeats = static_cast<int>(privateCards.size());
+    out.button = j.value("button", 0);
+    if (out.nSeats < 2 || out.button < 0 || out.button >= out.nSeats) {
+        error = "bad seat count or button";
+        return false;
+    }
+
+    out.holeCards.assign(out.nSeats, std::vector<int>(N_HOLE_CARDS, -1));
+    for (int i = 0; i < out.nSeats; ++i) {
+        const auto& hole = privateCards[i];
+        if (!hole.is_array() || hole.size() != N_HOLE_CARDS) {
+            error = "seat " + std::to_string(i) + " does not have two hole cards";
+            return false;
+        }
+        for (int k = 0; k < N_HOLE_CARDS; ++k) {
+            CardId id;
+            if (!parseCardJson(hole[k], id)) {
+                error = "bad hole card for seat " + std::to_string(i);
+                return false;
+            }
+            out.holeCards[i][k] = id;
+        }
+    }
+
+    // "public_cards": {"flop": [3], "turn": "x", "river": "y"}, streets optional
+    out.nBoard = 0;
+    if (j.contains("public_cards") && j["public_cards"].is_object()) {
+        const auto& pub = j["public_cards"];
+        if (pub.contains("flop")) {
+            const auto& flop = pub["flop"];
+            if (!flop.is_array() || flop.size() != N_FLOP_CARDS) {
+                error = "flop is not three cards";
+                return false;
+            }
+            for (const auto& c : flop) {
+                if (!parseCardJson(c, out.board[out.nBoard++])) {
+                    error = "bad flop card";
+                    return false;
+                }
+            }
+            for (const char* street : {"turn", "river"}) {
+                if (!pub.contains(street)) break;
+                if (!parseCardJson(pub[street], out.board[out.nBoard++])) {
+                    error = std::string("bad ") + street + " card";
+                    return false;
+                }
+            }
+        }
+    }
+
+    // Object keys come back sorted, so walk the streets in game order.
+    out.actions.clear();
+    const auto& actions = j["actions"];
+    for (int round = PREFLOP; round <= RIVER; ++round) {
+        if (!actions.contains(STREET_KEYS[round])) continue;
+        for (const auto& a : actions[STREET_KEYS[round]]) {
+            Action action;
+            action.round = round;
+            action.player = a.value("player", -1);
+            if (!a.contains("action") || !a["action"].is_string() ||
+                !parseActionType(a["action"].get_ref<const std::string&>(), action.type)) {
+                error = "unknown action on " + std::string(STREET_KEYS[round]);
+                return false;
+            }
+            if (action.player < 0 || action.player >= out.nSeats) {
+                error = "action by seat " + std::to_string(action.player);
+                return false;
+            }
+            action.amount = action.type == BET_RAISE ? static_cast<int>(std::lround(a.value("amount", 0.0))) : 0;
+            out.actions.push_back(action);
+        }
+    }
+    if (out.actions.empty()) {
+        error = "no actions";
+        return false;
+    }
+
+    out.rewards.assign(out.nSeats, 0.0);
+    if (j.contains("rewards") && j["rewards"].is_array()) {
+        for (int i = 0; i < out.nSeats && i < static_cast<int>(j["rewards"].size()); ++i) {
+            out.rewards[i] = j["rewards"][i].get<double>();
+        }
+    }
+    return true;
+}
+
+// ================================
+// Replay (calling thread)
+// ================================
+
+bool HandHistoryReplay::_popHand(Hand& out) {
+    for (;;) {
+        if (queue_.try_pop(out)) return true;
+        // Done is published after the last push, so one more pop sees it.
+        if (readerDone_.load(std::memory_order_acquire)) return queue_.try_pop(out);
+        std::this_thread::yield();
+    }
+}
+
+bool HandHistoryReplay::finished() const {
+    return !hasPending_ && readerDone_.load(std::memory_order_acquire) && queue_.empty();
+}
+
+size_t HandHistoryReplay::next_batch() {
+    rows_ = 0;
+    Hand hand;
+    for (;;) {
+        if (hasPending_) {
+            hand = std::move(pending_);
+            hasPending_ = false;
+        } else if (!_popHand(hand)) {
+            break;
+        }
+
+        const size_t needed = hand.actions.size();
+        if (rows_ > 0 && rows_ + needed > batchSize_) {
+            pending_ = std::move(hand);
+            hasPending_ = true;
+            break;
+        }
+        if (rows_ + needed > capacity_) _grow(rows_ + needed);
+        _replayHand(hand);
+        if (rows_ >= batchSize_) break;
+    }
+    return rows_;
+}
+
+bool HandHistoryReplay::_replayHand(const Hand& hand) {
+    if (hand.nSeats != nSeats_) {
+        ++handsRejected_;
+        return false;
+    }
+
+    const size_t firstRow = rows_;
+    bool ok = true;
+    bool done = false;
+    std::vector<float> finalRewards;
+    try {
+        env_->reset_for_replay(hand.button, hand.holeCards, hand.board, hand.nBoard);
+        for (const Action& action : hand.actions) {
+            if (done || env_->getCurrentRound() != action.round || env_->getCurrentPlayer() != action.player) {
+                ok = false;
+                break;
+            }
+            _writeRow(rows_, hand.ordinal);
+
+            // Log amounts are on top of the bet to call; step() takes the total bet.
+            const int toCall = env_->getCurrentBet();
+            float amount = -1.0f;
+            if (action.type == CHECK_CALL) amount = static_cast<float>(toCall);
+            if (action.type == BET_RAISE) amount = static_cast<float>(toCall + action.amount);
+
+            const size_t nRecorded = env_->getActionHistory().size();
+            auto result = env_->step(action.type, amount);
+            const auto& history = env_->getActionHistory();
+            actionBuf[rows_] = history.size() > nRecorded ? history.back().actionInt : -1;
+            ++rows_;
+
+            done = std::get<3>(result);
+            if (done) finalRewards = std::move(std::get<2>(result));
+        }
+        ok = ok && done;
+    } catch (const std::exception& e) {
+        POKER_LOG_DEBUG("HandHistoryReplay: hand " << hand.ordinal << " rejected: " << e.what());
+        ok = false;
+    }
+
+    if (!ok) {
+        rows_ = firstRow;
+        ++handsRejected_;
+        return false;
+    }
+
+    const float scalar = env_->getRewardScalar();
+    for (int i = 0; i < nSeats_ && i < static_cast<int>(finalRewards.size()); ++i) {
+        if (std::abs(static_cast<double>(finalRewards[i]) * scalar - hand.rewards[i]) > 0.5) {
+            ++rewardMismatches_;
+            break;
+        }
+    }
+    ++handsReplayed_;
+    rowsTotal_ += rows_ - firstRow;
+    return true;
+}
+
+// Observation and mask of the decision the env is at, into row `row`.
+void HandHistoryReplay::_writeRow(size_t row, int handOrdinal) {
+    env_->write_transformer_state(stateBuf.data() + row * stateDim_, static_cast<size_t>(stateDim_));
+
+    // 序列超过 maxSeqLen 时保留最近的动作（与 PokerEnvBatch 相同）
+    float* seqBlock = seqBuf.data() + row * maxSeqLen_ * actionDim_;
+    const size_t seqCap = static_cast<size_t>(maxSeqLen_) * actionDim_;
+    const size_t len = env_->write_transformer_sequence(seqBlock, seqCap);
+    std::fill(seqBlock + len * actionDim_, seqBlock + seqCap, 0.0f);
+    seqLenBuf[row] = static_cast<int32_t>(len);
+
+    float* maskRow = maskBuf.data() + row * nActions_;
+    std::fill(maskRow, maskRow + nActions_, 0.0f);
+    const LegalActionSet& legal = env_->legalActionSet();
+    for (int k = 0; k < legal.count; ++k) {
+        if (legal.actions[k] >= 0 && legal.actions[k] < nActions_) maskRow[legal.actions[k]] = 1.0f;
+    }
+
+    playerBuf[row] = env_->getCurrentPlayer();
+    handBuf[row] = handOrdinal;
+}
+
+void HandHistoryReplay::_grow(size_t rows) {
+    capacity_ = rows;
+    stateBuf.resize(rows * stateDim_, 0.0f);
+    seqBuf.resize(rows * maxSeqLen_ * actionDim_, 0.0f);
+    seqLenBuf.resize(rows, 0);
+    maskBuf.resize(rows * nActions_, 0.0f);
+    actionBuf.resize(rows, -1);
+    playerBuf.resize(rows, -1);
+    handBuf.resize(rows, -1);
+}
+
+HandHistoryReplay::Stats HandHistoryReplay::stats() const {
+    Stats s;
+    s.handsRead = handsRead_.load(std::memory_order_relaxed);
+    s.parseErrors = parseErrors_.load(std::memory_order_relaxed);
+    s.bytesRead = bytesRead_.load(std::memory_order_relaxed);
+    s.handsReplayed = handsReplayed_;
+    s.handsRejected = handsRejected_;
+    s.rewardMismatches = rewardMismatches_;
+    s.rows = rowsTotal_;
+    return s;
+}
+
+std::map<std::string, double> HandHistoryReplay::stats_py() const {
+    const Stats s = stats();
+    return {
+        {"hands_read", static_cast<double>(s.handsRead)},
+        {"parse_errors", static_cast<double>(s.parseErrors)},
+        {"hands_replayed", static_cast<double>(s.handsReplayed)},
+        {"hands_rejected", static_cast<double>(s.handsRejected)},
+        {"reward_mismatches", static_cast<double>(s.rewardMismatches)},
+        {"rows", static_cast<double>(s.rows)},
+        {"bytes_read", static_cast<double>(s.bytesRead)},
+        {"finished", finished() ? 1.0 : 0.0},
+    };
+}
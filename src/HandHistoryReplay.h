@@ -0,0 +1,189 @@
+#ifndef HAND_HISTORY_REPLAY_H
+#define HAND_HISTORY_REPLAY_H
+
+#include "PokerEnv_notorch.h"
+#include "CardId.h"
+#include "SpscQueue.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+// ================================
+// HandHistoryReplay
+// ================================
+// Streams a Pluribus-style hand-history file (tests/test_files/pluribus_logs.json
+// layout: "button", "private_cards", "public_cards", "actions" per street,
+// "rewards") through a PokerEnv and turns every recorded decision into a
+// training row: the transformer observation before the action, the legal
+// action mask, and the discrete action index the env records for it
+// (_mapActionToFixedIndex).
+//
+// A reader thread reads the file in fixed-size chunks, cuts out one hand
+// object at a time (a top-level JSON array or one object per line both
+// work), parses it and hands it over through an SpscQueue; the file is never
+// held in memory as a whole. next_batch() on the calling thread replays hands
+// from the queue into the row buffers below. Hands are never split across
+// batches; one with more decisions than batchSize grows the buffers.
+//
+// Buffers (B = rows of the last batch, at most capacity()):
+//   state features    float [B x (2 * N_SEATS + 2)]
+//   sequence features float [B x maxSeqLen x (N_SEATS + N_ACTIONS + 1)], zero padded
+//   sequence lengths  int32 [B]
+//   legal masks       float [B x N_ACTIONS]
+//   actions           int32 [B]   action index recorded for the logged action
+//   players           int32 [B]   acting seat
+//   hands             int32 [B]   ordinal of the hand in the file (0-based)
+//
+// Log amounts are raise-by amounts on top of the bet to call. A hand the env
+// plays differently (other seat to act or street, hand over early or not
+// over at the end, an action the env rejects, a different player count) is
+// dropped with all its rows and counted in stats. Chip results deviating
+// from the log by more than half a chip are counted but kept. For the
+// Pluribus logs the env should be built with blinds 50/100 and 10000 stacks.
+class HandHistoryReplay {
+public:
+    static constexpr int DEFAULT_BATCH_SIZE = 4096;
+    static constexpr int DEFAULT_MAX_SEQUENCE_LENGTH = 25;
+    static constexpr size_t DEFAULT_QUEUE_CAPACITY = 1024;
+    static constexpr size_t READ_CHUNK_BYTES = 1 << 20;
+
+    struct Action {
+        int round;   // PREFLOP .. RIVER
+        int player;
+        int type;    // FOLD / CHECK_CALL / BET_RAISE
+        int amount;  // raise-by amount for BET_RAISE, else 0
+    };
+
+    struct Hand {
+        int ordinal = -1;
+        int nSeats = 0;
+        int button = 0;
+        std::vector<std::vector<int>> holeCards; // [nSeats][2] card ids
+        CardId board[N_COMMUNITY_CARDS] = {};
+        int nBoard = 0;
+        std::vector<Action> actions;
+        std::vector<double> rewards;             // chips, per seat
+    };
+
+    struct Stats {
+        uint64_t handsRead = 0;        // parsed by the reader thread
+        uint64_t parseErrors = 0;      // objects that were not a valid hand
+        uint64_t handsReplayed = 0;
+        uint64_t handsRejected = 0;
+        uint64_t rewardMismatches = 0;
+        uint64_t rows = 0;
+        uint64_t bytesRead = 0;
+    };
+
+    HandHistoryReplay(const std::string& path,
+                      const nlohmann::json& config,
+                      int nSeats,
+                      const std::vector<float>& bet_sizes_as_frac_of_pot,
+                      bool uniform_action_interpolation,
+                      int smallBlind,
+                      int bigBlind,
+                      int ante,
+                      int defaultStackSize,
+                      int batchSize = DEFAULT_BATCH_SIZE,
+                      int maxSequenceLength = DEFAULT_MAX_SEQUENCE_LENGTH,
+                      size_t queueCapacity = DEFAULT_QUEUE_CAPACITY);
+    ~HandHistoryReplay();
+
+    HandHistoryReplay(const HandHistoryReplay&) = delete;
+    HandHistoryReplay& operator=(const HandHistoryReplay&) = delete;
+
+    // Replays whole hands until the next one would not fit in batchSize rows
+    // and returns the number of rows written; 0 once the file is exhausted.
+    size_t next_batch();
+    bool finished() const;
+    Stats stats() const;
+
+    // Parses one hand object; false (with a reason) if it is not a usable hand.
+    static bool parseHand(const nlohmann::json& j, Hand& out, std::string& error);
+
+    int numSeats() const { return nSeats_; }
+    int numActions() const { return nActions_; }
+    int maxSequenceLength() const { return maxSeqLen_; }
+    int stateDim() const { return stateDim_; }
+    int actionFeatureDim() const { return actionDim_; }
+    size_t batchSize() const { return batchSize_; }
+    size_t capacity() const { return capacity_; }
+    size_t rows() const { return rows_; }
+    PokerEnv& env() { return *env_; }
+
+    const float* stateFeatures() const { return stateBuf.data(); }
+    const float* sequenceFeatures() const { return seqBuf.data(); }
+    const int32_t* sequenceLengths() const { return seqLenBuf.data(); }
+    const float* legalActionMasks() const { return maskBuf.data(); }
+    const int32_t* actions() const { return actionBuf.data(); }
+    const int32_t* players() const { return playerBuf.data(); }
+    const int32_t* hands() const { return handBuf.data(); }
+
+    // --- Python-facing helpers ---
+    // Addresses stay valid until a batch grows the buffers (capacity()
+    // changes), so re-read them when capacity_py() differs.
+    size_t next_batch_py() { return next_batch(); }
+    size_t capacity_py() const { return capacity_; }
+    std::map<std::string, double> stats_py() const;
+    uintptr_t stateFeatures_address_py() const { return reinterpret_cast<uintptr_t>(stateBuf.data()); }
+    uintptr_t sequenceFeatures_address_py() const { return reinterpret_cast<uintptr_t>(seqBuf.data()); }
+    uintptr_t sequenceLengths_address_py() const { return reinterpret_cast<uintptr_t>(seqLenBuf.data()); }
+    uintptr_t legalActionMasks_address_py() const { return reinterpret_cast<uintptr_t>(maskBuf.data()); }
+    uintptr_t actions_address_py() const { return reinterpret_cast<uintptr_t>(actionBuf.data()); }
+    uintptr_t players_address_py() const { return reinterpret_cast<uintptr_t>(playerBuf.data()); }
+    uintptr_t hands_address_py() const { return reinterpret_cast<uintptr_t>(handBuf.data()); }
+
+private:
+    void _readerLoop();
+    void _emitObject(const char* begin, const char* end);
+    bool _popHand(Hand& out);
+    bool _replayHand(const Hand& hand);
+    void _writeRow(size_t row, int handOrdinal);
+    void _grow(size_t rows);
+
+    std::unique_ptr<PokerEnv> env_;
+    int nSeats_;
+    int nActions_;
+    int maxSeqLen_;
+    int stateDim_;
+    int actionDim_;
+    size_t batchSize_;
+    size_t capacity_ = 0;
+    size_t rows_ = 0;
+
+    std::vector<float> stateBuf;
+    std::vector<float> seqBuf;
+    std::vector<int32_t> seqLenBuf;
+    std::vector<float> maskBuf;
+    std::vector<int32_t> actionBuf;
+    std::vector<int32_t> playerBuf;
+    std::vector<int32_t> handBuf;
+
+    // Reader side.
+    std::ifstream file_;
+    SpscQueue<Hand> queue_;
+    std::thread reader_;
+    std::atomic<bool> stop_{false};
+    std::atomic<bool> readerDone_{false};
+    std::atomic<uint64_t> handsRead_{0};
+    std::atomic<uint64_t> parseErrors_{0};
+    std::atomic<uint64_t> bytesRead_{0};
+    int nextOrdinal_ = 0;
+
+    // Consumer side.
+    Hand pending_;
+    bool hasPending_ = false;
+    uint64_t handsReplayed_ = 0;
+    uint64_t handsRejected_ = 0;
+    uint64_t rewardMismatches_ = 0;
+    uint64_t rowsTotal_ = 0;
+};
+
+#endif // HAND_HISTORY_REPLAY_H
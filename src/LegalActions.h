@@ -0,0 +1,76 @@
+#ifndef LEGAL_ACTIONS_H
+#define LEGAL_ACTIONS_H
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+// ================================
+// Resolved action
+// ================================
+// An action as the env plays it: FOLD / CHECK_CALL / BET_RAISE and, for the
+// latter two, the player's total bet after the action in whole chips (-1 for
+// FOLD). Passed by value through formulation, validation and step().
+struct ResolvedAction {
+    uint8_t type;
+    int32_t amount;
+};
+
+// Action types are FOLD = 0, CHECK_CALL = 1, BET_RAISE = 2 (PokerEnv_notorch.h).
+constexpr int N_RESOLVED_ACTION_TYPES = 3;
+
+// Throws std::invalid_argument for a type outside FOLD..BET_RAISE (it would
+// otherwise be narrowed into one, e.g. 258 into BET_RAISE).
+inline ResolvedAction makeResolvedAction(int type, int amount) {
+    if (type < 0 || type >= N_RESOLVED_ACTION_TYPES) {
+        throw std::invalid_argument("makeResolvedAction: unknown action type " + std::to_string(type));
+    }
+    return ResolvedAction{static_cast<uint8_t>(type), static_cast<int32_t>(amount)};
+}
+
+inline bool operator==(ResolvedAction a, ResolvedAction b) { return a.type == b.type && a.amount == b.amount; }
+inline bool operator!=(ResolvedAction a, ResolvedAction b) { return !(a == b); }
+
+// ================================
+// Legal actions of one decision point
+// ================================
+// Computed once per decision point (PokerEnv::legalActionSet()) and shared by
+// the legal action mask, the raise-amount block of the observation and the
+// discrete step(actionInt). The env drops it whenever its state changes: a new
+// observation is recorded (step/reset), a state is loaded or copied in, or the
+// RNG is reseeded.
+//
+// With uniformActionInterpolation the raise amount of a bet size is sampled;
+// the sample drawn while building the set is the one step(actionInt) plays, so
+// the mask, the observation and the step agree on it.
+struct LegalActionSet {
+    // FOLD, CHECK_CALL and up to 30 bet sizes.
+    static constexpr int MAX_ACTIONS = 32;
+
+    bool valid = false;
+
+    // Legal action ints in ascending order.
+    int count = 0;
+    int actions[MAX_ACTIONS];
+
+    // What _resolveAction() made of action int a, for a < nResolved. Action
+    // ints past the point where the raise scan stopped are not resolved.
+    int nResolved = 0;
+    ResolvedAction resolved[MAX_ACTIONS];
+
+    bool contains(int a) const {
+        for (int i = 0; i < count; ++i) {
+            if (actions[i] == a) return true;
+        }
+        return false;
+    }
+    bool isResolved(int a) const { return a >= 0 && a < nResolved; }
+
+    void clear() {
+        valid = false;
+        count = 0;
+        nResolved = 0;
+    }
+};
+
+#endif // LEGAL_ACTIONS_H
@@ -0,0 +1,130 @@
+#ifndef OBSERVATION_LAYOUT_H
+#define OBSERVATION_LAYOUT_H
+
+#include <cstddef>
+
+// ================================
+// Observation layouts
+// ================================
+// Fixed float layouts written by the PokerEnv::write_*() methods and returned,
+// element for element, by the vector-returning observation functions. Every
+// size/offset depends only on the table configuration (nSeats, nActions =
+// 2 + bet sizes), so a consumer can allocate one buffer per table up front and
+// index it with the *Offset() / *Dim() functions below; the layout comments
+// name those functions. All offsets are in floats.
+//
+// "Relative position" below always means (seat - buttonPos + nSeats) % nSeats,
+// i.e. 0 = button.
+namespace ObservationLayout {
+
+// --------------------------------
+// Transformer state (write_transformer_state / getObservationForTransformer()<1>)
+// --------------------------------
+//   [stateCurrentPlayerOffset, +nSeats)  current player, one-hot by relative position
+//   [stateStacksOffset,        +nSeats)  (stack + currentBet) / DEFAULT_STACK_SIZE per absolute seat
+//   stateEffectiveStackOffset            effective stack / pot (pot 0 -> BIG_BLIND)
+//   statePlayersToActOffset              players still able to act after the current one / (nSeats - 1)
+constexpr size_t stateCurrentPlayerOffset(int)  { return 0; }
+constexpr size_t stateStacksOffset(int nSeats)   { return static_cast<size_t>(nSeats); }
+constexpr size_t stateEffectiveStackOffset(int nSeats) { return 2 * static_cast<size_t>(nSeats); }
+constexpr size_t statePlayersToActOffset(int nSeats)   { return 2 * static_cast<size_t>(nSeats) + 1; }
+constexpr size_t stateDim(int nSeats)                  { return 2 * static_cast<size_t>(nSeats) + 2; }
+
+// --------------------------------
+// Action row (write_transformer_sequence, one row per ActionRecord, oldest first)
+// --------------------------------
+//   [rowPlayerOffset, +nSeats)    acting player, one-hot by relative position
+//   [rowActionOffset, +nActions)  recorded actionInt, one-hot
+//   rowBetOffset                  betAmount / potAtActionTime (pot 0 -> BIG_BLIND)
+constexpr size_t rowPlayerOffset(int, int)           { return 0; }
+constexpr size_t rowActionOffset(int nSeats, int)    { return static_cast<size_t>(nSeats); }
+constexpr size_t rowBetOffset(int nSeats, int nActions) { return static_cast<size_t>(nSeats) + nActions; }
+constexpr size_t rowDim(int nSeats, int nActions)       { return static_cast<size_t>(nSeats) + nActions + 1; }
+
+// --------------------------------
+// Full observation (_calculateCurrentObservation, use_simplified_observation == false)
+// --------------------------------
+// Amounts are divided by BIG_BLIND unless noted; stack-like values by DEFAULT_STACK_SIZE.
+//   fullTableOffset           FULL_TABLE_DIM (7): ante, sb, bb, min raise, pot, current bet,
+//                             last raise amount
+//   fullLastActionTypeOffset  one-hot FOLD / CHECK_CALL / BET_RAISE (FULL_LAST_ACTION_TYPE_DIM)
+//   fullLastActorOffset       one-hot relative position (nSeats)
+//   fullCurrentPlayerOffset   one-hot relative position (nSeats)
+//   fullRoundOffset           one-hot PREFLOP..RIVER (FULL_ROUND_DIM)
+//   fullButtonOffset          one-hot absolute seat (nSeats)
+//   fullCountsOffset          FULL_COUNTS_DIM (2): active players / nSeats, raises this round / nSeats
+//   fullSidePotsOffset        fullSidePotsDim() entries: nSeats when nSeats > 2, else none
+//   fullPlayersOffset         nSeats blocks of fullPlayerBlockDim():
+//                               stack, currentBet, hasActed, totalInvested, relative position / (nSeats - 1),
+//                               investedThisRound, then
+//                               heads-up:   isAllin
+//                               multi-way:  folded, isAllin, side-pot rank one-hot (nSeats)
+//   fullBoardOffset           FULL_BOARD_CARDS x FULL_BOARD_CARD_DIM (13 rank one-hot + 4 canonical suit one-hot)
+//   fullRaiseAmountsOffset    nActions - 2 total bet sizes / DEFAULT_STACK_SIZE, -1 when not legal
+//   fullAdvancedOffset        FULL_ADVANCED_DIM (10): pot odds, effective stack, position strength,
+//                             aggression, investment ratio, hand progress, folded / allin / active
+//                             fractions, side-pot complexity
+constexpr size_t FULL_TABLE_DIM = 7;
+constexpr size_t FULL_LAST_ACTION_TYPE_DIM = 3;
+constexpr size_t FULL_ROUND_DIM = 4;
+constexpr size_t FULL_COUNTS_DIM = 2;
+constexpr size_t FULL_BOARD_CARD_DIM = 13 + 4;
+constexpr size_t FULL_BOARD_CARDS = 5;
+constexpr size_t FULL_ADVANCED_DIM = 10;
+
+constexpr size_t fullTableOffset(int) { return 0; }
+constexpr size_t fullLastActionTypeOffset(int) { return FULL_TABLE_DIM; }
+constexpr size_t fullLastActorOffset(int) { return FULL_TABLE_DIM + FULL_LAST_ACTION_TYPE_DIM; }
+constexpr size_t fullCurrentPlayerOffset(int nSeats) { return fullLastActorOffset(nSeats) + nSeats; }
+constexpr size_t fullRoundOffset(int nSeats) { return fullCurrentPlayerOffset(nSeats) + nSeats; }
+constexpr size_t fullButtonOffset(int nSeats) { return fullRoundOffset(nSeats) + FULL_ROUND_DIM; }
+constexpr size_t fullCountsOffset(int nSeats) { return fullButtonOffset(nSeats) + nSeats; }
+constexpr size_t fullSidePotsDim(int nSeats) { return nSeats > 2 ? static_cast<size_t>(nSeats) : 0; }
+constexpr size_t fullSidePotsOffset(int nSeats) { return fullCountsOffset(nSeats) + FULL_COUNTS_DIM; }
+constexpr size_t fullPlayerBlockDim(int nSeats) {
+    return 6 + (nSeats == 2 ? 1 : 2 + static_cast<size_t>(nSeats));
+}
+constexpr size_t fullPlayersOffset(int nSeats) { return fullSidePotsOffset(nSeats) + fullSidePotsDim(nSeats); }
+constexpr size_t fullBoardOffset(int nSeats) {
+    return fullPlayersOffset(nSeats) + static_cast<size_t>(nSeats) * fullPlayerBlockDim(nSeats);
+}
+constexpr size_t fullRaiseAmountsOffset(int nSeats) {
+    return fullBoardOffset(nSeats) + FULL_BOARD_CARDS * FULL_BOARD_CARD_DIM;
+}
+constexpr size_t fullAdvancedOffset(int nSeats, int nActions) {
+    return fullRaiseAmountsOffset(nSeats) + static_cast<size_t>(nActions - 2);
+}
+constexpr size_t fullDim(int nSeats, int nActions) {
+    return fullAdvancedOffset(nSeats, nActions) + FULL_ADVANCED_DIM;
+}
+
+// --------------------------------
+// Simplified observation (_calculateCurrentObservationSimplified, use_simplified_observation == true)
+// --------------------------------
+//   [simpleCurrentPlayerOffset, +nSeats)  current player, one-hot by relative position
+//   [simpleStacksOffset,        +nSeats)  (stack + currentBet) / DEFAULT_STACK_SIZE
+//   simpleEffectiveStackOffset            log1p(effective stack / pot)
+//   simpleHistoryLengthOffset             actionHistory.size() / 100
+//   [simpleRowsOffset, ...)               actionHistory.size() action rows (rowDim each, same layout as above)
+// This one is variable length; simplifiedDim() gives the size for a history length.
+constexpr size_t simpleCurrentPlayerOffset(int) { return 0; }
+constexpr size_t simpleStacksOffset(int nSeats) { return static_cast<size_t>(nSeats); }
+constexpr size_t simpleEffectiveStackOffset(int nSeats) { return 2 * static_cast<size_t>(nSeats); }
+constexpr size_t simpleHistoryLengthOffset(int nSeats) { return 2 * static_cast<size_t>(nSeats) + 1; }
+constexpr size_t simpleRowsOffset(int nSeats) { return 2 * static_cast<size_t>(nSeats) + 2; }
+constexpr size_t simplifiedDim(int nSeats, int nActions, size_t historyLength) {
+    return simpleRowsOffset(nSeats) + historyLength * rowDim(nSeats, nActions);
+}
+
+// --------------------------------
+// Private info block (write_private_info / write_observation_with_private_info)
+// --------------------------------
+//   nSeats rows of PRIVATE_INFO_DIM floats, row i = PrivateInfo::toVector() of seat i
+//   (what getAllPlayersPrivateInfo_py returns and getObservationWithPrivateInfo_py
+//   appends to every seat's copy of the simplified observation); zeros for an empty seat.
+constexpr size_t PRIVATE_INFO_DIM = 4;
+constexpr size_t privateInfoDim(int nSeats) { return static_cast<size_t>(nSeats) * PRIVATE_INFO_DIM; }
+
+} // namespace ObservationLayout
+
+#endif // OBSERVATION_LAYOUT_H
@@ -0,0 +1,151 @@
+#ifndef OBSERVATION_RING_H
+#define OBSERVATION_RING_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// ================================
+// ObservationRing
+// ================================
+// Fixed-capacity history of the most recent observations, stored as one
+// contiguous float block. Storage is mirrored: a row living in slot s is also
+// kept in slot s + capacity, so the last size() rows always form a single
+// contiguous [size() x stride()] window starting at the oldest row. The
+// window can be handed out as a strided view without linearising anything.
+//
+// Rows may have different lengths (the simplified observation grows with the
+// action history); every row is zero padded to stride() and its real length is
+// kept alongside. stride() only grows (geometrically), and storage is
+// reallocated only when an appended row is wider than the current stride - in
+// steady state an append is two row copies and no allocation.
+class ObservationRing {
+public:
+    // Strided view of the current window, oldest row first. Invalidated by the
+    // next append()/clear().
+    struct View {
+        const float* data = nullptr;        // rows x stride floats
+        const uint32_t* lengths = nullptr;  // valid floats per row
+        size_t rows = 0;
+        size_t stride = 0;
+
+        const float* row(size_t i) const { return data + i * stride; }
+    };
+
+    // Matches the sequence length getPublicObservation() has always returned.
+    static constexpr size_t DEFAULT_CAPACITY = 25;
+
+    explicit ObservationRing(size_t capacity = DEFAULT_CAPACITY, size_t stride = 0)
+        : capacity_(capacity > 0 ? capacity : 1)
+    {
+        _reallocate(std::max<size_t>(stride, 1));
+    }
+
+    size_t capacity() const { return capacity_; }
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    size_t stride() const { return stride_; }
+    // Rows appended since the last clear(), including those already evicted.
+    uint64_t totalAppended() const { return totalAppended_; }
+
+    // Drops all rows; storage and stride are kept.
+    void clear() {
+        head_ = 0;
+        size_ = 0;
+        totalAppended_ = 0;
+    }
+
+    // Makes room for rows of up to `stride` floats ahead of time.
+    void reserve(size_t stride) {
+        if (stride > stride_) _reallocate(stride);
+    }
+
+    // Appends a row of `dim` floats produced in place by writer(float* dst);
+    // the oldest row is evicted once the ring is full.
+    template <typename Writer>
+    void emplace(size_t dim, Writer&& writer) {
+        float* dst = _beginAppend(dim);
+        writer(dst);
+        _commitAppend(dim);
+    }
+
+    void push_back(const float* src, size_t dim) {
+        float* dst = _beginAppend(dim);
+        std::memcpy(dst, src, dim * sizeof(float));
+        _commitAppend(dim);
+    }
+
+    void push_back(const std::vector<float>& row) { push_back(row.data(), row.size()); }
+
+    // i = 0 is the oldest retained row.
+    const float* row(size_t i) const { return storage_.data() + (head_ + i) * stride_; }
+    size_t rowLength(size_t i) const { return lengths_[head_ + i]; }
+
+    std::vector<float> rowVector(size_t i) const {
+        const float* r = row(i);
+        return std::vector<float>(r, r + rowLength(i));
+    }
+
+    View view() const {
+        View v;
+        v.data = storage_.data() + head_ * stride_;
+        v.lengths = lengths_.data() + head_;
+        v.rows = size_;
+        v.stride = stride_;
+        return v;
+    }
+
+private:
+    size_t _slot(size_t i) const { return (head_ + i) % capacity_; }
+
+    float* _beginAppend(size_t dim) {
+        if (dim > stride_) _reallocate(std::max(dim, stride_ + stride_ / 2));
+        if (size_ == capacity_) {
+            // Evict the oldest row; its slot is reused below.
+            head_ = (head_ + 1) % capacity_;
+            --size_;
+        }
+        return storage_.data() + _slot(size_) * stride_;
+    }
+
+    void _commitAppend(size_t dim) {
+        const size_t slot = _slot(size_);
+        float* primary = storage_.data() + slot * stride_;
+        std::fill(primary + dim, primary + stride_, 0.0f);
+        std::memcpy(primary + capacity_ * stride_, primary, stride_ * sizeof(float));
+        lengths_[slot] = static_cast<uint32_t>(dim);
+        lengths_[slot + capacity_] = static_cast<uint32_t>(dim);
+        ++size_;
+        ++totalAppended_;
+    }
+
+    // Re-lays the retained rows out at a wider stride, starting at slot 0.
+    void _reallocate(size_t stride) {
+        std::vector<float> storage(2 * capacity_ * stride, 0.0f);
+        std::vector<uint32_t> lengths(2 * capacity_, 0);
+        for (size_t i = 0; i < size_; ++i) {
+            const size_t len = rowLength(i);
+            const float* src = row(i);
+            std::memcpy(storage.data() + i * stride, src, len * sizeof(float));
+            std::memcpy(storage.data() + (i + capacity_) * stride, src, len * sizeof(float));
+            lengths[i] = static_cast<uint32_t>(len);
+            lengths[i + capacity_] = static_cast<uint32_t>(len);
+        }
+        storage_.swap(storage);
+        lengths_.swap(lengths);
+        stride_ = stride;
+        head_ = 0;
+    }
+
+    size_t capacity_;
+    size_t stride_ = 0;
+    size_t head_ = 0;
+    size_t size_ = 0;
+    uint64_t totalAppended_ = 0;
+    std::vector<float> storage_;    // 2 * capacity_ rows of stride_ floats
+    std::vector<uint32_t> lengths_; // 2 * capacity_, mirrored like storage_
+};
+
+#endif // OBSERVATION_RING_H
@@ -0,0 +1,160 @@
+#include "PerfCounters.h"
+
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <vector>
+
+namespace PokerPerf {
+
+namespace detail {
+std::atomic<bool> enabledFlag{false};
+} // namespace detail
+
+namespace {
+
+using detail::ThreadBlock;
+
+const char* const TIMER_NAMES[N_TIMERS] = {
+    "step", "reset", "resolve_action", "equity", "side_pots", "observation", "transformer_observation",
+};
+
+const char* const COUNTER_NAMES[N_COUNTERS] = {
+    "suit_map.hits",       "suit_map.misses",     "hand_potential.hits", "hand_potential.misses",
+    "equity_table.hits",   "equity_table.misses", "equity_cache.hits",   "equity_cache.misses",
+    "legal_actions.hits",  "legal_actions.misses",
+};
+
+void zero(ThreadBlock& block) {
+    for (auto& c : block.counters) c.store(0, std::memory_order_relaxed);
+    for (auto& c : block.timerCalls) c.store(0, std::memory_order_relaxed);
+    for (auto& c : block.timerTicks) c.store(0, std::memory_order_relaxed);
+}
+
+void accumulate(const ThreadBlock& block, Snapshot& snap) {
+    for (int i = 0; i < N_COUNTERS; ++i) snap.counters[i] += block.counters[i].load(std::memory_order_relaxed);
+    for (int i = 0; i < N_TIMERS; ++i) {
+        snap.timerCalls[i] += block.timerCalls[i].load(std::memory_order_relaxed);
+        snap.timerTicks[i] += block.timerTicks[i].load(std::memory_order_relaxed);
+    }
+}
+
+// Live blocks plus the totals of threads that have exited. Leaked on purpose:
+// thread_local destructors may run after static destruction.
+struct Registry {
+    std::mutex mutex;
+    std::vector<ThreadBlock*> live;
+    ThreadBlock retired;
+
+    Registry() { zero(retired); }
+
+    static Registry& get() {
+        static Registry* registry = new Registry();
+        return *registry;
+    }
+};
+
+struct ThreadSlot {
+    ThreadBlock* block;
+
+    ThreadSlot() : block(new ThreadBlock) {
+        zero(*block);
+        Registry& r = Registry::get();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        r.live.push_back(block);
+    }
+
+    ~ThreadSlot() {
+        Registry& r = Registry::get();
+        {
+            std::lock_guard<std::mutex> lock(r.mutex);
+            for (int i = 0; i < N_COUNTERS; ++i) detail::bump(r.retired.counters[i], block->counters[i].load());
+            for (int i = 0; i < N_TIMERS; ++i) {
+                detail::bump(r.retired.timerCalls[i], block->timerCalls[i].load());
+                detail::bump(r.retired.timerTicks[i], block->timerTicks[i].load());
+            }
+            r.live.erase(std::remove(r.live.begin(), r.live.end(), block), r.live.end());
+        }
+        delete block;
+    }
+};
+
+// Tick rate reference point, taken at load time.
+struct Calibration {
+    uint64_t ticks0;
+    std::chrono::steady_clock::time_point time0;
+
+    Calibration() : ticks0(detail::ticks()), time0(std::chrono::steady_clock::now()) {}
+
+    static const Calibration& get() {
+        static const Calibration calibration;
+        return calibration;
+    }
+
+    double nsPerTick() const {
+#if POKER_PERF_HAS_TSC
+        const uint64_t ticks = detail::ticks() - ticks0;
+        const double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - time0).count();
+        // Too short an interval to measure: report raw ticks.
+        if (ticks < 1000000 || ns <= 0.0) return 1.0;
+        return ns / static_cast<double>(ticks);
+#else
+        return 1.0;
+#endif
+    }
+};
+
+const Calibration& calibrationAtLoad = Calibration::get();
+
+} // namespace
+
+const char* timerName(Timer timer) { return TIMER_NAMES[static_cast<int>(timer)]; }
+const char* counterName(Counter counter) { return COUNTER_NAMES[static_cast<int>(counter)]; }
+
+ThreadBlock& detail::threadBlock() {
+    thread_local ThreadSlot slot;
+    return *slot.block;
+}
+
+void setEnabled(bool on) { detail::enabledFlag.store(on, std::memory_order_relaxed); }
+
+Snapshot snapshot() {
+    Snapshot snap;
+    Registry& r = Registry::get();
+    {
+        std::lock_guard<std::mutex> lock(r.mutex);
+        accumulate(r.retired, snap);
+        for (const ThreadBlock* block : r.live) accumulate(*block, snap);
+    }
+    snap.nsPerTick = calibrationAtLoad.nsPerTick();
+    return snap;
+}
+
+void reset() {
+    Registry& r = Registry::get();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    zero(r.retired);
+    for (ThreadBlock* block : r.live) zero(*block);
+}
+
+std::map<std::string, double> toMap(const Snapshot& snap) {
+    std::map<std::string, double> out;
+#ifdef POKER_ENV_PERF
+    out["compiled"] = 1.0;
+#else
+    out["compiled"] = 0.0;
+#endif
+    out["enabled"] = enabled() ? 1.0 : 0.0;
+    for (int i = 0; i < N_COUNTERS; ++i) out[COUNTER_NAMES[i]] = static_cast<double>(snap.counters[i]);
+    for (int i = 0; i < N_TIMERS; ++i) {
+        const std::string name = TIMER_NAMES[i];
+        const double calls = static_cast<double>(snap.timerCalls[i]);
+        const double ns = static_cast<double>(snap.timerTicks[i]) * snap.nsPerTick;
+        out[name + ".calls"] = calls;
+        out[name + ".total_ns"] = ns;
+        out[name + ".mean_ns"] = calls > 0 ? ns / calls : 0.0;
+    }
+    return out;
+}
+
+} // namespace PokerPerf
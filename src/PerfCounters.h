@@ -0,0 +1,150 @@
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <string>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64)
+#include <x86intrin.h>
+#define POKER_PERF_HAS_TSC 1
+#else
+#include <chrono>
+#define POKER_PERF_HAS_TSC 0
+#endif
+
+// ================================
+// Hot-path instrumentation
+// ================================
+// Counters and scoped timers for production builds, compiled in with
+// -DPOKER_ENV_PERF and then switched on at runtime (PokerPerf::setEnabled,
+// PokerEnv::set_perf_enabled_py); both default to off. Without the define
+// every POKER_PERF_* macro expands to nothing.
+//
+//     POKER_PERF_SCOPE(PokerPerf::Timer::Step);     // calls + ticks until end of scope
+//     POKER_PERF_COUNT(PokerPerf::Counter::SuitMapHit);
+//
+// Each thread owns a cache-line aligned block of relaxed atomics that only
+// it writes (plain load + store, no locked instruction); snapshot() sums the
+// live blocks and those of exited threads. Timers read the TSC (steady_clock
+// elsewhere) and snapshots convert ticks to nanoseconds with a rate measured
+// against steady_clock since start-up. Timed regions nest (a step contains
+// its observation building), so timer totals are inclusive.
+namespace PokerPerf {
+
+enum class Timer : int {
+    Step = 0,          // PokerEnv::_stepResolved
+    Reset,             // every reset overload
+    ResolveAction,     // action int -> resolved action in step(int), and _getFixedAction
+    Equity,            // hand potential / equity evaluation (cache lookups included)
+    SidePots,          // _calculateSidePots, _calculateCurrentSidePots
+    Observation,       // full / simplified observation writers
+    TransformerObservation, // getObservationForTransformer, write_transformer_*
+    COUNT
+};
+
+enum class Counter : int {
+    SuitMapHit = 0,    // canonical suit map cache
+    SuitMapMiss,
+    HandPotentialHit,  // per-seat potential already computed for this deal
+    HandPotentialMiss,
+    EquityTableHit,    // offline table (EquityTable.h)
+    EquityTableMiss,
+    EquityCacheHit,    // shared suit-isomorphic cache (EquityCache.h)
+    EquityCacheMiss,
+    LegalActionsHit,   // legal-action scan reused for the decision
+    LegalActionsMiss,
+    COUNT
+};
+
+constexpr int N_TIMERS = static_cast<int>(Timer::COUNT);
+constexpr int N_COUNTERS = static_cast<int>(Counter::COUNT);
+
+const char* timerName(Timer timer);
+const char* counterName(Counter counter);
+
+namespace detail {
+extern std::atomic<bool> enabledFlag;
+
+struct alignas(64) ThreadBlock {
+    std::atomic<uint64_t> counters[N_COUNTERS];
+    std::atomic<uint64_t> timerCalls[N_TIMERS];
+    std::atomic<uint64_t> timerTicks[N_TIMERS];
+};
+
+ThreadBlock& threadBlock();
+
+// Owner-thread increment: readers only need a torn-free value.
+inline void bump(std::atomic<uint64_t>& cell, uint64_t by) {
+    cell.store(cell.load(std::memory_order_relaxed) + by, std::memory_order_relaxed);
+}
+
+inline uint64_t ticks() {
+#if POKER_PERF_HAS_TSC
+    return __rdtsc();
+#else
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                     std::chrono::steady_clock::now().time_since_epoch())
+                                     .count());
+#endif
+}
+} // namespace detail
+
+inline bool enabled() { return detail::enabledFlag.load(std::memory_order_relaxed); }
+void setEnabled(bool on);
+
+inline void count(Counter counter, uint64_t by = 1) {
+    if (enabled()) detail::bump(detail::threadBlock().counters[static_cast<int>(counter)], by);
+}
+
+class ScopedTimer {
+public:
+    explicit ScopedTimer(Timer timer) : timer_(timer), start_(enabled() ? detail::ticks() : 0) {}
+    ~ScopedTimer() {
+        if (start_ == 0) return;
+        detail::ThreadBlock& block = detail::threadBlock();
+        detail::bump(block.timerCalls[static_cast<int>(timer_)], 1);
+        detail::bump(block.timerTicks[static_cast<int>(timer_)], detail::ticks() - start_);
+    }
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+private:
+    Timer timer_;
+    uint64_t start_;
+};
+
+struct Snapshot {
+    uint64_t counters[N_COUNTERS] = {};
+    uint64_t timerCalls[N_TIMERS] = {};
+    uint64_t timerTicks[N_TIMERS] = {};
+    double nsPerTick = 1.0;
+};
+
+// Sum over all threads, live and exited.
+Snapshot snapshot();
+// Zeroes every thread's counters. Increments racing it may survive.
+void reset();
+
+// Flat view for Python: "<timer>.calls", "<timer>.total_ns", "<timer>.mean_ns",
+// "<counter>", plus "enabled" and "compiled" (0/1).
+std::map<std::string, double> toMap(const Snapshot& snap);
+
+} // namespace PokerPerf
+
+#ifdef POKER_ENV_PERF
+#define POKER_PERF_CONCAT_(a, b) a##b
+#define POKER_PERF_CONCAT(a, b) POKER_PERF_CONCAT_(a, b)
+#define POKER_PERF_SCOPE(timer) ::PokerPerf::ScopedTimer POKER_PERF_CONCAT(pokerPerfScope_, __LINE__)(timer)
+#define POKER_PERF_COUNT(counter) ::PokerPerf::count(counter)
+#else
+#define POKER_PERF_SCOPE(timer) \
+    do {                        \
+    } while (0)
+#define POKER_PERF_COUNT(counter) \
+    do {                          \
+    } while (0)
+#endif
+
+#endif // PERF_COUNTERS_H
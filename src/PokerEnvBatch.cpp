@@ -0,0 +1,252 @@
+#include "PokerEnvBatch.h"
+#include "PokerStateBin.h"
+#include "FastRng.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+PokerEnvBatch::PokerEnvBatch(int nEnvs,
+                             const nlohmann::json& config,
+                             int nSeats,
+                             const std::vector<float>& bet_sizes_as_frac_of_pot,
+                             bool uniform_action_interpolation,
+                             int smallBlind,
+                             int bigBlind,
+                             int ante,
+                             int defaultStackSize,
+                             int maxSequenceLength,
+                             bool autoReset,
+                             int nThreads,
+                             bool pinThreads)
+    : nSeats_(nSeats),
+      nActions_(2 + static_cast<int>(bet_sizes_as_frac_of_pot.size())),
+      maxSeqLen_(maxSequenceLength),
+      stateDim_(2 * nSeats + 2),
+      actionDim_(nSeats + 2 + static_cast<int>(bet_sizes_as_frac_of_pot.size()) + 1),
+      autoReset_(autoReset),
+      pool(new WorkStealingPool(nThreads, pinThreads))
+{
+    if (nEnvs <= 0) {
+        throw std::invalid_argument("PokerEnvBatch: nEnvs must be positive, got " + std::to_string(nEnvs));
+    }
+    if (maxSequenceLength <= 0) {
+        throw std::invalid_argument("PokerEnvBatch: maxSequenceLength must be positive, got " + std::to_string(maxSequenceLength));
+    }
+
+    envs.reserve(nEnvs);
+    for (int i = 0; i < nEnvs; ++i) {
+        envs.emplace_back(new PokerEnv(config, nSeats, bet_sizes_as_frac_of_pot, uniform_action_interpolation,
+                                       smallBlind, bigBlind, ante, defaultStackSize));
+    }
+
+    const size_t n = static_cast<size_t>(nEnvs);
+    stateBuf.assign(n * stateDim_, 0.0f);
+    seqBuf.assign(n * maxSeqLen_ * actionDim_, 0.0f);
+    seqLenBuf.assign(n, 0);
+    rewardBuf.assign(n * nSeats_, 0.0f);
+    doneBuf.assign(n, 0.0f);
+    maskBuf.assign(n * nActions_, 0.0f);
+    curPlayerBuf.assign(n, -1);
+    seatStackBuf.assign(n * nSeats_, 0);
+    seatBetBuf.assign(n * nSeats_, 0);
+    seatInvestedBuf.assign(n * nSeats_, 0);
+    seatFoldedBuf.assign(n * nSeats_, 0);
+    seatAllinBuf.assign(n * nSeats_, 0);
+
+    // The PokerEnv constructor already dealt the first hand; publish it.
+    for (int i = 0; i < nEnvs; ++i) {
+        _writeObservation(i);
+        _writeMaskAndPlayer(i);
+    }
+}
+
+PokerEnvBatch::~PokerEnvBatch() = default;
+
+void PokerEnvBatch::setNumThreads(int nThreads, bool pinThreads) {
+    pool.reset(new WorkStealingPool(nThreads, pinThreads));
+}
+
+PokerEnv& PokerEnvBatch::env(int i) {
+    if (i < 0 || i >= numEnvs()) {
+        throw std::out_of_range("PokerEnvBatch::env: index " + std::to_string(i) + " out of range");
+    }
+    return *envs[i];
+}
+
+const PokerEnv& PokerEnvBatch::env(int i) const {
+    if (i < 0 || i >= numEnvs()) {
+        throw std::out_of_range("PokerEnvBatch::env: index " + std::to_string(i) + " out of range");
+    }
+    return *envs[i];
+}
+
+std::vector<const PokerEnv*> PokerEnvBatch::_constEnvPtrs() const {
+    std::vector<const PokerEnv*> ptrs;
+    ptrs.reserve(envs.size());
+    for (const auto& e : envs) ptrs.push_back(e.get());
+    return ptrs;
+}
+
+size_t PokerEnvBatch::stateBlobSize() const {
+    return PokerStateBin::blobSize(_constEnvPtrs());
+}
+
+std::vector<uint8_t> PokerEnvBatch::save_states_bin() const {
+    return PokerStateBin::saveBlob(_constEnvPtrs());
+}
+
+size_t PokerEnvBatch::save_states_bin(uint8_t* dst, size_t cap) const {
+    return PokerStateBin::saveBlob(_constEnvPtrs(), dst, cap);
+}
+
+// Restores every table from a blob written by save_states_bin(). The
+// observation/mask buffers are republished; rewards/dones are cleared.
+void PokerEnvBatch::load_states_bin(const uint8_t* blob, size_t size) {
+    std::vector<PokerEnv*> ptrs;
+    ptrs.reserve(envs.size());
+    for (auto& e : envs) ptrs.push_back(e.get());
+    PokerStateBin::loadBlob(blob, size, ptrs);
+
+    std::fill(rewardBuf.begin(), rewardBuf.end(), 0.0f);
+    std::fill(doneBuf.begin(), doneBuf.end(), 0.0f);
+    for (int i = 0; i < numEnvs(); ++i) {
+        _writeObservation(i);
+        _writeMaskAndPlayer(i);
+    }
+}
+
+void PokerEnvBatch::reset_batch() {
+    std::fill(rewardBuf.begin(), rewardBuf.end(), 0.0f);
+    std::fill(doneBuf.begin(), doneBuf.end(), 0.0f);
+    pool->parallel_for(envs.size(), [this](size_t i) { _resetEnv(static_cast<int>(i)); });
+}
+
+void PokerEnvBatch::reset_batch(const std::vector<uint64_t>& seeds) {
+    if (seeds.size() != envs.size()) {
+        throw std::invalid_argument("PokerEnvBatch::reset_batch: expected " + std::to_string(envs.size()) +
+                                    " seeds, got " + std::to_string(seeds.size()));
+    }
+    for (int i = 0; i < numEnvs(); ++i) {
+        envs[i]->seed(seeds[i]);
+    }
+    reset_batch();
+}
+
+void PokerEnvBatch::seed_batch(uint64_t baseSeed) {
+    for (int i = 0; i < numEnvs(); ++i) {
+        envs[i]->seed(FastRng::streamSeed(baseSeed, static_cast<uint64_t>(i)));
+    }
+}
+
+void PokerEnvBatch::step_batch(const int* actionInts, size_t n) {
+    if (n != envs.size()) {
+        throw std::invalid_argument("PokerEnvBatch::step_batch: expected " + std::to_string(envs.size()) +
+                                    " actions, got " + std::to_string(n));
+    }
+    pool->parallel_for(n, [this, actionInts](size_t i) { _stepEnv(static_cast<int>(i), actionInts[i]); });
+}
+
+void PokerEnvBatch::step_batch(const std::vector<int>& actionInts) {
+    step_batch(actionInts.data(), actionInts.size());
+}
+
+void PokerEnvBatch::_resetEnv(int i) {
+    envs[i]->reset();
+    _writeObservation(i);
+    _writeMaskAndPlayer(i);
+}
+
+void PokerEnvBatch::_stepEnv(int i, int actionInt) {
+    float* rewardRow = rewardBuf.data() + static_cast<size_t>(i) * nSeats_;
+
+    // Without auto-reset a finished table just keeps reporting done.
+    if (!autoReset_ && doneBuf[i] != 0.0f) {
+        std::fill(rewardRow, rewardRow + nSeats_, 0.0f);
+        return;
+    }
+
+    // step_core skips the nested-vector observation step() builds; the rows
+    // below are written in place instead.
+    const bool done = envs[i]->step_core(actionInt, rewardRow, static_cast<size_t>(nSeats_));
+    doneBuf[i] = done ? 1.0f : 0.0f;
+
+    if (done && autoReset_) {
+        _resetEnv(i);
+        return;
+    }
+    _writeObservation(i);
+    _writeMaskAndPlayer(i);
+}
+
+// Row i of the state / sequence buffers, written by the env straight into
+// place: the most recent maxSeqLen action rows, zero padded behind.
+void PokerEnvBatch::_writeObservation(int i) {
+    PokerEnv& env = *envs[i];
+    env.write_transformer_state(stateBuf.data() + static_cast<size_t>(i) * stateDim_, static_cast<size_t>(stateDim_));
+
+    // 序列超过 maxSeqLen 时保留最近的动作
+    const size_t seqCap = static_cast<size_t>(maxSeqLen_) * actionDim_;
+    float* seqBlock = seqBuf.data() + static_cast<size_t>(i) * seqCap;
+    const size_t len = env.write_transformer_sequence(seqBlock, seqCap);
+    std::fill(seqBlock + len * actionDim_, seqBlock + seqCap, 0.0f);
+    seqLenBuf[i] = static_cast<int32_t>(len);
+
+    _writeSeatState(i);
+}
+
+// Row i of the seat-state buffers: straight copies of the table's SeatState arrays.
+void PokerEnvBatch::_writeSeatState(int i) {
+    const SeatState& seats = envs[i]->seatState();
+    const size_t row = static_cast<size_t>(i) * nSeats_;
+    const int n = std::min(nSeats_, seats.nSeats);
+    std::copy(seats.stack, seats.stack + n, seatStackBuf.data() + row);
+    std::copy(seats.currentBet, seats.currentBet + n, seatBetBuf.data() + row);
+    std::copy(seats.invested, seats.invested + n, seatInvestedBuf.data() + row);
+    std::copy(seats.folded, seats.folded + n, seatFoldedBuf.data() + row);
+    std::copy(seats.allin, seats.allin + n, seatAllinBuf.data() + row);
+}
+
+void PokerEnvBatch::_writeMaskAndPlayer(int i) {
+    float* maskRow = maskBuf.data() + static_cast<size_t>(i) * nActions_;
+    std::fill(maskRow, maskRow + nActions_, 0.0f);
+    const LegalActionSet& legal = envs[i]->legalActionSet();
+    for (int k = 0; k < legal.count; ++k) {
+        if (legal.actions[k] >= 0 && legal.actions[k] < nActions_) {
+            maskRow[legal.actions[k]] = 1.0f;
+        }
+    }
+    curPlayerBuf[i] = envs[i]->getCurrentPlayer();
+}
+
+void PokerEnvBatch::reset_batch_py(const std::vector<uint64_t>& seeds) {
+    if (seeds.empty()) {
+        reset_batch();
+    } else {
+        reset_batch(seeds);
+    }
+}
+
+void PokerEnvBatch::step_batch_py(const std::vector<int>& actionInts) {
+    step_batch(actionInts);
+}
+
+std::vector<size_t> PokerEnvBatch::stateFeaturesShape_py() const {
+    return {envs.size(), static_cast<size_t>(stateDim_)};
+}
+
+std::vector<size_t> PokerEnvBatch::sequenceFeaturesShape_py() const {
+    return {envs.size(), static_cast<size_t>(maxSeqLen_), static_cast<size_t>(actionDim_)};
+}
+
+std::vector<size_t> PokerEnvBatch::seatStateShape_py() const {
+    return {envs.size(), static_cast<size_t>(nSeats_)};
+}
+
+size_t PokerEnvBatch::save_states_bin_py(uintptr_t address, size_t cap) const {
+    return save_states_bin(reinterpret_cast<uint8_t*>(address), cap);
+}
+
+void PokerEnvBatch::load_states_bin_py(uintptr_t address, size_t size) {
+    load_states_bin(reinterpret_cast<const uint8_t*>(address), size);
+}
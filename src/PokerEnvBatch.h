@@ -0,0 +1,165 @@
+#ifndef POKER_ENV_BATCH_H
+#define POKER_ENV_BATCH_H
+
+#include "PokerEnv_notorch.h"
+#include "WorkStealingPool.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// ================================
+// PokerEnvBatch
+// ================================
+// Owns N independent PokerEnv tables and advances all of them with a single
+// call. Every per-step output is written into buffers that are allocated once
+// in the constructor and laid out row-major with the table index as the
+// leading dimension, so the binding layer can hand them to numpy as views
+// (see the *_address_py() accessors) instead of building nested lists.
+//
+// Buffers (T = number of tables):
+//   state features    float [T x (2 * N_SEATS + 2)]         (PokerEnv::write_transformer_state)
+//   sequence features float [T x maxSeqLen x (N_SEATS + N_ACTIONS + 1)], zero padded
+//                                                            (PokerEnv::write_transformer_sequence)
+//   sequence lengths  int32 [T]
+//   rewards           float [T x N_SEATS]
+//   dones             float [T]                              (1.0 when the hand finished on this step)
+//   legal masks       float [T x N_ACTIONS]
+//   current player    int32 [T]
+//   seat state        int32 [T x N_SEATS] stacks, bets, chips invested this hand;
+//                     uint8 [T x N_SEATS] folded, all-in (0/1)   (PokerEnv::seatState(), SeatState.h)
+//
+// Tables whose hand finished are reset in place (auto-reset), so after
+// step_batch() the observation/mask rows always describe the next decision
+// while rewards/dones still describe the step that was just taken.
+//
+// Tables are stepped on a persistent WorkStealingPool (nThreads, optionally
+// pinned to cores). Each table writes only its own rows, so no locking is
+// needed; step_batch() is plain C++ and can run with the GIL released.
+class PokerEnvBatch {
+public:
+    static constexpr int DEFAULT_MAX_SEQUENCE_LENGTH = 25;
+
+    PokerEnvBatch(int nEnvs,
+                  const nlohmann::json& config,
+                  int nSeats,
+                  const std::vector<float>& bet_sizes_as_frac_of_pot,
+                  bool uniform_action_interpolation,
+                  int smallBlind,
+                  int bigBlind,
+                  int ante,
+                  int defaultStackSize,
+                  int maxSequenceLength = DEFAULT_MAX_SEQUENCE_LENGTH,
+                  bool autoReset = true,
+                  int nThreads = 1,
+                  bool pinThreads = false);
+    ~PokerEnvBatch();
+
+    PokerEnvBatch(const PokerEnvBatch&) = delete;
+    PokerEnvBatch& operator=(const PokerEnvBatch&) = delete;
+
+    // Resets every table. With seeds, seeds.size() must equal numEnvs() and
+    // table i is reseeded with seeds[i] before its reset.
+    void reset_batch();
+    void reset_batch(const std::vector<uint64_t>& seeds);
+    // Reseeds table i with FastRng::streamSeed(baseSeed, i): one number
+    // reproduces the whole batch, and every table gets its own stream.
+    void seed_batch(uint64_t baseSeed);
+
+    // Applies actionInts[i] (discrete action index, as for PokerEnv::step(int))
+    // to table i. n must equal numEnvs().
+    void step_batch(const int* actionInts, size_t n);
+    void step_batch(const std::vector<int>& actionInts);
+
+    int numEnvs() const { return static_cast<int>(envs.size()); }
+    int numSeats() const { return nSeats_; }
+    int numActions() const { return nActions_; }
+    int maxSequenceLength() const { return maxSeqLen_; }
+    int stateDim() const { return stateDim_; }
+    int actionFeatureDim() const { return actionDim_; }
+    int numThreads() const { return pool->numThreads(); }
+
+    // Replaces the worker pool; must not be called while a batch call is running.
+    void setNumThreads(int nThreads, bool pinThreads = false);
+
+    PokerEnv& env(int i);
+    const PokerEnv& env(int i) const;
+
+    // Binary snapshot of every table as one PokerStateBin blob (header +
+    // fixed-size records, table i at record i); see PokerStateBin.h.
+    size_t stateBlobSize() const;
+    std::vector<uint8_t> save_states_bin() const;
+    size_t save_states_bin(uint8_t* dst, size_t cap) const;
+    void load_states_bin(const uint8_t* blob, size_t size);
+
+    const float* stateFeatures() const { return stateBuf.data(); }
+    const float* sequenceFeatures() const { return seqBuf.data(); }
+    const int32_t* sequenceLengths() const { return seqLenBuf.data(); }
+    const float* rewards() const { return rewardBuf.data(); }
+    const float* dones() const { return doneBuf.data(); }
+    const float* legalActionMasks() const { return maskBuf.data(); }
+    const int32_t* currentPlayers() const { return curPlayerBuf.data(); }
+    const int32_t* seatStacks() const { return seatStackBuf.data(); }
+    const int32_t* seatBets() const { return seatBetBuf.data(); }
+    const int32_t* seatInvested() const { return seatInvestedBuf.data(); }
+    const uint8_t* seatFolded() const { return seatFoldedBuf.data(); }
+    const uint8_t* seatAllin() const { return seatAllinBuf.data(); }
+
+    // --- Python-facing helpers ---
+    // The *_address_py() methods return the buffer address so Python can wrap
+    // it without copying (np.ctypeslib / ctypes.from_address); the buffers
+    // stay valid for the lifetime of the batch.
+    void reset_batch_py(const std::vector<uint64_t>& seeds);
+    void step_batch_py(const std::vector<int>& actionInts);
+    uintptr_t stateFeatures_address_py() const { return reinterpret_cast<uintptr_t>(stateBuf.data()); }
+    uintptr_t sequenceFeatures_address_py() const { return reinterpret_cast<uintptr_t>(seqBuf.data()); }
+    uintptr_t sequenceLengths_address_py() const { return reinterpret_cast<uintptr_t>(seqLenBuf.data()); }
+    uintptr_t rewards_address_py() const { return reinterpret_cast<uintptr_t>(rewardBuf.data()); }
+    uintptr_t dones_address_py() const { return reinterpret_cast<uintptr_t>(doneBuf.data()); }
+    uintptr_t legalActionMasks_address_py() const { return reinterpret_cast<uintptr_t>(maskBuf.data()); }
+    uintptr_t currentPlayers_address_py() const { return reinterpret_cast<uintptr_t>(curPlayerBuf.data()); }
+    uintptr_t seatStacks_address_py() const { return reinterpret_cast<uintptr_t>(seatStackBuf.data()); }
+    uintptr_t seatBets_address_py() const { return reinterpret_cast<uintptr_t>(seatBetBuf.data()); }
+    uintptr_t seatInvested_address_py() const { return reinterpret_cast<uintptr_t>(seatInvestedBuf.data()); }
+    uintptr_t seatFolded_address_py() const { return reinterpret_cast<uintptr_t>(seatFoldedBuf.data()); }
+    uintptr_t seatAllin_address_py() const { return reinterpret_cast<uintptr_t>(seatAllinBuf.data()); }
+    std::vector<size_t> stateFeaturesShape_py() const;
+    std::vector<size_t> sequenceFeaturesShape_py() const;
+    std::vector<size_t> seatStateShape_py() const;
+    size_t save_states_bin_py(uintptr_t address, size_t cap) const;
+    void load_states_bin_py(uintptr_t address, size_t size);
+
+private:
+    std::vector<const PokerEnv*> _constEnvPtrs() const;
+    void _resetEnv(int i);
+    void _stepEnv(int i, int actionInt);
+    void _writeObservation(int i);
+    void _writeMaskAndPlayer(int i);
+    void _writeSeatState(int i);
+
+    std::vector<std::unique_ptr<PokerEnv>> envs;
+
+    int nSeats_;
+    int nActions_;
+    int maxSeqLen_;
+    int stateDim_;
+    int actionDim_;
+    bool autoReset_;
+    std::unique_ptr<WorkStealingPool> pool;
+
+    std::vector<float> stateBuf;
+    std::vector<float> seqBuf;
+    std::vector<int32_t> seqLenBuf;
+    std::vector<float> rewardBuf;
+    std::vector<float> doneBuf;
+    std::vector<float> maskBuf;
+    std::vector<int32_t> curPlayerBuf;
+    std::vector<int32_t> seatStackBuf;
+    std::vector<int32_t> seatBetBuf;
+    std::vector<int32_t> seatInvestedBuf;
+    std::vector<uint8_t> seatFoldedBuf;
+    std::vector<uint8_t> seatAllinBuf;
+};
+
+#endif // POKER_ENV_BATCH_H
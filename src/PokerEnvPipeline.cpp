@@ -0,0 +1,167 @@
+#include "PokerEnvPipeline.h"
+#include "FastRng.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+PokerEnvPipeline::PokerEnvPipeline(int nEnvsPerSlot,
+                                   const nlohmann::json& config,
+                                   int nSeats,
+                                   const std::vector<float>& bet_sizes_as_frac_of_pot,
+                                   bool uniform_action_interpolation,
+                                   int smallBlind,
+                                   int bigBlind,
+                                   int ante,
+                                   int defaultStackSize,
+                                   int maxSequenceLength,
+                                   int nSlots,
+                                   int nThreads,
+                                   bool pinThreads)
+    : nEnvsPerSlot_(nEnvsPerSlot),
+      submitted_(static_cast<size_t>(std::max(nSlots, 1))),
+      completed_(static_cast<size_t>(std::max(nSlots, 1)))
+{
+    if (nSlots < 2) {
+        throw std::invalid_argument("PokerEnvPipeline: nSlots must be at least 2, got " + std::to_string(nSlots));
+    }
+
+    slots.resize(nSlots);
+    for (int s = 0; s < nSlots; ++s) {
+        // Auto-reset is what keeps a slot's rows meaningful from batch to batch.
+        slots[s].batch.reset(new PokerEnvBatch(nEnvsPerSlot, config, nSeats, bet_sizes_as_frac_of_pot,
+                                               uniform_action_interpolation, smallBlind, bigBlind, ante,
+                                               defaultStackSize, maxSequenceLength, true, nThreads, pinThreads));
+        slots[s].actions.assign(nEnvsPerSlot, 0);
+    }
+
+    // Every slot starts ready: the PokerEnvBatch constructors dealt and
+    // published the first hand.
+    for (int s = 0; s < nSlots; ++s) {
+        int id = s;
+        completed_.try_push(std::move(id));
+    }
+    driver_ = std::thread(&PokerEnvPipeline::_driverLoop, this);
+}
+
+PokerEnvPipeline::~PokerEnvPipeline() {
+    stop_.store(true, std::memory_order_relaxed);
+    if (driver_.joinable()) driver_.join();
+}
+
+void PokerEnvPipeline::_checkSlot(int slot, const char* fn) const {
+    if (slot < 0 || slot >= numSlots()) {
+        throw std::out_of_range(std::string("PokerEnvPipeline::") + fn + ": slot " + std::to_string(slot) +
+                                " out of range");
+    }
+}
+
+PokerEnvBatch& PokerEnvPipeline::batch(int slot) {
+    _checkSlot(slot, "batch");
+    return *slots[slot].batch;
+}
+
+const PokerEnvBatch& PokerEnvPipeline::batch(int slot) const {
+    _checkSlot(slot, "batch");
+    return *slots[slot].batch;
+}
+
+// ================================
+// Caller side
+// ================================
+
+int PokerEnvPipeline::_takeReady(int slot) {
+    Slot& s = slots[slot];
+    s.held = true;
+    s.submitted = false;
+    if (s.error) {
+        std::exception_ptr error = s.error;
+        s.error = nullptr;
+        std::rethrow_exception(error);
+    }
+    return slot;
+}
+
+int PokerEnvPipeline::poll_ready() {
+    int slot = -1;
+    if (!completed_.try_pop(slot)) return -1;
+    return _takeReady(slot);
+}
+
+int PokerEnvPipeline::wait_ready() {
+    const bool allHeld = std::all_of(slots.begin(), slots.end(), [](const Slot& s) { return s.held; });
+    if (allHeld) {
+        throw std::runtime_error("PokerEnvPipeline::wait_ready: every slot is already ready; submit one first");
+    }
+    int slot = -1;
+    SpscBackoff backoff;
+    while (!completed_.try_pop(slot)) backoff.wait();
+    return _takeReady(slot);
+}
+
+void PokerEnvPipeline::submit(int slot, const int* actionInts, size_t n) {
+    _checkSlot(slot, "submit");
+    Slot& s = slots[slot];
+    if (!s.held) {
+        throw std::runtime_error("PokerEnvPipeline::submit: slot " + std::to_string(slot) +
+                                 " is not ready; wait_ready() must return it first");
+    }
+    if (n != static_cast<size_t>(nEnvsPerSlot_)) {
+        throw std::invalid_argument("PokerEnvPipeline::submit: expected " + std::to_string(nEnvsPerSlot_) +
+                                    " actions, got " + std::to_string(n));
+    }
+    std::copy(actionInts, actionInts + n, s.actions.begin());
+    s.held = false;
+    s.submitted = true;
+    // At most numSlots() ids are ever queued, so this cannot fail.
+    int id = slot;
+    submitted_.try_push(std::move(id));
+}
+
+void PokerEnvPipeline::submit(int slot, const std::vector<int>& actionInts) {
+    submit(slot, actionInts.data(), actionInts.size());
+}
+
+void PokerEnvPipeline::submit_address_py(int slot, uintptr_t address, size_t n) {
+    const int32_t* src = reinterpret_cast<const int32_t*>(address);
+    if (!src && n > 0) {
+        throw std::invalid_argument("PokerEnvPipeline::submit_address_py: null buffer");
+    }
+    static_assert(sizeof(int) == sizeof(int32_t), "action buffers are int32");
+    submit(slot, reinterpret_cast<const int*>(src), n);
+}
+
+void PokerEnvPipeline::seed(uint64_t baseSeed) {
+    for (const Slot& s : slots) {
+        if (s.submitted) {
+            throw std::runtime_error("PokerEnvPipeline::seed: a submitted slot has not come back yet");
+        }
+    }
+    for (int s = 0; s < numSlots(); ++s) {
+        slots[s].batch->seed_batch(FastRng::streamSeed(baseSeed, static_cast<uint64_t>(s)));
+    }
+}
+
+// ================================
+// Driver thread
+// ================================
+
+void PokerEnvPipeline::_driverLoop() {
+    SpscBackoff backoff;
+    while (!stop_.load(std::memory_order_relaxed)) {
+        int slot = -1;
+        if (!submitted_.try_pop(slot)) {
+            backoff.wait();
+            continue;
+        }
+        backoff.reset();
+
+        Slot& s = slots[slot];
+        try {
+            s.batch->step_batch(s.actions.data(), s.actions.size());
+        } catch (...) {
+            s.error = std::current_exception();
+        }
+        completed_.try_push(std::move(slot));
+    }
+}
@@ -0,0 +1,132 @@
+#ifndef POKER_ENV_PIPELINE_H
+#define POKER_ENV_PIPELINE_H
+
+#include "PokerEnvBatch.h"
+#include "SpscQueue.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <thread>
+#include <vector>
+
+// ================================
+// PokerEnvPipeline
+// ================================
+// Overlaps policy inference with env stepping. The tables are split into
+// nSlots (default 2) independent PokerEnvBatch slots. A slot is either
+// ready (its observation buffers describe the next decision and belong to
+// the caller) or in flight (a driver thread is stepping it). The caller
+// runs inference on one ready slot while the driver steps the slot it
+// submitted before:
+//
+//     int s = pipe.wait_ready();            // slot whose observations are ready
+//     for (;;) {
+//         actions = policy(pipe.batch(s));  // GPU, reads the slot's buffers
+//         pipe.submit(s, actions);          // driver starts stepping slot s
+//         s = pipe.wait_ready();            // the other slot, stepped meanwhile
+//     }
+//
+// Submissions and completions travel through two SpscQueues of slot ids:
+// submit() and wait_ready() must be called from one thread, and the driver is
+// the only other party. A slot's buffers must not be touched between its
+// submit() and the wait_ready() that returns it again. Every slot starts out
+// ready (freshly reset), in slot order.
+//
+// The driver steps one slot at a time, each through its own WorkStealingPool
+// of nThreads (PokerEnvBatch), so the pools never run concurrently. Idle
+// waits spin briefly, then yield, then sleep, so neither side burns a core
+// while the other one is busy. If stepping throws, the exception is rethrown
+// by the wait_ready() that would have returned that slot.
+class PokerEnvPipeline {
+public:
+    static constexpr int DEFAULT_SLOTS = 2;
+
+    PokerEnvPipeline(int nEnvsPerSlot,
+                     const nlohmann::json& config,
+                     int nSeats,
+                     const std::vector<float>& bet_sizes_as_frac_of_pot,
+                     bool uniform_action_interpolation,
+                     int smallBlind,
+                     int bigBlind,
+                     int ante,
+                     int defaultStackSize,
+                     int maxSequenceLength = PokerEnvBatch::DEFAULT_MAX_SEQUENCE_LENGTH,
+                     int nSlots = DEFAULT_SLOTS,
+                     int nThreads = 1,
+                     bool pinThreads = false);
+    ~PokerEnvPipeline();
+
+    PokerEnvPipeline(const PokerEnvPipeline&) = delete;
+    PokerEnvPipeline& operator=(const PokerEnvPipeline&) = delete;
+
+    int numSlots() const { return static_cast<int>(slots.size()); }
+    int numEnvsPerSlot() const { return nEnvsPerSlot_; }
+
+    // A ready slot's buffers; see the ownership rule above.
+    PokerEnvBatch& batch(int slot);
+    const PokerEnvBatch& batch(int slot) const;
+
+    // Blocks until a slot is ready and returns it. Each submitted slot comes
+    // back exactly once, in submission order.
+    int wait_ready();
+    // Non-blocking form: -1 if no slot is ready yet.
+    int poll_ready();
+
+    // Hands slot's actions (n == numEnvsPerSlot(), as for step_batch) to the
+    // driver. The actions are copied, so the caller's array can be reused.
+    void submit(int slot, const int* actionInts, size_t n);
+    void submit(int slot, const std::vector<int>& actionInts);
+
+    // Reseeds slot s with FastRng::streamSeed(baseSeed, s) as its base seed.
+    // Only while no submitted slot is still out (e.g. right after construction).
+    void seed(uint64_t baseSeed);
+
+    // --- Python-facing helpers ---
+    // wait_ready_py() blocks; the binding should release the GIL around it.
+    // submit_address_py takes the data pointer of a C-contiguous int32 array
+    // of numEnvsPerSlot() elements. Buffer addresses are those of
+    // batch(slot) (PokerEnvBatch::*_address_py) and never change.
+    int wait_ready_py() { return wait_ready(); }
+    int poll_ready_py() { return poll_ready(); }
+    void submit_py(int slot, const std::vector<int>& actionInts) { submit(slot, actionInts); }
+    void submit_address_py(int slot, uintptr_t address, size_t n);
+    uintptr_t stateFeatures_address_py(int slot) const { return batch(slot).stateFeatures_address_py(); }
+    uintptr_t sequenceFeatures_address_py(int slot) const { return batch(slot).sequenceFeatures_address_py(); }
+    uintptr_t sequenceLengths_address_py(int slot) const { return batch(slot).sequenceLengths_address_py(); }
+    uintptr_t rewards_address_py(int slot) const { return batch(slot).rewards_address_py(); }
+    uintptr_t dones_address_py(int slot) const { return batch(slot).dones_address_py(); }
+    uintptr_t legalActionMasks_address_py(int slot) const { return batch(slot).legalActionMasks_address_py(); }
+    uintptr_t currentPlayers_address_py(int slot) const { return batch(slot).currentPlayers_address_py(); }
+    uintptr_t seatStacks_address_py(int slot) const { return batch(slot).seatStacks_address_py(); }
+    uintptr_t seatBets_address_py(int slot) const { return batch(slot).seatBets_address_py(); }
+    uintptr_t seatInvested_address_py(int slot) const { return batch(slot).seatInvested_address_py(); }
+    uintptr_t seatFolded_address_py(int slot) const { return batch(slot).seatFolded_address_py(); }
+    uintptr_t seatAllin_address_py(int slot) const { return batch(slot).seatAllin_address_py(); }
+
+private:
+    struct Slot {
+        std::unique_ptr<PokerEnvBatch> batch;
+        std::vector<int> actions;
+        std::exception_ptr error;
+        // Caller-side bookkeeping: held between the wait_ready() that returned
+        // the slot and its submit(); submitted from submit() until then.
+        bool held = false;
+        bool submitted = false;
+    };
+
+    void _driverLoop();
+    void _checkSlot(int slot, const char* fn) const;
+    int _takeReady(int slot);
+
+    std::vector<Slot> slots;
+    int nEnvsPerSlot_;
+    SpscQueue<int> submitted_;
+    SpscQueue<int> completed_;
+    std::atomic<bool> stop_{false};
+    std::thread driver_;
+};
+
+#endif // POKER_ENV_PIPELINE_H
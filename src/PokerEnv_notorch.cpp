@@ -1,13 +1,32 @@
 #include "PokerEnv_notorch.h"
-#include <iostream>
+#include "CardId.h"
+#include "ObservationLayout.h"
+#include "ObservationRing.h"
+#include "RangeLut.h"
+#include "PokerStateBin.h"
+#include "LegalActions.h"
+#include "Showdown.h"
+#include "HandEvalBatch.h"
+#include "EquityCache.h"
+#include "EquityTable.h"
+#include "EquityEngine.h"
+#include "RangeEvaluator.h"
+#include "CardParse.h"
+#include "PokerLog.h"
+#include "SeatState.h"
+#include "TableKernels.h"
+#include "PerfCounters.h"
+#include "HandDescription.h"
+#include "HandArena.h"
 #include <sstream> // For std::stringstream in toString()
-#include <numeric>
 #include <random>
 #include <algorithm>
 #include <set> // For std::set in reset()
 #include <limits> // For std::numeric_limits
 #include <cmath> // For std::abs
 #include <fstream> // For std::ifstream
+#include <cstring> // For std::memcpy in the binary snapshot
+#include <cstdlib> // For std::atoi
 #include <phevaluator/phevaluator.h> // For hand evaluation
 #include "../../PokerHandEvaluator/cpp/include/phevaluator/evaluator_holdem_potential.h"
 
@@ -29,156 +48,182 @@ extern "C" {
 #define CHECK_CALL 1
 #define BET_RAISE 2
 #endif
+static_assert(FOLD == 0 && CHECK_CALL == 1 && BET_RAISE == N_RESOLVED_ACTION_TYPES - 1,
+              "makeResolvedAction (LegalActions.h) validates types as 0..N_RESOLVED_ACTION_TYPES-1");
 
 // Forward declarations for helper functions that were in anonymous namespace
-static void printStringAsBytes(const std::string& s, const std::string& label = "");
-static std::tuple<bool, Card::Suit, size_t> findSuitInString(const std::string& cardStr);
 static std::pair<Card::CardValue, Card::Suit> parseCardStringInternal(const std::string& cardStr);
+static bool parseHoleCardsInto(const std::string& twoCardsStr, std::vector<Card>& storage);
 static std::string getCardString(Card::CardValue value, Card::Suit suit);
 
 
 // Helper function implementations (moved from anonymous namespace)
-static void printStringAsBytes(const std::string& s, const std::string& label) {
-    if (!label.empty()) {
-        std::cout << label << ": \\\"";
-    }
-    for (char c : s) {
-        std::cout << std::hex << static_cast<int>(static_cast<unsigned char>(c)) << " ";
-    }
-    if (!label.empty()) {
-        std::cout << "\\\" (length: " << std::dec << s.length() << ")" << std::endl;
-    }
-}
-
-static std::tuple<bool, Card::Suit, size_t> findSuitInString(const std::string& cardStr) {
-    #ifdef DEBUG_POKER_ENV
-    std::cout << "[DEBUG findSuitInString] Input cardStr: ";
-    printStringAsBytes(cardStr);
-    #endif
-
-    // IMPORTANT: Ensure this file (PokerEnv_notorch.cpp) is saved with UTF-8 encoding
-    const std::string spade_unicode = "♠"; // UTF-8: e2 99 a0
-    const std::string heart_unicode = "♥"; // UTF-8: e2 99 a5 (Note: original log showed e2 99 a1 for ♡, heart suit in Card.cpp is \u2661 which is ♡ not ♥)
-                                        // Let's stick to the symbols from Card.cpp: ♢, ♣, ♡, ♠
-    const std::string diamond_unicode = "♢"; // Card::SuitString[0] = \\u2662
-    const std::string club_unicode = "♣";    // Card::SuitString[1] = \\u2663
-    const std::string heart_alt_unicode = "♡"; // Card::SuitString[2] = \\u2661
-    // spade_unicode is already "♠" (Card::SuitString[3] = \\u2660)
-
-
-    #ifdef DEBUG_POKER_ENV
-    printStringAsBytes(spade_unicode, "[DEBUG findSuitInString] spade_unicode ('♠')");
-    printStringAsBytes(heart_alt_unicode, "[DEBUG findSuitInString] heart_alt_unicode ('♡')");
-    printStringAsBytes(club_unicode, "[DEBUG findSuitInString] club_unicode ('♣')");
-    printStringAsBytes(diamond_unicode, "[DEBUG findSuitInString] diamond_unicode ('♢')");
-    #endif
-
-    // Check for multi-byte Unicode suits first
-    if (cardStr.length() >= spade_unicode.length() && cardStr.rfind(spade_unicode) == cardStr.length() - spade_unicode.length()) {
-        #ifdef DEBUG_POKER_ENV
-        std::cout << "[DEBUG findSuitInString] Matched spade_unicode" << std::endl;
-        #endif
-        return {true, Card::Spades, spade_unicode.length()};
-    }
-    if (cardStr.length() >= heart_alt_unicode.length() && cardStr.rfind(heart_alt_unicode) == cardStr.length() - heart_alt_unicode.length()) {
-        #ifdef DEBUG_POKER_ENV
-        std::cout << "[DEBUG findSuitInString] Matched heart_alt_unicode (♡)" << std::endl;
-        #endif
-        return {true, Card::Hearts, heart_alt_unicode.length()};
-    }
-    if (cardStr.length() >= club_unicode.length() && cardStr.rfind(club_unicode) == cardStr.length() - club_unicode.length()) {
-        #ifdef DEBUG_POKER_ENV
-        std::cout << "[DEBUG findSuitInString] Matched club_unicode" << std::endl;
-        #endif
-        return {true, Card::Clubs, club_unicode.length()};
-    }
-    if (cardStr.length() >= diamond_unicode.length() && cardStr.rfind(diamond_unicode) == cardStr.length() - diamond_unicode.length()) {
-        #ifdef DEBUG_POKER_ENV
-        std::cout << "[DEBUG findSuitInString] Matched diamond_unicode" << std::endl;
-        #endif
-        return {true, Card::Diamonds, diamond_unicode.length()};
-    }
-
-    #ifdef DEBUG_POKER_ENV
-    std::cout << "[DEBUG findSuitInString] No Unicode suit matched. Trying ASCII." << std::endl;
-    #endif
-
-    // If no Unicode suit found, check for single ASCII character suits
-    if (cardStr.length() >= 1) {
-        char lastChar = cardStr.back();
-        if (lastChar == 's' || lastChar == 'S') return {true, Card::Spades, 1};
-        if (lastChar == 'h' || lastChar == 'H') return {true, Card::Hearts, 1};
-        if (lastChar == 'c' || lastChar == 'C') return {true, Card::Clubs, 1};
-        if (lastChar == 'd' || lastChar == 'D') return {true, Card::Diamonds, 1};
-    }
-    return {false, Card::Diamonds, 0}; // Default if not found
+// Throwing front end of CardParse::parseCard for the callers that want
+// Card enums; the hot paths below call CardParse directly.
+static std::pair<Card::CardValue, Card::Suit> parseCardStringInternal(const std::string& cardStr) {
+    CardId id = NO_CARD;
+    const CardParse::Status status = CardParse::parseCard(cardStr, id);
+    if (status != CardParse::Status::Ok) {
+        throw std::invalid_argument(std::string(CardParse::statusMessage(status)) + ": \"" + cardStr + "\"");
+    }
+    return {static_cast<Card::CardValue>(cardIdValue(id)), static_cast<Card::Suit>(cardIdSuit(id))};
 }
 
-static std::pair<Card::CardValue, Card::Suit> parseCardStringInternal(const std::string& cardStr) {
-    if (cardStr.empty()) {
-        throw std::invalid_argument("Card string cannot be empty");
+// Two hole cards from "As Kd" / "AsKd" / "10♠K♡" appended to storage as Card
+// objects; false (storage untouched) if the string is not two cards.
+static bool parseHoleCardsInto(const std::string& twoCardsStr, std::vector<Card>& storage) {
+    CardId hole[N_HOLE_CARDS];
+    if (CardParse::parseHoleCards(twoCardsStr, hole) != CardParse::Status::Ok) return false;
+    for (CardId id : hole) {
+        storage.emplace_back(static_cast<Card::Suit>(cardIdSuit(id)), static_cast<Card::CardValue>(cardIdValue(id)));
     }
+    return true;
+}
 
-    bool suitFound_flag;
-    Card::Suit suit_enum_val;
-    size_t suit_len_in_str_val;
+// "(size n): 51, 46, ... | (pheval_rank, pheval_suit): (12,3) (11,2) ..." for
+// the evaluation debug lines.
+[[maybe_unused]] static std::string evalCardsDebugString(const int* cards, size_t n) {
+    std::ostringstream oss;
+    oss << "(size " << n << "): ";
+    for (size_t i = 0; i < n; ++i) oss << cards[i] << (i + 1 == n ? "" : ", ");
+    oss << " | (pheval_rank, pheval_suit): ";
+    for (size_t i = 0; i < n; ++i) {
+        if (cards[i] != -1) oss << "(" << (cards[i] / 4) << "," << (cards[i] % 4) << ") ";
+        else oss << "(-1) ";
+    }
+    return oss.str();
+}
 
-    std::tie(suitFound_flag, suit_enum_val, suit_len_in_str_val) = findSuitInString(cardStr);
+static std::string getCardString(Card::CardValue value, Card::Suit suit) {
+    return Card::ValueString[static_cast<int>(value)] + Card::SuitStringASCII[static_cast<int>(suit)];
+}
 
-    if (!suitFound_flag) {
-        throw std::invalid_argument("Invalid suit in card string: \\" + cardStr + "\\\"");
-    }
+// Process-wide immutable Card objects, one per CardId. Hands and the board
+// point into this table instead of owning heap copies, so dealing never
+// allocates and the pointers kept in PlayerWinningInfo::holeCards remain
+// valid after the next reset.
+static std::vector<Card>& sharedCardTable() {
+    static std::vector<Card> table = [] {
+        std::vector<Card> cards;
+        cards.reserve(N_CARD_IDS);
+        for (int id = 0; id < N_CARD_IDS; ++id) {
+            cards.emplace_back(static_cast<Card::Suit>(cardIdSuit(id)), static_cast<Card::CardValue>(cardIdValue(id)));
+        }
+        return cards;
+    }();
+    return table;
+}
 
-    if (cardStr.length() <= suit_len_in_str_val) {
-         throw std::invalid_argument("Card string is too short (likely only a suit): \\" + cardStr + "\\\"");
-    }
-    std::string valueStr = cardStr.substr(0, cardStr.length() - suit_len_in_str_val);
-    if (valueStr.empty()) {
-         throw std::invalid_argument("Value part of card string is empty after suit extraction: \\" + cardStr + "\\\"");
-    }
+static Card* sharedCard(int id) {
+    return isValidCardId(id) ? &sharedCardTable()[id] : nullptr;
+}
 
-    Card::CardValue value_enum_val = Card::Two; // Default
-    bool valueFound_flag = false;
+static bool isSharedCard(const Card* card) {
+    const std::vector<Card>& table = sharedCardTable();
+    return card >= table.data() && card < table.data() + table.size();
+}
 
-    // Convert valueStr to uppercase for case-insensitive comparison for single char values
-    std::string valueStrUpper = valueStr;
-    if (valueStrUpper.length() == 1) {
-        valueStrUpper[0] = static_cast<char>(std::toupper(static_cast<unsigned char>(valueStrUpper[0])));
-    }
-    // For "10", it remains "10"
+static CardId cardIdOf(const Card* card) {
+    if (!card) return NO_CARD;
+    return makeCardId(static_cast<int>(card->getValue()), static_cast<int>(card->getSuit()));
+}
 
-    for (int v_idx = 0; v_idx < CARDVALUESIZE; ++v_idx) {
-        // Compare with stored Card::ValueString (which are uppercase e.g., "A", "K", "10")
-        if (Card::ValueString[v_idx] == valueStrUpper) {
-            value_enum_val = static_cast<Card::CardValue>(v_idx);
-            valueFound_flag = true;
-            break;
+// Card::card2int for every id, looked up once so the potential evaluator can
+// be fed straight from card ids. NO_CARD (a missing card) and any other
+// out-of-range id throw; every caller treats that as "no evaluation".
+static int card2intById(CardId id) {
+    static const std::vector<int> table = [] {
+        std::vector<int> ints(N_CARD_IDS);
+        for (int id = 0; id < N_CARD_IDS; ++id) ints[id] = Card::card2int(sharedCardTable()[id]);
+        return ints;
+    }();
+    if (!isValidCardId(id)) {
+        throw std::invalid_argument("card2intById: invalid card id " + std::to_string(static_cast<int>(id)));
+    }
+    return table[id];
+}
+
+// evaluate_holdem_with_potential on phevaluator card ints (hole first). A flop
+// or turn is answered from the shared equity table when one is installed and
+// its class has a valid potential; otherwise the hand is evaluated live.
+static int potentialWithTable(const std::vector<int>& all_cards) {
+    const EquityTable::Table* table = EquityTable::shared();
+    const size_t n_board = all_cards.size() >= N_HOLE_CARDS ? all_cards.size() - N_HOLE_CARDS : 0;
+    if (table && (n_board == EquityTable::FLOP_CARDS || n_board == EquityTable::TURN_CARDS)) {
+        CardId ids[N_HOLE_CARDS + EquityTable::TURN_CARDS];
+        uint64_t seen = 0;
+        bool valid = true;
+        for (size_t i = 0; i < all_cards.size() && valid; ++i) {
+            valid = isValidCardId(all_cards[i]) && !(seen & cardIdBit(static_cast<CardId>(all_cards[i])));
+            if (valid) {
+                ids[i] = static_cast<CardId>(all_cards[i]);
+                seen |= cardIdBit(ids[i]);
+            }
         }
-        // Special handling for 'T' vs "10"
-        if (Card::ValueString[v_idx] == "10" && valueStrUpper == "T") {
-            value_enum_val = static_cast<Card::CardValue>(v_idx); // This should map to Card::Ten
-            valueFound_flag = true;
-            break;
+        EquityTable::Entry entry;
+        if (valid && table->find(ids, ids + N_HOLE_CARDS, static_cast<int>(n_board), entry) &&
+            entry.potential != EquityTable::INVALID_POTENTIAL) {
+            return entry.potential;
         }
     }
+    return evaluate_holdem_with_potential(all_cards.data(), all_cards.size());
+}
 
-    if (!valueFound_flag) {
-        throw std::invalid_argument("Invalid value string: \\" + valueStr + "\\\" in card \\" + cardStr + "\\\"");
-    }
-    return {value_enum_val, suit_enum_val};
+// evaluate_2cards rank (1 = AA ... 169 = 72o) and the (170 - rank) / 169
+// strength of every hole pair, indexed by range index. The ranking lives in
+// evaluator_extended.c, so the table is filled from it once per process.
+struct PreflopEntry {
+    int rank;
+    float strength;
+};
+
+static float preflopStrengthFromRank(int rank) {
+    return static_cast<float>(170 - rank) / 169.0f;
 }
 
-static std::string getCardString(Card::CardValue value, Card::Suit suit) {
-    return Card::ValueString[static_cast<int>(value)] + Card::SuitStringASCII[static_cast<int>(suit)];
+static const PreflopEntry* preflopEntry(CardId c1, CardId c2) {
+    static const std::vector<PreflopEntry> table = [] {
+        std::vector<PreflopEntry> entries(RangeLut::N_RANGE_IDX);
+        for (int idx = 0; idx < RangeLut::N_RANGE_IDX; ++idx) {
+            const int rank = evaluate_2cards(RangeLut::rangeCard1(idx), RangeLut::rangeCard2(idx));
+            entries[idx] = {rank, preflopStrengthFromRank(rank)};
+        }
+        return entries;
+    }();
+    const int idx = RangeLut::rangeIdx(c1, c2);
+    return idx >= 0 ? &table[idx] : nullptr;
+}
+
+// Same fallbacks as getHandValuebyPlayer: 169 unless two distinct cards.
+static float preflopStrengthOf(const PokerPlayer* player) {
+    const PreflopEntry* entry = (player && player->hand.size() == 2)
+                                    ? preflopEntry(cardIdOf(player->hand[0]), cardIdOf(player->hand[1]))
+                                    : nullptr;
+    return entry ? entry->strength : preflopStrengthFromRank(169);
+}
+
+// Writes an n-wide one-hot block (all zeros when idx is out of range) and
+// returns the position just past it; used by the observation writers.
+static float* writeOneHot(float* out, int n, int idx) {
+    std::fill(out, out + n, 0.0f);
+    if (idx >= 0 && idx < n) out[idx] = 1.0f;
+    return out + n;
 }
 
 // Cache for canonical suit map results. Key is board long, value is the map.
-static std::map<int64_t, std::vector<int>> suit_map_cache;
+// thread_local: envs stepped concurrently (PokerEnvBatch) each fill their own copy.
+static thread_local std::map<int64_t, std::vector<int>> suit_map_cache;
 
 // ================================
 // PokerEnv Implementation
 // ================================
 
+// Seed of an env built without game_settings.seed: 64 bits from random_device.
+static uint64_t entropySeed() {
+    std::random_device rd;
+    return (static_cast<uint64_t>(rd()) << 32) ^ rd();
+}
+
 PokerEnv::PokerEnv(const nlohmann::json& config,
                   int nSeats, const std::vector<float>& bet_sizes_as_frac_of_pot, bool uniform_action_interpolation,
                   int smallBlind, int bigBlind, int ante, int defaultStackSize)
@@ -190,7 +235,7 @@ PokerEnv::PokerEnv(const nlohmann::json& config,
       betSizesListAsFracOfPot(bet_sizes_as_frac_of_pot),
       uniformActionInterpolation_member(uniform_action_interpolation),
       N_SEATS(nSeats),
-      m_rng(std::random_device{}())
+      m_rng(entropySeed())
 {
 
     // 安全地读取配置，处理空配置的情况
@@ -203,9 +248,7 @@ PokerEnv::PokerEnv(const nlohmann::json& config,
     // 读取观察模式配置
     // 首先从顶层读取debug_obs_flag（用于Python绑定兼容性）
     debug_obs_flag = args_config.value("debug_obs_flag", false);
-    #ifdef DEBUG_POKER_ENV
-    std::cout << "PokerEnv constructor: debug_obs_flag=" << debug_obs_flag << std::endl;
-#endif
+    POKER_LOG_DEBUG("PokerEnv constructor: debug_obs_flag=" << debug_obs_flag);
     if (args_config.contains("game_settings") && args_config["game_settings"].is_object()) {
         const auto& game_settings = args_config["game_settings"];
         use_simplified_observation = game_settings.value("use_simplified_observation", false);
@@ -213,6 +256,19 @@ PokerEnv::PokerEnv(const nlohmann::json& config,
         debug_obs_flag = game_settings.value("debug_obs_flag", debug_obs_flag);
         FIRST_ACTION_NO_CALL = game_settings.value("first_action_no_call", false);
         IS_FIXED_LIMIT_GAME = game_settings.value("is_fixed_limit_game", false);
+        // 离线权益表（PokerEnv::generate_equity_table 生成），进程内共享一份映射
+        const std::string equity_table_path = game_settings.value("equity_table_path", std::string());
+        if (!equity_table_path.empty()) {
+            EquityTable::installShared(equity_table_path);
+        }
+        // 固定随机种子（筹码/按钮/加注插值/发牌）；未设置时取自 random_device
+        if (game_settings.contains("seed") && game_settings["seed"].is_number_integer()) {
+            seed(game_settings["seed"].get<uint64_t>());
+        }
+        // 进程级日志级别（PokerLog.h），默认 warn
+        if (game_settings.contains("log_level") && game_settings["log_level"].is_string()) {
+            set_log_level_py(game_settings["log_level"].get<std::string>());
+        }
 
     } else {
         // 当没有配置文件时，尝试从默认配置文件读取
@@ -281,6 +337,16 @@ PokerEnv::PokerEnv(const nlohmann::json& config,
 
     ALL_ROUNDS_LIST = {PREFLOP, FLOP, TURN, RIVER};
     N_ACTIONS = 2 + betSizesListAsFracOfPot.size();
+    if (N_SEATS > Showdown::MAX_SEATS) {
+        throw std::invalid_argument("PokerEnv: " + std::to_string(N_SEATS) + " seats, at most " +
+                                    std::to_string(Showdown::MAX_SEATS) + " supported");
+    }
+    if (N_ACTIONS > LegalActionSet::MAX_ACTIONS) {
+        throw std::invalid_argument("PokerEnv: " + std::to_string(betSizesListAsFracOfPot.size()) +
+                                    " bet sizes configured, at most " + std::to_string(LegalActionSet::MAX_ACTIONS - 2) +
+                                    " supported");
+    }
+    m_kernels = &selectTableKernels<ActionRecord>(N_SEATS, N_ACTIONS);
 
     players.resize(N_SEATS);
     for (int i = 0; i < N_SEATS; ++i) {
@@ -288,22 +354,20 @@ PokerEnv::PokerEnv(const nlohmann::json& config,
          if (IS_EVALUATING && !startingStackSizesList.empty() && i < startingStackSizesList.size()){
             stackSize = startingStackSizesList[i];
         } else if (IS_EVALUATING) {
-            std::uniform_int_distribution<int> stackDist(BIG_BLIND, DEFAULT_STACK_SIZE);
-            stackSize = stackDist(m_rng);
+            stackSize = m_rng.uniformInt(BIG_BLIND, DEFAULT_STACK_SIZE);
         }
         players[i] = new PokerPlayer(i, stackSize);
     }
 
     // REWARD_SCALAR will be calculated after reset() is called and blinds are posted
 
-    deck = std::make_unique<Deck>();
+    deck.fill();
 
     communityCards.resize(N_COMMUNITY_CARDS, nullptr);
 
     sidePots.reserve(N_SEATS); // Max possible side pots
 
-    // std::uniform_int_distribution<int> buttonDist(0, N_SEATS - 1);
-    // buttonPos = buttonDist(m_rng);
+    // buttonPos = m_rng.uniformInt(0, N_SEATS - 1);
     buttonPos = 4;
     // sbPos, bbPos, currentPlayer will be set in reset()
 
@@ -352,8 +416,7 @@ PokerEnv::PokerEnv(const nlohmann::json& config,
             }
         }
     }
-    _initPrivObsLookUp(); // Initialize LUT in constructor
-    _initRangeIdxLut(); // Initialize range_idx LUT in constructor
+    _initPrivObsLookUp(); // Pick the shared private-observation table for suits_matter
     actions_this_street.resize(N_SEATS, 0); // 初始化actions_this_street
 
     bool custom_scenario = false;
@@ -392,6 +455,7 @@ PokerEnv::PokerEnv(const nlohmann::json& config,
     // 初始化手牌强度缓存
     _initialHandStrengthCache.resize(N_SEATS, 0.0f);
     _handPotentialCache.resize(N_SEATS, {0, 0});
+    _handPotentialDirty = 0;
 
     // 初始化私有信息缓存
     cached_private_info.resize(N_SEATS);
@@ -410,106 +474,164 @@ PokerEnv::PokerEnv(const nlohmann::json& config,
 
 PokerEnv::~PokerEnv() {
     for (PokerPlayer* p : players) {
-        if (p) { // Check if player pointer is not null
-            for (Card* c : p->hand) {
-                delete c; // Delete Card objects PokerEnv allocated for player hands
-            }
-            // p->hand.clear(); // PokerPlayer's destructor will call clear()
-            delete p;     // Delete the PokerPlayer object itself
-        }
+        // Hand cards point into the shared card table and are not owned here.
+        delete p;
     }
     players.clear();
 
-    // 清理 PokerEnv 拥有的 communityCards
-    for (Card* c : communityCards) {
-        delete c;
-    }
     communityCards.clear();
-
-    m_privObsLut.clear(); // Clear LUT in destructor
-    m_rangeIdxLut.clear(); // Clear range_idx LUT in destructor
-    m_idxToRangeLut.clear(); // Clear new reverse LUT in destructor
-    // deck is std::unique_ptr, handles itself
 }
 
-void PokerEnv::_initPrivObsLookUp() {
-    m_privObsLut.clear();
-    const int N_RANKS_CONST = 13;
-    const int N_SUITS_CONST = 4;
-    const int N_CARDS_IN_DECK = N_RANKS_CONST * N_SUITS_CONST;
-    const int N_HOLE_CARDS_CONST = 2;
-
-    bool suits_matter = true;
-    if (args_config.contains("game_settings") && args_config["game_settings"].is_object() &&
-        args_config["game_settings"].contains("suits_matter") && args_config["game_settings"]["suits_matter"].is_boolean()) {
-        suits_matter = args_config["game_settings"]["suits_matter"].get<bool>();
-    }
-
-    const int D_per_card = suits_matter ? (N_RANKS_CONST + N_SUITS_CONST) : N_RANKS_CONST;
-    const int priv_obs_size = N_HOLE_CARDS_CONST * D_per_card;
+// Reseeds the env RNG (dealing, stack/button draws, action interpolation).
+// The same seed gives the same hands on every platform (FastRng.h).
+void PokerEnv::seed(uint64_t seedValue) {
+    m_rng.seed(seedValue);
+    _invalidateLegalActions(); // interpolated raise amounts come from the new stream
+}
 
-    int current_idx = 0;
-    for (int c1_1d = 0; c1_1d < N_CARDS_IN_DECK; ++c1_1d) {
-        for (int c2_1d = c1_1d + 1; c2_1d < N_CARDS_IN_DECK; ++c2_1d) {
-            int64_t range_idx = static_cast<int64_t>(current_idx);
-            std::vector<float> priv_obs(priv_obs_size, 0.0f);
+// ================================
+// Copying (search / rollouts)
+// ================================
+// Copies configuration and game state without touching the config JSON parser,
+// the config file or any lookup table. Hand and board cards point into the
+// shared card table, so copying a player or the board is a plain pointer copy.
+PokerEnv::PokerEnv(const PokerEnv& other) {
+    // --- configuration ---
+    args_config = other.args_config;
+    SMALL_BLIND = other.SMALL_BLIND;
+    BIG_BLIND = other.BIG_BLIND;
+    ANTE = other.ANTE;
+    DEFAULT_STACK_SIZE = other.DEFAULT_STACK_SIZE;
+    betSizesListAsFracOfPot = other.betSizesListAsFracOfPot;
+    uniformActionInterpolation_member = other.uniformActionInterpolation_member;
+    N_SEATS = other.N_SEATS;
+    N_ACTIONS = other.N_ACTIONS;
+    m_kernels = other.m_kernels;
+    IS_EVALUATING = other.IS_EVALUATING;
+    debug_obs_flag = other.debug_obs_flag;
+    use_simplified_observation = other.use_simplified_observation;
+    FIRST_ACTION_NO_CALL = other.FIRST_ACTION_NO_CALL;
+    IS_FIXED_LIMIT_GAME = other.IS_FIXED_LIMIT_GAME;
+    startingStackSizesList = other.startingStackSizesList;
+    std::copy(std::begin(other.ROUND_BEFORE), std::end(other.ROUND_BEFORE), std::begin(ROUND_BEFORE));
+    std::copy(std::begin(other.ROUND_AFTER), std::end(other.ROUND_AFTER), std::begin(ROUND_AFTER));
+    ALL_ROUNDS_LIST = other.ALL_ROUNDS_LIST;
+    MAX_N_RAISES_PER_ROUND = other.MAX_N_RAISES_PER_ROUND;
+    max_rounds_per_hand = other.max_rounds_per_hand;
+    fix_utg_position = other.fix_utg_position;
+    end_with_round = other.end_with_round;
+    m_privObsSuitsMatter = other.m_privObsSuitsMatter;
+    ALL_FEATURE_SIZE = other.ALL_FEATURE_SIZE;
+
+    players.reserve(other.players.size());
+    for (const PokerPlayer* p : other.players) {
+        players.push_back(new PokerPlayer(*p));
+    }
+
+    // --- game state ---
+    copy_state_from(other);
+    m_rng = other.m_rng; // a clone replays the same future cards/interpolations
+}
 
-            int card1_value = c1_1d / N_SUITS_CONST;
-            int card1_suit = c1_1d % N_SUITS_CONST;
-            int card2_value = c2_1d / N_SUITS_CONST;
-            int card2_suit = c2_1d % N_SUITS_CONST;
+std::unique_ptr<PokerEnv> PokerEnv::clone() const {
+    return std::unique_ptr<PokerEnv>(new PokerEnv(*this));
+}
 
-            // Card 1 encoding (smaller 1D index)
-            int slot_offset = D_per_card * 0;
-            if (card1_value >= 0 && card1_value < N_RANKS_CONST) {
-                priv_obs[slot_offset + card1_value] = 1.0f;
-            }
-            if (suits_matter && card1_suit >= 0 && card1_suit < N_SUITS_CONST) {
-                priv_obs[slot_offset + N_RANKS_CONST + card1_suit] = 1.0f;
-            }
+// Overwrites this env's game state with src's: stacks, bets, pots, cards,
+// round, actor, betting bookkeeping, histories and per-player caches. Both
+// envs must have been built with the same table configuration; configuration
+// fields are not copied (and the config JSON is not looked at). The target
+// keeps its own RNG, so several rollouts from one state diverge unless they
+// are reseeded. Buffers are reused, so repeated copies into the same target
+// allocate only when a history grows beyond what the target held before.
+void PokerEnv::copy_state_from(const PokerEnv& src) {
+    if (&src == this) return;
+    if (src.N_SEATS != N_SEATS || src.N_ACTIONS != N_ACTIONS || src.players.size() != players.size()) {
+        throw std::invalid_argument("PokerEnv::copy_state_from: table configuration mismatch (N_SEATS " +
+                                    std::to_string(src.N_SEATS) + " vs " + std::to_string(N_SEATS) +
+                                    ", N_ACTIONS " + std::to_string(src.N_ACTIONS) + " vs " + std::to_string(N_ACTIONS) + ")");
+    }
+
+    for (size_t i = 0; i < players.size(); ++i) {
+        *players[i] = *src.players[i];
+    }
+
+    deck = src.deck;
+    communityCards = src.communityCards;
+    sidePots = src.sidePots;
+    mainPot = src.mainPot;
+    currentMainPot = src.currentMainPot;
+    currentSidePots = src.currentSidePots;
+
+    buttonPos = src.buttonPos;
+    sbPos = src.sbPos;
+    bbPos = src.bbPos;
+    currentPlayer = src.currentPlayer;
+    currentRound = src.currentRound;
+    handIsOver = src.handIsOver;
+    REWARD_SCALAR = src.REWARD_SCALAR;
+
+    lastAction_member = src.lastAction_member;
+    lastRaiser = src.lastRaiser;
+    nRaisesThisRound = src.nRaisesThisRound;
+    nActionsThisEpisode = src.nActionsThisEpisode;
+    cappedRaise_member = src.cappedRaise_member;
+    actions_this_street = src.actions_this_street;
+
+    _initialHandStrengthCache = src._initialHandStrengthCache;
+    _handPotentialCache = src._handPotentialCache;
+    _handPotentialDirty = src._handPotentialDirty;
+    cached_private_info = src.cached_private_info;
+    _currentPlayerInitialStrength = src._currentPlayerInitialStrength;
+    _currentPlayerHandPotential = src._currentPlayerHandPotential;
+
+    observationHistory = src.observationHistory;
+    actionHistory = src.actionHistory;
+    _clearLastHandWinnings();
+    for (const PlayerWinningInfo& lw : src.lastHandWinnings) {
+        _recordWinning(lw.seatId, lw.amountWon, lw.potIndex, lw.handDescriptionId, lw.holeCards.data(), lw.holeCards.size());
+    }
+    _invalidateLegalActions(); // resolved raise amounts may have been sampled from src's RNG
+    _syncPotBookkeeping();
+    _syncSeatState();
+}
 
-            // Card 2 encoding (larger 1D index)
-            slot_offset = D_per_card * 1;
-            if (card2_value >= 0 && card2_value < N_RANKS_CONST) {
-                priv_obs[slot_offset + card2_value] = 1.0f;
-            }
-            if (suits_matter && card2_suit >= 0 && card2_suit < N_SUITS_CONST) {
-                priv_obs[slot_offset + N_RANKS_CONST + card2_suit] = 1.0f;
-            }
+std::unique_ptr<PokerEnv> PokerEnv::clone_py() const {
+    return clone();
+}
 
-            m_privObsLut[range_idx] = priv_obs;
-            current_idx++;
-        }
-    }
+void PokerEnv::copy_state_from_py(const PokerEnv& src) {
+    copy_state_from(src);
 }
 
-void PokerEnv::_initRangeIdxLut() {
-    m_rangeIdxLut.clear();
-    m_idxToRangeLut.clear(); // Clear the reverse LUT as well
-    int current_idx = 0;
-    for (int c1_1d = 0; c1_1d < 52; ++c1_1d) {
-        for (int c2_1d = c1_1d + 1; c2_1d < 52; ++c2_1d) {
-            m_rangeIdxLut[std::make_pair(c1_1d, c2_1d)] = static_cast<int64_t>(current_idx);
-            m_idxToRangeLut[static_cast<int64_t>(current_idx)] = std::make_pair(c1_1d, c2_1d);
-            current_idx++;
-        }
+// The range-index and private-observation tables are process-wide and
+// immutable (RangeLut.h); all an env keeps is which private-observation
+// variant its config asks for.
+void PokerEnv::_initPrivObsLookUp() {
+    m_privObsSuitsMatter = true;
+    if (args_config.contains("game_settings") && args_config["game_settings"].is_object() &&
+        args_config["game_settings"].contains("suits_matter") && args_config["game_settings"]["suits_matter"].is_boolean()) {
+        m_privObsSuitsMatter = args_config["game_settings"]["suits_matter"].get<bool>();
     }
 }
 
-
 std::tuple<std::vector<std::vector<float>>, std::vector<float>> PokerEnv::reset() {
     std::fill(actions_this_street.begin(), actions_this_street.end(), 0); // 重置行动次数
     return reset(false); // Full reset
 }
 
 std::tuple<std::vector<std::vector<float>>, std::vector<float>> PokerEnv::reset(bool isNewRound) {
+    POKER_PERF_SCOPE(PokerPerf::Timer::Reset);
     std::fill(actions_this_street.begin(), actions_this_street.end(), 0); // 重置行动次数
     // 清空过往的观察值历史
     observationHistory.clear();
     // 重置历史动作记录
     actionHistory.clear();
 
-    deck->shuffle();
+    // Only the cards this hand can use are shuffled: hole cards, the board and
+    // the three burns.
+    deck.fill();
+    deck.shuffleTop(m_rng, N_SEATS * N_HOLE_CARDS + N_COMMUNITY_CARDS + 3);
     std::fill(communityCards.begin(), communityCards.end(), nullptr);
 
     if (!isNewRound) { // This is a full reset
@@ -527,7 +649,6 @@ std::tuple<std::vector<std::vector<float>>, std::vector<float>> PokerEnv::reset(
         } else if (IS_EVALUATING) {
             // Original logic for evaluating mode (random stacks)
             std::set<int> usedStacks;
-            std::uniform_int_distribution<int> stackDist(BIG_BLIND, DEFAULT_STACK_SIZE);
             for (int i = 0; i < N_SEATS; ++i) {
                 int randomStack;
                 if (!startingStackSizesList.empty() && i < static_cast<int>(startingStackSizesList.size())){
@@ -536,7 +657,7 @@ std::tuple<std::vector<std::vector<float>>, std::vector<float>> PokerEnv::reset(
                     int attempts = 0;
                     const int maxAttempts = 1000;
                     do {
-                        randomStack = stackDist(m_rng);
+                        randomStack = m_rng.uniformInt(BIG_BLIND, DEFAULT_STACK_SIZE);
                         attempts++;
                     } while (usedStacks.count(randomStack) && attempts < maxAttempts);
                     if (usedStacks.count(randomStack)) { // still collision after attempts
@@ -584,8 +705,7 @@ std::tuple<std::vector<std::vector<float>>, std::vector<float>> PokerEnv::reset(
         if (isNewRound) {
             buttonPos = (buttonPos + 1) % N_SEATS;
         } else {
-            std::uniform_int_distribution<int> buttonDist(0, N_SEATS - 1);
-            buttonPos = buttonDist(m_rng);
+            buttonPos = m_rng.uniformInt(0, N_SEATS - 1);
         }
 
         if (N_SEATS == 2) {
@@ -617,27 +737,27 @@ std::tuple<std::vector<std::vector<float>>, std::vector<float>> PokerEnv::reset(
     _putCurrentBetsIntoMainPotAndSidePots();
     _postSmallBlind();
     _postBigBlind();
+    _syncPotBookkeeping();
+    _syncSeatState();
 
     _dealHoleCards();
 
     // 建立初始手牌强度缓存
     for (int i = 0; i < N_SEATS; ++i) {
         if (players[i] && players[i]->hand.size() == 2) {
-            int handRank = getHandValuebyPlayer(i); // 1-169排名，1=最强，169=最弱
-            // 转换为0-1范围的强度值：强度 = (170 - rank) / 169
-            // AA(rank=1) -> strength=169/169=1.0, 72o(rank=169) -> strength=1/169≈0.006
-            _initialHandStrengthCache[i] = static_cast<float>(170 - handRank) / 169.0f;
+            // 查翻前表：强度 = (170 - rank) / 169，rank 为 1-169 排名（1=最强）
+            // AA(rank=1) -> strength=1.0, 72o(rank=169) -> strength=1/169≈0.006
+            _initialHandStrengthCache[i] = preflopStrengthOf(players[i]);
         } else {
             _initialHandStrengthCache[i] = 0.0f; // 无效手牌
         }
     }
 
     currentPlayer = _getFirstToActPreFlop();
-    _updateHandPotentialForAllPlayers();
+    _invalidateHandPotentials();
 
     // 计算并存储当前观察值到历史中
-    std::vector<float> currentObservation = _calculateCurrentObservationByConfig();
-    observationHistory.push_back(currentObservation);
+    _recordObservation();
 
 
 
@@ -649,22 +769,16 @@ std::tuple<std::vector<std::vector<float>>, std::vector<float>> PokerEnv::reset(
 
 // 新增：可以设置手牌和公共牌的重载版本
 std::tuple<std::vector<std::vector<float>>, std::vector<float>> PokerEnv::reset(bool isNewRound, const std::vector<std::vector<int>>& hole_cards, const std::vector<int>& board_cards) {
+    POKER_PERF_SCOPE(PokerPerf::Timer::Reset);
     std::fill(actions_this_street.begin(), actions_this_street.end(), 0); // 重置行动次数
     // 先进行标准重置
     observationHistory.clear();
     // 重置历史动作记录
     actionHistory.clear();
 
-    // 如果有指定手牌或公共牌，创建新的干净的deck
-    bool hasSpecifiedCards = !hole_cards.empty() || !board_cards.empty();
-    if (hasSpecifiedCards) {
-        // 创建新的完整deck
-        deck = std::make_unique<Deck>();
-        deck->shuffle();
-    } else {
-        // 没有指定卡牌时，使用现有deck并洗牌
-        deck->shuffle();
-    }
+    // 重新装满并洗牌；指定的手牌/公共牌随后从deck中移除
+    deck.fill();
+    deck.shuffle(m_rng);
 
     std::fill(communityCards.begin(), communityCards.end(), nullptr);
 
@@ -683,7 +797,6 @@ std::tuple<std::vector<std::vector<float>>, std::vector<float>> PokerEnv::reset(
         } else if (IS_EVALUATING) {
             // Original logic for evaluating mode (random stacks)
             std::set<int> usedStacks;
-            std::uniform_int_distribution<int> stackDist(BIG_BLIND, DEFAULT_STACK_SIZE);
             for (int i = 0; i < N_SEATS; ++i) {
                 int randomStack;
                 if (!startingStackSizesList.empty() && i < static_cast<int>(startingStackSizesList.size())){
@@ -692,7 +805,7 @@ std::tuple<std::vector<std::vector<float>>, std::vector<float>> PokerEnv::reset(
                     int attempts = 0;
                     const int maxAttempts = 1000;
                     do {
-                        randomStack = stackDist(m_rng);
+                        randomStack = m_rng.uniformInt(BIG_BLIND, DEFAULT_STACK_SIZE);
                         attempts++;
                     } while (usedStacks.count(randomStack) && attempts < maxAttempts);
                     if (usedStacks.count(randomStack)) { // still collision after attempts
@@ -739,8 +852,7 @@ std::tuple<std::vector<std::vector<float>>, std::vector<float>> PokerEnv::reset(
         if (isNewRound) {
             buttonPos = (buttonPos + 1) % N_SEATS;
         } else {
-            std::uniform_int_distribution<int> buttonDist(0, N_SEATS - 1);
-            buttonPos = buttonDist(m_rng);
+            buttonPos = m_rng.uniformInt(0, N_SEATS - 1);
         }
 
         if (N_SEATS == 2) {
@@ -779,13 +891,15 @@ std::tuple<std::vector<std::vector<float>>, std::vector<float>> PokerEnv::reset(
     } else {
         // 无效的公共牌数量，默认为PREFLOP
         currentRound = PREFLOP;
-        printf("警告: 无效的公共牌数量 %d，默认设置为PREFLOP\n", num_board_cards);
+        POKER_LOG_WARN("警告: 无效的公共牌数量 " << num_board_cards << "，默认设置为PREFLOP");
     }
 
     _postAntes();
     _putCurrentBetsIntoMainPotAndSidePots();
     _postSmallBlind();
     _postBigBlind();
+    _syncPotBookkeeping();
+    _syncSeatState();
 
     // 记录哪些玩家已经设置了手牌
     std::vector<bool> player_hand_set(N_SEATS, false);
@@ -797,20 +911,20 @@ std::tuple<std::vector<std::vector<float>>, std::vector<float>> PokerEnv::reset(
         for (int i = 0; i < max_board_cards; ++i) {
             int card_idx = board_cards[i];
             if (card_idx >= 0 && card_idx < 52) {
-                // 创建Card对象 (索引 = suit * 13 + value)
+                // 卡牌索引 = value * 4 + suit
                 Card::Suit suit = static_cast<Card::Suit>(card_idx % 4);
                 Card::CardValue value = static_cast<Card::CardValue>(card_idx / 4);
 
                 // 从 Deck 中移除该卡牌
-                if (!deck->removeCard(suit, value)) {
+                if (!deck.remove(static_cast<CardId>(card_idx))) {
                     // 移除失败，说明卡牌不在 Deck 中（已被使用/重复）
                     std::string card_str = getCardString(value, suit);
                     throw std::runtime_error("Duplicate card detected in board cards: " + card_str + " is already specified");
                 }
 
-                communityCards[i] = new Card(suit, value);
+                communityCards[i] = sharedCard(card_idx);
             } else {
-                printf("警告: 公共牌索引无效 (%d)，跳过该牌\n", card_idx);
+                POKER_LOG_WARN("警告: 公共牌索引无效 (" << card_idx << ")，跳过该牌");
             }
         }
 
@@ -834,15 +948,15 @@ std::tuple<std::vector<std::vector<float>>, std::vector<float>> PokerEnv::reset(
                         throw std::runtime_error("Duplicate card detected for player " + std::to_string(i) + ": both hole cards are " + card_str);
                     }
 
-                    // 创建Card对象 (索引 = suit * 13 + value)
+                    // 卡牌索引 = value * 4 + suit
                     Card::Suit suit1 = static_cast<Card::Suit>(card1_idx % 4);
                     Card::CardValue value1 = static_cast<Card::CardValue>(card1_idx / 4);
                     Card::Suit suit2 = static_cast<Card::Suit>(card2_idx % 4);
                     Card::CardValue value2 = static_cast<Card::CardValue>(card2_idx / 4);
 
                     // 从 Deck 中移除这两张卡牌
-                    bool card1_removed = deck->removeCard(suit1, value1);
-                    bool card2_removed = deck->removeCard(suit2, value2);
+                    bool card1_removed = deck.remove(static_cast<CardId>(card1_idx));
+                    bool card2_removed = deck.remove(static_cast<CardId>(card2_idx));
 
                     if (!card1_removed || !card2_removed) {
                         // 如果任何一张卡牌移除失败，说明有重复
@@ -866,12 +980,11 @@ std::tuple<std::vector<std::vector<float>>, std::vector<float>> PokerEnv::reset(
                         players[i]->hand.resize(2);
                     }
 
-                    // 创建新的Card对象并分配给玩家
-                    players[i]->hand[0] = new Card(suit1, value1);
-                    players[i]->hand[1] = new Card(suit2, value2);
+                    players[i]->hand[0] = sharedCard(card1_idx);
+                    players[i]->hand[1] = sharedCard(card2_idx);
                     player_hand_set[i] = true;
                 } else {
-                    printf("警告: 玩家 %d 的手牌索引无效 (%d, %d)，将从剩余牌中随机发牌\n", i, card1_idx, card2_idx);
+                    POKER_LOG_WARN("警告: 玩家 " << i << " 的手牌索引无效 (" << card1_idx << ", " << card2_idx << ")，将从剩余牌中随机发牌");
                 }
             }
         }
@@ -881,24 +994,24 @@ std::tuple<std::vector<std::vector<float>>, std::vector<float>> PokerEnv::reset(
     for (int i = 0; i < N_SEATS; ++i) {
         if (!player_hand_set[i]) {
             // 为玩家i从剩余deck中发两张牌
-            if (deck->getRemainingCardCount() >= 2) {
+            if (deck.remaining() >= 2) {
                 // 确保hand有足够的空间
                 if (players[i]->hand.size() < 2) {
                     players[i]->hand.resize(2);
                 }
 
-                // 使用popCard()方法从deck中取两张牌
-                Card* card1 = deck->popCard();
-                Card* card2 = deck->popCard();
+                // 从deck中取两张牌
+                Card* card1 = sharedCard(deck.draw());
+                Card* card2 = sharedCard(deck.draw());
 
                 if (card1 && card2) {
-                    players[i]->hand[0] = new Card(*card1); // 复制card对象
-                    players[i]->hand[1] = new Card(*card2); // 复制card对象
+                    players[i]->hand[0] = card1;
+                    players[i]->hand[1] = card2;
                 } else {
-                    printf("警告: deck中取牌失败，玩家 %d 无法获得手牌\n", i);
+                    POKER_LOG_WARN("警告: deck中取牌失败，玩家 " << i << " 无法获得手牌");
                 }
             } else {
-                printf("警告: deck中剩余卡牌不足，玩家 %d 无法获得手牌\n", i);
+                POKER_LOG_WARN("警告: deck中剩余卡牌不足，玩家 " << i << " 无法获得手牌");
             }
         }
     }
@@ -906,10 +1019,9 @@ std::tuple<std::vector<std::vector<float>>, std::vector<float>> PokerEnv::reset(
     // 建立初始手牌强度缓存
     for (int i = 0; i < N_SEATS; ++i) {
         if (players[i] && players[i]->hand.size() == 2 && players[i]->hand[0] && players[i]->hand[1]) {
-            int handRank = getHandValuebyPlayer(i); // 1-169排名，1=最强，169=最弱
-            // 转换为0-1范围的强度值：强度 = (170 - rank) / 169
-            // AA(rank=1) -> strength=169/169=1.0, 72o(rank=169) -> strength=1/169≈0.006
-            _initialHandStrengthCache[i] = static_cast<float>(170 - handRank) / 169.0f;
+            // 查翻前表：强度 = (170 - rank) / 169，rank 为 1-169 排名（1=最强）
+            // AA(rank=1) -> strength=1.0, 72o(rank=169) -> strength=1/169≈0.006
+            _initialHandStrengthCache[i] = preflopStrengthOf(players[i]);
         } else {
             _initialHandStrengthCache[i] = 0.0f; // 无效手牌
         }
@@ -923,15 +1035,48 @@ std::tuple<std::vector<std::vector<float>>, std::vector<float>> PokerEnv::reset(
     }
 
 
-    _updateHandPotentialForAllPlayers();
+    _invalidateHandPotentials();
 
     // 计算并存储当前观察值到历史中
-    std::vector<float> currentObservation = _calculateCurrentObservationByConfig();
-    observationHistory.push_back(currentObservation);
+    _recordObservation();
 
     return getObservationForTransformer();
 }
 
+// 回放记录的牌局（HandHistoryReplay）：按钮位固定为 button，手牌按 hole_cards
+// 指定，并把剩余牌堆排好，使之后发出的翻牌/转牌/河牌正好是 board（0-5 张，
+// 不足的部分照常随机）。发每条街前的烧牌留在原位。
+void PokerEnv::reset_for_replay(int button, const std::vector<std::vector<int>>& hole_cards,
+                                const CardId* board, int nBoard) {
+    if (button < 0 || button >= N_SEATS) {
+        throw std::invalid_argument("reset_for_replay: button " + std::to_string(button) + " out of range for " +
+                                    std::to_string(N_SEATS) + " seats");
+    }
+    if (nBoard < 0 || nBoard > N_COMMUNITY_CARDS || (nBoard > 0 && !board)) {
+        throw std::invalid_argument("reset_for_replay: board holds " + std::to_string(nBoard) + " cards");
+    }
+
+    // 借用固定 UTG 的位置逻辑来指定按钮位（两人桌 UTG 即按钮位）
+    const int savedUtg = fix_utg_position;
+    fix_utg_position = N_SEATS == 2 ? button : (button + 3) % N_SEATS;
+    try {
+        reset(false, hole_cards, {});
+    } catch (...) {
+        fix_utg_position = savedUtg;
+        throw;
+    }
+    fix_utg_position = savedUtg;
+
+    // 发牌顺序：烧 1，翻牌 3，烧 1，转牌 1，烧 1，河牌 1
+    static constexpr int BOARD_DEPTH[N_COMMUNITY_CARDS] = {1, 2, 3, 5, 7};
+    for (int i = 0; i < nBoard; ++i) {
+        if (!deck.placeAt(board[i], BOARD_DEPTH[i])) {
+            throw std::runtime_error("reset_for_replay: board card " + std::to_string(board[i]) +
+                                     " is already dealt or the deck is too short");
+        }
+    }
+}
+
 void PokerEnv::reset(bool is_eval_sim,
                      const std::vector<std::string>& player_specific_hole_cards_str,
                      const std::vector<std::vector<int>>& player_specific_hole_cards_value,
@@ -940,17 +1085,17 @@ void PokerEnv::reset(bool is_eval_sim,
                      const std::vector<int>& deck_value,
                      const std::vector<int>& starting_stacks_config,
                      int max_rounds_per_hand_param) {
+    POKER_PERF_SCOPE(PokerPerf::Timer::Reset);
 
 #ifdef DEBUG_POKER_ENV
-    std::cout << "reset: Complex reset function called with:" << std::endl;
-    std::cout << "  board_cards_str: '" << board_cards_str << "'" << std::endl;
-    std::cout << "  board_cards_value.size(): " << board_cards_value.size() << std::endl;
-    std::cout << "  board_cards_value: [";
+    POKER_LOG_DEBUG("reset: Complex reset function called with:");
+    POKER_LOG_DEBUG("  board_cards_str: '" << board_cards_str << "'");
+    POKER_LOG_DEBUG("  board_cards_value.size(): " << board_cards_value.size());
+    std::ostringstream board_values;
     for (size_t i = 0; i < board_cards_value.size(); ++i) {
-        std::cout << board_cards_value[i];
-        if (i < board_cards_value.size() - 1) std::cout << ", ";
+        board_values << (i == 0 ? "" : ", ") << board_cards_value[i];
     }
-    std::cout << "]" << std::endl;
+    POKER_LOG_DEBUG("  board_cards_value: [" << board_values.str() << "]");
 #endif
 
     std::fill(actions_this_street.begin(), actions_this_street.end(), 0); // 重置行动次数
@@ -970,20 +1115,17 @@ void PokerEnv::reset(bool is_eval_sim,
             } else if (!startingStackSizesList.empty() && i < static_cast<int>(startingStackSizesList.size())) {
                 stack_size = startingStackSizesList[i];
             } else {
-                std::uniform_int_distribution<int> stackDist(BIG_BLIND, DEFAULT_STACK_SIZE);
-                stack_size = stackDist(m_rng);
+                stack_size = m_rng.uniformInt(BIG_BLIND, DEFAULT_STACK_SIZE);
             }
         }
-        // Clear player's hand of any PokerEnv-owned cards before PokerPlayer::reset potentially clears the vector
-        for (Card* c : players[i]->hand) delete c;
         players[i]->hand.clear();
         players[i]->reset(false, stack_size); // isNewRound=false for full player state reset
     }
     _calculateRewardScalar();
 
     // 2. Deck Setup
-    deck->spaceTheDeck(); // Clears Deck's internal storage, re-initializes all_cards_storage, and refills current_deck
-    deck->shuffle();      // Shuffles current_deck
+    deck.fill();          // All 52 cards back in the deck
+    deck.shuffle(m_rng);
 
     // Cards are now directly removed from deck when specified, no need for tracking
 
@@ -1008,8 +1150,7 @@ void PokerEnv::reset(bool is_eval_sim,
     } else {
         // 使用默认位置逻辑
         if (!is_eval_sim) {
-            std::uniform_int_distribution<int> buttonDist(0, N_SEATS - 1);
-            buttonPos = buttonDist(m_rng);
+            buttonPos = m_rng.uniformInt(0, N_SEATS - 1);
         }
         // ... (rest of button, blinds, pot state reset as before) ...
         if (N_SEATS == 2) {
@@ -1035,8 +1176,6 @@ void PokerEnv::reset(bool is_eval_sim,
     handIsOver = false;
     currentRound = PREFLOP;
 
-    // Clear PokerEnv-owned community cards
-    for (Card* c : communityCards) delete c;
     std::fill(communityCards.begin(), communityCards.end(), nullptr);
 
     // 4. Community Cards (Board) Setup
@@ -1049,12 +1188,13 @@ void PokerEnv::reset(bool is_eval_sim,
         for (const auto& card_obj : temp_board_card_objects) {
             if (community_idx < N_COMMUNITY_CARDS) {
                 // Use Deck to check for duplicates: try to remove card from deck
-                if (!deck->removeCard(card_obj.getSuit(), card_obj.getValue())) {
+                const CardId card_id = cardIdOf(&card_obj);
+                if (!deck.remove(card_id)) {
                     // Card removal failed, it's a duplicate
                     std::string card_str = getCardString(card_obj.getValue(), card_obj.getSuit());
                     throw std::runtime_error("Duplicate card detected in board cards (string): " + card_str + " is already specified");
                 }
-                communityCards[community_idx] = new Card(card_obj.getSuit(), card_obj.getValue()); // PokerEnv owns this
+                communityCards[community_idx] = sharedCard(card_id);
                 community_idx++;
                 board_set_from_string = true;
             } else break;
@@ -1069,13 +1209,13 @@ void PokerEnv::reset(bool is_eval_sim,
                 Card::CardValue v = static_cast<Card::CardValue>(card_val_int / 4);
 
                 // Use Deck to check for duplicates: try to remove card from deck
-                if (!deck->removeCard(s, v)) {
+                if (!deck.remove(static_cast<CardId>(card_val_int))) {
                     // Card removal failed, it's a duplicate
                     std::string card_str = getCardString(v, s);
                     throw std::runtime_error("Duplicate card detected in board cards: " + card_str + " is already specified");
                 }
 
-                communityCards[community_idx] = new Card(s, v); // PokerEnv owns this
+                communityCards[community_idx] = sharedCard(card_val_int);
                 community_idx++;
             } else if (community_idx >= N_COMMUNITY_CARDS) break;
         }
@@ -1147,8 +1287,10 @@ void PokerEnv::reset(bool is_eval_sim,
                         }
 
                         // Use Deck to check for duplicates: try to remove cards from deck
-                        bool card1_removed = deck->removeCard(pcard1_val_suit.second, pcard1_val_suit.first);
-                        bool card2_removed = deck->removeCard(pcard2_val_suit.second, pcard2_val_suit.first);
+                        const CardId card1_id = makeCardId(static_cast<int>(pcard1_val_suit.first), static_cast<int>(pcard1_val_suit.second));
+                        const CardId card2_id = makeCardId(static_cast<int>(pcard2_val_suit.first), static_cast<int>(pcard2_val_suit.second));
+                        bool card1_removed = deck.remove(card1_id);
+                        bool card2_removed = deck.remove(card2_id);
 
                         if (!card1_removed || !card2_removed) {
                             // If any card removal failed, it's a duplicate
@@ -1168,8 +1310,8 @@ void PokerEnv::reset(bool is_eval_sim,
 
                             throw std::runtime_error(error_msg);
                         } else {
-                            players[i]->hand[0] = new Card(pcard1_val_suit.second, pcard1_val_suit.first); // PokerEnv owns
-                            players[i]->hand[1] = new Card(pcard2_val_suit.second, pcard2_val_suit.first); // PokerEnv owns
+                            players[i]->hand[0] = sharedCard(card1_id);
+                            players[i]->hand[1] = sharedCard(card2_id);
 
                             player_card_set[i] = true;
                             p_card_set_this_iter = true;
@@ -1197,8 +1339,8 @@ void PokerEnv::reset(bool is_eval_sim,
                     Card::Suit s2 = static_cast<Card::Suit>(c2_val_int % 4); Card::CardValue v2 = static_cast<Card::CardValue>(c2_val_int / 4);
 
                     // Use Deck to check for duplicates: try to remove cards from deck
-                    bool card1_removed = deck->removeCard(s1, v1);
-                    bool card2_removed = deck->removeCard(s2, v2);
+                    bool card1_removed = deck.remove(static_cast<CardId>(c1_val_int));
+                    bool card2_removed = deck.remove(static_cast<CardId>(c2_val_int));
 
                     if (!card1_removed || !card2_removed) {
                         // If any card removal failed, it's a duplicate
@@ -1218,8 +1360,8 @@ void PokerEnv::reset(bool is_eval_sim,
 
                         throw std::runtime_error(error_msg);
                     } else {
-                        players[i]->hand[0] = new Card(s1, v1); // PokerEnv owns
-                        players[i]->hand[1] = new Card(s2, v2); // PokerEnv owns
+                        players[i]->hand[0] = sharedCard(c1_val_int);
+                        players[i]->hand[1] = sharedCard(c2_val_int);
 
                         player_card_set[i] = true;
                     }
@@ -1236,32 +1378,19 @@ void PokerEnv::reset(bool is_eval_sim,
             // players[i]->hand should already be empty or full of nullptrs from earlier
             // and resized to N_HOLE_CARDS.
             for (int j = 0; j < N_HOLE_CARDS; ++j) {
-                Card* drawn_card_ptr = deck->drawCard(); // Card* is owned by Deck
-                if (drawn_card_ptr) {
-                    // PokerEnv makes its own copy to own for its player hands
-                    players[i]->hand[j] = new Card(drawn_card_ptr->getSuit(), drawn_card_ptr->getValue());
-                } else {
-                    // Deck is empty - this is an error condition if we need to deal more.
-                    players[i]->hand[j] = nullptr; // No card available
-                    // std::cerr << "Error: Deck ran out of cards dealing to player " << i << std::endl;
-                }
+                // nullptr if the deck ran out of cards
+                players[i]->hand[j] = sharedCard(deck.draw());
             }
         }
     }
 
-    // Handle the case where no specific cards were set for anyone and no custom deck.
-    // This part seems redundant if the above logic correctly fills hands.
-    // The previous logic section from line 787-795 regarding `no_specific_hole_cards_at_all`
-    // and calling `_dealHoleCards()` can be removed if the new loop (737-756) correctly
-    // deals to unspecified players by copying from `deck->drawCard()`.
-    // The old `_dealHoleCards()` assigns `deck->drawCard()` pointers directly, which we are avoiding
-    // for PokerEnv's direct ownership of hand cards.
-
     // 8. Post Blinds/Antes
     _postAntes();
     _putCurrentBetsIntoMainPotAndSidePots();
     _postSmallBlind();
     _postBigBlind();
+    _syncPotBookkeeping();
+    _syncSeatState();
 
     // 9. Determine Current Player
     if (currentRound == PREFLOP) {
@@ -1274,19 +1403,17 @@ void PokerEnv::reset(bool is_eval_sim,
     // 建立初始手牌强度缓存
     for (int i = 0; i < N_SEATS; ++i) {
         if (players[i] && players[i]->hand.size() == 2 && players[i]->hand[0] && players[i]->hand[1]) {
-            int handRank = getHandValuebyPlayer(i); // 1-169排名，1=最强，169=最弱
-            // 转换为0-1范围的强度值：强度 = (170 - rank) / 169
-            // AA(rank=1) -> strength=169/169=1.0, 72o(rank=169) -> strength=1/169≈0.006
-            _initialHandStrengthCache[i] = static_cast<float>(170 - handRank) / 169.0f;
+            // 查翻前表：强度 = (170 - rank) / 169，rank 为 1-169 排名（1=最强）
+            // AA(rank=1) -> strength=1.0, 72o(rank=169) -> strength=1/169≈0.006
+            _initialHandStrengthCache[i] = preflopStrengthOf(players[i]);
         } else {
             _initialHandStrengthCache[i] = 0.0f; // 无效手牌
         }
     }
 
-    _updateHandPotentialForAllPlayers();
+    _invalidateHandPotentials();
     // 10. Initial Observation
-    std::vector<float> currentObservation = _calculateCurrentObservationByConfig(); // Ensure this uses final state
-    observationHistory.push_back(currentObservation);
+    _recordObservation(); // Ensure this uses final state
 
     // Function is void.
 }
@@ -1295,22 +1422,55 @@ std::tuple<std::vector<std::vector<float>>, std::vector<float>, std::vector<floa
     // This is the discrete action step.
     // It converts the discrete actionInt into a specific action type and amount,
     // validates it, and then calls the (actionType, amount) version of step.
+    // Call the step function that takes a resolved action, passing the original actionInt
+    return _stepResolved(_resolveDiscreteAction(actionInt), actionInt);
+}
 
-    // Get the environment-adjusted action formulation (potential type and amount)
-    std::vector<float> adjustedAction = _getEnvAdjustedActionFormulation(actionInt);
-
-    // Get the fixed (validated and possibly modified) action
-    std::vector<float> fixedAction = _getFixedAction(adjustedAction);
+// Action ints the legal-action scan already resolved are played as resolved
+// there, so the step matches the mask and the observation.
+// For FOLD, amount is -1. For CHECK_CALL/BET_RAISE, it's the total bet amount.
+ResolvedAction PokerEnv::_resolveDiscreteAction(int actionInt) {
+    POKER_PERF_SCOPE(PokerPerf::Timer::ResolveAction);
+    const LegalActionSet& legal = legalActionSet();
+    return legal.isResolved(actionInt)
+        ? legal.resolved[actionInt]
+        // environment-adjusted formulation, then validated (and possibly modified)
+        : _resolveAction(_formulateAction(actionInt));
+}
 
-    int finalActionType = static_cast<int>(fixedAction[0]);
-    float finalAmount = fixedAction[1]; // For FOLD, amount is -1. For CHECK_CALL/BET_RAISE, it's the total bet amount.
+// step(int) without the observation: advances the env, writes the N_SEATS
+// step rewards into `rewards` (`cap` floats) and returns done. For callers
+// that read the observation in place afterwards (PokerEnvBatch,
+// write_transformer_state / write_transformer_sequence) instead of through
+// the nested vectors step() builds. A buffer that is too small is rejected
+// before the env is touched.
+bool PokerEnv::step_core(int actionInt, float* rewards, size_t cap) {
+    if (!rewards || cap < static_cast<size_t>(N_SEATS)) {
+        throw std::invalid_argument("step_core: buffer holds " + std::to_string(cap) +
+                                    " floats, rewards need " + std::to_string(N_SEATS));
+    }
+    return _stepResolvedCore(_resolveDiscreteAction(actionInt), actionInt, rewards);
+}
 
-    // Call the step function that takes actionType and amount, passing the original actionInt
-    return step(finalActionType, finalAmount, actionInt);
+// Python-facing form; the amount is truncated to whole chips.
+std::tuple<std::vector<std::vector<float>>, std::vector<float>, std::vector<float>, bool> PokerEnv::step(int actionTypeFromCaller, float amountFromCaller, int originalActionInt) {
+    return _stepResolved(makeResolvedAction(actionTypeFromCaller, static_cast<int>(amountFromCaller)), originalActionInt);
 }
 
 
-std::tuple<std::vector<std::vector<float>>, std::vector<float>, std::vector<float>, bool> PokerEnv::step(int actionTypeFromCaller, float amountFromCaller, int originalActionInt) {
+std::tuple<std::vector<std::vector<float>>, std::vector<float>, std::vector<float>, bool> PokerEnv::_stepResolved(ResolvedAction intended, int originalActionInt) {
+    std::vector<float> rewards(N_SEATS, 0.0f);
+    const bool currentIsDone = _stepResolvedCore(intended, originalActionInt, rewards.data());
+
+    // 使用getObservationForTransformer()并返回其结果加上rewards和currentIsDone
+    auto [sequence_features, state_features] = getObservationForTransformer();
+    return std::make_tuple(std::move(sequence_features), std::move(state_features), std::move(rewards), currentIsDone);
+}
+
+// Applies the action and advances the hand; rewards[0..N_SEATS) gets the step
+// rewards (zero unless the hand finished). Returns done.
+bool PokerEnv::_stepResolvedCore(ResolvedAction intended, int originalActionInt, float* rewards) {
+    POKER_PERF_SCOPE(PokerPerf::Timer::Step);
     if (currentPlayer < 0 || currentPlayer >= N_SEATS || !players[currentPlayer]) {
         throw std::runtime_error("PokerEnv::step(actionType, amount): Invalid current player index: " + std::to_string(currentPlayer));
     }
@@ -1318,60 +1478,51 @@ std::tuple<std::vector<std::vector<float>>, std::vector<float>, std::vector<floa
     // 检查行动次数限制
     // this->max_rounds_per_hand 是指一条街上允许的单个玩家最大行动次数。
     if (this->max_rounds_per_hand > 0 && actions_this_street[currentPlayer] >= this->max_rounds_per_hand) {
-        if (actionTypeFromCaller == BET_RAISE) {
+        if (intended.type == BET_RAISE) {
             // 玩家已达到行动次数上限，且意图是BET_RAISE
             // 尝试将动作强制改为CHECK_CALL，如果CHECK_CALL不可行，则强制为FOLD
 
             // 构造一个虚拟的CHECK_CALL动作意图
-            std::vector<float> hypothetical_check_call_intent = {static_cast<float>(CHECK_CALL), -1.0f};
             // 获取如果玩家尝试CHECK_CALL，实际会发生的动作
-            std::vector<float> outcome_if_check_call = _getFixedAction(hypothetical_check_call_intent);
+            const ResolvedAction outcome_if_check_call = _resolveAction(makeResolvedAction(CHECK_CALL, -1));
 
-            if (outcome_if_check_call[0] == CHECK_CALL) {
+            if (outcome_if_check_call.type == CHECK_CALL) {
                 // CHECK_CALL 是可行的
-                actionTypeFromCaller = CHECK_CALL;
-                amountFromCaller = outcome_if_check_call[1]; // 使用_getFixedAction确定的金额
-                #ifdef DEBUG_POKER_ENV
-                std::cout << "[DEBUG] Player " << currentPlayer
-                          << " action limit reached (" << actions_this_street[currentPlayer] << "/" << this->max_rounds_per_hand
-                          << "). BET_RAISE forced to CHECK_CALL with amount " << amountFromCaller << "." << std::endl;
-                #endif
+                intended = outcome_if_check_call; // 使用_resolveAction确定的金额
+                POKER_LOG_DEBUG("[DEBUG] Player " << currentPlayer
+                                << " action limit reached (" << actions_this_street[currentPlayer] << "/" << this->max_rounds_per_hand
+                                << "). BET_RAISE forced to CHECK_CALL with amount " << intended.amount << ".");
             } else {
-                // CHECK_CALL 不可行 (例如，_getFixedAction 将其转为 FOLD)
-                actionTypeFromCaller = FOLD;
-                amountFromCaller = -1.0f;
-                #ifdef DEBUG_POKER_ENV
-                std::cout << "[DEBUG] Player " << currentPlayer
-                          << " action limit reached (" << actions_this_street[currentPlayer] << "/" << this->max_rounds_per_hand
-                          << "). BET_RAISE forced to FOLD because CHECK_CALL was not viable (became type "
-                          << outcome_if_check_call[0] << ")." << std::endl;
-                #endif
+                // CHECK_CALL 不可行 (例如，_resolveAction 将其转为 FOLD)
+                intended = makeResolvedAction(FOLD, -1);
+                POKER_LOG_DEBUG("[DEBUG] Player " << currentPlayer
+                                << " action limit reached (" << actions_this_street[currentPlayer] << "/" << this->max_rounds_per_hand
+                                << "). BET_RAISE forced to FOLD because CHECK_CALL was not viable (became type "
+                                << static_cast<int>(outcome_if_check_call.type) << ").");
             }
         }
         // 如果原意图是 FOLD 或 CHECK_CALL，或者已被强制修改为 FOLD/CHECK_CALL，则允许执行
     }
 
-    std::vector<int> stacksBefore;
-    for (const auto* p : players) stacksBefore.push_back(p->stack);
+    int stacksBefore[Showdown::MAX_SEATS];
+    for (int i = 0; i < N_SEATS; ++i) stacksBefore[i] = players[i]->stack;
 
     PokerPlayer* player = players[currentPlayer];
 
-    // Construct input for _getFixedAction with potentially modified actionTypeFromCaller and amountFromCaller
-    std::vector<float> intendedActionVec = {static_cast<float>(actionTypeFromCaller), amountFromCaller};
     // Get the fixed (validated and possibly modified) action
-    std::vector<float> fixedActionVec = _getFixedAction(intendedActionVec);
+    const ResolvedAction fixedAction = _resolveAction(intended);
 
-    int finalActionType = static_cast<int>(fixedActionVec[0]);
-    float finalAmount = fixedActionVec[1]; // This is the target total currentBet for CHECK_CALL/BET_RAISE, or -1 for FOLD.
+    const int finalActionType = fixedAction.type;
+    const int finalAmount = fixedAction.amount; // This is the target total currentBet for CHECK_CALL/BET_RAISE, or -1 for FOLD.
 
     // 记录历史动作 - 修正betAmount计算逻辑
     int betAmount = 0;
     if (finalActionType == BET_RAISE) {
         // 对于加注，记录实际加注额（总下注额减去之前的下注）
-        betAmount = static_cast<int>(finalAmount) - player->currentBet;
+        betAmount = finalAmount - player->currentBet;
     } else if (finalActionType == CHECK_CALL) {
         // 对于跟注，记录跟注额
-        betAmount = static_cast<int>(finalAmount) - player->currentBet;
+        betAmount = finalAmount - player->currentBet;
     }
 
         // 使用getPotSize()方法获取当前底池大小，确保一致性
@@ -1391,45 +1542,55 @@ std::tuple<std::vector<std::vector<float>>, std::vector<float>, std::vector<floa
 
     // 调试输出已移除
 
+    const int betBeforeAction = player->currentBet;
     if (finalActionType == FOLD) {
         player->fold();
     } else if (finalActionType == CHECK_CALL) {
-        player->betRaise(static_cast<int>(finalAmount));
+        player->betRaise(finalAmount);
     } else if (finalActionType == BET_RAISE) {
-        player->betRaise(static_cast<int>(finalAmount));
+        player->betRaise(finalAmount);
         lastRaiser = currentPlayer;
         nRaisesThisRound++;
     }
+    if (player->currentBet != betBeforeAction) {
+        _potTotal += player->currentBet - betBeforeAction;
+        _currentSidePotsDirty = true;
+    }
 
     // 在玩家行动后，增加其在本条街的行动次数
     if (currentPlayer >= 0 && currentPlayer < N_SEATS) { // Defensive check
         actions_this_street[currentPlayer]++;
-        #ifdef DEBUG_POKER_ENV
-        std::cout << "[DEBUG] Player " << currentPlayer << " action count for street " << currentRound << " incremented to " << actions_this_street[currentPlayer] << std::endl;
-        #endif
+        POKER_LOG_DEBUG("[DEBUG] Player " << currentPlayer << " action count for street " << currentRound << " incremented to " << actions_this_street[currentPlayer]);
     }
 
-    lastAction_member = {finalActionType, static_cast<int>(finalAmount), currentPlayer};
+    lastAction_member = {finalActionType, finalAmount, currentPlayer};
     nActionsThisEpisode++;
 
-    // 实时计算边池状态
-    _calculateCurrentSidePots();
-    #ifdef DEBUG_POKER_ENV
-        std::cout << "[DEBUG] step: player:"<< currentPlayer << "  action:" << finalActionType << "  amount:" << finalAmount << " actionint:" << originalActionInt << std::endl;
-    #endif
+    // 实时计算边池状态（投入没变时沿用上次结果）
+#ifdef DEBUG_POKER_ENV
+    if (!_currentSidePotsDirty) {
+        const int keptMainPot = currentMainPot;
+        const std::vector<int> keptSidePots = currentSidePots;
+        _calculateCurrentSidePots();
+        if (keptMainPot != currentMainPot || keptSidePots != currentSidePots) {
+            POKER_LOG_ERROR("[DEBUG step] current side pots went stale without a contribution change");
+        }
+    }
+#endif
+    if (_currentSidePotsDirty) {
+        _calculateCurrentSidePots();
+        _currentSidePotsDirty = false;
+    }
+    POKER_LOG_DEBUG("[DEBUG] step: player:"<< currentPlayer << "  action:" << finalActionType << "  amount:" << finalAmount << " actionint:" << originalActionInt);
     bool currentIsDone = _isHandDone();
 
     bool movedToNextRound = false;
     if (!currentIsDone && _isBettingDone()) {
-        #ifdef DEBUG_POKER_ENV
-        std::cout << "[DEBUG] step: calling _moveToNextRound" << std::endl;
-        #endif
+        POKER_LOG_DEBUG("[DEBUG] step: calling _moveToNextRound");
         _moveToNextRound();
         movedToNextRound = true;
         currentIsDone = _isHandDone(); // Check again after moving to next round
-        #ifdef DEBUG_POKER_ENV
-        std::cout << "[DEBUG] step: after _moveToNextRound, currentIsDone=" << currentIsDone << std::endl;
-        #endif
+        POKER_LOG_DEBUG("[DEBUG] step: after _moveToNextRound, currentIsDone=" << currentIsDone);
     }
 
     if (currentIsDone) {
@@ -1446,11 +1607,13 @@ std::tuple<std::vector<std::vector<float>>, std::vector<float>, std::vector<floa
         }
     }
 
-    std::vector<float> rewards(N_SEATS, 0.0f);
+    _syncSeatState();
+
+    std::fill(rewards, rewards + N_SEATS, 0.0f);
     if (currentIsDone) {
         float totalReward = 0.0f;
         for (int i = 0; i < N_SEATS; ++i) {
-            int stackDiff = players[i]->stack - stacksBefore[i];
+            int stackDiff = m_seats.stack[i] - stacksBefore[i];
             rewards[i] = static_cast<float>(stackDiff) / REWARD_SCALAR;
             totalReward += rewards[i];
         }
@@ -1462,52 +1625,63 @@ std::tuple<std::vector<std::vector<float>>, std::vector<float>, std::vector<floa
         }
     }
 
-    std::vector<float> currentObservation = _calculateCurrentObservationByConfig();
-    observationHistory.push_back(currentObservation);
-
-    // 使用getObservationForTransformer()并返回其结果加上rewards和currentIsDone
-    auto transformer_result = getObservationForTransformer();
-    auto sequence_features = std::get<0>(transformer_result);
-    auto state_features = std::get<1>(transformer_result);
-
-    return std::make_tuple(sequence_features, state_features, rewards, currentIsDone);
+    _recordObservation();
+    return currentIsDone;
 }
 
 std::vector<std::vector<float>> PokerEnv::getPublicObservation() {
     // RNN优化：返回适合时序建模的观察序列
-    const int MAX_SEQUENCE_LENGTH = 25;  // 限制序列长度，避免内存爆炸
-
+    // observationHistory 只保留最近 capacity() (= MAX_SEQUENCE_LENGTH, 25) 个观察，避免内存爆炸
     std::vector<std::vector<float>> sequence_observations;
 
-    // 直接从历史记录中获取最近的观察，最多不超过MAX_SEQUENCE_LENGTH
-    int start_idx = std::max(0, static_cast<int>(observationHistory.size()) - MAX_SEQUENCE_LENGTH);
-
     // 如果历史记录为空，则计算并添加当前观察
     if (observationHistory.empty()) {
         sequence_observations.push_back(_calculateCurrentObservationByConfig());
     } else {
         // 否则，从历史记录中提取序列
-        for (size_t i = start_idx; i < observationHistory.size(); ++i) {
-            sequence_observations.push_back(observationHistory[i]);
+        sequence_observations.reserve(observationHistory.size());
+        for (size_t i = 0; i < observationHistory.size(); ++i) {
+            sequence_observations.push_back(observationHistory.rowVector(i));
         }
     }
 
 
-#ifdef DEBUG_POKER_ENV
-    std::cout << "RNN sequence length: " << sequence_observations.size()
-              << ", total history: " << observationHistory.size() << std::endl;
-#endif
+    POKER_LOG_DEBUG("RNN sequence length: " << sequence_observations.size()
+                    << ", total history: " << observationHistory.totalAppended());
 
     return sequence_observations;
 }
 
+// Zero-copy counterpart of getPublicObservation(): the retained history as one
+// [rows x stride] block, oldest first, rows zero padded to stride (lengths[i]
+// holds the real size). Unlike getPublicObservation() an empty history gives
+// rows == 0. Valid until the next reset/step.
+ObservationRing::View PokerEnv::getPublicObservationView() const {
+    return observationHistory.view();
+}
+
+// 计算当前观察并直接写入历史 ring buffer（无临时 vector）
+void PokerEnv::_recordObservation() {
+    _invalidateLegalActions(); // a new decision point
+    observationHistory.emplace(observationSize(), [this](float* dst) {
+        if (use_simplified_observation) {
+            _writeCurrentObservationSimplified(dst);
+        } else {
+            _writeCurrentObservation(dst);
+        }
+    });
+}
+
 std::vector<float> PokerEnv::_calculateCurrentObservation() {
-    // This needs to be ported from PokerEnv::getPublicObservation in PokerEnv.cpp
-    // The PyTorch version constructs a large feature vector.
-    // We need to replicate that feature construction logic.
-    // For brevity, this will be a simplified version or placeholder.
-    // A full porting of the observation vector is complex.
+    std::vector<float> allFeatures(ObservationLayout::fullDim(N_SEATS, N_ACTIONS));
+    _writeCurrentObservation(allFeatures.data());
+    return allFeatures;
+}
 
+// Full observation, written straight into dst; layout and offsets are
+// documented in ObservationLayout.h (fullDim() floats).
+size_t PokerEnv::_writeCurrentObservation(float* dst) {
+    POKER_PERF_SCOPE(PokerPerf::Timer::Observation);
     const int NUM_RANKS = 13;
     const int NUM_SUITS = 4;
     const int MAX_COMMUNITY_CARDS = 5;
@@ -1522,198 +1696,145 @@ std::vector<float> PokerEnv::_calculateCurrentObservation() {
     float normalizationSum = static_cast<float>(BIG_BLIND);
     if (normalizationSum <= 0.0f) normalizationSum = 1.0f;
 
-    std::vector<float> allFeatures;
-    // Reserve space (rough estimate)
-    allFeatures.reserve(7 + 3 + MAX_PLAYERS_OBS + MAX_PLAYERS_OBS + TOTAL_ROUNDS +
-                        MAX_PLAYERS_OBS + // side pots
-                        MAX_PLAYERS_OBS * (2 + 2 + MAX_PLAYERS_OBS) + // player features
-                        MAX_COMMUNITY_CARDS * (NUM_RANKS + NUM_SUITS));
+    // 对于筹码相关特征，使用起始筹码作为归一化基准
+    float stackNormFactor = static_cast<float>(DEFAULT_STACK_SIZE);
+    if (stackNormFactor <= 0.0f) stackNormFactor = 1000.0f; // 默认值
 
+    float* out = dst;
 
     // Table State
-    allFeatures.push_back(static_cast<float>(ANTE) / normalizationSum);
-    allFeatures.push_back(static_cast<float>(SMALL_BLIND) / normalizationSum);
-    allFeatures.push_back(static_cast<float>(BIG_BLIND) / normalizationSum);
-    allFeatures.push_back(static_cast<float>(_getCurrentTotalMinRaise()) / normalizationSum);
-    allFeatures.push_back(static_cast<float>(getPotSize()) / normalizationSum);
-    allFeatures.push_back(static_cast<float>(getCurrentBet()) / normalizationSum); // total to call
-    allFeatures.push_back((lastAction_member[0] == BET_RAISE) ? static_cast<float>(lastAction_member[1]) / normalizationSum : 0.0f);
+    *out++ = static_cast<float>(ANTE) / normalizationSum;
+    *out++ = static_cast<float>(SMALL_BLIND) / normalizationSum;
+    *out++ = static_cast<float>(BIG_BLIND) / normalizationSum;
+    *out++ = static_cast<float>(_getCurrentTotalMinRaise()) / normalizationSum;
+    *out++ = static_cast<float>(getPotSize()) / normalizationSum;
+    *out++ = static_cast<float>(getCurrentBet()) / normalizationSum; // total to call
+    *out++ = (lastAction_member[0] == BET_RAISE) ? static_cast<float>(lastAction_member[1]) / normalizationSum : 0.0f;
 
     // Last Action Type (one-hot)
-    std::vector<float> lastActionTypeFeat(3, 0.0f);
-    if (lastAction_member[0] >= 0 && lastAction_member[0] < 3) lastActionTypeFeat[lastAction_member[0]] = 1.0f;
-    else lastActionTypeFeat[CHECK_CALL] = 1.0f; // Default
-    allFeatures.insert(allFeatures.end(), lastActionTypeFeat.begin(), lastActionTypeFeat.end());
+    const int lastActionType = (lastAction_member[0] >= 0 && lastAction_member[0] < 3) ? lastAction_member[0] : CHECK_CALL; // Default
+    out = writeOneHot(out, 3, lastActionType);
 
     // Last Action Player (relative to button, one-hot)
-    std::vector<float> lastActionPlayerRelPosFeat(MAX_PLAYERS_OBS, 0.0f);
+    int lastActorRelPos = -1;
     if (lastAction_member[2] >= 0 && lastAction_member[2] < N_SEATS) { // Check against N_SEATS for valid player
-        int lastActorAbsPos = lastAction_member[2];
-        int lastActorRelPos = (lastActorAbsPos - buttonPos + N_SEATS) % N_SEATS;
-        if (lastActorRelPos >= 0 && lastActorRelPos < MAX_PLAYERS_OBS) { // Ensure relative pos is within observation bounds
-            lastActionPlayerRelPosFeat[lastActorRelPos] = 1.0f;
-        }
+        lastActorRelPos = (lastAction_member[2] - buttonPos + N_SEATS) % N_SEATS;
     }
-    allFeatures.insert(allFeatures.end(), lastActionPlayerRelPosFeat.begin(), lastActionPlayerRelPosFeat.end());
+    out = writeOneHot(out, MAX_PLAYERS_OBS, lastActorRelPos);
 
     // Current Player (relative to button, one-hot)
-    std::vector<float> currentPlayerRelPosFeat(MAX_PLAYERS_OBS, 0.0f);
+    int currentPlayerRelPos = -1;
     if (currentPlayer >= 0 && currentPlayer < N_SEATS) { // Check against N_SEATS for valid player
-        int currentPlayerAbsPos = currentPlayer;
-        int currentPlayerRelPos = (currentPlayerAbsPos - buttonPos + N_SEATS) % N_SEATS;
-        if (currentPlayerRelPos >= 0 && currentPlayerRelPos < MAX_PLAYERS_OBS) { // Ensure relative pos is within observation bounds
-            currentPlayerRelPosFeat[currentPlayerRelPos] = 1.0f;
-        }
+        currentPlayerRelPos = (currentPlayer - buttonPos + N_SEATS) % N_SEATS;
     }
-    allFeatures.insert(allFeatures.end(), currentPlayerRelPosFeat.begin(), currentPlayerRelPosFeat.end());
+    out = writeOneHot(out, MAX_PLAYERS_OBS, currentPlayerRelPos);
 
     // Current Round (one-hot)
-    std::vector<float> currentRoundFeat(TOTAL_ROUNDS, 0.0f);
-    if (currentRound >= 0 && currentRound < TOTAL_ROUNDS) currentRoundFeat[currentRound] = 1.0f;
-    allFeatures.insert(allFeatures.end(), currentRoundFeat.begin(), currentRoundFeat.end());
+    out = writeOneHot(out, TOTAL_ROUNDS, currentRound);
 
     // Button Position (one-hot)
-    std::vector<float> buttonPosFeat(MAX_PLAYERS_OBS, 0.0f);
-    if (buttonPos >= 0 && buttonPos < MAX_PLAYERS_OBS) buttonPosFeat[buttonPos] = 1.0f;
-    allFeatures.insert(allFeatures.end(), buttonPosFeat.begin(), buttonPosFeat.end());
+    out = writeOneHot(out, MAX_PLAYERS_OBS, buttonPos);
 
     // Number of active players remaining (not folded, not all-in)
-    int activePlayersRemaining = 0;
-    for(const auto* p : players) {
-        if (p && !p->folded && !p->isAllin && p->stack > 0) {
-            activePlayersRemaining++;
-        }
-    }
-    allFeatures.push_back(static_cast<float>(activePlayersRemaining) / N_SEATS); // Normalize by total seats
+    const SeatState& seats = m_seats;
+    const int activePlayersRemaining = seats.countCanAct();
+    *out++ = static_cast<float>(activePlayersRemaining) / N_SEATS; // Normalize by total seats
 
     // Number of raises this round
-    allFeatures.push_back(static_cast<float>(nRaisesThisRound) / (N_SEATS > 0 ? N_SEATS : 1.0f)); // Normalize by N_SEATS or a typical max (e.g., 4)
+    *out++ = static_cast<float>(nRaisesThisRound) / (N_SEATS > 0 ? N_SEATS : 1.0f); // Normalize by N_SEATS or a typical max (e.g., 4)
 
     // Side Pots
     if (N_SEATS > 2) { // Only include for multiplayer for consistency with original
         for (int i = 0; i < MAX_PLAYERS_OBS; ++i) {
-            allFeatures.push_back(i < currentSidePots.size() ? static_cast<float>(currentSidePots[i]) / normalizationSum : 0.0f);
+            *out++ = i < currentSidePots.size() ? static_cast<float>(currentSidePots[i]) / normalizationSum : 0.0f;
         }
     }
 
     // Player Features
     for (int i = 0; i < MAX_PLAYERS_OBS; ++i) {
-        if (i < N_SEATS) {
-            const PokerPlayer* p = players[i];
-            // 对于筹码相关特征，使用起始筹码作为归一化基准
-            float stackNormFactor = static_cast<float>(DEFAULT_STACK_SIZE);
-            if (stackNormFactor <= 0.0f) stackNormFactor = 1000.0f; // 默认值
-
-            allFeatures.push_back(static_cast<float>(p->stack) / stackNormFactor);
-            allFeatures.push_back(static_cast<float>(p->currentBet) / normalizationSum);
-            allFeatures.push_back(p->hasActed ? 1.0f : 0.0f); // 新增：玩家是否已行动
-            allFeatures.push_back(static_cast<float>(p->totalInvestedThisHand) / stackNormFactor); // 新增：玩家本手牌总投入
-
-            // 新增：玩家相对于按钮的位置 (0: button, 1: button+1, ..., N_SEATS-1: button-1)
-            float relativePosition = 0.0f;
-            if (N_SEATS > 0) {
-                relativePosition = static_cast<float>((p->seatId - buttonPos + N_SEATS) % N_SEATS);
-            }
-            allFeatures.push_back(N_SEATS > 1 ? relativePosition / (N_SEATS -1) : 0.0f); // 归一化
+        const PokerPlayer* p = players[i];
 
-            // 新增：玩家本轮投入额
-            allFeatures.push_back(static_cast<float>(p->investedThisRound) / normalizationSum); // 假设 p->investedThisRound 存在
+        *out++ = static_cast<float>(seats.stack[i]) / stackNormFactor;
+        *out++ = static_cast<float>(seats.currentBet[i]) / normalizationSum;
+        *out++ = p->hasActed ? 1.0f : 0.0f; // 玩家是否已行动
+        *out++ = static_cast<float>(seats.invested[i]) / stackNormFactor; // 玩家本手牌总投入
 
-            if (N_SEATS == 2) {
-                allFeatures.push_back(p->isAllin ? 1.0f : 0.0f);
-            } else {
-                allFeatures.push_back(p->folded ? 1.0f : 0.0f);
-                allFeatures.push_back(p->isAllin ? 1.0f : 0.0f);
-                // Side Pot Rank (one-hot)
-                for (int j = 0; j < MAX_PLAYERS_OBS; ++j) {
-                    allFeatures.push_back((p->currentSidePotRank == j) ? 1.0f : 0.0f);
-                }
-            }
-        } else { // Padding for non-existent players if MAX_PLAYERS_OBS > N_SEATS
-            allFeatures.push_back(0.0f); // stack
-            allFeatures.push_back(0.0f); // currentBet
-            allFeatures.push_back(0.0f); // hasActed
-            allFeatures.push_back(0.0f); // totalInvestedThisHand
-            allFeatures.push_back(0.0f); // relativePosition
-            allFeatures.push_back(0.0f); // investedThisRound
-            if (N_SEATS == 2) {
-                allFeatures.push_back(0.0f); // isAllin
-            } else {
-                allFeatures.push_back(0.0f); // folded
-                allFeatures.push_back(0.0f); // isAllin
-                for (int j = 0; j < MAX_PLAYERS_OBS; ++j) allFeatures.push_back(0.0f); // sidePotRank
-            }
+        // 玩家相对于按钮的位置 (0: button, 1: button+1, ..., N_SEATS-1: button-1)
+        float relativePosition = 0.0f;
+        if (N_SEATS > 0) {
+            relativePosition = static_cast<float>((p->seatId - buttonPos + N_SEATS) % N_SEATS);
+        }
+        *out++ = N_SEATS > 1 ? relativePosition / (N_SEATS -1) : 0.0f; // 归一化
+
+        // 玩家本轮投入额
+        *out++ = static_cast<float>(p->investedThisRound) / normalizationSum;
+
+        if (N_SEATS == 2) {
+            *out++ = static_cast<float>(seats.allin[i]);
+        } else {
+            *out++ = static_cast<float>(seats.folded[i]);
+            *out++ = static_cast<float>(seats.allin[i]);
+            // Side Pot Rank (one-hot)
+            out = writeOneHot(out, MAX_PLAYERS_OBS, p->currentSidePotRank);
         }
     }
 
     // Community Cards (with suit isomorphism)
     const auto& ccards = community_cards_for_iso; // Reuse cards
     for (int i = 0; i < MAX_COMMUNITY_CARDS; ++i) {
-        std::vector<float> rankFeats(NUM_RANKS, 0.0f);
-        std::vector<float> suitFeats(NUM_SUITS, 0.0f);
+        int rankIdx = -1;
+        int suitIdx = -1;
         if (i < ccards.size() && ccards[i]) {
-            int val = static_cast<int>(ccards[i]->getValue());
+            rankIdx = static_cast<int>(ccards[i]->getValue());
             int original_suit = static_cast<int>(ccards[i]->getSuit());
-            if (val >= 0 && val < NUM_RANKS) rankFeats[val] = 1.0f;
             if (original_suit >= 0 && original_suit < NUM_SUITS) {
-                int canonical_suit = canonical_suit_map[original_suit]; // Use canonical suit
-                suitFeats[canonical_suit] = 1.0f;
+                suitIdx = canonical_suit_map[original_suit]; // Use canonical suit
             }
         }
-        allFeatures.insert(allFeatures.end(), rankFeats.begin(), rankFeats.end());
-        allFeatures.insert(allFeatures.end(), suitFeats.begin(), suitFeats.end());
+        out = writeOneHot(out, NUM_RANKS, rankIdx);
+        out = writeOneHot(out, NUM_SUITS, suitIdx);
     }
 
-    // 新增：每个合法加注选项对应的具体总下注额 (归一化)
+    // 每个合法加注选项对应的具体总下注额 (归一化)
     const int MAX_RAISE_OPTIONS_IN_OBS = N_ACTIONS - 2; // 可配置的槽位数
-    std::vector<float> raiseOptionAmounts(MAX_RAISE_OPTIONS_IN_OBS, -1.0f); // 用-1.0f作为未填充标记
+    float* raiseOptionAmounts = out;
+    std::fill(raiseOptionAmounts, raiseOptionAmounts + MAX_RAISE_OPTIONS_IN_OBS, -1.0f); // 用-1.0f作为未填充标记
+    out += MAX_RAISE_OPTIONS_IN_OBS;
 
     if (currentPlayer >= 0 && currentPlayer < N_SEATS && players[currentPlayer] && !players[currentPlayer]->folded && !players[currentPlayer]->isAllin) {
-        std::vector<int> legalActs = getLegalActions();
+        const LegalActionSet& legal = legalActionSet();
         int currentRaiseOptionSlot = 0;
-        for (int actionInt : legalActs) {
+        for (int i = 0; i < legal.count; ++i) {
+            const int actionInt = legal.actions[i];
             if (actionInt >= BET_RAISE) { // 是一个加注动作
                 if (currentRaiseOptionSlot < MAX_RAISE_OPTIONS_IN_OBS) {
-                    // 获取此加注动作对应的总下注额
-                    std::vector<float> adjustedAction = _getEnvAdjustedActionFormulation(actionInt);
-                    std::vector<float> fixedAction = _getFixedAction(adjustedAction);
-                    float totalBetAmount = fixedAction[1]; // _getFixedAction 返回的是总下注额
-                    if (fixedAction[0] == BET_RAISE) { // 确保这确实是一个有效的加注
-                         float stackNormFactor = static_cast<float>(DEFAULT_STACK_SIZE);
-                         if (stackNormFactor <= 0.0f) stackNormFactor = 1000.0f;
-                         raiseOptionAmounts[currentRaiseOptionSlot] = totalBetAmount / stackNormFactor;
+                    // 此加注动作对应的总下注额（合法动作扫描时已确定）
+                    if (legal.resolved[actionInt].type == BET_RAISE) { // 确保这确实是一个有效的加注
+                         raiseOptionAmounts[currentRaiseOptionSlot] = static_cast<float>(legal.resolved[actionInt].amount) / stackNormFactor;
                     }
                     currentRaiseOptionSlot++;
                 }
             }
         }
     }
-    allFeatures.insert(allFeatures.end(), raiseOptionAmounts.begin(), raiseOptionAmounts.end());
 
-    // === 新增：扑克专用高级特征 ===
+    // === 扑克专用高级特征 ===
 
     // 1. 底池赔率 (Pot Odds)
-    int totalToCall = getCurrentBet() - (currentPlayer >= 0 && currentPlayer < N_SEATS ? players[currentPlayer]->currentBet : 0);
+    int totalToCall = getCurrentBet() - (currentPlayer >= 0 && currentPlayer < N_SEATS ? seats.currentBet[currentPlayer] : 0);
     float potOdds = (getPotSize() > 0 && totalToCall > 0) ?
                     static_cast<float>(totalToCall) / static_cast<float>(getPotSize() + totalToCall) : 0.0f;
-    allFeatures.push_back(potOdds);
+    *out++ = potOdds;
 
     // 2. 有效筹码深度 (Effective Stack Depth)
     float effectiveStack = 0.0f;
-    if (currentPlayer >= 0 && currentPlayer < N_SEATS && !players[currentPlayer]->folded) {
-        int minStack = players[currentPlayer]->stack;
-        for (const auto* p : players) {
-            if (p && !p->folded && p->seatId != currentPlayer) {
-                minStack = std::min(minStack, p->stack);
-            }
-        }
-        float stackNormFactor = static_cast<float>(DEFAULT_STACK_SIZE);
-        if (stackNormFactor <= 0.0f) stackNormFactor = 1000.0f;
+    if (currentPlayer >= 0 && currentPlayer < N_SEATS && !seats.folded[currentPlayer]) {
+        const int minStack = seats.minOverOpponents(seats.stack, currentPlayer, seats.stack[currentPlayer]);
         effectiveStack = static_cast<float>(minStack) / stackNormFactor;
     }
-    allFeatures.push_back(effectiveStack);
+    *out++ = effectiveStack;
 
-        // 3. 位置强度指标 (Position Strength)
+    // 3. 位置强度指标 (Position Strength)
     float positionStrength = 0.0f;
     if (currentPlayer >= 0 && currentPlayer < N_SEATS) {
         int relativePos = (currentPlayer - buttonPos + N_SEATS) % N_SEATS;
@@ -1734,27 +1855,25 @@ std::vector<float> PokerEnv::_calculateCurrentObservation() {
             // 其他位置：CO, MP, UTG等，按距离BTN的远近线性分布
             // relativePos: 1(CO)最强 -> (N_SEATS-3)(UTG)最弱
             int earlyPositionCount = N_SEATS - 3;  // 除了BTN、SB、BB的位置数
-                         if (earlyPositionCount > 0) {
-                 // 从CO(relativePos=1)到UTG(relativePos=N_SEATS-3)的线性分布
-                 float earlyPosStrength = static_cast<float>(earlyPositionCount - (relativePos - 1)) / static_cast<float>(earlyPositionCount);
-                 strength = 0.2f + 0.7f * earlyPosStrength;  // 范围 [0.2, 0.9]，让CO略弱于BTN
-             } else {
-                 strength = 0.5f; // 兜底值
-             }
+            if (earlyPositionCount > 0) {
+                // 从CO(relativePos=1)到UTG(relativePos=N_SEATS-3)的线性分布
+                float earlyPosStrength = static_cast<float>(earlyPositionCount - (relativePos - 1)) / static_cast<float>(earlyPositionCount);
+                strength = 0.2f + 0.7f * earlyPosStrength;  // 范围 [0.2, 0.9]，让CO略弱于BTN
+            } else {
+                strength = 0.5f; // 兜底值
+            }
         }
         positionStrength = strength;
     }
-    allFeatures.push_back(positionStrength);
+    *out++ = positionStrength;
 
     // 4. 激进度指标 (Aggression Factor)
-    float aggressionFactor = 0.0f;
-    int totalRaises = 0, totalCalls = 0;
-    // 这里需要根据您的动作历史记录来计算
     // 简化版本：基于当前轮的加注次数
+    float aggressionFactor = 0.0f;
     if (nRaisesThisRound > 0) {
         aggressionFactor = static_cast<float>(nRaisesThisRound) / static_cast<float>(nRaisesThisRound + 1);
     }
-    allFeatures.push_back(aggressionFactor);
+    *out++ = aggressionFactor;
 
     // 5. 投入比例 (Investment Ratio)
     float investmentRatio = 0.0f;
@@ -1762,168 +1881,80 @@ std::vector<float> PokerEnv::_calculateCurrentObservation() {
         float startingStackForPlayer = static_cast<float>(players[currentPlayer]->startingStack);
         if (startingStackForPlayer <= 0.0f) startingStackForPlayer = static_cast<float>(DEFAULT_STACK_SIZE);
         if (startingStackForPlayer > 0.0f) {
-            investmentRatio = static_cast<float>(players[currentPlayer]->totalInvestedThisHand) / startingStackForPlayer;
+            investmentRatio = static_cast<float>(seats.invested[currentPlayer]) / startingStackForPlayer;
         }
     }
-    allFeatures.push_back(investmentRatio);
+    *out++ = investmentRatio;
 
     // 6. 手牌阶段进度 (Hand Progress)
-    float handProgress = static_cast<float>(currentRound) / 3.0f; // 0=preflop, 1=river
-    allFeatures.push_back(handProgress);
+    *out++ = static_cast<float>(currentRound) / 3.0f; // 0=preflop, 1=river
 
     // 7. 玩家活跃度分布 (Player Activity Distribution)
-    int foldedCount = 0, allinCount = 0, activeCount = 0;
-    for (const auto* p : players) {
-        if (p) {
-            if (p->folded) foldedCount++;
-            else if (p->isAllin) allinCount++;
-            else activeCount++;
-        }
-    }
-    allFeatures.push_back(static_cast<float>(foldedCount) / N_SEATS);
-    allFeatures.push_back(static_cast<float>(allinCount) / N_SEATS);
-    allFeatures.push_back(static_cast<float>(activeCount) / N_SEATS);
+    const int foldedCount = seats.countFolded();
+    const int allinCount = seats.countAllin();
+    const int activeCount = N_SEATS - foldedCount - allinCount;
+    *out++ = static_cast<float>(foldedCount) / N_SEATS;
+    *out++ = static_cast<float>(allinCount) / N_SEATS;
+    *out++ = static_cast<float>(activeCount) / N_SEATS;
 
     // 8. 边池复杂度 (Side Pot Complexity)
     float sidePotComplexity = 0.0f;
     if (!sidePots.empty()) {
         sidePotComplexity = static_cast<float>(sidePots.size()) / static_cast<float>(N_SEATS);
     }
-    allFeatures.push_back(sidePotComplexity);
+    *out++ = sidePotComplexity;
 
-    return allFeatures;
+    return static_cast<size_t>(out - dst);
 }
 
 std::vector<float> PokerEnv::_calculateCurrentObservationSimplified() {
-    // Transformer版本：使用可变长度的动作历史
-    // 新增：筹码量信息、统一归一化、未行动玩家数量
-    // 优化：移除游戏阶段特征（只训练翻前），移除位置强度向量（让模型自己学习），优化下注倍数表示
-
-    // 定义固定的动作空间 - 与N_ACTIONS保持一致
-    const int FIXED_ACTION_TYPES = N_ACTIONS; // 2 + betSizesListAsFracOfPot.size()
-
-    std::vector<float> obs;
-
-    // 计算动作特征大小
-    int actionFeatureSize = N_SEATS + FIXED_ACTION_TYPES + 1; // 玩家位置 + 固定动作向量 + 下注倍数
-    int stackFeatureSize = N_SEATS; // 每个玩家的筹码量（相对于初始筹码）
-    int effectiveStackFeatureSize = 1; // 有效筹码量与底池比例
-    int playersToActFeatureSize = 1; // 当前玩家之后还有多少人未行动
-    int historyLengthFeatureSize = 1; // 动作历史长度（归一化）
+    std::vector<float> obs(ObservationLayout::simplifiedDim(N_SEATS, N_ACTIONS, actionHistory.size()));
+    _writeCurrentObservationSimplified(obs.data());
+    return obs;
+}
 
-    // 计算总大小：其他特征 + 动作历史长度 + 动作历史数据
-    int totalSize = N_SEATS + stackFeatureSize + effectiveStackFeatureSize + playersToActFeatureSize +
-                   historyLengthFeatureSize + actionHistory.size() * actionFeatureSize;
-    obs.reserve(totalSize);
+// Transformer版本：使用可变长度的动作历史
+// 新增：筹码量信息、统一归一化
+// 优化：移除游戏阶段特征（只训练翻前），移除位置强度向量（让模型自己学习），优化下注倍数表示
+// Layout: ObservationLayout.h, simplifiedDim(actionHistory.size()) floats.
+size_t PokerEnv::_writeCurrentObservationSimplified(float* dst) {
+    POKER_PERF_SCOPE(PokerPerf::Timer::Observation);
+    float* out = dst;
 
     // 1. 当前玩家位置 (N_SEATS个位置，one-hot编码) - 让模型自己学习位置价值
-    std::vector<float> currentPlayerPos(N_SEATS, 0.0f);
-    if (currentPlayer >= 0 && currentPlayer < N_SEATS) {
-        // 计算当前玩家相对于按钮的位置
-        int relativePos = (currentPlayer - buttonPos + N_SEATS) % N_SEATS;
-        if (relativePos >= 0 && relativePos < N_SEATS) {
-            currentPlayerPos[relativePos] = 1.0f;
-        }
-    }
-    obs.insert(obs.end(), currentPlayerPos.begin(), currentPlayerPos.end());
-
-    // 2. 每个玩家的筹码量（相对于初始筹码量）
-    std::vector<float> stackSizes(N_SEATS, 0.0f);
-    for (int i = 0; i < N_SEATS; i++) {
-        if (players[i] && DEFAULT_STACK_SIZE > 0) {
-            // 计算当前总筹码量（包括已下注的筹码）
-            int totalChips = players[i]->stack + players[i]->currentBet;
-            stackSizes[i] = static_cast<float>(totalChips) / static_cast<float>(DEFAULT_STACK_SIZE);
-        }
-    }
-    obs.insert(obs.end(), stackSizes.begin(), stackSizes.end());
-
-    // 3. 有效筹码量与当前底池的比例
-    float effectiveStackToPotRatio = 0.0f;
-    if (currentPlayer >= 0 && currentPlayer < N_SEATS && players[currentPlayer]) {
-        // 使用getPotSize()方法获取当前底池大小，确保一致性
-        int currentPot = getPotSize();
-        if (currentPot == 0) currentPot = BIG_BLIND; // 避免除零
-
-        // 计算有效筹码量：当前玩家与所有未弃牌对手之间的最小筹码量
-        int currentPlayerTotalChips = players[currentPlayer]->stack + players[currentPlayer]->currentBet;
-        int effectiveStack = currentPlayerTotalChips;
+    _writeCurrentPlayerAndStacks(out);
+    out += 2 * N_SEATS;
 
-        // 找到最小对手筹码量
-        for (int i = 0; i < N_SEATS; i++) {
-            if (i != currentPlayer && players[i] && !players[i]->folded) {
-                int opponentTotalChips = players[i]->stack + players[i]->currentBet;
-                effectiveStack = std::min(effectiveStack, opponentTotalChips);
+    // 2. 有效筹码量与当前底池的比例
+    *out++ = std::log1p(_effectiveStackToPotRatio()); // log(1 + x));
 
-            }
-        }
-
-
-        effectiveStackToPotRatio = static_cast<float>(effectiveStack) / static_cast<float>(currentPot);
-    }
-    obs.push_back(std::log1p(effectiveStackToPotRatio)); // log(1 + x));
-
-
-    // 5. 动作历史长度（归一化到[0,1]范围，假设最大长度为100）
-    float normalizedHistoryLength = static_cast<float>(actionHistory.size()) / 100.0f;
-    obs.push_back(normalizedHistoryLength);
-
-    // 6. 动作历史记录（可变长度，放在最后）
-    for (size_t historyIdx = 0; historyIdx < actionHistory.size(); historyIdx++) {
-        // 玩家位置向量 (N_SEATS)
-        std::vector<float> playerPos(N_SEATS, 0.0f);
-
-        // 固定大小的动作向量 (FIXED_ACTION_TYPES)
-        std::vector<float> actionTaken(FIXED_ACTION_TYPES, 0.0f);
-
-        // 下注倍数 (1)
-        float betMultiplier = 0.0f;
-
-        // 从历史动作记录中获取数据（按时间顺序，最早的在前）
-        const ActionRecord& record = actionHistory[historyIdx];
-
-        // 设置玩家位置（相对于按钮位置）
-        if (record.playerId >= 0 && record.playerId < N_SEATS) {
-            // 计算相对位置：button=0, sb=1, bb=2, utg=3, ...
-            int relativePos = (record.playerId - buttonPos + N_SEATS) % N_SEATS;
-            if (relativePos >= 0 && relativePos < N_SEATS) {
-                playerPos[relativePos] = 1.0f;
-            }
-        }
-
-        // 直接使用记录的actionInt，避免重新计算
-        int actionIndex = record.actionInt;
-        if (actionIndex >= 0 && actionIndex < FIXED_ACTION_TYPES) {
-            actionTaken[actionIndex] = 1.0f;
-        }
+    // 3. 动作历史长度（归一化到[0,1]范围，假设最大长度为100）
+    *out++ = static_cast<float>(actionHistory.size()) / 100.0f;
 
-        // 优化的下注倍数计算（相对于底池大小，对加注使用对数变换）
-        if (record.betAmount > 0) {
-            int historicalPot = record.potAtActionTime > 0 ? record.potAtActionTime : BIG_BLIND;
+    // 4. 动作历史记录（可变长度，放在最后，按时间顺序，最早的在前）
+    m_kernels->actionRows(actionHistory.data(), actionHistory.size(), N_SEATS, N_ACTIONS, buttonPos, BIG_BLIND, out);
+    out += actionHistory.size() * ObservationLayout::rowDim(N_SEATS, N_ACTIONS);
 
-            betMultiplier = static_cast<float>(record.betAmount) / static_cast<float>(historicalPot);
-
-        } else {
-            betMultiplier = 0.0f;
-        }
-
-        // 添加到观察向量
-        obs.insert(obs.end(), playerPos.begin(), playerPos.end());
-        obs.insert(obs.end(), actionTaken.begin(), actionTaken.end());
-        obs.push_back(betMultiplier);
-    }
+    return static_cast<size_t>(out - dst);
+}
 
-    // 验证观察向量大小是否正确（调试用）
-    #ifdef DEBUG_POKER_ENV
-    if (obs.size() != static_cast<size_t>(totalSize)) {
-        std::cerr << "Warning: Observation vector size mismatch. Expected: " << totalSize
-                  << ", Actual: " << obs.size() << std::endl;
-    }
-    #endif
+// 当前玩家位置 one-hot (相对按钮) + 每个玩家总筹码 (stack + currentBet) / DEFAULT_STACK_SIZE, 2 * N_SEATS floats.
+void PokerEnv::_writeCurrentPlayerAndStacks(float* dst) const {
+    m_kernels->currentPlayerAndStacks(m_seats, currentPlayer, buttonPos, DEFAULT_STACK_SIZE, dst);
+}
 
-    return obs;
+// 有效筹码量（当前玩家与所有未弃牌对手之间的最小总筹码）/ 当前底池; 没有当前玩家时为 0
+float PokerEnv::_effectiveStackToPotRatio() {
+    // 使用getPotSize()方法获取当前底池大小，确保一致性
+    int currentPot = getPotSize();
+    if (currentPot == 0) currentPot = BIG_BLIND; // 避免除零
+    return m_kernels->effectiveStackToPot(m_seats, currentPlayer, currentPot);
 }
 
+// 单个动作的特征行: 玩家位置 one-hot + 动作 one-hot + 下注倍数 (ObservationLayout::rowDim floats)
+void PokerEnv::_writeActionRow(const ActionRecord& record, float* dst) const {
+    m_kernels->actionRows(&record, 1, N_SEATS, N_ACTIONS, buttonPos, BIG_BLIND, dst);
+}
 
 
 // 实现getPublicObservationSimplified方法
@@ -2050,13 +2081,21 @@ std::vector<float> PokerEnv::_calculateCurrentObservationByConfig() {
     }
 }
 
+// Private-observation range index of a seat's hole cards. Once the board is
+// dealt it is the colex index c1 * (c1 - 1) / 2 + c2 of the suit-canonical
+// cards (_getCanonicalSuitMap_static, same card ids as getHandByPid), so
+// suit-isomorphic holdings share an index. Preflop (no board, or
+// end_with_round == 0 in PREFLOP) it is the 169-class index
+// getHandValuebyPlayer - 1 (0 = AA .. 168 = weakest). Neither is a RangeLut
+// index; use getRawRangeIdx for rangeCard1/2, getHandRank(rangeIdx, board) and
+// rank_all_hands.
 int64_t PokerEnv::getRangeIdx(int playerId) {
 
     if (playerId < 0 || playerId >= N_SEATS) {
         return -1;
     }
     const PokerPlayer* p = players[playerId];
-    if (p->hand.size() < 2) { // Hands must have 2 cards
+    if (p->hand.size() < 2 || !p->hand[0] || !p->hand[1]) { // Hands must have 2 cards
         return -1;
     }
 
@@ -2079,6 +2118,7 @@ int64_t PokerEnv::getRangeIdx(int playerId) {
         int handRank = getHandValuebyPlayer(playerId);
         return handRank - 1; // 转换为 0-168 范围
     }
+
     // --- Apply Suit Isomorphism to get Canonical Hand ---
     std::vector<int> canonical_suit_map = _getCanonicalSuitMap_static(getCommunityCards());
 
@@ -2102,6 +2142,20 @@ int64_t PokerEnv::getRangeIdx(int playerId) {
     return range_idx;
 }
 
+// RangeLut::rangeIdx (lexicographic, 0..1325) of the cards a seat actually
+// holds, on every street: the index rangeCard1/2, getHandRank(rangeIdx, board),
+// rank_all_hands and RangeLut::privObs decode. -1 without two hole cards.
+int64_t PokerEnv::getRawRangeIdx(int playerId) const {
+    if (playerId < 0 || playerId >= N_SEATS || !players[playerId]) {
+        return -1;
+    }
+    const PokerPlayer* p = players[playerId];
+    if (p->hand.size() < 2 || !p->hand[0] || !p->hand[1]) {
+        return -1;
+    }
+    return RangeLut::rangeIdx(cardIdOf(p->hand[0]), cardIdOf(p->hand[1]));
+}
+
 // New function: getRangeIdxByHand(const Card* card1, const Card* card2)
 int64_t PokerEnv::getRangeIdxByHand(const Card* card1, const Card* card2) {
     if (!card1 || !card2) {
@@ -2118,289 +2172,167 @@ int64_t PokerEnv::getRangeIdxByHand(const Card* card1, const Card* card2) {
     int card1_1d = card1_value * N_SUITS + card1_suit;
     int card2_1d = card2_value * N_SUITS + card2_suit;
 
-    // 确保 c1 < c2
-    if (card1_1d > card2_1d) {
-        std::swap(card1_1d, card2_1d);
-    }
-
-    // 使用查找表
-    auto it = m_rangeIdxLut.find(std::make_pair(card1_1d, card2_1d));
-    if (it != m_rangeIdxLut.end()) {
-        return it->second;
+    // 使用查找表 (顺序无关)
+    int range_idx = RangeLut::rangeIdx(card1_1d, card2_1d);
+    if (range_idx >= 0) {
+        return static_cast<int64_t>(range_idx);
     }
 
     // 如果没找到，返回 -1 表示错误 (理论上不应该发生)
-    #ifdef DEBUG_POKER_ENV
-    std::cerr << "[ERROR getRangeIdxByHand(Card*, Card*)] Did not find (" << card1_1d << "," << card2_1d << ") in LUT!" << std::endl;
-    #endif
+    POKER_LOG_DEBUG("[ERROR getRangeIdxByHand(Card*, Card*)] Did not find (" << card1_1d << "," << card2_1d << ") in LUT!");
     return -1;
 }
 
 // Overload: getRangeIdxByHand(const std::string& cardStr1, const std::string& cardStr2)
 int64_t PokerEnv::getRangeIdxByHand(const std::string& cardStr1, const std::string& cardStr2) {
-    try {
-        auto parsedCard1 = parseCardStringInternal(cardStr1);
-        auto parsedCard2 = parseCardStringInternal(cardStr2);
-
-        Card c1_obj(parsedCard1.second, parsedCard1.first);
-        Card c2_obj(parsedCard2.second, parsedCard2.first);
-
-        return getRangeIdxByHand(&c1_obj, &c2_obj);
-    } catch (const std::invalid_argument& e) {
-        #ifdef DEBUG_POKER_ENV
-        std::cerr << "[DEBUG getRangeIdxByHand two_str] Error parsing card strings: " << e.what() << std::endl;
-        #endif
+    CardId c1 = NO_CARD, c2 = NO_CARD;
+    if (CardParse::parseCard(cardStr1, c1) != CardParse::Status::Ok ||
+        CardParse::parseCard(cardStr2, c2) != CardParse::Status::Ok) {
+        POKER_LOG_DEBUG("[DEBUG getRangeIdxByHand two_str] Error parsing card strings: " << cardStr1 << ", " << cardStr2);
         return -1; // Indicate error
     }
+    return RangeLut::rangeIdx(c1, c2); // -1 for the same card twice
 }
 
 // New overload: getRangeIdxByHand(const std::string& twoCardsStr)
+// "As Kd" splits at the first space; "AsKd" / "10♠K♡" at the first split
+// where both halves are cards (CardParse::parseHoleCards).
 int64_t PokerEnv::getRangeIdxByHand(const std::string& twoCardsStr) {
-    if (twoCardsStr.empty()) {
-        return -1;
-    }
-
-    std::string cardStr1, cardStr2;
-    size_t space_pos = twoCardsStr.find(' ');
-
-    if (space_pos != std::string::npos) {
-        cardStr1 = twoCardsStr.substr(0, space_pos);
-        size_t first_char_card2 = twoCardsStr.find_first_not_of(' ', space_pos);
-        if (first_char_card2 != std::string::npos) {
-            cardStr2 = twoCardsStr.substr(first_char_card2);
-        } else {
-            #ifdef DEBUG_POKER_ENV
-            std::cerr << "[DEBUG getRangeIdxByHand single_str] Malformed input with space: " << twoCardsStr << std::endl;
-            #endif
-            return -1;
-        }
-    } else {
-        // No space found, iterate through all possible split points
-        bool found_split = false;
-        // Iterate from a minimum card length (e.g., 2 like "As") to a maximum practical length
-        // Maximum length for a card: "10" (2) + Unicode suit (e.g. ♠ is 3 bytes) = 5.
-        // Minimum total length for two cards: 2+2 = 4 (e.g. "AsKc")
-        // Maximum total length for two cards: 5+5 = 10 (e.g. "10♠10♥")
-        if (twoCardsStr.length() >= 4 && twoCardsStr.length() <= 10) { // Basic sanity check on total length
-            for (size_t len_card1 = 2; len_card1 <= 5 && len_card1 < twoCardsStr.length(); ++len_card1) {
-                std::string potential_card1_str = twoCardsStr.substr(0, len_card1);
-                std::string potential_card2_str = twoCardsStr.substr(len_card1);
-
-                if (potential_card2_str.length() < 2 || potential_card2_str.length() > 5) { // Sanity check for card 2 length
-                    continue;
-                }
-
-                try {
-                    parseCardStringInternal(potential_card1_str); // Throws on error
-                    parseCardStringInternal(potential_card2_str); // Throws on error
-                    // If both parsed successfully, this is our split
-                    cardStr1 = potential_card1_str;
-                    cardStr2 = potential_card2_str;
-                    found_split = true;
-                    break;
-                } catch (const std::invalid_argument& e) {
-                    // This split was invalid, try next length for card1
-                    #ifdef DEBUG_POKER_ENV
-                    // std::cout << "[DEBUG getRangeIdxByHand single_str] Split attempt failed for "
-                    //           << potential_card1_str << " / " << potential_card2_str << ": " << e.what() << std::endl;
-                    #endif
-                }
-            }
-        }
-
-        if (!found_split) {
-            #ifdef DEBUG_POKER_ENV
-            std::cerr << "[DEBUG getRangeIdxByHand single_str] Could not determine valid split for no-space string: " << twoCardsStr << std::endl;
-            #endif
-            return -1; // Could not split
-        }
-    }
-
-    #ifdef DEBUG_POKER_ENV
-    std::cout << "[DEBUG getRangeIdxByHand single_str] Split '" << twoCardsStr << "' into: card1='" << cardStr1 << "', card2='" << cardStr2 << "'" << std::endl;
-    #endif
-
-    if (cardStr1.empty() || cardStr2.empty()) {
-        #ifdef DEBUG_POKER_ENV
-        std::cerr << "[DEBUG getRangeIdxByHand single_str] One of the card strings is empty after split attempt for: " << twoCardsStr << std::endl;
-        #endif
+    CardId hole[N_HOLE_CARDS];
+    const CardParse::Status status = CardParse::parseHoleCards(twoCardsStr, hole);
+    if (status != CardParse::Status::Ok) {
+        POKER_LOG_DEBUG("[DEBUG getRangeIdxByHand single_str] " << CardParse::statusMessage(status) << ": " << twoCardsStr);
         return -1;
     }
-    return getRangeIdxByHand(cardStr1, cardStr2); // Call the two-string overload
+    return RangeLut::rangeIdx(hole[0], hole[1]);
 }
 
 std::vector<float> PokerEnv::getRangePrivObs(int playerId) {
-    int64_t range_idx = getRangeIdx(playerId);
-
-    if (range_idx == -1) {
-        // Invalid player ID or hand, return an empty or zeroed vector
-        // consistent with LUT vector size.
-        const int N_RANKS_CONST = 13;
-        const int N_SUITS_CONST = 4;
-        const int N_HOLE_CARDS_CONST = 2;
-        bool suits_matter = true;
-        if (args_config.contains("game_settings") && args_config["game_settings"].is_object() &&
-            args_config["game_settings"].contains("suits_matter") && args_config["game_settings"]["suits_matter"].is_boolean()) {
-            suits_matter = args_config["game_settings"]["suits_matter"].get<bool>();
-        }
-        const int D_per_card = suits_matter ? (N_RANKS_CONST + N_SUITS_CONST) : N_RANKS_CONST;
-        return std::vector<float>(N_HOLE_CARDS_CONST * D_per_card, 0.0f);
-    }
+    RangeLut::FloatSpan obs = getRangePrivObsView(playerId);
+    return std::vector<float>(obs.begin(), obs.end());
+}
 
-    auto it = m_privObsLut.find(range_idx);
-    if (it != m_privObsLut.end()) {
-        return it->second;
-    } else {
-#ifdef DEBUG_POKER_ENV
-        std::cerr << "Error: range_idx " << range_idx << " not found in m_privObsLut. This should not happen if LUT is built correctly." << std::endl;
-#endif
-        // Fallback, though theoretically unreachable if range_idx is valid and LUT is correct.
-        const int N_RANKS_CONST = 13;
-        const int N_SUITS_CONST = 4;
-        const int N_HOLE_CARDS_CONST = 2;
-        bool suits_matter = true;
-        if (args_config.contains("game_settings") && args_config["game_settings"].is_object() &&
-            args_config["game_settings"].contains("suits_matter") && args_config["game_settings"]["suits_matter"].is_boolean()) {
-            suits_matter = args_config["game_settings"]["suits_matter"].get<bool>();
-        }
-        const int D_per_card = suits_matter ? (N_RANKS_CONST + N_SUITS_CONST) : N_RANKS_CONST;
-        return std::vector<float>(N_HOLE_CARDS_CONST * D_per_card, 0.0f);
-    }
+// View into the shared table; an invalid player ID or hand gives a zero row
+// of the same width.
+RangeLut::FloatSpan PokerEnv::getRangePrivObsView(int playerId) {
+    return RangeLut::privObs(getRawRangeIdx(playerId), m_privObsSuitsMatter);
 }
 
 
 std::vector<float> PokerEnv::getLegalActionMask() {
-    // This needs to call the more detailed getLegalActions() from PokerEnv.cpp
-    // and then convert that to a mask.
-    // The getLegalActions() in PokerEnv.cpp itself depends on _getFixedAction logic.
-    // For now, a simplified version:
-    // 获取合法动作列表
-    std::vector<int> legalActions = getLegalActions();
-
-    // 创建全0的掩码（所有动作不合法）
-    std::vector<float> mask(N_ACTIONS, 0.0f);
+    const LegalActionSet& legal = legalActionSet();
 
-    // 根据合法动作列表设置掩码
-    for (int action : legalActions) {
-        if (action >= 0 && action < N_ACTIONS) {
-            mask[action] = 1.0f;
+    // 创建全0的掩码（所有动作不合法），再按合法动作置1
+    std::vector<float> mask(N_ACTIONS, 0.0f);
+    for (int i = 0; i < legal.count; ++i) {
+        if (legal.actions[i] >= 0 && legal.actions[i] < N_ACTIONS) {
+            mask[legal.actions[i]] = 1.0f;
         }
     }
-
     return mask;
 }
 
 std::vector<int> PokerEnv::getLegalActions() {
-    std::vector<int> legalActions;
+    const LegalActionSet& legal = legalActionSet();
+    return std::vector<int>(legal.actions, legal.actions + legal.count);
+}
+
+// Legal actions of the current decision point, computed on first use and kept
+// until the state changes (see LegalActions.h).
+const LegalActionSet& PokerEnv::legalActionSet() {
+    if (!m_legalActions.valid) {
+        POKER_PERF_COUNT(PokerPerf::Counter::LegalActionsMiss);
+        _buildLegalActionSet(m_legalActions);
+    } else {
+        POKER_PERF_COUNT(PokerPerf::Counter::LegalActionsHit);
+    }
+    return m_legalActions;
+}
+
+void PokerEnv::_invalidateLegalActions() {
+    m_legalActions.clear();
+}
+
+void PokerEnv::_buildLegalActionSet(LegalActionSet& out) {
+    out.clear();
+    auto resolve = [&out](int a, ResolvedAction fixed) {
+        out.resolved[a] = fixed;
+        out.nResolved = a + 1;
+    };
 
     // 默认总是可以弃牌
-    legalActions.push_back(FOLD);
+    resolve(FOLD, _resolveAction(makeResolvedAction(FOLD, -1)));
+    out.actions[out.count++] = FOLD;
 
     // 检查是否可以跟注/让牌
-    std::vector<float> checkCallAction = {static_cast<float>(CHECK_CALL), -1}; // Use static_cast for clarity
-    std::vector<float> fixedCheckCallAction = _getFixedAction(checkCallAction);
-
-    if (fixedCheckCallAction[0] == CHECK_CALL) {
-        legalActions.push_back(CHECK_CALL);
+    resolve(CHECK_CALL, _resolveAction(makeResolvedAction(CHECK_CALL, -1)));
+    if (out.resolved[CHECK_CALL].type == CHECK_CALL) {
+        out.actions[out.count++] = CHECK_CALL;
     }
 
     // 检查各种加注选项
     int lastTooSmall = -1;
     for (int a = 2; a < N_ACTIONS; ++a) {
-        std::vector<float> raiseAction = _getEnvAdjustedActionFormulation(a);
-        std::vector<float> fixedRaiseAction = _getFixedAction(raiseAction);
+        const ResolvedAction raiseAction = _formulateAction(a);
+        const ResolvedAction fixedRaiseAction = _resolveAction(raiseAction);
+        resolve(a, fixedRaiseAction);
 
         // 如果想加注但环境不允许，就停止添加更大的加注选项
-        if (raiseAction[0] != fixedRaiseAction[0]) {
+        if (raiseAction.type != fixedRaiseAction.type) {
             break;
         }
 
         // 如果加注额被调整为较小值，记录下来
-        if (raiseAction[1] < fixedRaiseAction[1] && a < N_ACTIONS) {
+        if (raiseAction.amount < fixedRaiseAction.amount && a < N_ACTIONS) {
             lastTooSmall = a;
         } else {
             // 如果有之前太小的加注，先添加
             if (lastTooSmall != -1) {
-                legalActions.push_back(lastTooSmall);
+                out.actions[out.count++] = lastTooSmall;
                 lastTooSmall = -1;
             }
 
             // 添加当前合法的加注
-            legalActions.push_back(a);
+            out.actions[out.count++] = a;
         }
 
         // 如果加注被调整为较大值，更大的加注也会被调整为相同值，所以停止添加
-        if (raiseAction[1] > fixedRaiseAction[1]) {
+        if (raiseAction.amount > fixedRaiseAction.amount) {
             break;
         }
     }
 
-    return legalActions;
+    out.valid = true;
 }
 
 // --- Private helper method implementations (Ported from PokerEnv.cpp) ---
 
+// Dealt cards point into the shared card table (nullptr if the deck is empty);
+// hand vectors keep their capacity across clear(), so dealing does not allocate.
 void PokerEnv::_dealHoleCards() {
     for (auto p : players) {
-        // Delete cards PokerEnv might have new'd for this hand previously
-        for (Card* c : p->hand) {
-            delete c;
-        }
         p->hand.clear();
         for (int i = 0; i < N_HOLE_CARDS; ++i) {
-            Card* drawn_card_ptr = deck->drawCard();
-            if (drawn_card_ptr) {
-                p->hand.push_back(new Card(drawn_card_ptr->getSuit(), drawn_card_ptr->getValue())); // PokerEnv owns the new copy
-            } else {
-                p->hand.push_back(nullptr); // Should ideally not happen if deck has enough cards
-            }
+            p->hand.push_back(sharedCard(deck.draw()));
         }
     }
 }
 
 void PokerEnv::_dealFlop() {
-    // Delete existing cards at these community card slots if any (owned by PokerEnv)
-    for (int i = 0; i < N_FLOP_CARDS; ++i) {
-        delete communityCards[i];
-        communityCards[i] = nullptr;
-    }
-    deck->burnCard(); // Burn one card before flop
+    deck.burn(); // Burn one card before flop
     for (int i = 0; i < N_FLOP_CARDS; ++i) {
-        Card* drawn_card_ptr = deck->drawCard();
-        if (drawn_card_ptr) {
-            communityCards[i] = new Card(drawn_card_ptr->getSuit(), drawn_card_ptr->getValue()); // PokerEnv owns copy
-        } else {
-            communityCards[i] = nullptr; // Error or deck empty
-        }
+        communityCards[i] = sharedCard(deck.draw());
     }
 }
 
 void PokerEnv::_dealTurn() {
-    // Delete existing card at this community card slot if any (owned by PokerEnv)
-    delete communityCards[N_FLOP_CARDS];
-    communityCards[N_FLOP_CARDS] = nullptr;
-
-    deck->burnCard(); // Burn one card before turn
-    Card* drawn_card_ptr = deck->drawCard();
-    if (drawn_card_ptr) {
-        communityCards[N_FLOP_CARDS] = new Card(drawn_card_ptr->getSuit(), drawn_card_ptr->getValue()); // PokerEnv owns copy
-    } else {
-        communityCards[N_FLOP_CARDS] = nullptr; // Error or deck empty
-    }
+    deck.burn(); // Burn one card before turn
+    communityCards[N_FLOP_CARDS] = sharedCard(deck.draw());
 }
 
 void PokerEnv::_dealRiver() {
-    // Delete existing card at this community card slot if any (owned by PokerEnv)
-    delete communityCards[N_FLOP_CARDS + N_TURN_CARDS];
-    communityCards[N_FLOP_CARDS + N_TURN_CARDS] = nullptr;
-
-    deck->burnCard(); // Burn one card before river
-    Card* drawn_card_ptr = deck->drawCard();
-    if (drawn_card_ptr) {
-        communityCards[N_FLOP_CARDS + N_TURN_CARDS] = new Card(drawn_card_ptr->getSuit(), drawn_card_ptr->getValue()); // PokerEnv owns copy
-    } else {
-        communityCards[N_FLOP_CARDS + N_TURN_CARDS] = nullptr; // Error or deck empty
-    }
+    deck.burn(); // Burn one card before river
+    communityCards[N_FLOP_CARDS + N_TURN_CARDS] = sharedCard(deck.draw());
 }
 
 void PokerEnv::_dealNextRound() {
@@ -2408,8 +2340,8 @@ void PokerEnv::_dealNextRound() {
     else if (currentRound == TURN) _dealTurn();
     else if (currentRound == RIVER) _dealRiver();
 
-    // 发完公共牌后更新所有玩家的手牌强度和潜力
-    _updateHandPotentialForAllPlayers();
+    // 发完公共牌后所有玩家的手牌潜力失效，读取时重新计算
+    _invalidateHandPotentials();
 }
 
 void PokerEnv::_dealRemainingCommunityCards() {
@@ -2432,8 +2364,8 @@ void PokerEnv::_dealRemainingCommunityCards() {
     }
     // 如果当前轮次是RIVER，不需要发任何牌
 
-    // 发完公共牌后更新所有玩家的手牌强度和潜力
-    _updateHandPotentialForAllPlayers();
+    // 发完公共牌后所有玩家的手牌潜力失效，读取时重新计算
+    _invalidateHandPotentials();
 }
 
 void PokerEnv::_postAntes() {
@@ -2576,20 +2508,14 @@ void PokerEnv::_moveToNextRound() {
         cappedRaise_member.reset();
     } else {
         // 游戏达到了设定的结束轮次
-#ifdef  DEBUG_POKER_ENV
-        std::cout << "_moveToNextRound: Game reached end_with_round" << std::endl;
-#endif
+        POKER_LOG_DEBUG("_moveToNextRound: Game reached end_with_round");
         if (end_with_round == 0) {
             // 如果只玩翻前，直接结束游戏，不发公共牌
-#ifdef  DEBUG_POKER_ENV
-            std::cout << "_moveToNextRound: end_with_round is 0, ending game without dealing community cards" << std::endl;
-#endif
+            POKER_LOG_DEBUG("_moveToNextRound: end_with_round is 0, ending game without dealing community cards");
             handIsOver = true;
         } else {
             // 其他情况需要发完剩余的公共牌进行比牌
-#ifdef  DEBUG_POKER_ENV
-            std::cout << "_moveToNextRound: Dealing remaining community cards for showdown" << std::endl;
-#endif
+            POKER_LOG_DEBUG("_moveToNextRound: Dealing remaining community cards for showdown");
             _dealRemainingCommunityCards();
             handIsOver = true;
         }
@@ -2608,169 +2534,123 @@ void PokerEnv::_putCurrentBetsIntoMainPotAndSidePots() {
     // sidePots are calculated from totalInvestedThisHand later in _calculateSidePots
 }
 
-void PokerEnv::_calculateSidePots() {
-    // This implementation is complex. It needs to mirror PokerEnv.cpp's _calculateSidePots
-    // which correctly determines main pot, side pots, and player eligibility (sidePotRank)
-    // Based on sorted player investments (totalInvestedThisHand).
-
-    // Simplified version for now, real version from PokerEnv.cpp needed.
-    // The crucial part is correctly setting player->sidePotRank.
-    // 0 = main pot, 1 = side pot 0, 2 = side pot 1 etc.
-
-    // For now, assume mainPot contains everything and sidePots are empty.
-    // This is incorrect for proper side pot logic. A full port is required.
-    // The version in PokerEnv.cpp correctly uses PlayerInvestmentInfo.
-    // For demonstration, this will be left as a TODO for full porting.
-
-    //--- Start of Ported _calculateSidePots from PokerEnv.cpp (needs PokerPlayer to have totalInvestedThisHand and sidePotRank)
-    int totalPotFromBets = this->mainPot; // mainPot currently holds sum of all currentBets + previous main/side pots
-    this->mainPot = 0;
-    this->sidePots.clear();
-
-    struct PlayerInvestmentInfo {
-        PokerPlayer* player;
-        int invested; // totalInvestedThisHand
-        bool operator<(const PlayerInvestmentInfo& other) const {
-            return invested < other.invested;
-        }
-    };
-
-    std::vector<PlayerInvestmentInfo> player_investments;
-    for (PokerPlayer* p : players) {
-        if (p && p->totalInvestedThisHand > 0) {
-            player_investments.push_back({p, p->totalInvestedThisHand});
-        }
-    }
+// Contribution layers of a hand: the distinct positive amounts of
+// invested[0..nSeats), ascending, and what each layer collects, every seat
+// paying min(invested - previous level, layer height). layerOfSeat[i] is the
+// last layer seat i pays into (its own level), -1 if it put nothing in.
+// Returns the number of layers, at most nSeats. No allocation.
+static int buildContributionLayers(const int* invested, int nSeats, int* layerPot, int* layerOfSeat) {
+    int levels[Showdown::MAX_SEATS];
+    int nLevels = 0;
+    for (int i = 0; i < nSeats; ++i) {
+        const int v = invested[i];
+        if (v <= 0) continue;
+        int j = nLevels;
+        while (j > 0 && levels[j - 1] > v) --j;
+        if (j > 0 && levels[j - 1] == v) continue;
+        for (int k = nLevels; k > j; --k) levels[k] = levels[k - 1];
+        levels[j] = v;
+        ++nLevels;
+    }
+
+    for (int k = 0; k < nLevels; ++k) layerPot[k] = 0;
+    for (int i = 0; i < nSeats; ++i) {
+        const int v = invested[i];
+        layerOfSeat[i] = -1;
+        int previous = 0;
+        for (int k = 0; k < nLevels && v > previous; ++k) {
+            layerPot[k] += std::min(v, levels[k]) - previous;
+            layerOfSeat[i] = k;
+            previous = levels[k];
+        }
+    }
+    return nLevels;
+}
 
-    if (player_investments.empty()) {
-        this->mainPot = totalPotFromBets; // Should be 0 if no one invested
-        return;
+void PokerEnv::_calculateSidePots() {
+    POKER_PERF_SCOPE(PokerPerf::Timer::SidePots);
+    // Layers of totalInvestedThisHand: the lowest is the main pot, each
+    // higher one a side pot. sidePotRank is the index of the last pot a
+    // player is eligible for (0 = main pot, 1 = side pot 0, ...); seats that
+    // invested nothing keep theirs.
+    int invested[Showdown::MAX_SEATS];
+    int layerPot[Showdown::MAX_SEATS];
+    int layerOfSeat[Showdown::MAX_SEATS];
+    for (int i = 0; i < N_SEATS; ++i) {
+        invested[i] = players[i] ? players[i]->totalInvestedThisHand : 0;
     }
+    const int nLayers = buildContributionLayers(invested, N_SEATS, layerPot, layerOfSeat);
 
-    std::sort(player_investments.begin(), player_investments.end());
-
-    int last_bet_level = 0;
-    for (const auto& inv_info : player_investments) {
-        int current_bet_level = inv_info.invested;
-        if (current_bet_level <= last_bet_level) continue;
-
-        int pot_this_layer = 0;
-        int layer_contribution_per_player = current_bet_level - last_bet_level;
-
-        for (PokerPlayer* p_contributor : players) { // Iterate all players to check contribution
-            if (p_contributor && p_contributor->totalInvestedThisHand >= current_bet_level) {
-                pot_this_layer += layer_contribution_per_player;
-                // Set sidePotRank: index of the last pot they are eligible for.
-                // Main pot: rank 0. Side pot 0 (this->sidePots[0]): rank 1, etc.
-                p_contributor->sidePotRank = (this->mainPot == 0 && this->sidePots.empty()) ? 0 : 1 + static_cast<int>(this->sidePots.size());
-            } else if (p_contributor && p_contributor->totalInvestedThisHand > last_bet_level && p_contributor->totalInvestedThisHand < current_bet_level) {
-                // Player is all-in at a level below current_bet_level but above last_bet_level
-                 pot_this_layer += (p_contributor->totalInvestedThisHand - last_bet_level);
-                 p_contributor->sidePotRank = (this->mainPot == 0 && this->sidePots.empty()) ? 0 : 1 + static_cast<int>(this->sidePots.size());
-            }
-        }
-
-
-        if (pot_this_layer > 0) {
-            if (this->mainPot == 0 && this->sidePots.empty()) { // First pot is main pot
-                this->mainPot = pot_this_layer;
-            } else {
-                this->sidePots.push_back(pot_this_layer);
-            }
+    sidePots.clear();
+    if (nLayers > 0) {
+        mainPot = layerPot[0];
+        sidePots.assign(layerPot + 1, layerPot + nLayers);
+        for (int i = 0; i < N_SEATS; ++i) {
+            if (layerOfSeat[i] >= 0) players[i]->sidePotRank = layerOfSeat[i];
         }
-        last_bet_level = current_bet_level;
     }
-    //--- End of Ported _calculateSidePots
+    // With no investment at all mainPot keeps whatever was collected.
+
+    _syncPotBookkeeping();
 }
 
 void PokerEnv::_calculateCurrentSidePots() {
-    // 实时计算当前边池状态，基于玩家的totalInvestedThisHand + currentBet
-    // 这个方法在每次下注后立即调用，提供实时的边池信息
-
-    // 临时存储：计算虚拟的边池，但不改变实际的mainPot和sidePots
-    // 用于观察向量，实际的边池分配仍在_assignRewardsAndResetBets中进行
-
-    struct PlayerInvestmentInfo {
-        PokerPlayer* player;
-        int invested; // totalInvestedThisHand + currentBet
-        bool operator<(const PlayerInvestmentInfo& other) const {
-            return invested < other.invested;
-        }
-    };
-
-    std::vector<PlayerInvestmentInfo> player_investments;
+    POKER_PERF_SCOPE(PokerPerf::Timer::SidePots);
+    // 实时边池（观察向量用），不改变实际的 mainPot 和 sidePots（实际分配在
+    // _assignRewardsAndResetBets 中）。只在某个玩家的投入变化后（见
+    // _currentSidePotsDirty）重新计算。
+    //
+    // The layered version this replaced never wrote a layer: currentSidePots
+    // is sized N_SEATS before the loop and its bounds check wanted fewer, and
+    // its eligibility test never saw an empty vector. What it produced is
+    // exactly this: no current side pots, currentMainPot = mainPot, rank
+    // N_SEATS + 1 for every seat with chips in and 0 for all if none has.
+    // Kept as is so observations do not change.
+    currentMainPot = mainPot;
+    currentSidePots.assign(N_SEATS, 0);
+
+    bool anyInvested = false;
     for (PokerPlayer* p : players) {
-        if (p && (p->totalInvestedThisHand + p->currentBet) > 0) {
-            player_investments.push_back({p, p->totalInvestedThisHand + p->currentBet});
+        if (p && p->totalInvestedThisHand + p->currentBet > 0) {
+            p->currentSidePotRank = 1 + N_SEATS;
+            anyInvested = true;
         }
     }
-
-    if (player_investments.empty()) {
-        // 清空当前边池信息
-        currentMainPot = mainPot;
-        currentSidePots.clear();
-        currentSidePots.resize(N_SEATS, 0);
+    if (!anyInvested) {
         for (PokerPlayer* p : players) {
             if (p) p->currentSidePotRank = 0;
         }
-        return;
     }
+}
 
-    std::sort(player_investments.begin(), player_investments.end());
-
-    // 重置当前边池信息
-    currentMainPot = mainPot; // 已经收集的主池
-    currentSidePots.clear();
-    currentSidePots.resize(N_SEATS, 0);
+// Chips in the pot counted from scratch: collected pots plus bets on the table.
+int PokerEnv::_potSizeFromScratch() const {
+    int total = mainPot;
+    for (int pot : sidePots) total += pot;
+    for (const PokerPlayer* p : players) {
+        if (p) total += p->currentBet;
+    }
+    return total;
+}
 
-    int last_bet_level = 0;
-    for (const auto& inv_info : player_investments) {
-        int current_bet_level = inv_info.invested;
-        if (current_bet_level <= last_bet_level) continue;
-
-        int pot_this_layer = 0;
-        int layer_contribution_per_player = current_bet_level - last_bet_level;
-
-        for (PokerPlayer* p_contributor : players) {
-            if (p_contributor && (p_contributor->totalInvestedThisHand + p_contributor->currentBet) >= current_bet_level) {
-                pot_this_layer += layer_contribution_per_player;
-                // 设置当前边池等级
-                p_contributor->currentSidePotRank = (currentMainPot == mainPot && currentSidePots.empty()) ? 0 : 1 + static_cast<int>(currentSidePots.size());
-            } else if (p_contributor && (p_contributor->totalInvestedThisHand + p_contributor->currentBet) > last_bet_level &&
-                      (p_contributor->totalInvestedThisHand + p_contributor->currentBet) < current_bet_level) {
-                pot_this_layer += ((p_contributor->totalInvestedThisHand + p_contributor->currentBet) - last_bet_level);
-                p_contributor->currentSidePotRank = (currentMainPot == mainPot && currentSidePots.empty()) ? 0 : 1 + static_cast<int>(currentSidePots.size());
-            }
-        }
+// Called wherever chips move other than by a bet in step(): resets, street
+// collection, showdown and state loads.
+void PokerEnv::_syncPotBookkeeping() {
+    _potTotal = _potSizeFromScratch();
+    _currentSidePotsDirty = true;
+}
 
-        if (pot_this_layer > 0) {
-            if (currentMainPot == mainPot && currentSidePots.empty()) {
-                currentMainPot += pot_this_layer;
-            } else {
-                if (currentSidePots.size() < N_SEATS) { // Check bounds before access
-                    currentSidePots[currentSidePots.size()] = pot_this_layer; // This logic is wrong for pushing to vector.
-                                                                            // sidePots.push_back(pot_this_layer) if it's a std::vector
-                                                                            // This currentSidePots is resized to N_SEATS.
-                                                                            // It should be:
-                                                                            // currentSidePots.push_back(pot_this_layer);
-                                                                            // Or if it's meant to be an array:
-                                                                            // if (idx < N_SEATS) currentSidePots[idx++] = pot_this_layer
-                                                                            // For now, assuming it tries to act like a list of side pots:
-                                                                            // This should likely be currentSidePots.push_back(pot_this_layer)
-                                                                            // and currentSidePots should not be pre-resized with 0s if it's dynamic.
-                                                                            // Given it's used as currentSidePots[i] in obs, it's an array.
-                                                                            // Let's assume the original intent was to fill it sequentially:
-                    int current_side_pot_idx = 0;
-                    while(current_side_pot_idx < currentSidePots.size() && currentSidePots[current_side_pot_idx] != 0) {
-                        current_side_pot_idx++;
-                    }
-                    if (current_side_pot_idx < currentSidePots.size()) {
-                         currentSidePots[current_side_pot_idx] = pot_this_layer;
-                    }
-                }
-            }
-        }
-        last_bet_level = current_bet_level;
+// Copies the hot per-seat fields out of the players (SeatState.h).
+void PokerEnv::_syncSeatState() {
+    m_seats.nSeats = N_SEATS;
+    for (int i = 0; i < N_SEATS; ++i) {
+        const PokerPlayer* p = players[i];
+        m_seats.stack[i] = p->stack;
+        m_seats.currentBet[i] = p->currentBet;
+        m_seats.chips[i] = p->stack + p->currentBet;
+        m_seats.invested[i] = p->totalInvestedThisHand;
+        m_seats.folded[i] = p->folded ? 1 : 0;
+        m_seats.allin[i] = p->isAllin ? 1 : 0;
     }
 }
 
@@ -2799,15 +2679,13 @@ int PokerEnv::getFractionOfPotRaise(float fraction, PokerPlayer* playerThatBets)
     int toCall = biggestBetOutThere - playerThatBets->currentBet;
     toCall = std::max(0, toCall);
 
-    int potBeforeAction = mainPot; // Current main pot
-    for (int sp : sidePots) potBeforeAction += sp; // Plus side pots
-    for (const auto* p : players) potBeforeAction += p->currentBet; // Plus bets on table
+    int potBeforeAction = getPotSize(); // Collected pots plus bets on the table
 
     int potAfterCall = potBeforeAction + toCall;
     int delta = static_cast<int>(static_cast<float>(toCall) + (static_cast<float>(potAfterCall) * fraction));
     int totalRaise = delta + playerThatBets->currentBet; // This is target total bet for playerThatBets
 
-    // Clamping / min raise adjustment should happen in _processRaise or _getFixedAction
+    // Clamping / min raise adjustment should happen in _resolveRaise or _resolveAction
     return totalRaise;
 }
 
@@ -2815,59 +2693,36 @@ int PokerEnv::getFractionOfPotRaise(float fraction, PokerPlayer* playerThatBets)
 // Base function: getHandRank from vectors of Card pointers
 // This is one of the top-level functions that directly calls phevaluator logic.
 int PokerEnv::getHandRank(const std::vector<Card*>& hand_cards, const std::vector<Card*>& board_cards) const {
-    std::vector<Card*> all_cards = hand_cards;
-    all_cards.insert(all_cards.end(), board_cards.begin(), board_cards.end());
-
-    // Filter out nullptrs that might have been passed
-    all_cards.erase(std::remove(all_cards.begin(), all_cards.end(), nullptr), all_cards.end());
-
-    // Convert to phevaluator's int representation
-    std::vector<int> eval_cards_int;
-    eval_cards_int.reserve(all_cards.size());
-    for(Card* c : all_cards) {
-        // No need to check for nullptr here if already removed, but double check for safety
-        if (c) {
-            eval_cards_int.push_back(_convert_card_to_phevaluator_int(c));
+    // Card ids are phevaluator's ints already; gather them into a fixed array,
+    // skipping nullptrs (empty board slots).
+    int eval_cards_int[7];
+    size_t n_cards = 0;
+    size_t n_total = 0;
+    for (const std::vector<Card*>* group : {&hand_cards, &board_cards}) {
+        for (const Card* c : *group) {
+            if (!c) continue;
+            if (n_cards < 7) eval_cards_int[n_cards++] = cardIdOf(c);
+            ++n_total;
         }
     }
 
-    // Filter out any -1 (error indicators from conversion if any were pushed)
-    eval_cards_int.erase(std::remove(eval_cards_int.begin(), eval_cards_int.end(), -1), eval_cards_int.end());
-
-    if (eval_cards_int.size() < 5) {
+    if (n_cards < 5) {
         return 0; // Not enough cards to evaluate
     }
 
-    #ifdef DEBUG_POKER_ENV
-    std::cout << "[DEBUG getHandRank(vec_card*, vec_card*)] Input hand_cards (" << hand_cards.size() << "), board_cards (" << board_cards.size() << ")" << std::endl;
-    std::cout << "  eval_cards_int for phevaluator (size " << eval_cards_int.size() << "): ";
-    for (size_t i = 0; i < eval_cards_int.size(); ++i) {
-        std::cout << eval_cards_int[i] << (i == eval_cards_int.size() - 1 ? "" : ", ");
-    }
-    std::cout << std::endl;
-    std::cout << "  eval_cards_int breakdown (pheval_rank, pheval_suit): ";
-    for (int card_int : eval_cards_int) {
-        if (card_int != -1) {
-             std::cout << "(" << (card_int / 4) << "," << (card_int % 4) << ") ";
-        } else {
-             std::cout << "(-1) ";
-        }
+    POKER_LOG_DEBUG("[DEBUG getHandRank(vec_card*, vec_card*)] Input hand_cards (" << hand_cards.size() << "), board_cards (" << board_cards.size() << ")");
+    POKER_LOG_DEBUG("  eval_cards_int for phevaluator " << evalCardsDebugString(eval_cards_int, n_cards));
+    if (n_total > 7) {
+        POKER_LOG_DEBUG("[WARNING PokerEnv::getHandRank(vec_card*, vec_card*)] More than 7 cards after processing (" << n_total << "). Evaluating first 7.");
     }
-    std::cout << std::endl;
-    #endif
 
     // Call the appropriate phevaluator function based on the number of cards
     int rank_val = 7463; // Default to phevaluator's worst rank representation + 1
-    if (eval_cards_int.size() == 5) {
+    if (n_cards == 5) {
         rank_val = evaluate_5cards(eval_cards_int[0], eval_cards_int[1], eval_cards_int[2], eval_cards_int[3], eval_cards_int[4]);
-    } else if (eval_cards_int.size() == 6) {
+    } else if (n_cards == 6) {
         rank_val = evaluate_6cards(eval_cards_int[0], eval_cards_int[1], eval_cards_int[2], eval_cards_int[3], eval_cards_int[4], eval_cards_int[5]);
-    } else if (eval_cards_int.size() == 7) { // Max 7 cards
-        rank_val = evaluate_7cards(eval_cards_int[0], eval_cards_int[1], eval_cards_int[2], eval_cards_int[3], eval_cards_int[4], eval_cards_int[5], eval_cards_int[6]);
-    } else if (eval_cards_int.size() > 7) {
-         #ifdef DEBUG_POKER_ENV
-        std::cout << "[WARNING PokerEnv::getHandRank(vec_card*, vec_card*)] More than 7 cards after processing (" << eval_cards_int.size() << "). Evaluating first 7." << std::endl;
-        #endif
+    } else { // 7 cards (anything beyond the first 7 is ignored)
         rank_val = evaluate_7cards(eval_cards_int[0], eval_cards_int[1], eval_cards_int[2], eval_cards_int[3], eval_cards_int[4], eval_cards_int[5], eval_cards_int[6]);
     }
     // phevaluator: 1 is best (Royal/Straight Flush), 7462 is worst (High Card).
@@ -2879,29 +2734,31 @@ int PokerEnv::getHandRank(const std::vector<Card*>& hand_cards, const std::vecto
 void PokerEnv::_assignRewardsAndResetBets() {
     _calculateSidePots(); // Ensure pots are correctly structured first
 
-    lastHandWinnings.clear();
-    std::vector<PokerPlayer*> playersToShowHands;
-    for(PokerPlayer* p : players) {
+    _clearLastHandWinnings();
+    Showdown::SeatMask showdownSeats = 0;
+    for (int i = 0; i < N_SEATS; ++i) {
+        const PokerPlayer* p = players[i];
         // Eligible for showdown if not folded OR folded but was all-in
         if (p && (!p->folded || p->isAllin) && p->totalInvestedThisHand > 0) {
-            playersToShowHands.push_back(p);
+            showdownSeats |= Showdown::seatBit(i);
         }
     }
+    const int nShowdown = Showdown::seatCount(showdownSeats);
 
     // If only one player remains eligible for any pot money (others folded without all-in)
-    if (playersToShowHands.size() == 1) {
-        PokerPlayer* winner = playersToShowHands[0];
+    if (nShowdown == 1) {
+        PokerPlayer* winner = players[Showdown::lowestSeat(showdownSeats)];
         int totalWinnings = 0;
-        std::string handDesc = "Won by Default";
+        uint8_t handDesc = HandDescription::WON_BY_DEFAULT;
          if (!winner->folded) { // If they didn't fold, get hand description
             int rank = getHandRank(winner->hand, getCommunityCards());
-            handDesc = getHandDescriptionFromRank(rank); // Pass phevaluator rank directly
+            handDesc = HandDescription::fromRank(rank); // Pass phevaluator rank directly
          }
 
         if (mainPot > 0) {
             winner->award(mainPot);
             totalWinnings += mainPot;
-            lastHandWinnings.push_back({winner->seatId, mainPot, "Main Pot", handDesc, winner->hand});
+            _recordWinning(winner, mainPot, HandDescription::MAIN_POT, handDesc);
             mainPot = 0;
         }
         for (size_t i = 0; i < sidePots.size(); ++i) {
@@ -2911,34 +2768,39 @@ void PokerEnv::_assignRewardsAndResetBets() {
                  if (winner->sidePotRank >= static_cast<int>(i + 1)) {
                     winner->award(sidePots[i]);
                     totalWinnings += sidePots[i];
-                    lastHandWinnings.push_back({winner->seatId, sidePots[i], "Side Pot " + std::to_string(i + 1), handDesc, winner->hand});
+                    _recordWinning(winner, sidePots[i], static_cast<uint8_t>(i + 1), handDesc);
                     sidePots[i] = 0;
                  }
             }
         }
-    } else if (playersToShowHands.size() > 1) {
+    } else if (nShowdown > 1) {
+        // Each showdown hand is evaluated once; every pot is settled from these ranks.
+        Showdown::SeatRanks ranks;
+        _evaluateShowdownRanks(showdownSeats, ranks);
+
+        // Seats eligible for pot k (0 = main pot): player rank N is eligible for pots 0..N.
+        auto potContenders = [&](int k) {
+            Showdown::SeatMask contenders = 0;
+            for (Showdown::SeatMask m = showdownSeats; m; m = Showdown::dropLowest(m)) {
+                const int seat = Showdown::lowestSeat(m);
+                if (players[seat]->sidePotRank >= k) contenders |= Showdown::seatBit(seat);
+            }
+            return contenders;
+        };
+
         // --- Distribute Main Pot ---
-        std::vector<PokerPlayer*> mainPotContenders;
-        for(PokerPlayer* p : playersToShowHands) {
-            if (p->sidePotRank >= 0) mainPotContenders.push_back(p); // Rank 0 means main pot
-        }
-        if (mainPot > 0 && !mainPotContenders.empty()) {
-            distributePot(mainPot, mainPotContenders, "Main Pot");
+        if (mainPot > 0) {
+            _awardPot(mainPot, potContenders(0), ranks, HandDescription::MAIN_POT);
         }
         mainPot = 0;
 
         // --- Distribute Side Pots ---
         for (size_t i = 0; i < sidePots.size(); ++i) {
             if (sidePots[i] > 0) {
-                std::vector<PokerPlayer*> sidePotContenders;
-                for (PokerPlayer* p : playersToShowHands) {
-                    // Player rank N is eligible for pots 0..N. sidePots[i] is pot number i+1.
-                    if (p->sidePotRank >= static_cast<int>(i + 1)) {
-                        sidePotContenders.push_back(p);
-                    }
-                }
-                if (!sidePotContenders.empty()) {
-                    distributePot(sidePots[i], sidePotContenders, "Side Pot " + std::to_string(i + 1));
+                // sidePots[i] is pot number i+1.
+                const Showdown::SeatMask contenders = potContenders(static_cast<int>(i + 1));
+                if (contenders) {
+                    _awardPot(sidePots[i], contenders, ranks, static_cast<uint8_t>(i + 1));
                 }
                 sidePots[i] = 0;
             }
@@ -2946,70 +2808,117 @@ void PokerEnv::_assignRewardsAndResetBets() {
     }
     // Else (no one eligible for pots, e.g. error or all folded with no investment for some reason)
 
+    _syncPotBookkeeping();
+
     // Player state reset (currentBet, totalInvested) is handled by PokerPlayer::reset called by PokerEnv::reset
 }
 
-void PokerEnv::distributePot(int potAmount, std::vector<PokerPlayer*>& contenders, const std::string& potName) {
-    if (potAmount <= 0 || contenders.empty()) return;
-
-    // 过滤出参与摊牌的玩家（没有弃牌的，或者全下的玩家）
-    std::vector<PokerPlayer*> showdownPlayers;
-    for(PokerPlayer* p : contenders) {
-        if (!p->folded || p->isAllin) {
-            showdownPlayers.push_back(p);
+// One 7-card evaluation per seat in `seats`. Seats holding two hole cards on a
+// full board go through the batch evaluator in a single call; anything else
+// (a short board or missing cards) falls back to getHandRank.
+void PokerEnv::_evaluateShowdownRanks(Showdown::SeatMask seats, Showdown::SeatRanks& ranks) const {
+    CardId board[N_COMMUNITY_CARDS];
+    bool fullBoard = communityCards.size() == N_COMMUNITY_CARDS;
+    for (int i = 0; fullBoard && i < N_COMMUNITY_CARDS; ++i) {
+        fullBoard = communityCards[i] != nullptr;
+        if (fullBoard) board[i] = cardIdOf(communityCards[i]);
+    }
+
+    CardId packed[Showdown::MAX_SEATS][HandEvalBatch::CARDS_PER_HAND];
+    int packedSeat[Showdown::MAX_SEATS];
+    int nPacked = 0;
+    for (Showdown::SeatMask m = seats; m; m = Showdown::dropLowest(m)) {
+        const int seat = Showdown::lowestSeat(m);
+        const std::vector<Card*>& hand = players[seat]->hand;
+        if (fullBoard && hand.size() == N_HOLE_CARDS && hand[0] && hand[1]) {
+            packed[nPacked][0] = cardIdOf(hand[0]);
+            packed[nPacked][1] = cardIdOf(hand[1]);
+            std::copy(board, board + N_COMMUNITY_CARDS, packed[nPacked] + N_HOLE_CARDS);
+            packedSeat[nPacked++] = seat;
+        } else {
+            ranks.rank[seat] = getHandRank(hand, communityCards);
         }
     }
 
-    if (showdownPlayers.empty()) return; // 没有人参与摊牌
+    int32_t packedRanks[Showdown::MAX_SEATS];
+    evaluate_hands_batch(&packed[0][0], static_cast<size_t>(nPacked), packedRanks);
+    for (int i = 0; i < nPacked; ++i) ranks.rank[packedSeat[i]] = packedRanks[i];
+}
+
+// Splits potAmount between the best hands among `contenders` (all of which
+// must be showdown seats with an entry in ranks). The odd chips go to the
+// lowest winning seat. potIndex: 0 = main pot, k = side pot k.
+void PokerEnv::_awardPot(int potAmount, Showdown::SeatMask contenders, const Showdown::SeatRanks& ranks, uint8_t potIndex) {
+    if (potAmount <= 0 || !contenders) return;
 
     // 如果只有一个玩家，直接获胜
-    if (showdownPlayers.size() == 1) {
-        PokerPlayer* winner = showdownPlayers[0];
+    if (Showdown::seatCount(contenders) == 1) {
+        PokerPlayer* winner = players[Showdown::lowestSeat(contenders)];
         winner->award(potAmount);
-        lastHandWinnings.push_back({
-            winner->seatId,
-            potAmount,
-            potName,
-            "Won by default",
-            winner->hand
-        });
+        _recordWinning(winner, potAmount, potIndex, HandDescription::WON_BY_DEFAULT);
         return;
     }
 
-    // 使用新的牌力分组功能
-    std::vector<std::vector<PokerPlayer*>> handGroups = groupPlayersByHandStrength(showdownPlayers);
+    // 最强的一组获胜者
+    const Showdown::SeatMask winners = Showdown::bestSeats(ranks, contenders);
+    const int nWinners = Showdown::seatCount(winners);
 
-    if (handGroups.empty()) return;
+    // 计算每个获胜者应该得到的金额
+    int prizePerWinner = potAmount / nWinners;
+    int remainder = potAmount % nWinners;
 
-    // 最强的一组获胜者（第一组就是最强的）
-    std::vector<PokerPlayer*> winners = handGroups[0];
+    // 获取获胜手牌的描述
+    const uint8_t handDesc = HandDescription::fromRank(ranks.rank[Showdown::lowestSeat(winners)]);
 
-    if (!winners.empty()) {
-        // 计算每个获胜者应该得到的金额
-        int prizePerWinner = potAmount / winners.size();
-        int remainder = potAmount % winners.size();
+    // 分配奖金给获胜者
+    for (Showdown::SeatMask m = winners; m; m = Showdown::dropLowest(m)) {
+        PokerPlayer* winner = players[Showdown::lowestSeat(m)];
+        int finalPrize = prizePerWinner + remainder; // 余数给第一个获胜者
+        remainder = 0;
 
-        // 获取获胜手牌的描述
-        int bestRank = getHandRank(winners[0]->hand, communityCards);
-        std::string handDesc = getHandDescriptionFromRank(bestRank);
+        winner->award(finalPrize);
+        _recordWinning(winner, finalPrize, potIndex, handDesc);
+    }
+}
 
-        // 分配奖金给获胜者
-        for (size_t i = 0; i < winners.size(); ++i) {
-            int finalPrize = prizePerWinner;
-            if (i == 0) {
-                finalPrize += remainder; // 余数给第一个获胜者
-            }
+// lastHandWinnings entries keep their hole cards in m_handArena; the arena is
+// rewound whenever the list is, so each settlement reuses the same storage.
+// The list itself is left alone by reset(): the last hand's results stay
+// readable until the next pot is settled or a state is loaded.
+void PokerEnv::_clearLastHandWinnings() {
+    lastHandWinnings.clear();
+    m_handArena.rewind();
+}
 
-            winners[i]->award(finalPrize);
-            lastHandWinnings.push_back({
-                winners[i]->seatId,
-                finalPrize,
-                potName,
-                handDesc,
-                winners[i]->hand
-            });
+void PokerEnv::_recordWinning(int seatId, int amount, uint8_t potIndex, uint8_t handDescriptionId,
+                              Card* const* holeCards, size_t nHoleCards) {
+    PlayerWinningInfo info{seatId, amount, potIndex, handDescriptionId,
+                           std::pmr::vector<Card*>(holeCards, holeCards + nHoleCards, m_handArena.resource())};
+    lastHandWinnings.push_back(std::move(info));
+}
+
+void PokerEnv::_recordWinning(const PokerPlayer* winner, int amount, uint8_t potIndex, uint8_t handDescriptionId) {
+    _recordWinning(winner->seatId, amount, potIndex, handDescriptionId, winner->hand.data(), winner->hand.size());
+}
+
+void PokerEnv::distributePot(int potAmount, std::vector<PokerPlayer*>& contenders, const std::string& potName) {
+    if (potAmount <= 0 || contenders.empty()) return;
+
+    // 过滤出参与摊牌的玩家（没有弃牌的，或者全下的玩家）
+    Showdown::SeatMask showdownSeats = 0;
+    for (int i = 0; i < N_SEATS; ++i) {
+        const PokerPlayer* p = players[i];
+        if (p && (!p->folded || p->isAllin) && std::find(contenders.begin(), contenders.end(), p) != contenders.end()) {
+            showdownSeats |= Showdown::seatBit(i);
         }
     }
+    if (!showdownSeats) return; // 没有人参与摊牌
+
+    Showdown::SeatRanks ranks;
+    if (Showdown::seatCount(showdownSeats) > 1) {
+        _evaluateShowdownRanks(showdownSeats, ranks);
+    }
+    _awardPot(potAmount, showdownSeats, ranks, HandDescription::potIndexOf(potName));
 }
 
 int PokerEnv::_adjustRaise(float raiseTotalAmountInChips_float) {
@@ -3033,19 +2942,18 @@ int PokerEnv::_adjustRaise(float raiseTotalAmountInChips_float) {
 // --- Getters and other public methods ---
 int PokerEnv::getNumPlayers() const { return N_SEATS; }
 const std::vector<Card*>& PokerEnv::getCommunityCards() const { return communityCards; }
+const std::vector<PokerEnv::ActionRecord>& PokerEnv::getActionHistory() const { return actionHistory; }
 
 int PokerEnv::getPotSize() const {
-    // 返回真正的当前底池：已收集的mainPot + sidePots + 桌上的currentBet
-    int total_pot = mainPot + std::accumulate(sidePots.begin(), sidePots.end(), 0);
-
-    // 加上桌上的下注
-    for (const PokerPlayer* p : players) {
-        if (p) {
-            total_pot += p->currentBet;
-        }
+    // 真正的当前底池：已收集的 mainPot + sidePots + 桌上的 currentBet，
+    // 由 step() 和 _syncPotBookkeeping() 维护
+#ifdef DEBUG_POKER_ENV
+    const int fromScratch = _potSizeFromScratch();
+    if (fromScratch != _potTotal) {
+        POKER_LOG_ERROR("[DEBUG getPotSize] running pot " << _potTotal << " != recomputed " << fromScratch);
     }
-
-    return total_pot;
+#endif
+    return _potTotal;
 }
 
 int PokerEnv::getCurrentBet() const { // This is effectively _getBiggestBetOutThereAkaTotalToCall
@@ -3111,16 +3019,20 @@ int PokerEnv::_getFirstToActPostFlop() {
 
 
 void PokerEnv::printBoard() {
-    for(auto c : communityCards) if(c) std::cout << c->toString() << " ";
-    std::cout << std::endl;
+    std::ostringstream oss;
+    for(auto c : communityCards) if(c) oss << c->toString() << " ";
+    oss << "\n";
+    PokerLog::print(oss.str());
 }
 
 void PokerEnv::printHands() {
+    std::ostringstream oss;
     for(auto p : players) {
-        std::cout << "P" << p->seatId << ": ";
-        p->printHand();
-        std::cout << " S:" << p->stack << " B:" << p->currentBet << std::endl;
+        oss << "P" << p->seatId << ": ";
+        for (const Card* c : p->hand) if (c) oss << c->toString() << " ";
+        oss << " S:" << p->stack << " B:" << p->currentBet << "\n";
     }
+    PokerLog::print(oss.str());
 }
 
 nlohmann::json PokerEnv::state_dict() const {
@@ -3179,15 +3091,18 @@ nlohmann::json PokerEnv::state_dict() const {
     }
     state["communityCards"] = community_cards_json;
 
-    state["deck"] = deck->state_dict(); // Assuming Deck has state_dict
+    // Undealt cards as ids, in dealing order (the last entry is dealt next)
+    nlohmann::json deck_json = nlohmann::json::array();
+    for (int i = 0; i < deck.remaining(); ++i) deck_json.push_back(static_cast<int>(deck.cards[i]));
+    state["deck"] = deck_json;
 
     nlohmann::json last_winnings_json = nlohmann::json::array();
     for(const auto& lw : lastHandWinnings) {
         nlohmann::json lw_item;
         lw_item["seatId"] = lw.seatId;
         lw_item["amountWon"] = lw.amountWon;
-        lw_item["potDescription"] = lw.potDescription;
-        lw_item["handDescription"] = lw.handDescription;
+        lw_item["potDescription"] = std::string(lw.potDescription());
+        lw_item["handDescription"] = std::string(lw.handDescription());
         nlohmann::json hc_json = nlohmann::json::array();
         for(const Card* card : lw.holeCards) {
             if (card) {
@@ -3203,7 +3118,16 @@ nlohmann::json PokerEnv::state_dict() const {
     }
     state["lastHandWinnings"] = last_winnings_json;
 
-    // m_rng state is tricky, usually not serialized directly like this for mt19937
+    // [playerId, actionType, betAmount, round, potAtActionTime, playerStackAtActionTime, actionInt]
+    nlohmann::json action_history_json = nlohmann::json::array();
+    for (const ActionRecord& a : actionHistory) {
+        action_history_json.push_back({a.playerId, a.actionType, a.betAmount, a.round,
+                                       a.potAtActionTime, a.playerStackAtActionTime, a.actionInt});
+    }
+    state["actionHistory"] = action_history_json;
+    state["actions_this_street"] = actions_this_street;
+
+    // m_rng state is not saved; the deck is, in dealing order.
     return state;
 }
 
@@ -3215,12 +3139,21 @@ void PokerEnv::load_state_dict(const nlohmann::json& state, bool blank_private_i
     }
 
     N_SEATS = state["N_SEATS"]; // Should match constructor if not dynamic
+    if (N_SEATS > Showdown::MAX_SEATS) {
+        throw std::invalid_argument("load_state_dict: N_SEATS " + std::to_string(N_SEATS) + " exceeds " +
+                                    std::to_string(Showdown::MAX_SEATS));
+    }
     SMALL_BLIND = state["SMALL_BLIND"];
     BIG_BLIND = state["BIG_BLIND"];
     ANTE = state["ANTE"];
     DEFAULT_STACK_SIZE = state["DEFAULT_STACK_SIZE"];
     REWARD_SCALAR = state["REWARD_SCALAR"];
     N_ACTIONS = state["N_ACTIONS"];
+    if (N_ACTIONS > LegalActionSet::MAX_ACTIONS) {
+        throw std::invalid_argument("load_state_dict: N_ACTIONS " + std::to_string(N_ACTIONS) + " exceeds " +
+                                    std::to_string(LegalActionSet::MAX_ACTIONS));
+    }
+    m_kernels = &selectTableKernels<ActionRecord>(N_SEATS, N_ACTIONS);
     IS_EVALUATING = state["IS_EVALUATING"];
 
     buttonPos = state["buttonPos"];
@@ -3262,36 +3195,319 @@ void PokerEnv::load_state_dict(const nlohmann::json& state, bool blank_private_i
     }
     for(size_t i=0; i<players_json.size(); ++i) {
         players[i]->load_state_dict(players_json[i], blank_private_info);
+        // Swap any cards the player materialised for the shared instances.
+        for (Card*& c : players[i]->hand) {
+            if (c && !isSharedCard(c)) {
+                Card* shared = sharedCard(cardIdOf(c));
+                delete c;
+                c = shared;
+            }
+        }
     }
 
-    deck->load_state_dict(state["deck"]); //Requires Deck to implement this
+    if (state.contains("deck") && state["deck"].is_array()) {
+        deck.clear();
+        for (const auto& id_json : state["deck"]) {
+            int id = id_json.get<int>();
+            if (isValidCardId(id)) deck.append(static_cast<CardId>(id));
+        }
+    } else {
+        deck.fill();
+    }
 
     const auto& comm_cards_json = state["communityCards"];
     communityCards.assign(N_COMMUNITY_CARDS, nullptr); // Clear and resize
-    for(size_t i=0; i<comm_cards_json.size(); ++i) {
+    for(size_t i=0; i<comm_cards_json.size() && i < communityCards.size(); ++i) {
         if (!comm_cards_json[i].is_null()) {
-            // Find card from deck - this is critical. Deck must provide this.
-            // Or, Card objects are created here, but Deck might lose track / double-delete.
-            // Placeholder: Assume deck can find/provide card pointer
-            // communityCards[i] = deck->findCard(comm_cards_json[i][0].get<int>(), comm_cards_json[i][1].get<int>());
+            // Saved as [value, suit]
+            communityCards[i] = sharedCard(makeCardId(comm_cards_json[i][0].get<int>(), comm_cards_json[i][1].get<int>()));
         }
     }
 
-    lastHandWinnings.clear();
+    _clearLastHandWinnings();
     if(state.contains("lastHandWinnings")) {
         for(const auto& lw_json : state["lastHandWinnings"]) {
-            PlayerWinningInfo lw_info;
-            lw_info.seatId = lw_json["seatId"];
-            lw_info.amountWon = lw_json["amountWon"];
-            lw_info.potDescription = lw_json["potDescription"];
-            lw_info.handDescription = lw_json["handDescription"];
-            // Hole cards also need recovery from deck or careful reconstruction
-            lastHandWinnings.push_back(lw_info);
+            Card* holeCards[N_HOLE_CARDS];
+            size_t nHoleCards = 0;
+            if (lw_json.contains("holeCards")) {
+                for (const auto& hc_json : lw_json["holeCards"]) {
+                    if (nHoleCards == N_HOLE_CARDS) break;
+                    holeCards[nHoleCards++] = sharedCard(makeCardId(hc_json[0].get<int>(), hc_json[1].get<int>()));
+                }
+            }
+            // Descriptions are interned; text this build does not know loads back empty.
+            _recordWinning(lw_json["seatId"].get<int>(), lw_json["amountWon"].get<int>(),
+                           HandDescription::potIndexOf(lw_json["potDescription"].get<std::string>()),
+                           HandDescription::idOf(lw_json["handDescription"].get<std::string>()),
+                           holeCards, nHoleCards);
         }
     }
-    // RNG state typically not loaded this way, would need specific mt19937 serialization.
+
+    // Dicts written before the history was saved load with an empty one.
+    actions_this_street.assign(N_SEATS, 0);
+    if (state.contains("actions_this_street")) {
+        const std::vector<int> counts = state["actions_this_street"].get<std::vector<int>>();
+        std::copy_n(counts.begin(), std::min<size_t>(counts.size(), N_SEATS), actions_this_street.begin());
+    }
+    actionHistory.clear();
+    if (state.contains("actionHistory")) {
+        for (const auto& a : state["actionHistory"]) {
+            actionHistory.emplace_back(a[0].get<int>(), a[1].get<int>(), a[2].get<int>(), a[3].get<int>(),
+                                       a[4].get<int>(), a[5].get<int>(), a[6].get<int>());
+        }
+    }
+
+    // RNG state is not part of the dict; the loading env keeps its own stream.
     _initPrivObsLookUp(); // When state is loaded, esp. if args_config (and thus suits_matter) might change.
-    _initRangeIdxLut(); // When state is loaded, also initialize the range_idx LUT.
+    _invalidateHandPotentials();
+    _syncPotBookkeeping();
+    _syncSeatState();
+    _restartObservationHistory();
+}
+
+// A loaded state carries the action history but not the observations the
+// saving env recorded along the way, so the history restarts with the
+// current decision point; the previous hand's rows never leak through.
+void PokerEnv::_restartObservationHistory() {
+    observationHistory.clear();
+    _recordObservation(); // also invalidates the legal-action cache
+}
+
+// ================================
+// Binary state snapshot (layout: PokerStateBin.h)
+// ================================
+
+size_t PokerEnv::stateBinSize() const {
+    return PokerStateBin::recordSize(N_SEATS, N_ACTIONS);
+}
+
+size_t PokerEnv::save_state_bin(uint8_t* dst, size_t cap) const {
+    using namespace PokerStateBin;
+    const size_t size = stateBinSize();
+    if (!dst || cap < size) {
+        throw std::invalid_argument("save_state_bin: buffer holds " + std::to_string(cap) +
+                                    " bytes, snapshot needs " + std::to_string(size));
+    }
+    if (N_SEATS > 0xFF || N_ACTIONS > 0xFF || sidePots.size() > static_cast<size_t>(N_SEATS) ||
+        lastHandWinnings.size() > maxWinnings(N_SEATS) || lastAction_member.size() < 3) {
+        throw std::runtime_error("save_state_bin: table state does not fit the fixed layout");
+    }
+    std::memset(dst, 0, size);
+
+    StateBinHeader h{};
+    h.magic = RECORD_MAGIC;
+    h.version = VERSION;
+    h.byteOrder = BYTE_ORDER_MARK;
+    h.recordSize = static_cast<uint32_t>(size);
+    h.nSeats = static_cast<uint8_t>(N_SEATS);
+    h.nActions = static_cast<uint8_t>(N_ACTIONS);
+    h.nSidePots = static_cast<uint8_t>(sidePots.size());
+    h.deckCount = static_cast<uint8_t>(deck.remaining());
+    h.nWinnings = static_cast<uint16_t>(lastHandWinnings.size());
+    h.nMaxRaises = static_cast<uint8_t>(std::min<size_t>(MAX_N_RAISES_PER_ROUND.size(), N_ROUNDS));
+    for (int i = 0; i < N_BOARD_CARDS; ++i) {
+        const Card* c = i < static_cast<int>(communityCards.size()) ? communityCards[i] : nullptr;
+        h.board[i] = cardIdOf(c);
+    }
+    h.flags = (IS_EVALUATING ? FLAG_IS_EVALUATING : 0u) |
+              (handIsOver ? FLAG_HAND_IS_OVER : 0u) |
+              (uniformActionInterpolation_member ? FLAG_UNIFORM_INTERPOLATION : 0u) |
+              (FIRST_ACTION_NO_CALL ? FLAG_FIRST_ACTION_NO_CALL : 0u) |
+              (IS_FIXED_LIMIT_GAME ? FLAG_FIXED_LIMIT : 0u) |
+              (cappedRaise_member.happenedThisRound ? FLAG_CAPPED_RAISE_THIS_ROUND : 0u);
+    h.smallBlind = SMALL_BLIND;
+    h.bigBlind = BIG_BLIND;
+    h.ante = ANTE;
+    h.defaultStackSize = DEFAULT_STACK_SIZE;
+    h.rewardScalar = REWARD_SCALAR;
+    h.buttonPos = buttonPos;
+    h.sbPos = sbPos;
+    h.bbPos = bbPos;
+    h.currentPlayer = currentPlayer;
+    h.currentRound = currentRound;
+    h.mainPot = mainPot;
+    for (int i = 0; i < 3; ++i) h.lastAction[i] = lastAction_member[i];
+    h.lastRaiser = lastRaiser;
+    h.nRaisesThisRound = nRaisesThisRound;
+    h.nActionsThisEpisode = nActionsThisEpisode;
+    h.cappedRaisePlayerThatRaised = cappedRaise_member.playerThatRaised;
+    h.cappedRaisePlayerThatCantReopen = cappedRaise_member.playerThatCantReopen;
+    h.fixUtgPosition = fix_utg_position;
+    for (int i = 0; i < h.nMaxRaises; ++i) h.maxRaisesPerRound[i] = MAX_N_RAISES_PER_ROUND[i];
+    // The most recent MAX_ACTION_RECORDS actions, oldest first.
+    const size_t nRecords = std::min<size_t>(actionHistory.size(), MAX_ACTION_RECORDS);
+    h.nActionRecords = static_cast<uint16_t>(nRecords);
+    std::memcpy(dst, &h, sizeof(h));
+
+    const size_t nBetSizes = std::min<size_t>(betSizesListAsFracOfPot.size(), static_cast<size_t>(N_ACTIONS - 2));
+    std::memcpy(dst + betSizesOffset(), betSizesListAsFracOfPot.data(), nBetSizes * sizeof(float));
+    std::memcpy(dst + sidePotsOffset(N_SEATS, N_ACTIONS), sidePots.data(), sidePots.size() * sizeof(int32_t));
+
+    uint8_t* playerDst = dst + playersOffset(N_SEATS, N_ACTIONS);
+    for (int i = 0; i < N_SEATS; ++i) {
+        const PokerPlayer* p = players[i];
+        StateBinPlayer rec{};
+        rec.seatId = p->seatId;
+        rec.stack = p->stack;
+        rec.startingStack = p->startingStack;
+        rec.currentBet = p->currentBet;
+        rec.totalInvestedThisHand = p->totalInvestedThisHand;
+        rec.investedThisRound = p->investedThisRound;
+        rec.sidePotRank = p->sidePotRank;
+        rec.currentSidePotRank = p->currentSidePotRank;
+        rec.folded = p->folded;
+        rec.isAllin = p->isAllin;
+        rec.hasActed = p->hasActed;
+        rec.nHandCards = static_cast<uint8_t>(std::min<size_t>(p->hand.size(), 2));
+        for (int c = 0; c < rec.nHandCards; ++c) rec.hand[c] = cardIdOf(p->hand[c]);
+        std::memcpy(playerDst + i * sizeof(rec), &rec, sizeof(rec));
+    }
+
+    uint8_t* winDst = dst + winningsOffset(N_SEATS, N_ACTIONS);
+    for (size_t i = 0; i < lastHandWinnings.size(); ++i) {
+        const PlayerWinningInfo& lw = lastHandWinnings[i];
+        StateBinWinning rec{};
+        rec.amountWon = lw.amountWon;
+        rec.seatId = static_cast<int8_t>(lw.seatId);
+        rec.potIndex = lw.potIndex;
+        rec.handDescription = lw.handDescriptionId;
+        rec.nHoleCards = static_cast<uint8_t>(std::min<size_t>(lw.holeCards.size(), 2));
+        for (int c = 0; c < rec.nHoleCards; ++c) rec.holeCards[c] = cardIdOf(lw.holeCards[c]);
+        std::memcpy(winDst + i * sizeof(rec), &rec, sizeof(rec));
+    }
+
+    std::memcpy(dst + deckOffset(N_SEATS, N_ACTIONS), deck.cards, deck.remaining());
+
+    for (int i = 0; i < N_SEATS && i < static_cast<int>(actions_this_street.size()); ++i) {
+        const int32_t n = actions_this_street[i];
+        std::memcpy(dst + actionsThisStreetOffset(N_SEATS, N_ACTIONS) + i * sizeof(int32_t), &n, sizeof(n));
+    }
+    const size_t firstRecord = actionHistory.size() - nRecords;
+    uint8_t* actionDst = dst + actionsOffset(N_SEATS, N_ACTIONS);
+    for (size_t i = 0; i < nRecords; ++i) {
+        const ActionRecord& a = actionHistory[firstRecord + i];
+        StateBinAction rec{};
+        rec.betAmount = a.betAmount;
+        rec.potAtActionTime = a.potAtActionTime;
+        rec.playerStackAtActionTime = a.playerStackAtActionTime;
+        rec.playerId = static_cast<int8_t>(a.playerId);
+        rec.actionType = static_cast<int8_t>(a.actionType);
+        rec.round = static_cast<int8_t>(a.round);
+        rec.actionInt = static_cast<int8_t>(a.actionInt);
+        std::memcpy(actionDst + i * sizeof(rec), &rec, sizeof(rec));
+    }
+    return size;
+}
+
+std::vector<uint8_t> PokerEnv::save_state_bin() const {
+    std::vector<uint8_t> buf(stateBinSize());
+    save_state_bin(buf.data(), buf.size());
+    return buf;
+}
+
+// Checked copy of a snapshot for this table (PokerStateBin::decodeRecord).
+PokerStateBin::Record PokerEnv::decode_state_bin(const uint8_t* src, size_t size) const {
+    return PokerStateBin::decodeRecord(src, size, N_SEATS, N_ACTIONS);
+}
+
+// Everything is decoded and validated before the first field is written, so
+// a bad snapshot throws with the env unchanged.
+void PokerEnv::load_state_bin(const uint8_t* src, size_t size) {
+    load_state_bin(decode_state_bin(src, size));
+}
+
+// Writes a record from decode_state_bin into the env; it does no checking of
+// its own and cannot fail part way.
+void PokerEnv::load_state_bin(const PokerStateBin::Record& r) {
+    using namespace PokerStateBin;
+    const StateBinHeader& h = r.header;
+
+    SMALL_BLIND = h.smallBlind;
+    BIG_BLIND = h.bigBlind;
+    ANTE = h.ante;
+    DEFAULT_STACK_SIZE = h.defaultStackSize;
+    REWARD_SCALAR = h.rewardScalar;
+    IS_EVALUATING = (h.flags & FLAG_IS_EVALUATING) != 0;
+    handIsOver = (h.flags & FLAG_HAND_IS_OVER) != 0;
+    uniformActionInterpolation_member = (h.flags & FLAG_UNIFORM_INTERPOLATION) != 0;
+    FIRST_ACTION_NO_CALL = (h.flags & FLAG_FIRST_ACTION_NO_CALL) != 0;
+    IS_FIXED_LIMIT_GAME = (h.flags & FLAG_FIXED_LIMIT) != 0;
+    buttonPos = h.buttonPos;
+    sbPos = h.sbPos;
+    bbPos = h.bbPos;
+    currentPlayer = h.currentPlayer;
+    currentRound = h.currentRound;
+    mainPot = h.mainPot;
+    lastAction_member.assign(h.lastAction, h.lastAction + 3);
+    lastRaiser = h.lastRaiser;
+    nRaisesThisRound = h.nRaisesThisRound;
+    nActionsThisEpisode = h.nActionsThisEpisode;
+    cappedRaise_member.happenedThisRound = (h.flags & FLAG_CAPPED_RAISE_THIS_ROUND) != 0;
+    cappedRaise_member.playerThatRaised = h.cappedRaisePlayerThatRaised;
+    cappedRaise_member.playerThatCantReopen = h.cappedRaisePlayerThatCantReopen;
+    fix_utg_position = h.fixUtgPosition;
+    MAX_N_RAISES_PER_ROUND.assign(h.maxRaisesPerRound, h.maxRaisesPerRound + h.nMaxRaises);
+
+    betSizesListAsFracOfPot.assign(r.betSizes.begin(), r.betSizes.end());
+    sidePots.assign(r.sidePots.begin(), r.sidePots.end());
+
+    for (int i = 0; i < N_SEATS; ++i) {
+        const StateBinPlayer& rec = r.players[i];
+        PokerPlayer* p = players[i];
+        p->seatId = rec.seatId;
+        p->stack = rec.stack;
+        p->startingStack = rec.startingStack;
+        p->currentBet = rec.currentBet;
+        p->totalInvestedThisHand = rec.totalInvestedThisHand;
+        p->investedThisRound = rec.investedThisRound;
+        p->sidePotRank = rec.sidePotRank;
+        p->currentSidePotRank = rec.currentSidePotRank;
+        p->folded = rec.folded != 0;
+        p->isAllin = rec.isAllin != 0;
+        p->hasActed = rec.hasActed != 0;
+        p->hand.clear();
+        for (int c = 0; c < rec.nHandCards && c < 2; ++c) {
+            if (Card* card = sharedCard(rec.hand[c])) p->hand.push_back(card);
+        }
+    }
+
+    _clearLastHandWinnings();
+    for (const StateBinWinning& rec : r.winnings) {
+        Card* holeCards[N_HOLE_CARDS];
+        size_t nHoleCards = 0;
+        for (int c = 0; c < rec.nHoleCards && c < 2; ++c) {
+            if (Card* card = sharedCard(rec.holeCards[c])) holeCards[nHoleCards++] = card;
+        }
+        _recordWinning(rec.seatId, rec.amountWon, rec.potIndex, rec.handDescription, holeCards, nHoleCards);
+    }
+
+    communityCards.assign(N_COMMUNITY_CARDS, nullptr);
+    for (int i = 0; i < N_BOARD_CARDS && i < static_cast<int>(communityCards.size()); ++i) {
+        communityCards[i] = sharedCard(h.board[i]);
+    }
+
+    deck.clear();
+    for (uint8_t id : r.deck) deck.append(id);
+
+    actions_this_street.assign(r.actionsThisStreet.begin(), r.actionsThisStreet.end());
+    actionHistory.clear();
+    for (const StateBinAction& rec : r.actions) {
+        actionHistory.emplace_back(rec.playerId, rec.actionType, rec.betAmount, rec.round,
+                                   rec.potAtActionTime, rec.playerStackAtActionTime, rec.actionInt);
+    }
+
+    _invalidateHandPotentials();
+    _syncPotBookkeeping();
+    _syncSeatState();
+    _restartObservationHistory();
+}
+
+size_t PokerEnv::save_state_bin_py(uintptr_t address, size_t cap) const {
+    return save_state_bin(reinterpret_cast<uint8_t*>(address), cap);
+}
+
+void PokerEnv::load_state_bin_py(uintptr_t address, size_t size) {
+    load_state_bin(reinterpret_cast<const uint8_t*>(address), size);
 }
 
 int PokerEnv::findNextPlayerToAct(int current_player_idx) {
@@ -3343,7 +3559,15 @@ std::vector<std::vector<float>> PokerEnv::getPublicObservation_py() {
     return getPublicObservation();
 }
 
+// (data address, lengths address, rows, stride) of getPublicObservationView();
+// wrap with np.ctypeslib / ctypes.from_address as a read-only view.
+std::tuple<uintptr_t, uintptr_t, size_t, size_t> PokerEnv::getPublicObservationView_py() const {
+    ObservationRing::View v = getPublicObservationView();
+    return std::make_tuple(reinterpret_cast<uintptr_t>(v.data), reinterpret_cast<uintptr_t>(v.lengths), v.rows, v.stride);
+}
+
 int64_t PokerEnv::getRangeIdx_py(int playerId) { return getRangeIdx(playerId); }
+int64_t PokerEnv::getRawRangeIdx_py(int playerId) const { return getRawRangeIdx(playerId); }
 std::vector<float> PokerEnv::getLegalActionMask_py() { return getLegalActionMask(); }
 
 std::tuple<std::vector<std::vector<float>>, std::vector<float>, std::vector<float>, bool> PokerEnv::step_py(int actionInt) {
@@ -3411,10 +3635,9 @@ std::vector<std::tuple<int, int, int, int, std::vector<std::tuple<int, int>>>> P
         for(const Card* card_ptr : win_info.holeCards) {
             if (card_ptr) hole_cards_tuples.push_back(_cardToTuple(card_ptr));
         }
-        // Placeholder pot/hand desc idx. In a real system, map strings to fixed ints.
-        int pot_desc_idx = (win_info.potDescription == "Main Pot" ? 0 : (win_info.potDescription.find("Side Pot") != std::string::npos ? 1 : 2));
-        int hand_desc_idx = 0; // Needs mapping based on win_info.handDescription string
-        winnings_tuples.emplace_back(win_info.seatId, win_info.amountWon, pot_desc_idx, hand_desc_idx, hole_cards_tuples);
+        // Pot index (0 = main pot, k = side pot k) and HandDescription::Id; 255 = unknown.
+        winnings_tuples.emplace_back(win_info.seatId, win_info.amountWon, static_cast<int>(win_info.potIndex),
+                                     static_cast<int>(win_info.handDescriptionId), hole_cards_tuples);
     }
     return winnings_tuples;
 }
@@ -3435,23 +3658,18 @@ std::vector<float> PokerEnv::get_extra_features_py() const {
 }
 
 
-std::vector<float> PokerEnv::_processCheckCall(int totalToCall) {
-    // This needs to be ported from PokerEnv.cpp
-    // It calculates the actual amount to call and returns {CHECK_CALL, actual_total_bet_after_call}
-    // Placeholder:
+// Calculates the actual amount to call: {CHECK_CALL, total bet after the call}.
+ResolvedAction PokerEnv::_resolveCheckCall(int totalToCall) {
     PokerPlayer* player = players[currentPlayer];
     int amount_needed = totalToCall - player->currentBet;
     int actual_call_amount = std::min(amount_needed, player->stack);
-    float final_bet_amount = static_cast<float>(player->currentBet + actual_call_amount);
-    return {static_cast<float>(CHECK_CALL), final_bet_amount};
+    return makeResolvedAction(CHECK_CALL, player->currentBet + actual_call_amount);
 }
 
-std::vector<float> PokerEnv::_processRaise(float raiseTotalAmountInChips_float) {
-    // This needs to be ported from PokerEnv.cpp
-    // It adjusts the raise amount (min/max, all-in) and returns {BET_RAISE, actual_total_bet_after_raise}
-    // Placeholder:
+// Adjusts the raise amount (min raise, all-in): {BET_RAISE, total bet after the raise}.
+ResolvedAction PokerEnv::_resolveRaise(int raiseTotalAmountInChips) {
     PokerPlayer* player = players[currentPlayer];
-    int intended_total_bet = static_cast<int>(raiseTotalAmountInChips_float);
+    int intended_total_bet = raiseTotalAmountInChips;
 
     // Clamp to min raise
     int min_raise_total = _getCurrentTotalMinRaise();
@@ -3460,22 +3678,272 @@ std::vector<float> PokerEnv::_processRaise(float raiseTotalAmountInChips_float)
     // Clamp to all-in
     intended_total_bet = std::min(intended_total_bet, player->currentBet + player->stack);
 
-    return {static_cast<float>(BET_RAISE), static_cast<float>(intended_total_bet)};
+    return makeResolvedAction(BET_RAISE, intended_total_bet);
+}
+
+// {type, amount} float-vector forms of the resolution helpers, kept for callers
+// that still pass actions that way.
+static std::vector<float> toActionVector(ResolvedAction a) {
+    return {static_cast<float>(a.type), static_cast<float>(a.amount)};
 }
 
-std::string PokerEnv::getHandDescriptionFromRank(int phevaluatorRank) const {
+std::vector<float> PokerEnv::_processCheckCall(int totalToCall) {
+    return toActionVector(_resolveCheckCall(totalToCall));
+}
+
+std::vector<float> PokerEnv::_processRaise(float raiseTotalAmountInChips_float) {
+    return toActionVector(_resolveRaise(static_cast<int>(raiseTotalAmountInChips_float)));
+}
+
+std::vector<float> PokerEnv::_getEnvAdjustedActionFormulation(int actionInt) {
+    return toActionVector(_formulateAction(actionInt));
+}
+
+// Vector form of _resolveAction ([actionType, amount]); timed like the
+// resolution in step(int).
+std::vector<float> PokerEnv::_getFixedAction(const std::vector<float>& action) {
+    POKER_PERF_SCOPE(PokerPerf::Timer::ResolveAction);
+    if (action.empty()) {
+        throw std::runtime_error("Empty action vector in _getFixedAction");
+    }
+    const int amount = action.size() > 1 ? static_cast<int>(action[1]) : 0;
+    return toActionVector(_resolveAction(makeResolvedAction(static_cast<int>(action[0]), amount)));
+}
+
+// ================================
+// Batched hand evaluation
+// ================================
+// cards is [nHands][7] card ids (two hole cards and five board cards, any
+// order, all distinct); ranks[i] gets the phevaluator rank of hand i.
+void PokerEnv::evaluate_hands_batch(const CardId* cards, size_t nHands, int32_t* ranks) {
+    HandEvalBatch::evaluate7(cards, nHands, ranks);
+}
+
+std::vector<int> PokerEnv::evaluate_hands_batch_py(const std::vector<int>& cardIds) {
+    const size_t perHand = HandEvalBatch::CARDS_PER_HAND;
+    if (cardIds.size() % perHand != 0) {
+        throw std::invalid_argument("evaluate_hands_batch: " + std::to_string(cardIds.size()) +
+                                    " card ids is not a whole number of 7-card hands");
+    }
+    const size_t nHands = cardIds.size() / perHand;
+    std::vector<CardId> cards(cardIds.size());
+    for (size_t h = 0; h < nHands; ++h) {
+        uint64_t seen = 0;
+        for (size_t j = 0; j < perHand; ++j) {
+            const int id = cardIds[h * perHand + j];
+            if (!isValidCardId(id) || (seen & cardIdBit(static_cast<CardId>(id)))) {
+                throw std::invalid_argument("evaluate_hands_batch: hand " + std::to_string(h) +
+                                            " has an invalid or repeated card id " + std::to_string(id));
+            }
+            seen |= cardIdBit(static_cast<CardId>(id));
+            cards[h * perHand + j] = static_cast<CardId>(id);
+        }
+    }
+    std::vector<int32_t> ranks(nHands);
+    evaluate_hands_batch(cards.data(), nHands, ranks.data());
+    return std::vector<int>(ranks.begin(), ranks.end());
+}
+
+static void riverBoardFromIds(const std::vector<int>& boardCards, const char* caller,
+                              CardId board[RangeEvaluator::BOARD_CARDS]) {
+    if (boardCards.size() != RangeEvaluator::BOARD_CARDS) {
+        throw std::invalid_argument(std::string(caller) + ": need a 5-card board, got " +
+                                    std::to_string(boardCards.size()) + " cards");
+    }
+    for (size_t i = 0; i < boardCards.size(); ++i) {
+        if (!isValidCardId(boardCards[i])) {
+            throw std::invalid_argument(std::string(caller) + ": invalid card id " + std::to_string(boardCards[i]));
+        }
+        board[i] = static_cast<CardId>(boardCards[i]);
+    }
+}
+
+// Rank of every range index on a river board (card ids); 0 for hands the
+// board blocks. Same values as getHandRank(rangeIdx, board), in one call.
+std::vector<int16_t> PokerEnv::rank_all_hands_py(const std::vector<int>& boardCards) {
+    CardId board[RangeEvaluator::BOARD_CARDS];
+    riverBoardFromIds(boardCards, "rank_all_hands", board);
+    std::vector<int16_t> ranks(RangeLut::N_RANGE_IDX);
+    RangeEvaluator::rankAllHands(board, ranks.data());
+    return ranks;
+}
+
+// Per-hand showdown values of rangeA against rangeB and back, plus A's
+// expected result per compatible deal (RangeEvaluator.h).
+std::tuple<std::vector<double>, std::vector<double>, double> PokerEnv::range_vs_range_ev_py(
+    const std::vector<int>& boardCards, const std::vector<float>& rangeA, const std::vector<float>& rangeB) {
+    CardId board[RangeEvaluator::BOARD_CARDS];
+    riverBoardFromIds(boardCards, "range_vs_range_ev", board);
+    RangeEvaluator::RangeVsRange result = RangeEvaluator::rangeVsRange(board, rangeA, rangeB);
+    return std::make_tuple(std::move(result.valueA), std::move(result.valueB), result.evA);
+}
+
+// Card ids of every card in a hand-history line ("[As Kd] Qh10c|J♠"), in
+// order, in one pass (CardParse::parseLine).
+std::vector<int> PokerEnv::parse_cards_py(const std::string& line) {
+    std::vector<CardId> ids(line.size() / 2 + 1); // every card is at least 2 bytes
+    int nCards = 0;
+    size_t errorPos = 0;
+    const CardParse::Status status =
+        CardParse::parseLine(line, ids.data(), static_cast<int>(ids.size()), nCards, errorPos);
+    if (status != CardParse::Status::Ok) {
+        throw std::invalid_argument(std::string("parse_cards: ") + CardParse::statusMessage(status) + " at byte " +
+                                    std::to_string(errorPos) + " of '" + line + "'");
+    }
+    return std::vector<int>(ids.begin(), ids.begin() + nCards);
+}
+
+// Process-wide log level: "trace", "debug", "info", "warn", "error" or "off".
+// Lines below the compile-time threshold stay compiled out whatever the level.
+void PokerEnv::set_log_level_py(const std::string& level) {
+    if (!PokerLog::setLevel(level)) {
+        throw std::invalid_argument("set_log_level: unknown level '" + level +
+                                    "' (expected trace, debug, info, warn, error or off)");
+    }
+}
+
+// Writes out the calling thread's buffered log lines (PokerLog::setThreadBuffered).
+void PokerEnv::flush_log_py() {
+    PokerLog::flushThread();
+}
+
+// Counters of the process-wide equity cache (EquityCache.h).
+std::map<std::string, double> PokerEnv::getEquityCacheStats_py() {
+    const EquityCache::Stats stats = EquityCache::shared().stats();
+    return {
+        {"hits", static_cast<double>(stats.hits)},
+        {"misses", static_cast<double>(stats.misses)},
+        {"inserts", static_cast<double>(stats.inserts)},
+        {"evictions", static_cast<double>(stats.evictions)},
+        {"capacity", static_cast<double>(stats.capacity)},
+        {"hit_rate", stats.hitRate()},
+    };
+}
+
+void PokerEnv::clearEquityCache_py() {
+    EquityCache::shared().clear();
+    EquityCache::shared().resetStats();
+}
+
+// Hot-path counters and timers (PerfCounters.h), summed over all threads.
+// All zero unless built with -DPOKER_ENV_PERF and switched on with
+// set_perf_enabled_py(true); "compiled" and "enabled" tell which.
+std::map<std::string, double> PokerEnv::get_perf_stats_py() {
+    return PokerPerf::toMap(PokerPerf::snapshot());
+}
+
+void PokerEnv::reset_perf_stats_py() {
+    PokerPerf::reset();
+}
+
+void PokerEnv::set_perf_enabled_py(bool enabled) {
+    PokerPerf::setEnabled(enabled);
+}
+
+static std::map<std::string, double> equityResultToMap(const EquityEngine::Result& result) {
+    return {
+        {"equity", result.equity},
+        {"std_error", result.stdError},
+        {"samples", static_cast<double>(result.samples)},
+        {"exhaustive", result.exhaustive ? 1.0 : 0.0},
+    };
+}
+
+// Equity of hole against weighted opponent ranges (EquityEngine.h). Cards are
+// ids; each range holds RangeLut::N_RANGE_IDX weights, an empty one means
+// every hand equally likely.
+std::map<std::string, double> PokerEnv::compute_equity_py(const std::vector<int>& holeCards,
+                                                          const std::vector<int>& boardCards,
+                                                          const std::vector<std::vector<float>>& opponentRanges,
+                                                          uint64_t maxSamples, double maxSeconds,
+                                                          uint64_t seed, int nThreads) {
+    if (holeCards.size() != N_HOLE_CARDS) {
+        throw std::invalid_argument("compute_equity: need 2 hole cards, got " + std::to_string(holeCards.size()));
+    }
+    if (boardCards.size() > N_COMMUNITY_CARDS) {
+        throw std::invalid_argument("compute_equity: board has " + std::to_string(boardCards.size()) +
+                                    " cards, at most 5 allowed");
+    }
+    auto toCardId = [](int id) {
+        if (!isValidCardId(id)) throw std::invalid_argument("compute_equity: invalid card id " + std::to_string(id));
+        return static_cast<CardId>(id);
+    };
+    const CardId hole[N_HOLE_CARDS] = {toCardId(holeCards[0]), toCardId(holeCards[1])};
+    CardId board[N_COMMUNITY_CARDS];
+    for (size_t i = 0; i < boardCards.size(); ++i) board[i] = toCardId(boardCards[i]);
+
+    std::vector<EquityEngine::RangeWeights> ranges;
+    ranges.reserve(opponentRanges.size());
+    for (const std::vector<float>& range : opponentRanges) {
+        ranges.push_back(range.empty() ? EquityEngine::uniformRange() : range);
+    }
+
+    EquityEngine::Options options;
+    options.maxSamples = maxSamples;
+    options.maxSeconds = maxSeconds;
+    options.seed = seed;
+    options.nThreads = nThreads;
+    return equityResultToMap(EquityEngine::compute(hole, board, static_cast<int>(boardCards.size()), ranges, options));
+}
+
+std::map<std::string, double> PokerEnv::getPlayerEquity_py(int playerId, uint64_t maxSamples, uint64_t seed) const {
+    EquityEngine::Options options;
+    options.maxSamples = maxSamples;
+    options.seed = seed;
+    return equityResultToMap(computePlayerEquity(playerId, options));
+}
+
+// Writes the flop (and optionally turn) equity table read through
+// game_settings.equity_table_path, evaluating each class with the same
+// functions the env would otherwise call live.
+size_t PokerEnv::generate_equity_table(const std::string& path, bool includeTurn, int nThreads) {
+    return EquityTable::generate(path, includeTurn, nThreads, [](const CardId* hole, const CardId* board, int nBoard) {
+        int card_ints[N_HOLE_CARDS + EquityTable::TURN_CARDS];
+        int card_ids[N_HOLE_CARDS + EquityTable::TURN_CARDS];
+        int n_cards = 0;
+        for (int i = 0; i < N_HOLE_CARDS; ++i, ++n_cards) {
+            card_ints[n_cards] = card2intById(hole[i]);
+            card_ids[n_cards] = hole[i];
+        }
+        for (int i = 0; i < nBoard; ++i, ++n_cards) {
+            card_ints[n_cards] = card2intById(board[i]);
+            card_ids[n_cards] = board[i];
+        }
+
+        EquityTable::Entry entry{EquityTable::INVALID_EQUITY, EquityTable::INVALID_EQUITY,
+                                 EquityTable::INVALID_POTENTIAL};
+        try {
+            const holdem_evaluation_t evaluation = evaluate_holdem_multidimensional(card_ints, n_cards);
+            if (evaluation.equity_vs_all >= 0 && evaluation.equity_vs_all <= 10000 &&
+                evaluation.equity_vs_pair_sets >= 0 && evaluation.equity_vs_pair_sets <= 10000) {
+                entry.equityVsAll = static_cast<uint16_t>(evaluation.equity_vs_all);
+                entry.equityVsPairSets = static_cast<uint16_t>(evaluation.equity_vs_pair_sets);
+            }
+        } catch (const std::exception&) {
+            // recorded as INVALID_EQUITY; the env falls back to its baseline
+        }
+        // Separately, so a failed equity evaluation does not also lose the
+        // potential (and the other way round).
+        try {
+            entry.potential = evaluate_holdem_with_potential(card_ids, n_cards);
+        } catch (const std::exception&) {
+            // recorded as INVALID_POTENTIAL; lookups evaluate the hand live
+        }
+        return entry;
+    });
+}
+
+size_t PokerEnv::generate_equity_table_py(const std::string& path, bool includeTurn, int nThreads) {
+    if (path.empty()) throw std::invalid_argument("generate_equity_table: empty path");
+    if (nThreads < 1) {
+        throw std::invalid_argument("generate_equity_table: nThreads must be >= 1, got " + std::to_string(nThreads));
+    }
+    return generate_equity_table(path, includeTurn, nThreads);
+}
+
+std::string_view PokerEnv::getHandDescriptionFromRank(int phevaluatorRank) const {
     // phevaluatorRank is 1 (best) to 7462 (worst)
-    if (phevaluatorRank <= 0 || phevaluatorRank > 7462) return "Invalid Rank";
-    if (phevaluatorRank <= 10) return "Straight Flush";
-    if (phevaluatorRank <= 166) return "Four of a Kind";
-    if (phevaluatorRank <= 322) return "Full House";
-    if (phevaluatorRank <= 1599) return "Flush";
-    if (phevaluatorRank <= 1609) return "Straight";
-    // Cater's ranges: 3K (1610-2467), 2P (2468-3325), 1P (3326-6185), HC (6186-7462)
-    if (phevaluatorRank <= 2467) return "Three of a Kind";
-    if (phevaluatorRank <= 3325) return "Two Pair";
-    if (phevaluatorRank <= 6185) return "One Pair";
-    return "High Card";
+    return HandDescription::name(HandDescription::fromRank(phevaluatorRank));
 }
 
 // Static helper for Python bindings (if needed, or direct conversion in bindings)
@@ -3492,31 +3960,27 @@ int PokerEnv::_cardToInt(const Card* card) {
     return -1; // Invalid card representation
 }
 
-// --- Start of _getEnvAdjustedActionFormulation (replacement) ---
-std::vector<float> PokerEnv::_getEnvAdjustedActionFormulation(int actionInt) {
+// --- Start of _formulateAction ---
+ResolvedAction PokerEnv::_formulateAction(int actionInt) {
     // 将离散动作转换为实际动作
     if (actionInt == FOLD) {
-        return {static_cast<float>(FOLD), -1.0f}; // 弃牌
+        return makeResolvedAction(FOLD, -1); // 弃牌
     }
 
     if (actionInt == CHECK_CALL) {
-        return {static_cast<float>(CHECK_CALL), -1.0f}; // 跟注/让牌
+        return makeResolvedAction(CHECK_CALL, -1); // 跟注/让牌
     }
 
     if (actionInt >= 2 && actionInt < N_ACTIONS) {
         // 检查 currentPlayer 是否有效
         if (currentPlayer < 0 || currentPlayer >= N_SEATS || !players[currentPlayer]) {
-#ifdef DEBUG_POKER_ENV
-            std::cerr << "Error: Invalid current player in _getEnvAdjustedActionFormulation." << std::endl;
-#endif
-            return {static_cast<float>(CHECK_CALL), -1.0f};
+            POKER_LOG_DEBUG("Error: Invalid current player in _formulateAction.");
+            return makeResolvedAction(CHECK_CALL, -1);
         }
 
         if (actionInt - 2 < 0 || static_cast<size_t>(actionInt - 2) >= betSizesListAsFracOfPot.size()) {
-#ifdef DEBUG_POKER_ENV
-            std::cerr << "Error: actionInt out of bounds for betSizesListAsFracOfPot." << std::endl;
-#endif
-            return {static_cast<float>(CHECK_CALL), -1.0f};
+            POKER_LOG_DEBUG("Error: actionInt out of bounds for betSizesListAsFracOfPot.");
+            return makeResolvedAction(CHECK_CALL, -1);
         }
         float fraction = betSizesListAsFracOfPot[actionInt - 2];
         int raiseAmount = getFractionOfPotRaise(fraction, players[currentPlayer]);
@@ -3527,9 +3991,7 @@ std::vector<float> PokerEnv::_getEnvAdjustedActionFormulation(int actionInt) {
                 maxAmount = players[currentPlayer]->stack + players[currentPlayer]->currentBet;
             } else {
                  if (actionInt - 1 < 0 || static_cast<size_t>(actionInt - 1) >= betSizesListAsFracOfPot.size()) {
-#ifdef DEBUG_POKER_ENV
-                     std::cerr << "Error: actionInt-1 out of bounds for betSizesListAsFracOfPot (maxAmount calc)." << std::endl;
-#endif
+                     POKER_LOG_DEBUG("Error: actionInt-1 out of bounds for betSizesListAsFracOfPot (maxAmount calc).");
                      maxAmount = raiseAmount;
                 } else {
                     float biggerFraction = betSizesListAsFracOfPot[actionInt - 1];
@@ -3543,9 +4005,7 @@ std::vector<float> PokerEnv::_getEnvAdjustedActionFormulation(int actionInt) {
                 minAmount = _getCurrentTotalMinRaise();
             } else {
                 if (actionInt - 3 < 0 || static_cast<size_t>(actionInt - 3) >= betSizesListAsFracOfPot.size()) {
-#ifdef DEBUG_POKER_ENV
-                    std::cerr << "Error: actionInt-3 out of bounds for betSizesListAsFracOfPot (minAmount calc)." << std::endl;
-#endif
+                    POKER_LOG_DEBUG("Error: actionInt-3 out of bounds for betSizesListAsFracOfPot (minAmount calc).");
                     minAmount = raiseAmount;
                 } else {
                     float smallerFraction = betSizesListAsFracOfPot[actionInt - 3];
@@ -3555,36 +4015,30 @@ std::vector<float> PokerEnv::_getEnvAdjustedActionFormulation(int actionInt) {
             }
 
             if (minAmount >= maxAmount) {
-                return {static_cast<float>(BET_RAISE), static_cast<float>(minAmount)};
+                return makeResolvedAction(BET_RAISE, minAmount);
             }
 
-            std::uniform_int_distribution<> dis(minAmount, maxAmount -1);
-            int randomAmount = dis(m_rng);
+            int randomAmount = m_rng.uniformInt(minAmount, maxAmount - 1);
 
-            return {static_cast<float>(BET_RAISE), static_cast<float>(randomAmount)};
+            return makeResolvedAction(BET_RAISE, randomAmount);
         } else {
-            return {static_cast<float>(BET_RAISE), static_cast<float>(raiseAmount)};
+            return makeResolvedAction(BET_RAISE, raiseAmount);
         }
     }
 
-#ifdef DEBUG_POKER_ENV
-    std::cerr << "Invalid actionInt: " << actionInt << " in _getEnvAdjustedActionFormulation" << std::endl;
-#endif
-    return {static_cast<float>(CHECK_CALL), -1.0f};
+    POKER_LOG_DEBUG("Invalid actionInt: " << actionInt << " in _formulateAction");
+    return makeResolvedAction(CHECK_CALL, -1);
 }
-// --- End of _getEnvAdjustedActionFormulation ---
+// --- End of _formulateAction ---
 
 
-// --- Start of _getFixedAction (new method) ---
-std::vector<float> PokerEnv::_getFixedAction(const std::vector<float>& action) {
-    if (action.empty()) {
-        throw std::runtime_error("Empty action vector in _getFixedAction");
-    }
-    int actionIdx = static_cast<int>(action[0]);
-    float intendedRaiseTotalAmount = action.size() > 1 ? action[1] : 0.0f;
+// --- Start of _resolveAction ---
+ResolvedAction PokerEnv::_resolveAction(ResolvedAction action) {
+    const int actionIdx = action.type;
+    const int intendedRaiseTotalAmount = action.amount;
 
     if (currentPlayer < 0 || currentPlayer >= N_SEATS || !players[currentPlayer]) {
-        throw std::runtime_error("Current player not set or invalid in _getFixedAction");
+        throw std::runtime_error("Current player not set or invalid in _resolveAction");
     }
     PokerPlayer* player = players[currentPlayer];
 
@@ -3592,31 +4046,29 @@ std::vector<float> PokerEnv::_getFixedAction(const std::vector<float>& action) {
 
     if (actionIdx == FOLD) {
         if (totalToCall <= player->currentBet) {
-            return _processCheckCall(totalToCall);
+            return _resolveCheckCall(totalToCall);
         }
-        return {static_cast<float>(FOLD), -1.0f};
+        return makeResolvedAction(FOLD, -1);
     } else if (actionIdx == CHECK_CALL) {
         if (FIRST_ACTION_NO_CALL && (nActionsThisEpisode == 0) && (currentRound == PREFLOP)) {
-            return {static_cast<float>(FOLD), -1.0f};
+            return makeResolvedAction(FOLD, -1);
         }
-        return _processCheckCall(totalToCall);
+        return _resolveCheckCall(totalToCall);
     } else if (actionIdx == BET_RAISE) {
         if (IS_FIXED_LIMIT_GAME && currentRound != PREFLOP) {  // 翻前不受限制
             if (currentRound >= 0 && static_cast<size_t>(currentRound) < MAX_N_RAISES_PER_ROUND.size()) {
                 if (nRaisesThisRound >= MAX_N_RAISES_PER_ROUND[currentRound]) {
-                    return _processCheckCall(totalToCall);
+                    return _resolveCheckCall(totalToCall);
                 }
             } else {
-#ifdef DEBUG_POKER_ENV
-                 std::cerr << "Warning: currentRound out of bounds for MAX_N_RAISES_PER_ROUND. Defaulting to Call." << std::endl;
-#endif
-                 return _processCheckCall(totalToCall);
+                 POKER_LOG_DEBUG("Warning: currentRound out of bounds for MAX_N_RAISES_PER_ROUND. Defaulting to Call.");
+                 return _resolveCheckCall(totalToCall);
             }
         }
 
         if ((player->stack + player->currentBet <= totalToCall) ||
             (cappedRaise_member.happenedThisRound && cappedRaise_member.playerThatCantReopen == currentPlayer)) {
-            return _processCheckCall(totalToCall);
+            return _resolveCheckCall(totalToCall);
         }
 
             // If the last raiser is all-in, and no other players (who are not the current player and not the last raiser)
@@ -3634,48 +4086,40 @@ std::vector<float> PokerEnv::_getFixedAction(const std::vector<float>& action) {
                 if (!other_active_players_exist) {
                     // Only the current player and the all-in lastRaiser are effectively in contention for further betting.
                     // Current player cannot re-raise.
-                    return _processCheckCall(totalToCall);
+                    return _resolveCheckCall(totalToCall);
                 }
             }
 
-        return _processRaise(intendedRaiseTotalAmount);
+        return _resolveRaise(intendedRaiseTotalAmount);
     } else {
-#ifdef DEBUG_POKER_ENV
-        std::cerr << "Invalid action index (" << actionIdx << "), must be FOLD (0), CHECK/CALL (1), or BET/RAISE (2)" << std::endl;
-#endif
-        throw std::runtime_error("Invalid action index in _getFixedAction");
+        POKER_LOG_DEBUG("Invalid action index (" << actionIdx << "), must be FOLD (0), CHECK/CALL (1), or BET/RAISE (2)");
+        throw std::runtime_error("Invalid action index in _resolveAction");
     }
 }
-// --- End of _getFixedAction ---
+// --- End of _resolveAction ---
 
 void PokerEnv::_calculateRewardScalar() {
     bool scaleRewards = false;
 
-#ifdef DEBUG_POKER_ENV
-    std::cout << "[DEBUG] _calculateRewardScalar: 开始执行" << std::endl;
-    std::cout << "[DEBUG] args_config内容: " << args_config.dump() << std::endl;
-#endif
+    POKER_LOG_DEBUG("[DEBUG] _calculateRewardScalar: 开始执行");
+    POKER_LOG_DEBUG("[DEBUG] args_config内容: " << args_config.dump());
 
     // Check if scale_rewards is enabled in config
     if (args_config.contains("reward_settings") && args_config["reward_settings"].is_object() &&
         args_config["reward_settings"].contains("scale_rewards") && args_config["reward_settings"]["scale_rewards"].is_boolean()) {
         scaleRewards = args_config["reward_settings"]["scale_rewards"].get<bool>();
-#ifdef DEBUG_POKER_ENV
-        std::cout << "[DEBUG] 从配置中读取到 scale_rewards: " << scaleRewards << std::endl;
-#endif
+        POKER_LOG_DEBUG("[DEBUG] 从配置中读取到 scale_rewards: " << scaleRewards);
     } else {
-#ifdef DEBUG_POKER_ENV
-        std::cout << "[DEBUG] 配置中没有找到valid的scale_rewards设置，使用默认值false" << std::endl;
+        POKER_LOG_DEBUG("[DEBUG] 配置中没有找到valid的scale_rewards设置，使用默认值false");
         if (!args_config.contains("reward_settings")) {
-            std::cout << "[DEBUG] - 没有reward_settings部分" << std::endl;
+            POKER_LOG_DEBUG("[DEBUG] - 没有reward_settings部分");
         } else if (!args_config["reward_settings"].is_object()) {
-            std::cout << "[DEBUG] - reward_settings不是对象" << std::endl;
+            POKER_LOG_DEBUG("[DEBUG] - reward_settings不是对象");
         } else if (!args_config["reward_settings"].contains("scale_rewards")) {
-            std::cout << "[DEBUG] - reward_settings中没有scale_rewards" << std::endl;
+            POKER_LOG_DEBUG("[DEBUG] - reward_settings中没有scale_rewards");
         } else if (!args_config["reward_settings"]["scale_rewards"].is_boolean()) {
-            std::cout << "[DEBUG] - scale_rewards不是布尔值" << std::endl;
+            POKER_LOG_DEBUG("[DEBUG] - scale_rewards不是布尔值");
         }
-#endif
     }
 
     if (scaleRewards) {
@@ -3695,147 +4139,62 @@ void PokerEnv::_calculateRewardScalar() {
         REWARD_SCALAR = averageStack;
         if (REWARD_SCALAR == 0.0f) REWARD_SCALAR = 1.0f; // Avoid division by zero
 
-#ifdef DEBUG_POKER_ENV
-        std::cout << "[DEBUG] scale_rewards=true, 计算averageStack=" << averageStack
-                  << ", REWARD_SCALAR=" << REWARD_SCALAR << std::endl;
-#endif
+        POKER_LOG_DEBUG("[DEBUG] scale_rewards=true, 计算averageStack=" << averageStack
+                        << ", REWARD_SCALAR=" << REWARD_SCALAR);
     } else {
         REWARD_SCALAR = 1.0f;
-#ifdef DEBUG_POKER_ENV
-        std::cout << "[DEBUG] scale_rewards=false, 设置REWARD_SCALAR=1.0" << std::endl;
-#endif
+        POKER_LOG_DEBUG("[DEBUG] scale_rewards=false, 设置REWARD_SCALAR=1.0");
     }
 
-#ifdef DEBUG_POKER_ENV
-    std::cout << "[DEBUG] _calculateRewardScalar: 完成，最终REWARD_SCALAR=" << REWARD_SCALAR << std::endl;
-#endif
+    POKER_LOG_DEBUG("[DEBUG] _calculateRewardScalar: 完成，最终REWARD_SCALAR=" << REWARD_SCALAR);
 }
 
 // Method to expose the internal LUT to Python for testing
 std::map<int64_t, std::vector<float>> PokerEnv::getInternalPrivObsLut_py() const {
-    return m_privObsLut;
+    std::map<int64_t, std::vector<float>> lut;
+    for (int idx = 0; idx < RangeLut::N_RANGE_IDX; ++idx) {
+        RangeLut::FloatSpan obs = RangeLut::privObs(idx, m_privObsSuitsMatter);
+        lut.emplace(idx, std::vector<float>(obs.begin(), obs.end()));
+    }
+    return lut;
 }
 
 // Private helper to parse board card string
+// 0, 3, 4 or 5 cards, space separated or concatenated (CardParse::parseBoard);
+// anything else leaves out_board_storage empty.
 void PokerEnv::_parseBoardString(const std::string& boardCardsStr, std::vector<Card>& out_board_storage) const {
     out_board_storage.clear(); // Ensure it starts empty
 
-    if (boardCardsStr.empty()) {
-        return; // 0 community cards
-    }
-
-    std::vector<std::string> potential_card_strs;
-    std::string current_segment;
-    std::istringstream iss(boardCardsStr);
-
-    bool has_spaces = (boardCardsStr.find(' ') != std::string::npos);
-
-    if (has_spaces) {
-        while (iss >> current_segment) {
-            potential_card_strs.push_back(current_segment);
-        }
-
-        if (potential_card_strs.empty() && !boardCardsStr.empty()){ // e.g. boardCardsStr was just spaces
-             // Proceed to no-space parsing
-        } else if (potential_card_strs.size() == 0 || potential_card_strs.size() == 3 || potential_card_strs.size() == 4 || potential_card_strs.size() == 5) {
-            bool all_parsed_successfully = true;
-            std::vector<Card> temp_parsed_cards_for_space_branch; // Use a distinct name for this temporary vector
-            for (const std::string& s : potential_card_strs) {
-                try {
-                    auto parsed_card = parseCardStringInternal(s);
-                    temp_parsed_cards_for_space_branch.emplace_back(parsed_card.second, parsed_card.first);
-                } catch (const std::invalid_argument& e) {
-                    all_parsed_successfully = false;
-                    #ifdef DEBUG_POKER_ENV
-                    std::cerr << "[DEBUG _parseBoardString] Error parsing space-separated card string '" << s << "': " << e.what() << std::endl;
-                    #endif
-                    break;
-                }
-            }
-            if (all_parsed_successfully) {
-                out_board_storage = temp_parsed_cards_for_space_branch; // Assign if all were successful
-                return; // Successfully parsed space-separated cards
-            }
-        }
-        // If parsing space-separated failed or wrong number of cards, ensure out_board_storage is clear before trying concatenated parsing
-        out_board_storage.clear();
-    }
-
-    // Attempt concatenated parsing if no spaces or space parsing failed
-    std::string s_to_parse = boardCardsStr;
-    // Remove all spaces for concatenated parsing attempt (only if has_spaces was true and previous attempt failed, or if no spaces initially)
-    if (has_spaces) { // if space parsing failed, s_to_parse still contains original boardCardsStr
-        s_to_parse.erase(std::remove_if(s_to_parse.begin(), s_to_parse.end(), ::isspace), s_to_parse.end());
-    } else { // if no spaces to begin with, s_to_parse is already correct (boardCardsStr)
-        // No action needed on s_to_parse if there were no spaces originally
-    }
-
-    if (s_to_parse.empty()) { // If original was just spaces and became empty, or was empty initially
-        out_board_storage.clear(); // Ensure it's empty
-        return; // Treat as 0 cards
-    }
-
-    out_board_storage.clear(); // Clear for this concatenated parsing attempt
-    size_t current_pos = 0;
-    while(current_pos < s_to_parse.length() && out_board_storage.size() < 5) { // check out_board_storage.size()
-        std::string best_card_str_found;
-        std::pair<Card::CardValue, Card::Suit> parsed_card_data;
-        bool current_card_successfully_parsed = false;
-
-        for (size_t len_try = std::min((size_t)5, s_to_parse.length() - current_pos); len_try >= 2; --len_try) {
-            std::string potential_card = s_to_parse.substr(current_pos, len_try);
-            try {
-                parsed_card_data = parseCardStringInternal(potential_card);
-                best_card_str_found = potential_card;
-                current_card_successfully_parsed = true;
-                break;
-            } catch (const std::invalid_argument& e) {
-                // Not a valid card of this length, try shorter.
-            }
-        }
-
-        if (current_card_successfully_parsed) {
-            out_board_storage.emplace_back(parsed_card_data.second, parsed_card_data.first);
-            current_pos += best_card_str_found.length();
-        } else {
-            #ifdef DEBUG_POKER_ENV
-            std::cerr << "[ERROR _parseBoardString] Failed to parse card from remaining non-space string: '" << s_to_parse.substr(current_pos) << "' in full string '" << boardCardsStr << "'" << std::endl;
-            #endif
-            out_board_storage.clear(); // Parsing failed, invalid board
-            return;
-        }
+    CardId board[CardParse::MAX_BOARD_CARDS];
+    int nBoard = 0;
+    const CardParse::Status status = CardParse::parseBoard(boardCardsStr, board, nBoard);
+    if (status != CardParse::Status::Ok) {
+        POKER_LOG_DEBUG("[ERROR _parseBoardString] " << CardParse::statusMessage(status) << ": '" << boardCardsStr << "'");
+        return;
     }
-
-    size_t num_parsed_cards = out_board_storage.size();
-    if (num_parsed_cards != 0 && num_parsed_cards != 3 && num_parsed_cards != 4 && num_parsed_cards != 5) {
-        #ifdef DEBUG_POKER_ENV
-        std::cerr << "[ERROR _parseBoardString] Invalid number of board cards parsed (" << num_parsed_cards << ") from: '" << boardCardsStr << "'" << std::endl;
-        #endif
-        out_board_storage.clear(); // Invalid number of cards
+    for (int i = 0; i < nBoard; ++i) {
+        out_board_storage.emplace_back(static_cast<Card::Suit>(cardIdSuit(board[i])),
+                                       static_cast<Card::CardValue>(cardIdValue(board[i])));
     }
 }
 
 
 int PokerEnv::getHandRank(int64_t rangeIdx, const std::string& boardCardsStr) const {
-    auto it_idx_to_range = m_idxToRangeLut.find(rangeIdx);
-    if (it_idx_to_range == m_idxToRangeLut.end()) {
-        #ifdef DEBUG_POKER_ENV
-        std::cerr << "[ERROR PokerEnv::getHandRank(rangeIdx, string_board)] Invalid rangeIdx provided: " << rangeIdx << std::endl;
-        #endif
+    if (!RangeLut::isValidRangeIdx(rangeIdx)) {
+        POKER_LOG_DEBUG("[ERROR PokerEnv::getHandRank(rangeIdx, string_board)] Invalid rangeIdx provided: " << rangeIdx);
         return 0; // Invalid rangeIdx
     }
 
-    // m_idxToRangeLut stores pairs of 1D card indices (0-51)
+    // RangeLut stores pairs of 1D card indices (0-51)
     // We need to convert these to Card::CardValue and Card::Suit
-    int card1_1d = it_idx_to_range->second.first;
-    int card2_1d = it_idx_to_range->second.second;
+    int card1_1d = RangeLut::rangeCard1(static_cast<int>(rangeIdx));
+    int card2_1d = RangeLut::rangeCard2(static_cast<int>(rangeIdx));
 
-    // Convert 1D indices to CardValue and Suit
-    // Card layout: 0-12 = 2♢-A♢, 13-25 = 2♣-A♣, 26-38 = 2♡-A♡, 39-51 = 2♠-A♠
-    Card::Suit card1_suit = static_cast<Card::Suit>(card1_1d / 13);
-    Card::CardValue card1_value = static_cast<Card::CardValue>(card1_1d % 13);
-    Card::Suit card2_suit = static_cast<Card::Suit>(card2_1d / 13);
-    Card::CardValue card2_value = static_cast<Card::CardValue>(card2_1d % 13);
+    // Range indices are over card ids (value * 4 + suit, CardId.h)
+    Card::Suit card1_suit = static_cast<Card::Suit>(cardIdSuit(static_cast<CardId>(card1_1d)));
+    Card::CardValue card1_value = static_cast<Card::CardValue>(cardIdValue(static_cast<CardId>(card1_1d)));
+    Card::Suit card2_suit = static_cast<Card::Suit>(cardIdSuit(static_cast<CardId>(card2_1d)));
+    Card::CardValue card2_value = static_cast<Card::CardValue>(cardIdValue(static_cast<CardId>(card2_1d)));
 
     std::vector<Card> local_hole_cards_storage;
     local_hole_cards_storage.reserve(2);
@@ -3849,9 +4208,7 @@ int PokerEnv::getHandRank(int64_t rangeIdx, const std::string& boardCardsStr) co
         hand_card_ptrs.push_back(&local_hole_cards_storage[0]);
         hand_card_ptrs.push_back(&local_hole_cards_storage[1]);
     } else {
-        #ifdef DEBUG_POKER_ENV
-        std::cerr << "[ERROR PokerEnv::getHandRank(rangeIdx, string_board)] Failed to construct local hole cards. rangeIdx: " << rangeIdx << std::endl;
-        #endif
+        POKER_LOG_DEBUG("[ERROR PokerEnv::getHandRank(rangeIdx, string_board)] Failed to construct local hole cards. rangeIdx: " << rangeIdx);
         return 0; // Error case
     }
 
@@ -3879,35 +4236,18 @@ int PokerEnv::getHandRank(int64_t rangeIdx, const std::string& boardCardsStr) co
     eval_cards_int.erase(std::remove(eval_cards_int.begin(), eval_cards_int.end(), -1), eval_cards_int.end());
 
     if (eval_cards_int.size() < 5) {
-        #ifdef DEBUG_POKER_ENV
-        std::cout << "[DEBUG PokerEnv::getHandRank(rangeIdx, string_board)] Need at least 5 cards for evaluation, got "
-                  << eval_cards_int.size() << ". Hole cards from rangeIdx: " << rangeIdx
-                  << " (vals " << static_cast<int>(local_hole_cards_storage[0].getValue()) << Card::SuitString[local_hole_cards_storage[0].getSuit()]
-                  << " " << static_cast<int>(local_hole_cards_storage[1].getValue()) << Card::SuitString[local_hole_cards_storage[1].getSuit()]
-                  << "), Board string: '" << boardCardsStr << "'. Returning 0 (unrankable)." << std::endl;
-        #endif
+        POKER_LOG_DEBUG("[DEBUG PokerEnv::getHandRank(rangeIdx, string_board)] Need at least 5 cards for evaluation, got "
+                        << eval_cards_int.size() << ". Hole cards from rangeIdx: " << rangeIdx
+                        << " (vals " << static_cast<int>(local_hole_cards_storage[0].getValue()) << Card::SuitString[local_hole_cards_storage[0].getSuit()]
+                        << " " << static_cast<int>(local_hole_cards_storage[1].getValue()) << Card::SuitString[local_hole_cards_storage[1].getSuit()]
+                        << "), Board string: '" << boardCardsStr << "'. Returning 0 (unrankable).");
         return 0; // Not enough cards to evaluate
     }
 
-    #ifdef DEBUG_POKER_ENV
-    std::cout << "[DEBUG getHandRank(rangeIdx, string_board)] rangeIdx: " << rangeIdx
-              << ", Hole: " << local_hole_cards_storage[0].toString() << " " << local_hole_cards_storage[1].toString()
-              << ", Board: " << boardCardsStr << std::endl;
-    std::cout << "  eval_cards_int for phevaluator (size " << eval_cards_int.size() << "): ";
-    for (size_t i = 0; i < eval_cards_int.size(); ++i) {
-        std::cout << eval_cards_int[i] << (i == eval_cards_int.size() - 1 ? "" : ", ");
-    }
-    std::cout << std::endl;
-    std::cout << "  eval_cards_int breakdown (pheval_rank, pheval_suit): ";
-    for (int card_int : eval_cards_int) {
-        if (card_int != -1) {
-             std::cout << "(" << (card_int / 4) << "," << (card_int % 4) << ") ";
-        } else {
-             std::cout << "(-1) ";
-        }
-    }
-    std::cout << std::endl;
-    #endif
+    POKER_LOG_DEBUG("[DEBUG getHandRank(rangeIdx, string_board)] rangeIdx: " << rangeIdx
+                    << ", Hole: " << local_hole_cards_storage[0].toString() << " " << local_hole_cards_storage[1].toString()
+                    << ", Board: " << boardCardsStr);
+    POKER_LOG_DEBUG("  eval_cards_int for phevaluator " << evalCardsDebugString(eval_cards_int.data(), eval_cards_int.size()));
 
     // Call the appropriate phevaluator function based on the number of cards
     int rank_val = 7463; // Default to phevaluator's worst rank representation + 1
@@ -3918,9 +4258,7 @@ int PokerEnv::getHandRank(int64_t rangeIdx, const std::string& boardCardsStr) co
     } else if (eval_cards_int.size() == 7) { // Max 7 cards
         rank_val = evaluate_7cards(eval_cards_int[0], eval_cards_int[1], eval_cards_int[2], eval_cards_int[3], eval_cards_int[4], eval_cards_int[5], eval_cards_int[6]);
     } else if (eval_cards_int.size() > 7) {
-         #ifdef DEBUG_POKER_ENV
-        std::cout << "[WARNING PokerEnv::getHandRank(vec_card*, vec_card*)] More than 7 cards after processing (" << eval_cards_int.size() << "). Evaluating first 7." << std::endl;
-        #endif
+        POKER_LOG_DEBUG("[WARNING PokerEnv::getHandRank(vec_card*, vec_card*)] More than 7 cards after processing (" << eval_cards_int.size() << "). Evaluating first 7.");
         rank_val = evaluate_7cards(eval_cards_int[0], eval_cards_int[1], eval_cards_int[2], eval_cards_int[3], eval_cards_int[4], eval_cards_int[5], eval_cards_int[6]);
     }
     // phevaluator: 1 is best (Royal/Straight Flush), 7462 is worst (High Card).
@@ -3931,90 +4269,16 @@ int PokerEnv::getHandRank(int64_t rangeIdx, const std::string& boardCardsStr) co
 
 int PokerEnv::getHandRank(const std::string& twoHoleCardsStr, const std::string& boardCardsStr) const {
     if (twoHoleCardsStr.empty()) {
-        #ifdef DEBUG_POKER_ENV
-        std::cerr << "[ERROR PokerEnv::getHandRank(string_hole, string_board)] Provided empty string for hole cards."<< std::endl;
-        #endif
+        POKER_LOG_DEBUG("[ERROR PokerEnv::getHandRank(string_hole, string_board)] Provided empty string for hole cards.");
         return 0; // Error/worst rank
     }
 
-    std::string cardStr1_local, cardStr2_local;
-    // Logic to parse twoHoleCardsStr (copied and adapted from getRangeIdxByHand)
-    size_t space_pos = twoHoleCardsStr.find(' ');
-    if (space_pos != std::string::npos) {
-        cardStr1_local = twoHoleCardsStr.substr(0, space_pos);
-        size_t first_char_card2 = twoHoleCardsStr.find_first_not_of(' ', space_pos);
-        if (first_char_card2 != std::string::npos) {
-            cardStr2_local = twoHoleCardsStr.substr(first_char_card2);
-        } else {
-            #ifdef DEBUG_POKER_ENV
-            std::cerr << "[ERROR PokerEnv::getHandRank(string_hole, string_board)] Malformed hole card string with space: '" << twoHoleCardsStr << "'" << std::endl;
-            #endif
-            return 0;
-        }
-    } else { // No spaces, could be "AsKs" or "10sKs" or unicode "A♠K♠"
-        bool found_split = false;
-        // Try splitting by finding the start of a second valid card string.
-        // Iterate potential lengths for the first card (2 to 5 chars typical, e.g. "As", "10s", "A♠", "10♠")
-        for (size_t len_card1 = 2; len_card1 <= 5 && len_card1 < twoHoleCardsStr.length(); ++len_card1) {
-            std::string potential_card1_str = twoHoleCardsStr.substr(0, len_card1);
-            std::string potential_card2_str = twoHoleCardsStr.substr(len_card1);
-
-            if (potential_card2_str.length() < 2 || potential_card2_str.length() > 5) continue; // Basic length check for second card
-
-            // Attempt to parse both to validate the split
-            try {
-                parseCardStringInternal(potential_card1_str); // Validate part1
-                parseCardStringInternal(potential_card2_str); // Validate part2
-                cardStr1_local = potential_card1_str;
-                cardStr2_local = potential_card2_str;
-                found_split = true;
-                break;
-            } catch (const std::invalid_argument&) { /* This split is invalid, try next */ }
-        }
-        if (!found_split) {
-            #ifdef DEBUG_POKER_ENV
-            std::cerr << "[ERROR PokerEnv::getHandRank(string_hole, string_board)] Failed to split no-space hole card string: '" << twoHoleCardsStr << "'" << std::endl;
-            #endif
-            return 0;
-        }
-    }
-
-    if (cardStr1_local.empty() || cardStr2_local.empty()) {
-        #ifdef DEBUG_POKER_ENV
-        std::cerr << "[ERROR PokerEnv::getHandRank(string_hole, string_board)] One or both card strings empty after hole split attempt for: '" << twoHoleCardsStr << "'" << std::endl;
-        #endif
-        return 0;
-    }
-
     std::vector<Card> local_hole_cards_storage; // Stores actual Card objects for hole cards
-    std::vector<Card*> hand_card_ptrs;        // Pointers to the locally stored hole cards
-    try {
-        auto parsedCard1_data = parseCardStringInternal(cardStr1_local); // Returns pair: <Value, Suit>
-        auto parsedCard2_data = parseCardStringInternal(cardStr2_local); // Returns pair: <Value, Suit>
-
-        // Card constructor is Card(CardValue val, CardSuit suit) OR Card(CardSuit suit, CardValue val)
-        // parseCardStringInternal returns std::pair<Card::CardValue, Card::Suit>
-        // So it should be Card(parsedCard_data.first, parsedCard_data.second)
-        local_hole_cards_storage.emplace_back(parsedCard1_data.second, parsedCard1_data.first);
-        local_hole_cards_storage.emplace_back(parsedCard2_data.second, parsedCard2_data.first);
-
-        if (local_hole_cards_storage.size() == 2) {
-            hand_card_ptrs.push_back(&local_hole_cards_storage[0]);
-            hand_card_ptrs.push_back(&local_hole_cards_storage[1]);
-        } else {
-             #ifdef DEBUG_POKER_ENV
-             std::cerr << "[ERROR PokerEnv::getHandRank(string_hole, string_board)] Failed to construct local hole cards from strings. Card1: '"
-                       << cardStr1_local << "', Card2: '" << cardStr2_local << "'" << std::endl;
-             #endif
-             return 0; // Error case
-        }
-    } catch (const std::invalid_argument& e) {
-        #ifdef DEBUG_POKER_ENV
-        std::cerr << "[ERROR PokerEnv::getHandRank(string_hole, string_board)] Exception parsing hole card strings. Card1: '"
-                  << cardStr1_local << "', Card2: '" << cardStr2_local << "'. Error: " << e.what() << std::endl;
-        #endif
+    if (!parseHoleCardsInto(twoHoleCardsStr, local_hole_cards_storage)) {
+        POKER_LOG_DEBUG("[ERROR PokerEnv::getHandRank(string_hole, string_board)] Failed to parse hole card string: '" << twoHoleCardsStr << "'");
         return 0; // Error/worst rank
     }
+    std::vector<Card*> hand_card_ptrs = {&local_hole_cards_storage[0], &local_hole_cards_storage[1]};
 
     std::vector<Card> local_board_storage_for_this_call; // Stores actual Card objects for board cards
     _parseBoardString(boardCardsStr, local_board_storage_for_this_call);
@@ -4040,30 +4304,13 @@ int PokerEnv::getHandRank(const std::string& twoHoleCardsStr, const std::string&
     eval_cards_int.erase(std::remove(eval_cards_int.begin(), eval_cards_int.end(), -1), eval_cards_int.end());
 
     if (eval_cards_int.size() < 5) {
-        #ifdef DEBUG_POKER_ENV
-        std::cout << "[DEBUG PokerEnv::getHandRank(string_hole, string_board)] Need at least 5 cards for evaluation, got "
-                  << eval_cards_int.size() << ". Hole cards: '" << twoHoleCardsStr << "', Board string: '" << boardCardsStr << "'. Returning 0 (unrankable)." << std::endl;
-        #endif
+        POKER_LOG_DEBUG("[DEBUG PokerEnv::getHandRank(string_hole, string_board)] Need at least 5 cards for evaluation, got "
+                        << eval_cards_int.size() << ". Hole cards: '" << twoHoleCardsStr << "', Board string: '" << boardCardsStr << "'. Returning 0 (unrankable).");
         return 0; // Not enough cards
     }
 
-    #ifdef DEBUG_POKER_ENV
-    std::cout << "[DEBUG getHandRank(string_hole, string_board)] Hole: " << twoHoleCardsStr << ", Board: " << boardCardsStr << std::endl;
-    std::cout << "  eval_cards_int for phevaluator (size " << eval_cards_int.size() << "): ";
-    for (size_t i = 0; i < eval_cards_int.size(); ++i) {
-        std::cout << eval_cards_int[i] << (i == eval_cards_int.size() - 1 ? "" : ", ");
-    }
-    std::cout << std::endl;
-    std::cout << "  eval_cards_int breakdown (pheval_rank, pheval_suit): ";
-     for (int card_int : eval_cards_int) {
-        if (card_int != -1) {
-             std::cout << "(" << (card_int / 4) << "," << (card_int % 4) << ") ";
-        } else {
-             std::cout << "(-1) ";
-        }
-    }
-    std::cout << std::endl;
-    #endif
+    POKER_LOG_DEBUG("[DEBUG getHandRank(string_hole, string_board)] Hole: " << twoHoleCardsStr << ", Board: " << boardCardsStr);
+    POKER_LOG_DEBUG("  eval_cards_int for phevaluator " << evalCardsDebugString(eval_cards_int.data(), eval_cards_int.size()));
 
     int rank_val = 7463; // Default to phevaluator's worst rank representation + 1
     if (eval_cards_int.size() == 5) {
@@ -4073,9 +4320,7 @@ int PokerEnv::getHandRank(const std::string& twoHoleCardsStr, const std::string&
     } else if (eval_cards_int.size() == 7) { // Max 7 cards
         rank_val = evaluate_7cards(eval_cards_int[0], eval_cards_int[1], eval_cards_int[2], eval_cards_int[3], eval_cards_int[4], eval_cards_int[5], eval_cards_int[6]);
     } else if (eval_cards_int.size() > 7) {
-        #ifdef DEBUG_POKER_ENV
-        std::cout << "[WARNING PokerEnv::getHandRank(string_hole, string_board)] More than 7 cards after parsing (" << eval_cards_int.size() << "). Evaluating first 7." << std::endl;
-        #endif
+        POKER_LOG_DEBUG("[WARNING PokerEnv::getHandRank(string_hole, string_board)] More than 7 cards after parsing (" << eval_cards_int.size() << "). Evaluating first 7.");
         rank_val = evaluate_7cards(eval_cards_int[0], eval_cards_int[1], eval_cards_int[2], eval_cards_int[3], eval_cards_int[4], eval_cards_int[5], eval_cards_int[6]);
     }
     // Return phevaluator result directly: 1 = best, 7462 = worst
@@ -4083,25 +4328,21 @@ int PokerEnv::getHandRank(const std::string& twoHoleCardsStr, const std::string&
 }
 
 int PokerEnv::getHandRank(int64_t rangeIdx, const std::vector<Card*>& board_cards) const {
-    auto it_idx_to_range = m_idxToRangeLut.find(rangeIdx);
-    if (it_idx_to_range == m_idxToRangeLut.end()) {
-        #ifdef DEBUG_POKER_ENV
-        std::cerr << "[ERROR PokerEnv::getHandRank(rangeIdx, vec_board*)] Invalid rangeIdx: " << rangeIdx << std::endl;
-        #endif
+    if (!RangeLut::isValidRangeIdx(rangeIdx)) {
+        POKER_LOG_DEBUG("[ERROR PokerEnv::getHandRank(rangeIdx, vec_board*)] Invalid rangeIdx: " << rangeIdx);
         return 0; // Invalid rangeIdx
     }
 
-    // m_idxToRangeLut stores pairs of 1D card indices (0-51)
+    // RangeLut stores pairs of 1D card indices (0-51)
     // We need to convert these to Card::CardValue and Card::Suit
-    int card1_1d = it_idx_to_range->second.first;
-    int card2_1d = it_idx_to_range->second.second;
+    int card1_1d = RangeLut::rangeCard1(static_cast<int>(rangeIdx));
+    int card2_1d = RangeLut::rangeCard2(static_cast<int>(rangeIdx));
 
-    // Convert 1D indices to CardValue and Suit
-    // Card layout: 0-12 = 2♢-A♢, 13-25 = 2♣-A♣, 26-38 = 2♡-A♡, 39-51 = 2♠-A♠
-    Card::Suit card1_suit = static_cast<Card::Suit>(card1_1d / 13);
-    Card::CardValue card1_value = static_cast<Card::CardValue>(card1_1d % 13);
-    Card::Suit card2_suit = static_cast<Card::Suit>(card2_1d / 13);
-    Card::CardValue card2_value = static_cast<Card::CardValue>(card2_1d % 13);
+    // Range indices are over card ids (value * 4 + suit, CardId.h)
+    Card::Suit card1_suit = static_cast<Card::Suit>(cardIdSuit(static_cast<CardId>(card1_1d)));
+    Card::CardValue card1_value = static_cast<Card::CardValue>(cardIdValue(static_cast<CardId>(card1_1d)));
+    Card::Suit card2_suit = static_cast<Card::Suit>(cardIdSuit(static_cast<CardId>(card2_1d)));
+    Card::CardValue card2_value = static_cast<Card::CardValue>(cardIdValue(static_cast<CardId>(card2_1d)));
 
     // Store Card objects locally to ensure their lifetime
     std::vector<Card> local_hole_cards_storage;
@@ -4120,97 +4361,13 @@ int PokerEnv::getHandRank(const std::string& twoHoleCardsStr, const std::vector<
         return 0; // Worst rank
     }
 
-    std::string cardStr1_local, cardStr2_local;
-    // Logic to parse twoHoleCardsStr into cardStr1_local and cardStr2_local
-    // (Copied and adapted from existing getRangeIdxByHand(const std::string& twoCardsStr))
-    size_t space_pos = twoHoleCardsStr.find(' ');
-    if (space_pos != std::string::npos) {
-        cardStr1_local = twoHoleCardsStr.substr(0, space_pos);
-        size_t first_char_card2 = twoHoleCardsStr.find_first_not_of(' ', space_pos);
-        if (first_char_card2 != std::string::npos) {
-            cardStr2_local = twoHoleCardsStr.substr(first_char_card2);
-        } else {
-            #ifdef DEBUG_POKER_ENV
-            std::cerr << "[ERROR getHandRank(string, vec_card*)] Malformed input with space: " << twoHoleCardsStr << std::endl;
-            #endif
-            return 0;
-        }
-    } else {
-        bool found_split = false;
-        if (twoHoleCardsStr.length() >= 4 && twoHoleCardsStr.length() <= 10) {
-            for (size_t len_card1 = 2; len_card1 <= 5 && len_card1 < twoHoleCardsStr.length(); ++len_card1) {
-                std::string potential_card1_str = twoHoleCardsStr.substr(0, len_card1);
-                std::string potential_card2_str = twoHoleCardsStr.substr(len_card1);
-
-                if (potential_card2_str.length() < 2 || potential_card2_str.length() > 5) { // Sanity check for card 2 length
-                    continue;
-                }
-
-                try {
-                    parseCardStringInternal(potential_card1_str); // Throws on error
-                    parseCardStringInternal(potential_card2_str); // Throws on error
-                    // If both parsed successfully, this is our split
-                    cardStr1_local = potential_card1_str;
-                    cardStr2_local = potential_card2_str;
-                    found_split = true;
-                    break;
-                } catch (const std::invalid_argument& e) {
-                    // This split was invalid, try next length for card1
-                    #ifdef DEBUG_POKER_ENV
-                    // std::cout << "[DEBUG getRangeIdxByHand single_str] Split attempt failed for "
-                    //           << potential_card1_str << " / " << potential_card2_str << ": " << e.what() << std::endl;
-                    #endif
-                }
-            }
-        }
-
-        if (!found_split) {
-            #ifdef DEBUG_POKER_ENV
-            std::cerr << "[ERROR getHandRank(string, vec_card*)] Could not determine valid split for no-space string: " << twoHoleCardsStr << std::endl;
-            #endif
-            return 0; // Corrected: Could not split, return 0 for worst rank/error
-        }
-    }
-
-    // The #ifdef DEBUG_POKER_ENV std::cout line that was here previously will be removed by this edit.
-    // Corrected logic for handling parsed card strings and calling base getHandRank:
-    if (cardStr1_local.empty() || cardStr2_local.empty()) {
-        #ifdef DEBUG_POKER_ENV
-        std::cerr << "[ERROR getHandRank(string_hole, vec_board*)] Empty card string after parsing twoHoleCardsStr: '" << twoHoleCardsStr << "'" << std::endl;
-        #endif
-        return 0; // Return 0 for error/worst rank
-    }
-
-    try {
-        auto parsedCard1 = parseCardStringInternal(cardStr1_local);
-        auto parsedCard2 = parseCardStringInternal(cardStr2_local);
-
-        std::vector<Card> local_hole_cards_storage; // Stores actual Card objects for hole cards
-        local_hole_cards_storage.emplace_back(parsedCard1.second, parsedCard1.first);
-        local_hole_cards_storage.emplace_back(parsedCard2.second, parsedCard2.first);
-
-        std::vector<Card*> temp_hole_cards_ptrs; // Pointers to the locally stored hole cards
-        if (local_hole_cards_storage.size() == 2) { // Ensure cards were actually added
-            temp_hole_cards_ptrs.push_back(&local_hole_cards_storage[0]);
-            temp_hole_cards_ptrs.push_back(&local_hole_cards_storage[1]);
-        } else {
-            // This case should ideally not be reached if parsing logic for twoHoleCardsStr is robust
-            // and cardStr1_local/cardStr2_local are guaranteed non-empty and valid if we reach here.
-            #ifdef DEBUG_POKER_ENV
-            std::cerr << "[ERROR getHandRank(string_hole, vec_board*)] Failed to create local Card objects from twoHoleCardsStr: '" << twoHoleCardsStr << "'. Parsed strings: '" << cardStr1_local << "', '" << cardStr2_local << "'" << std::endl;
-            #endif
-            return 0; // Error case
-        }
-
-        // Call the base getHandRank that takes two std::vector<Card*>
-        // The board_cards are passed through as they are already Card* (lifetime managed by caller)
-        return getHandRank(temp_hole_cards_ptrs, board_cards);
-    } catch (const std::invalid_argument& e) {
-        #ifdef DEBUG_POKER_ENV
-        std::cerr << "[ERROR getHandRank(string_hole, vec_board*)] Exception parsing card strings ('" << cardStr1_local << "', '" << cardStr2_local << "') from twoHoleCardsStr ('" << twoHoleCardsStr << "'): " << e.what() << std::endl;
-        #endif
+    std::vector<Card> local_hole_cards_storage; // Stores actual Card objects for hole cards
+    if (!parseHoleCardsInto(twoHoleCardsStr, local_hole_cards_storage)) {
+        POKER_LOG_DEBUG("[ERROR getHandRank(string, vec_card*)] Failed to parse hole card string: " << twoHoleCardsStr);
         return 0; // Worst rank on parsing error
     }
+    std::vector<Card*> temp_hole_cards_ptrs = {&local_hole_cards_storage[0], &local_hole_cards_storage[1]};
+    return getHandRank(temp_hole_cards_ptrs, board_cards);
 }
 
 int PokerEnv::_convert_card_to_phevaluator_int(const Card* card) const {
@@ -4258,72 +4415,50 @@ int PokerEnv::compareHandStrength(const PokerPlayer* player1, const PokerPlayer*
     return 0;
 }
 
+// Each player's hand is evaluated once, then ordered by rank (ties keep their
+// input order).
 std::vector<PokerPlayer*> PokerEnv::sortPlayersByHandStrength(const std::vector<PokerPlayer*>& players, bool ascending) const {
-    std::vector<PokerPlayer*> sortedPlayers = players;
-
-    // 创建一个helper对象来避免lambda中的const问题
-    auto compareHelper = [this](const PokerPlayer* a, const PokerPlayer* b, bool asc) -> bool {
-        if (!a || !b) return false;
-
-        int rankA = this->getHandRank(a->hand, this->communityCards);
-        int rankB = this->getHandRank(b->hand, this->communityCards);
-
-        // phevaluator中数值越小牌力越强
-        if (asc) {
-            return rankA < rankB; // 从强到弱
-        } else {
-            return rankA > rankB; // 从弱到强
-        }
-    };
+    std::vector<std::pair<int, PokerPlayer*>> ranked;
+    ranked.reserve(players.size());
+    for (PokerPlayer* p : players) {
+        // nullptr 排在最后
+        ranked.emplace_back(p ? getHandRank(p->hand, communityCards) : 0, p);
+    }
 
-    std::sort(sortedPlayers.begin(), sortedPlayers.end(),
-              [this, ascending, compareHelper](const PokerPlayer* a, const PokerPlayer* b) {
-                  return compareHelper(a, b, ascending);
-              });
+    std::stable_sort(ranked.begin(), ranked.end(),
+                     [ascending](const std::pair<int, PokerPlayer*>& a, const std::pair<int, PokerPlayer*>& b) {
+                         if (!a.second || !b.second) return a.second && !b.second;
+                         // phevaluator中数值越小牌力越强
+                         return ascending ? a.first < b.first  // 从强到弱
+                                          : a.first > b.first; // 从弱到强
+                     });
 
+    std::vector<PokerPlayer*> sortedPlayers;
+    sortedPlayers.reserve(ranked.size());
+    for (const auto& entry : ranked) sortedPlayers.push_back(entry.second);
     return sortedPlayers;
 }
 
 std::vector<std::vector<PokerPlayer*>> PokerEnv::groupPlayersByHandStrength(const std::vector<PokerPlayer*>& players) const {
     std::vector<std::vector<PokerPlayer*>> groups;
 
-    if (players.empty()) {
-        return groups;
+    // 每位玩家只评估一次，再按牌力（从强到弱）排序并分组
+    std::vector<std::pair<int, PokerPlayer*>> ranked;
+    ranked.reserve(players.size());
+    for (PokerPlayer* p : players) {
+        if (p) ranked.emplace_back(getHandRank(p->hand, communityCards), p);
     }
-
-    // 首先按牌力排序（从强到弱）
-    std::vector<PokerPlayer*> sortedPlayers = sortPlayersByHandStrength(players, true);
+    std::stable_sort(ranked.begin(), ranked.end(),
+                     [](const std::pair<int, PokerPlayer*>& a, const std::pair<int, PokerPlayer*>& b) {
+                         return a.first < b.first;
+                     });
 
     // 将相同牌力的玩家分组
-    std::vector<PokerPlayer*> currentGroup;
-    int currentRank = -1;
-
-    for (PokerPlayer* player : sortedPlayers) {
-        if (!player) continue;
-
-        int playerRank = getHandRank(player->hand, communityCards);
-
-        if (currentRank == -1) {
-            // 第一个玩家
-            currentRank = playerRank;
-            currentGroup.push_back(player);
-        } else if (playerRank == currentRank) {
-            // 相同牌力，加入当前组
-            currentGroup.push_back(player);
-        } else {
-            // 不同牌力，保存当前组并开始新组
-            if (!currentGroup.empty()) {
-                groups.push_back(currentGroup);
-            }
-            currentGroup.clear();
-            currentGroup.push_back(player);
-            currentRank = playerRank;
+    for (size_t i = 0; i < ranked.size(); ++i) {
+        if (i == 0 || ranked[i].first != ranked[i - 1].first) {
+            groups.emplace_back();
         }
-    }
-
-    // 添加最后一组
-    if (!currentGroup.empty()) {
-        groups.push_back(currentGroup);
+        groups.back().push_back(ranked[i].second);
     }
 
     return groups;
@@ -4331,23 +4466,20 @@ std::vector<std::vector<PokerPlayer*>> PokerEnv::groupPlayersByHandStrength(cons
 
 // Add new method after existing getHandRank methods
 int PokerEnv::getHandRankWithPotential(int64_t rangeIdx, const std::string& boardCardsStr) const {
-    auto it_idx_to_range = m_idxToRangeLut.find(rangeIdx);
-    if (it_idx_to_range == m_idxToRangeLut.end()) {
-        #ifdef DEBUG_POKER_ENV
-        std::cerr << "[ERROR PokerEnv::getHandRankWithPotential] Invalid rangeIdx provided: " << rangeIdx << std::endl;
-        #endif
+    if (!RangeLut::isValidRangeIdx(rangeIdx)) {
+        POKER_LOG_DEBUG("[ERROR PokerEnv::getHandRankWithPotential] Invalid rangeIdx provided: " << rangeIdx);
         return 0; // Invalid rangeIdx
     }
 
     // Get hole cards from range index
-    int card1_1d = it_idx_to_range->second.first;
-    int card2_1d = it_idx_to_range->second.second;
+    int card1_1d = RangeLut::rangeCard1(static_cast<int>(rangeIdx));
+    int card2_1d = RangeLut::rangeCard2(static_cast<int>(rangeIdx));
 
-    // Convert to Card objects
-    Card::Suit card1_suit = static_cast<Card::Suit>(card1_1d / 13);
-    Card::CardValue card1_value = static_cast<Card::CardValue>(card1_1d % 13);
-    Card::Suit card2_suit = static_cast<Card::Suit>(card2_1d / 13);
-    Card::CardValue card2_value = static_cast<Card::CardValue>(card2_1d % 13);
+    // Convert to Card objects (range indices are over card ids, CardId.h)
+    Card::Suit card1_suit = static_cast<Card::Suit>(cardIdSuit(static_cast<CardId>(card1_1d)));
+    Card::CardValue card1_value = static_cast<Card::CardValue>(cardIdValue(static_cast<CardId>(card1_1d)));
+    Card::Suit card2_suit = static_cast<Card::Suit>(cardIdSuit(static_cast<CardId>(card2_1d)));
+    Card::CardValue card2_value = static_cast<Card::CardValue>(cardIdValue(static_cast<CardId>(card2_1d)));
 
     std::vector<Card> local_hole_cards_storage;
     local_hole_cards_storage.emplace_back(card1_suit, card1_value);
@@ -4368,11 +4500,9 @@ int PokerEnv::getHandRankWithPotential(int64_t rangeIdx, const std::string& boar
     if (local_board_storage.size() > 3) c4 = _convert_card_to_phevaluator_int(&local_board_storage[3]);
     if (local_board_storage.size() > 4) c5 = _convert_card_to_phevaluator_int(&local_board_storage[4]);
 
-    #ifdef DEBUG_POKER_ENV
-    std::cout << "[DEBUG getHandRankWithPotential] rangeIdx: " << rangeIdx
-              << ", Hole: " << local_hole_cards_storage[0].toString() << " " << local_hole_cards_storage[1].toString()
-              << ", Board: " << boardCardsStr << ", Auto-detected stage based on board size: " << local_board_storage.size() << std::endl;
-    #endif
+    POKER_LOG_DEBUG("[DEBUG getHandRankWithPotential] rangeIdx: " << rangeIdx
+                    << ", Hole: " << local_hole_cards_storage[0].toString() << " " << local_hole_cards_storage[1].toString()
+                    << ", Board: " << boardCardsStr << ", Auto-detected stage based on board size: " << local_board_storage.size());
 
     // Collect all cards into array for new API
     std::vector<int> all_cards;
@@ -4385,7 +4515,7 @@ int PokerEnv::getHandRankWithPotential(int64_t rangeIdx, const std::string& boar
     if (c5 != -1) all_cards.push_back(c5);
 
     // Call our new potential evaluator (stage auto-determined)
-    int potential_rank = evaluate_holdem_with_potential(all_cards.data(), all_cards.size());
+    int potential_rank = potentialWithTable(all_cards);
 
     // To maintain backward compatibility with a system expecting rank (lower is better),
     // we convert strength back to a pseudo-rank.
@@ -4396,90 +4526,16 @@ int PokerEnv::getHandRankWithPotential(int64_t rangeIdx, const std::string& boar
 int PokerEnv::getHandRankWithPotential(const std::string& twoHoleCardsStr, const std::string& boardCardsStr) const {
     // 暂时使用标准评估，后续完善潜力评估
         if (twoHoleCardsStr.empty()) {
-        #ifdef DEBUG_POKER_ENV
-        std::cerr << "[ERROR PokerEnv::getHandRank(string_hole, string_board)] Provided empty string for hole cards."<< std::endl;
-        #endif
+        POKER_LOG_DEBUG("[ERROR PokerEnv::getHandRank(string_hole, string_board)] Provided empty string for hole cards.");
         return 0; // Error/worst rank
     }
 
-    std::string cardStr1_local, cardStr2_local;
-    // Logic to parse twoHoleCardsStr (copied and adapted from getRangeIdxByHand)
-    size_t space_pos = twoHoleCardsStr.find(' ');
-    if (space_pos != std::string::npos) {
-        cardStr1_local = twoHoleCardsStr.substr(0, space_pos);
-        size_t first_char_card2 = twoHoleCardsStr.find_first_not_of(' ', space_pos);
-        if (first_char_card2 != std::string::npos) {
-            cardStr2_local = twoHoleCardsStr.substr(first_char_card2);
-        } else {
-            #ifdef DEBUG_POKER_ENV
-            std::cerr << "[ERROR PokerEnv::getHandRank(string_hole, string_board)] Malformed hole card string with space: '" << twoHoleCardsStr << "'" << std::endl;
-            #endif
-            return 0;
-        }
-    } else { // No spaces, could be "AsKs" or "10sKs" or unicode "A♠K♠"
-        bool found_split = false;
-        // Try splitting by finding the start of a second valid card string.
-        // Iterate potential lengths for the first card (2 to 5 chars typical, e.g. "As", "10s", "A♠", "10♠")
-        for (size_t len_card1 = 2; len_card1 <= 5 && len_card1 < twoHoleCardsStr.length(); ++len_card1) {
-            std::string potential_card1_str = twoHoleCardsStr.substr(0, len_card1);
-            std::string potential_card2_str = twoHoleCardsStr.substr(len_card1);
-
-            if (potential_card2_str.length() < 2 || potential_card2_str.length() > 5) continue; // Basic length check for second card
-
-            // Attempt to parse both to validate the split
-            try {
-                parseCardStringInternal(potential_card1_str); // Validate part1
-                parseCardStringInternal(potential_card2_str); // Validate part2
-                cardStr1_local = potential_card1_str;
-                cardStr2_local = potential_card2_str;
-                found_split = true;
-                break;
-            } catch (const std::invalid_argument&) { /* This split is invalid, try next */ }
-        }
-        if (!found_split) {
-            #ifdef DEBUG_POKER_ENV
-            std::cerr << "[ERROR PokerEnv::getHandRank(string_hole, string_board)] Failed to split no-space hole card string: '" << twoHoleCardsStr << "'" << std::endl;
-            #endif
-            return 0;
-        }
-    }
-
-    if (cardStr1_local.empty() || cardStr2_local.empty()) {
-        #ifdef DEBUG_POKER_ENV
-        std::cerr << "[ERROR PokerEnv::getHandRank(string_hole, string_board)] One or both card strings empty after hole split attempt for: '" << twoHoleCardsStr << "'" << std::endl;
-        #endif
-        return 0;
-    }
-
     std::vector<Card> local_hole_cards_storage; // Stores actual Card objects for hole cards
-    std::vector<Card*> hand_card_ptrs;        // Pointers to the locally stored hole cards
-    try {
-        auto parsedCard1_data = parseCardStringInternal(cardStr1_local); // Returns pair: <Value, Suit>
-        auto parsedCard2_data = parseCardStringInternal(cardStr2_local); // Returns pair: <Value, Suit>
-
-        // Card constructor is Card(CardValue val, CardSuit suit) OR Card(CardSuit suit, CardValue val)
-        // parseCardStringInternal returns std::pair<Card::CardValue, Card::Suit>
-        // So it should be Card(parsedCard_data.first, parsedCard_data.second)
-        local_hole_cards_storage.emplace_back(parsedCard1_data.second, parsedCard1_data.first);
-        local_hole_cards_storage.emplace_back(parsedCard2_data.second, parsedCard2_data.first);
-
-        if (local_hole_cards_storage.size() == 2) {
-            hand_card_ptrs.push_back(&local_hole_cards_storage[0]);
-            hand_card_ptrs.push_back(&local_hole_cards_storage[1]);
-        } else {
-             #ifdef DEBUG_POKER_ENV
-             std::cerr << "[ERROR PokerEnv::getHandRank(string_hole, string_board)] Failed to construct local hole cards from strings. Card1: '"
-                       << cardStr1_local << "', Card2: '" << cardStr2_local << "'" << std::endl;
-             #endif
-             return 0; // Error case
-        }
-    } catch (const std::invalid_argument& e) {
-        #ifdef DEBUG_POKER_ENV
-        std::cerr << "[ERROR PokerEnv::getHandRank(string_hole, string_board)] Exception parsing hole card strings. Card1: '"
-                  << cardStr1_local << "', Card2: '" << cardStr2_local << "'. Error: " << e.what() << std::endl;
-        #endif
+    if (!parseHoleCardsInto(twoHoleCardsStr, local_hole_cards_storage)) {
+        POKER_LOG_DEBUG("[ERROR PokerEnv::getHandRankWithPotential(string_hole, string_board)] Failed to parse hole card string: '" << twoHoleCardsStr << "'");
         return 0; // Error/worst rank
     }
+    std::vector<Card*> hand_card_ptrs = {&local_hole_cards_storage[0], &local_hole_cards_storage[1]};
 
     std::vector<Card> local_board_storage_for_this_call; // Stores actual Card objects for board cards
     _parseBoardString(boardCardsStr, local_board_storage_for_this_call);
@@ -4505,30 +4561,13 @@ int PokerEnv::getHandRankWithPotential(const std::string& twoHoleCardsStr, const
     eval_cards_int.erase(std::remove(eval_cards_int.begin(), eval_cards_int.end(), -1), eval_cards_int.end());
 
     if (eval_cards_int.size() < 5) {
-        #ifdef DEBUG_POKER_ENV
-        std::cout << "[DEBUG PokerEnv::getHandRank(string_hole, string_board)] Need at least 5 cards for evaluation, got "
-                  << eval_cards_int.size() << ". Hole cards: '" << twoHoleCardsStr << "', Board string: '" << boardCardsStr << "'. Returning 0 (unrankable)." << std::endl;
-        #endif
+        POKER_LOG_DEBUG("[DEBUG PokerEnv::getHandRank(string_hole, string_board)] Need at least 5 cards for evaluation, got "
+                        << eval_cards_int.size() << ". Hole cards: '" << twoHoleCardsStr << "', Board string: '" << boardCardsStr << "'. Returning 0 (unrankable).");
         return 0; // Not enough cards
     }
 
-    #ifdef DEBUG_POKER_ENV
-    std::cout << "[DEBUG getHandRank(string_hole, string_board)] Hole: " << twoHoleCardsStr << ", Board: " << boardCardsStr << std::endl;
-    std::cout << "  eval_cards_int for phevaluator (size " << eval_cards_int.size() << "): ";
-    for (size_t i = 0; i < eval_cards_int.size(); ++i) {
-        std::cout << eval_cards_int[i] << (i == eval_cards_int.size() - 1 ? "" : ", ");
-    }
-    std::cout << std::endl;
-    std::cout << "  eval_cards_int breakdown (pheval_rank, pheval_suit): ";
-     for (int card_int : eval_cards_int) {
-        if (card_int != -1) {
-             std::cout << "(" << (card_int / 4) << "," << (card_int % 4) << ") ";
-        } else {
-             std::cout << "(-1) ";
-        }
-    }
-    std::cout << std::endl;
-    #endif
+    POKER_LOG_DEBUG("[DEBUG getHandRank(string_hole, string_board)] Hole: " << twoHoleCardsStr << ", Board: " << boardCardsStr);
+    POKER_LOG_DEBUG("  eval_cards_int for phevaluator " << evalCardsDebugString(eval_cards_int.data(), eval_cards_int.size()));
 
     // Convert hole cards to phevaluator int format
     int h1 = _convert_card_to_phevaluator_int(&local_hole_cards_storage[0]);
@@ -4542,11 +4581,9 @@ int PokerEnv::getHandRankWithPotential(const std::string& twoHoleCardsStr, const
     if (local_board_storage_for_this_call.size() > 3) c4 = _convert_card_to_phevaluator_int(&local_board_storage_for_this_call[3]);
     if (local_board_storage_for_this_call.size() > 4) c5 = _convert_card_to_phevaluator_int(&local_board_storage_for_this_call[4]);
 
-    #ifdef DEBUG_POKER_ENV
-    std::cout << "[DEBUG getHandRankWithPotential(string)] Hole: " << twoHoleCardsStr << ", Board: " << boardCardsStr << ", Auto-detected stage based on board size: " << local_board_storage_for_this_call.size() << std::endl;
-    std::cout << "  Converted to phevaluator format - h1: " << h1 << ", h2: " << h2
-              << ", c1: " << c1 << ", c2: " << c2 << ", c3: " << c3 << ", c4: " << c4 << ", c5: " << c5 << std::endl;
-    #endif
+    POKER_LOG_DEBUG("[DEBUG getHandRankWithPotential(string)] Hole: " << twoHoleCardsStr << ", Board: " << boardCardsStr << ", Auto-detected stage based on board size: " << local_board_storage_for_this_call.size());
+    POKER_LOG_DEBUG("  Converted to phevaluator format - h1: " << h1 << ", h2: " << h2
+                    << ", c1: " << c1 << ", c2: " << c2 << ", c3: " << c3 << ", c4: " << c4 << ", c5: " << c5);
 
     // Collect all cards into array for new API
     std::vector<int> all_cards;
@@ -4559,7 +4596,7 @@ int PokerEnv::getHandRankWithPotential(const std::string& twoHoleCardsStr, const
     if (c5 != -1) all_cards.push_back(c5);
 
     // Call our new potential evaluator
-    int potential_rank = evaluate_holdem_with_potential(all_cards.data(), all_cards.size());
+    int potential_rank = potentialWithTable(all_cards);
 
     // To maintain backward compatibility with a system expecting rank (lower is better),
     // we convert strength back to a pseudo-rank.
@@ -4569,23 +4606,20 @@ int PokerEnv::getHandRankWithPotential(const std::string& twoHoleCardsStr, const
 
 // New overload for vector<Card*> board cards
 int PokerEnv::getHandRankWithPotential(int64_t rangeIdx, const std::vector<Card*>& board_cards) const {
-    auto it_idx_to_range = m_idxToRangeLut.find(rangeIdx);
-    if (it_idx_to_range == m_idxToRangeLut.end()) {
-        #ifdef DEBUG_POKER_ENV
-        std::cerr << "[ERROR PokerEnv::getHandRankWithPotential(vector)] Invalid rangeIdx provided: " << rangeIdx << std::endl;
-        #endif
+    if (!RangeLut::isValidRangeIdx(rangeIdx)) {
+        POKER_LOG_DEBUG("[ERROR PokerEnv::getHandRankWithPotential(vector)] Invalid rangeIdx provided: " << rangeIdx);
         return 0; // Invalid rangeIdx
     }
 
     // Get hole cards from range index
-    int card1_1d = it_idx_to_range->second.first;
-    int card2_1d = it_idx_to_range->second.second;
+    int card1_1d = RangeLut::rangeCard1(static_cast<int>(rangeIdx));
+    int card2_1d = RangeLut::rangeCard2(static_cast<int>(rangeIdx));
 
-    // Convert to Card objects
-    Card::Suit card1_suit = static_cast<Card::Suit>(card1_1d / 13);
-    Card::CardValue card1_value = static_cast<Card::CardValue>(card1_1d % 13);
-    Card::Suit card2_suit = static_cast<Card::Suit>(card2_1d / 13);
-    Card::CardValue card2_value = static_cast<Card::CardValue>(card2_1d % 13);
+    // Convert to Card objects (range indices are over card ids, CardId.h)
+    Card::Suit card1_suit = static_cast<Card::Suit>(cardIdSuit(static_cast<CardId>(card1_1d)));
+    Card::CardValue card1_value = static_cast<Card::CardValue>(cardIdValue(static_cast<CardId>(card1_1d)));
+    Card::Suit card2_suit = static_cast<Card::Suit>(cardIdSuit(static_cast<CardId>(card2_1d)));
+    Card::CardValue card2_value = static_cast<Card::CardValue>(cardIdValue(static_cast<CardId>(card2_1d)));
 
     std::vector<Card> local_hole_cards_storage;
     local_hole_cards_storage.emplace_back(card1_suit, card1_value);
@@ -4603,11 +4637,9 @@ int PokerEnv::getHandRankWithPotential(int64_t rangeIdx, const std::vector<Card*
     if (board_cards.size() > 3 && board_cards[3]) c4 = _convert_card_to_phevaluator_int(board_cards[3]);
     if (board_cards.size() > 4 && board_cards[4]) c5 = _convert_card_to_phevaluator_int(board_cards[4]);
 
-    #ifdef DEBUG_POKER_ENV
-    std::cout << "[DEBUG getHandRankWithPotential(vector)] rangeIdx: " << rangeIdx
-              << ", Hole: " << local_hole_cards_storage[0].toString() << " " << local_hole_cards_storage[1].toString()
-              << ", Board size: " << board_cards.size() << ", Auto-detected stage based on board size: " << board_cards.size() << std::endl;
-    #endif
+    POKER_LOG_DEBUG("[DEBUG getHandRankWithPotential(vector)] rangeIdx: " << rangeIdx
+                    << ", Hole: " << local_hole_cards_storage[0].toString() << " " << local_hole_cards_storage[1].toString()
+                    << ", Board size: " << board_cards.size() << ", Auto-detected stage based on board size: " << board_cards.size());
 
     // Collect all cards into array for new API
     std::vector<int> all_cards;
@@ -4620,7 +4652,7 @@ int PokerEnv::getHandRankWithPotential(int64_t rangeIdx, const std::vector<Card*
     if (c5 != -1) all_cards.push_back(c5);
 
     // Call our potential evaluator (stage auto-determined)
-    int potential_rank = evaluate_holdem_with_potential(all_cards.data(), all_cards.size());
+    int potential_rank = potentialWithTable(all_cards);
 
     // Invert strength to pseudo-rank for backward compatibility
     return 1000000 - potential_rank;
@@ -4632,9 +4664,7 @@ int PokerEnv::getHandRankWithPotential(int64_t rangeIdx, const std::vector<Card*
 
 int PokerEnv::getHandValuebyCard(const Card* card1, const Card* card2) const {
     if (!card1 || !card2) {
-        #ifdef DEBUG_POKER_ENV
-        std::cerr << "[ERROR getHandValuebyCard] Invalid card pointers provided" << std::endl;
-        #endif
+        POKER_LOG_DEBUG("[ERROR getHandValuebyCard] Invalid card pointers provided");
         return 169; // Return worst possible rank (weakest hand)
     }
 
@@ -4643,159 +4673,67 @@ int PokerEnv::getHandValuebyCard(const Card* card1, const Card* card2) const {
     int card2_int = _convert_card_to_phevaluator_int(card2);
 
     if (card1_int == -1 || card2_int == -1) {
-        #ifdef DEBUG_POKER_ENV
-        std::cerr << "[ERROR getHandValuebyCard] Failed to convert cards to phevaluator format" << std::endl;
-        #endif
+        POKER_LOG_DEBUG("[ERROR getHandValuebyCard] Failed to convert cards to phevaluator format");
         return 169; // Return worst possible rank
     }
 
-    #ifdef DEBUG_POKER_ENV
-    std::cout << "[DEBUG getHandValuebyCard] Card1: " << card1->toString()
-              << " (pheval: " << card1_int << "), Card2: " << card2->toString()
-              << " (pheval: " << card2_int << ")" << std::endl;
-    #endif
+    POKER_LOG_DEBUG("[DEBUG getHandValuebyCard] Card1: " << card1->toString()
+                    << " (pheval: " << card1_int << "), Card2: " << card2->toString()
+                    << " (pheval: " << card2_int << ")");
 
-    // Call evaluate_2cards from evaluator_extended.c
-    int hand_value = evaluate_2cards(card1_int, card2_int);
+    // evaluate_2cards rank through the preflop table
+    const PreflopEntry* preflop = preflopEntry(static_cast<CardId>(card1_int), static_cast<CardId>(card2_int));
+    int hand_value = preflop ? preflop->rank : evaluate_2cards(card1_int, card2_int);
 
-    #ifdef DEBUG_POKER_ENV
-    std::cout << "[DEBUG getHandValuebyCard] Hand value: " << hand_value << std::endl;
-    #endif
+    POKER_LOG_DEBUG("[DEBUG getHandValuebyCard] Hand value: " << hand_value);
 
     return hand_value;
 }
 
 int PokerEnv::getHandValuebyPlayer(int playerId) const {
     if (playerId < 0 || playerId >= N_SEATS || !players[playerId]) {
-        #ifdef DEBUG_POKER_ENV
-        std::cerr << "[ERROR getHandValuebyPlayer] Invalid playerId: " << playerId << std::endl;
-        #endif
+        POKER_LOG_DEBUG("[ERROR getHandValuebyPlayer] Invalid playerId: " << playerId);
         return 169; // Return worst possible rank
     }
 
     const PokerPlayer* player = players[playerId];
     if (player->hand.size() != 2) {
-        #ifdef DEBUG_POKER_ENV
-        std::cerr << "[ERROR getHandValuebyPlayer] Player " << playerId
-                  << " does not have exactly 2 hole cards (has " << player->hand.size() << ")" << std::endl;
-        #endif
+        POKER_LOG_DEBUG("[ERROR getHandValuebyPlayer] Player " << playerId
+                        << " does not have exactly 2 hole cards (has " << player->hand.size() << ")");
         return 169; // Return worst possible rank
     }
 
     const Card* card1 = player->hand[0];
     const Card* card2 = player->hand[1];
 
-
-    // Collect all cards into array for new API
-    std::vector<int> all_cards;
-    all_cards.push_back(_convert_card_to_phevaluator_int(card1));
-    all_cards.push_back(_convert_card_to_phevaluator_int(card2));
-
-    // Call our potential evaluator (returns strength, higher is better)
-    int potential_strength = evaluate_2cards(all_cards[0], all_cards[1]);
-
-    // Invert strength to pseudo-rank for backward compatibility
-    return potential_strength;
+    // 1-169 rank from the preflop table (evaluate_2cards, computed once)
+    if (const PreflopEntry* preflop = preflopEntry(cardIdOf(card1), cardIdOf(card2))) {
+        return preflop->rank;
+    }
+    return evaluate_2cards(_convert_card_to_phevaluator_int(card1), _convert_card_to_phevaluator_int(card2));
 }
 
 int PokerEnv::getHandValuebyString(const std::string& twoCardsStr) const {
     if (twoCardsStr.empty()) {
-        #ifdef DEBUG_POKER_ENV
-        std::cerr << "[ERROR getHandValuebyString] Empty card string provided" << std::endl;
-        #endif
+        POKER_LOG_DEBUG("[ERROR getHandValuebyString] Empty card string provided");
         return 169; // Return worst possible rank
     }
 
-    std::string cardStr1, cardStr2;
-    size_t space_pos = twoCardsStr.find(' ');
-
-    if (space_pos != std::string::npos) {
-        // Space-separated format: "5s 6s"
-        cardStr1 = twoCardsStr.substr(0, space_pos);
-        size_t first_char_card2 = twoCardsStr.find_first_not_of(' ', space_pos);
-        if (first_char_card2 != std::string::npos) {
-            cardStr2 = twoCardsStr.substr(first_char_card2);
-        } else {
-            #ifdef DEBUG_POKER_ENV
-            std::cerr << "[ERROR getHandValuebyString] Malformed space-separated string: " << twoCardsStr << std::endl;
-            #endif
-            return 169;
-        }
-    } else {
-        // Concatenated format: "5s6s" or "5♠6♠"
-        bool found_split = false;
-
-        // Try different split positions
-        for (size_t len_card1 = 2; len_card1 <= 5 && len_card1 < twoCardsStr.length(); ++len_card1) {
-            std::string potential_card1 = twoCardsStr.substr(0, len_card1);
-            std::string potential_card2 = twoCardsStr.substr(len_card1);
-
-            if (potential_card2.length() < 2 || potential_card2.length() > 5) {
-                continue; // Invalid length for second card
-            }
-
-            try {
-                // Try to parse both cards to validate the split
-                parseCardStringInternal(potential_card1);
-                parseCardStringInternal(potential_card2);
-
-                // If both parsed successfully, use this split
-                cardStr1 = potential_card1;
-                cardStr2 = potential_card2;
-                found_split = true;
-                break;
-            } catch (const std::invalid_argument&) {
-                // This split was invalid, try next length
-                continue;
-            }
-        }
-
-        if (!found_split) {
-            #ifdef DEBUG_POKER_ENV
-            std::cerr << "[ERROR getHandValuebyString] Could not parse concatenated string: " << twoCardsStr << std::endl;
-            #endif
-            return 169;
-        }
+    CardId hole[N_HOLE_CARDS];
+    const CardParse::Status status = CardParse::parseHoleCards(twoCardsStr, hole);
+    if (status != CardParse::Status::Ok) {
+        POKER_LOG_DEBUG("[ERROR getHandValuebyString] " << CardParse::statusMessage(status) << ": " << twoCardsStr);
+        return 169; // Return worst possible rank on error
     }
 
-    if (cardStr1.empty() || cardStr2.empty()) {
-        #ifdef DEBUG_POKER_ENV
-        std::cerr << "[ERROR getHandValuebyString] One or both card strings empty after parsing: " << twoCardsStr << std::endl;
-        #endif
-        return 169;
-    }
+    // CardId is the phevaluator card int (value * 4 + suit).
+    int all_cards[N_HOLE_CARDS] = {hole[0], hole[1]};
 
-    #ifdef DEBUG_POKER_ENV
-    std::cout << "[DEBUG getHandValuebyString] Parsed '" << twoCardsStr
-              << "' into: card1='" << cardStr1 << "', card2='" << cardStr2 << "'" << std::endl;
-    #endif
+    // Call our potential evaluator (returns strength, higher is better)
+    int potential_strength = evaluate_holdem_with_potential(all_cards, N_HOLE_CARDS);
 
-    try {
-        // Parse the card strings
-        auto parsedCard1 = parseCardStringInternal(cardStr1);
-        auto parsedCard2 = parseCardStringInternal(cardStr2);
-
-        // Create temporary Card objects
-        Card card1_obj(parsedCard1.second, parsedCard1.first);
-        Card card2_obj(parsedCard2.second, parsedCard2.first);
-
-        // Collect all cards into array for new API
-        std::vector<int> all_cards;
-        all_cards.push_back(_convert_card_to_phevaluator_int(&card1_obj));
-        all_cards.push_back(_convert_card_to_phevaluator_int(&card2_obj));
-
-        // Call our potential evaluator (returns strength, higher is better)
-        int potential_strength = evaluate_holdem_with_potential(all_cards.data(), all_cards.size());
-
-        // Invert strength to pseudo-rank for backward compatibility (adjusted for 0-10000 range)
-        return 10000 - potential_strength;
-    } catch (const std::invalid_argument& e) {
-        #ifdef DEBUG_POKER_ENV
-        std::cerr << "[ERROR getHandValuebyString] Exception parsing cards '"
-                  << cardStr1 << "', '" << cardStr2 << "': " << e.what() << std::endl;
-        #endif
-        return 169; // Return worst possible rank on error
-    }
+    // Invert strength to pseudo-rank for backward compatibility (adjusted for 0-10000 range)
+    return 10000 - potential_strength;
 }
 
 // 新增：获取玩家手牌索引的函数
@@ -4871,10 +4809,10 @@ int PokerEnv::get_call_amount() const {
 
 // 测试函数：测试带有手牌和公共牌设置的reset函数
 void test_reset_with_cards(PokerEnv* env) {
-    printf("开始测试reset函数的手牌和公共牌设置功能...\n");
+    POKER_LOG_PRINT("开始测试reset函数的手牌和公共牌设置功能...\n");
 
     // 测试用例1: Preflop测试
-    printf("\n=== 测试用例1: Preflop (无公共牌) ===\n");
+    POKER_LOG_PRINT("\n=== 测试用例1: Preflop (无公共牌) ===\n");
     std::vector<std::vector<int>> hole_cards = {
         {0, 13},   // Player 0: As (黑桃A), Kh (红桃K)
         {1, 14},   // Player 1: 2s (黑桃2), Ah (红桃A)
@@ -4883,61 +4821,59 @@ void test_reset_with_cards(PokerEnv* env) {
     std::vector<int> board_cards = {}; // 无公共牌
 
     auto obs = env->reset(false, hole_cards, board_cards);
-    printf("当前轮次: %d (应该是PREFLOP=0)\n", env->getCurrentRound());
-    printf("当前玩家: %d\n", env->getCurrentPlayer());
+    POKER_LOG_PRINT("当前轮次: " << env->getCurrentRound() << " (应该是PREFLOP=0)\n");
+    POKER_LOG_PRINT("当前玩家: " << env->getCurrentPlayer() << "\n");
 
     // 检查手牌设置
     for (int i = 0; i < 3; i++) {
         auto player_hand = env->getPlayerHand_py(i);
-        printf("玩家 %d 手牌: (%d,%d), (%d,%d)\n", i,
-               std::get<0>(player_hand[0]), std::get<1>(player_hand[0]),
-               std::get<0>(player_hand[1]), std::get<1>(player_hand[1]));
+        POKER_LOG_PRINT("玩家 " << i << " 手牌: (" << std::get<0>(player_hand[0]) << "," << std::get<1>(player_hand[0]) << "), (" << std::get<0>(player_hand[1]) << "," << std::get<1>(player_hand[1]) << ")\n");
     }
 
     // 测试用例2: Flop测试
-    printf("\n=== 测试用例2: Flop (3张公共牌) ===\n");
+    POKER_LOG_PRINT("\n=== 测试用例2: Flop (3张公共牌) ===\n");
     board_cards = {2, 15, 28}; // 3s, 3h, 3d (三条3)
 
     obs = env->reset(false, hole_cards, board_cards);
-    printf("当前轮次: %d (应该是FLOP=1)\n", env->getCurrentRound());
+    POKER_LOG_PRINT("当前轮次: " << env->getCurrentRound() << " (应该是FLOP=1)\n");
 
     auto community_cards = env->getCommunityCards_py();
-    printf("公共牌: ");
+    std::ostringstream board_line;
     for (size_t i = 0; i < community_cards.size(); i++) {
-        printf("%d ", community_cards[i]);
+        board_line << community_cards[i] << " ";
     }
-    printf("\n");
+    POKER_LOG_PRINT("公共牌: " << board_line.str() << "\n");
 
     // 测试用例3: Turn测试
-    printf("\n=== 测试用例3: Turn (4张公共牌) ===\n");
+    POKER_LOG_PRINT("\n=== 测试用例3: Turn (4张公共牌) ===\n");
     board_cards = {2, 15, 28, 41}; // 3s, 3h, 3d, 3c (四条3)
 
     obs = env->reset(false, hole_cards, board_cards);
-    printf("当前轮次: %d (应该是TURN=2)\n", env->getCurrentRound());
+    POKER_LOG_PRINT("当前轮次: " << env->getCurrentRound() << " (应该是TURN=2)\n");
 
     community_cards = env->getCommunityCards_py();
-    printf("公共牌: ");
+    board_line.str("");
     for (size_t i = 0; i < community_cards.size(); i++) {
-        printf("%d ", community_cards[i]);
+        board_line << community_cards[i] << " ";
     }
-    printf("\n");
+    POKER_LOG_PRINT("公共牌: " << board_line.str() << "\n");
 
     // 测试用例4: River测试
-    printf("\n=== 测试用例4: River (5张公共牌) ===\n");
+    POKER_LOG_PRINT("\n=== 测试用例4: River (5张公共牌) ===\n");
     board_cards = {2, 15, 28, 41, 12}; // 3s, 3h, 3d, 3c, Ks (四条3带K)
 
     obs = env->reset(false, hole_cards, board_cards);
-    printf("当前轮次: %d (应该是RIVER=3)\n", env->getCurrentRound());
+    POKER_LOG_PRINT("当前轮次: " << env->getCurrentRound() << " (应该是RIVER=3)\n");
 
     community_cards = env->getCommunityCards_py();
-    printf("公共牌: ");
+    board_line.str("");
     for (size_t i = 0; i < community_cards.size(); i++) {
-        printf("%d ", community_cards[i]);
+        board_line << community_cards[i] << " ";
     }
-    printf("\n");
+    POKER_LOG_PRINT("公共牌: " << board_line.str() << "\n");
 
     // 测试用例5: 错误输入测试
-    printf("\n=== 测试用例5: 错误输入测试 ===\n");
+    POKER_LOG_PRINT("\n=== 测试用例5: 错误输入测试 ===\n");
     std::vector<std::vector<int>> invalid_hole_cards = {
         {-1, 52},   // 无效索引
         {100, 200}  // 超出范围
@@ -4945,14 +4881,14 @@ void test_reset_with_cards(PokerEnv* env) {
     std::vector<int> invalid_board_cards = {-5, 60, 100}; // 无效索引
 
     obs = env->reset(false, invalid_hole_cards, invalid_board_cards);
-    printf("错误输入处理完成，游戏仍能正常进行\n");
+    POKER_LOG_PRINT("错误输入处理完成，游戏仍能正常进行\n");
 
-    printf("\n所有测试用例完成！\n");
+    POKER_LOG_PRINT("\n所有测试用例完成！\n");
 }
 
 // 便于从外部调用的C接口测试函数
 extern "C" void test_pokerenv_reset_with_cards() {
-    printf("正在创建PokerEnv测试实例...\n");
+    POKER_LOG_PRINT("正在创建PokerEnv测试实例...\n");
 
     // 创建基本配置
     nlohmann::json config;
@@ -4966,7 +4902,7 @@ extern "C" void test_pokerenv_reset_with_cards() {
     // 运行测试
     test_reset_with_cards(&env);
 
-    printf("测试完成！\n");
+    POKER_LOG_PRINT("测试完成！\n");
 }
 // ===================================================================
 // Card Isomorphism Helper (Static)
@@ -4989,8 +4925,10 @@ std::vector<int> _getCanonicalSuitMap_static(const std::vector<Card*>& community
     // 2. Check cache first.
     auto it = suit_map_cache.find(board_long);
     if (it != suit_map_cache.end()) {
+        POKER_PERF_COUNT(PokerPerf::Counter::SuitMapHit);
         return it->second;
     }
+    POKER_PERF_COUNT(PokerPerf::Counter::SuitMapMiss);
 
     // 3. If not in cache, compute the map.
     const int NUM_SUITS = 4;
@@ -5037,35 +4975,37 @@ std::vector<int> _getCanonicalSuitMap_static(const std::vector<Card*>& community
 
 
 void PokerEnv::printState() const {
-    std::cout << "--- PokerEnv State ---" << std::endl;
-    std::cout << "Current Player: " << currentPlayer << std::endl;
-    std::cout << "Current Round: " << currentRound << std::endl;
-    std::cout << "Main Pot: " << mainPot << std::endl;
-    std::cout << "Side Pots: ";
-    for (int pot : sidePots) std::cout << pot << " ";
-    std::cout << std::endl;
-    std::cout << "Current Bet: " << getCurrentBet() << std::endl;
-    std::cout << "Current Side Pots: ";
-    for (int pot : currentSidePots) std::cout << pot << " ";
-    std::cout << std::endl;
-    std::cout << "Last Action: " << lastAction_member[0] << " (" << lastAction_member[1] << ")" << std::endl;
-    std::cout << "Last Raiser: " << lastRaiser << std::endl;
-    std::cout << "Number of Raises This Round: " << nRaisesThisRound << std::endl;
-    std::cout << "Number of Actions This Episode: " << nActionsThisEpisode << std::endl;
-    std::cout << "Hand Is Over: " << handIsOver << std::endl;
-    std::cout << "Bet Sizes List As Fraction of Pot: ";
-    for (float bet : betSizesListAsFracOfPot) std::cout << bet << " ";
-    std::cout << std::endl;
-    std::cout << "Uniform Action Interpolation Member: " << uniformActionInterpolation_member << std::endl;
-    std::cout << "Capped Raise Member: " << (cappedRaise_member.happenedThisRound ? "True" : "False") << ", Raised by: " << cappedRaise_member.playerThatRaised << ", Cannot Reopen: " << cappedRaise_member.playerThatCantReopen << std::endl;
-    std::cout << "First Action No Call: " << FIRST_ACTION_NO_CALL << std::endl;
-    std::cout << "Fixed Limit Game: " << IS_FIXED_LIMIT_GAME << std::endl;
-    std::cout << "Max Number of Raises Per Round: ";
-    for (int max_raises : MAX_N_RAISES_PER_ROUND) std::cout << max_raises << " ";
-    std::cout << std::endl;
-    std::cout << "Max Rounds Per Hand: " << max_rounds_per_hand << std::endl;
-    std::cout << "Number of Active Players Not Folded: " << getNumActivePlayersNotFolded() << std::endl;
-    std::cout << std::endl;
+    std::ostringstream oss;
+    oss << "--- PokerEnv State ---" << "\n";
+    oss << "Current Player: " << currentPlayer << "\n";
+    oss << "Current Round: " << currentRound << "\n";
+    oss << "Main Pot: " << mainPot << "\n";
+    oss << "Side Pots: ";
+    for (int pot : sidePots) oss << pot << " ";
+    oss << "\n";
+    oss << "Current Bet: " << getCurrentBet() << "\n";
+    oss << "Current Side Pots: ";
+    for (int pot : currentSidePots) oss << pot << " ";
+    oss << "\n";
+    oss << "Last Action: " << lastAction_member[0] << " (" << lastAction_member[1] << ")" << "\n";
+    oss << "Last Raiser: " << lastRaiser << "\n";
+    oss << "Number of Raises This Round: " << nRaisesThisRound << "\n";
+    oss << "Number of Actions This Episode: " << nActionsThisEpisode << "\n";
+    oss << "Hand Is Over: " << handIsOver << "\n";
+    oss << "Bet Sizes List As Fraction of Pot: ";
+    for (float bet : betSizesListAsFracOfPot) oss << bet << " ";
+    oss << "\n";
+    oss << "Uniform Action Interpolation Member: " << uniformActionInterpolation_member << "\n";
+    oss << "Capped Raise Member: " << (cappedRaise_member.happenedThisRound ? "True" : "False") << ", Raised by: " << cappedRaise_member.playerThatRaised << ", Cannot Reopen: " << cappedRaise_member.playerThatCantReopen << "\n";
+    oss << "First Action No Call: " << FIRST_ACTION_NO_CALL << "\n";
+    oss << "Fixed Limit Game: " << IS_FIXED_LIMIT_GAME << "\n";
+    oss << "Max Number of Raises Per Round: ";
+    for (int max_raises : MAX_N_RAISES_PER_ROUND) oss << max_raises << " ";
+    oss << "\n";
+    oss << "Max Rounds Per Hand: " << max_rounds_per_hand << "\n";
+    oss << "Number of Active Players Not Folded: " << getNumActivePlayersNotFolded() << "\n";
+    oss << "\n";
+    PokerLog::print(oss.str());
 }
 
 int PokerEnv::turnBBtoActionInt(float bbMultiplier) {
@@ -5128,7 +5068,7 @@ float PokerEnv::getCurrentPlayerInitialHandStrength() const {
 float PokerEnv::getCurrentPlayerHandPotential() const {
     if (currentPlayer >= 0 && currentPlayer < N_SEATS) {
         // 为了兼容性，返回equity_vs_all作为浮点数（归一化到0-1）
-        holdem_evaluation_t eval = _handPotentialCache[currentPlayer];
+        const holdem_evaluation_t& eval = _handPotentialFor(currentPlayer);
         return static_cast<float>(eval.equity_vs_all) / 10000.0f;
     }
     return 0.0f; // 无效玩家或超出范围
@@ -5140,93 +5080,151 @@ std::tuple<int, int> PokerEnv::getCurrentPlayerHandMultidimensional() const {
         return std::make_tuple(5000, 5000);
     }
 
-    // 直接从缓存中获取结果
-    holdem_evaluation_t eval = _handPotentialCache[currentPlayer];
+    // 从缓存中获取结果（首次读取时计算）
+    const holdem_evaluation_t& eval = _handPotentialFor(currentPlayer);
     return std::make_tuple(static_cast<int>(eval.equity_vs_all), static_cast<int>(eval.equity_vs_pair_sets));
 }
 
-void PokerEnv::_updateHandStrengthAndPotentialForCurrentPlayer() {
-    // 为了向后兼容，调用为所有玩家更新的函数，然后设置当前玩家的值
-    _updateHandPotentialForAllPlayers();
+// 当前玩家之外的每个未弃牌座位都按均匀范围处理（环境不跟踪对手的范围），
+// 在当前公共牌上计算 playerId 的真实权益。观察构建时可以用较小的采样预算调用。
+EquityEngine::Result PokerEnv::computePlayerEquity(int playerId, const EquityEngine::Options& options) const {
+    EquityEngine::Result result;
+    if (playerId < 0 || playerId >= N_SEATS || !players[playerId] || players[playerId]->hand.size() < 2 ||
+        !players[playerId]->hand[0] || !players[playerId]->hand[1]) {
+        return result; // 无效玩家：权益为0
+    }
+    POKER_PERF_SCOPE(PokerPerf::Timer::Equity);
+
+    const CardId hole[N_HOLE_CARDS] = {cardIdOf(players[playerId]->hand[0]), cardIdOf(players[playerId]->hand[1])};
+    CardId board[N_COMMUNITY_CARDS];
+    int n_board = 0;
+    for (const Card* card : communityCards) {
+        if (card != nullptr && n_board < N_COMMUNITY_CARDS) board[n_board++] = cardIdOf(card);
+    }
+
+    std::vector<EquityEngine::RangeWeights> ranges;
+    for (int i = 0; i < N_SEATS; ++i) {
+        if (i != playerId && players[i] && !players[i]->folded) ranges.push_back(EquityEngine::uniformRange());
+    }
+    if (ranges.empty()) {
+        // 没有对手：底池归该玩家
+        result.equity = 1.0;
+        result.exhaustive = true;
+        return result;
+    }
+    return EquityEngine::compute(hole, board, n_board, ranges, options);
+}
 
-    // 更新当前玩家的手牌潜力（已经在_updateHandPotentialForAllPlayers中计算）
+void PokerEnv::_updateHandStrengthAndPotentialForCurrentPlayer() {
+    // 为了向后兼容：手牌潜力按需计算，这里只读取当前玩家的值
     if (currentPlayer >= 0 && currentPlayer < N_SEATS) {
         // 为了兼容性，将多维度评估转换为单一浮点值
-        holdem_evaluation_t eval = _handPotentialCache[currentPlayer];
+        const holdem_evaluation_t& eval = _handPotentialFor(currentPlayer);
         _currentPlayerHandPotential = static_cast<float>(eval.equity_vs_all) / 10000.0f;
     } else {
         _currentPlayerHandPotential = 0.0f;
     }
 }
 
-void PokerEnv::_updateHandPotentialForAllPlayers() {
-    for (int playerId = 0; playerId < N_SEATS; ++playerId) {
-        // 初始化默认值（全0）
-        holdem_evaluation_t default_eval = {0, 0};
+// 手牌潜力按座位惰性计算：发牌或加载状态后只打上脏标记，
+// 第一次读取某个座位时才评估。实际只会读到行动中的玩家，
+// 所以弃牌和全下的座位不会被评估。
+void PokerEnv::_invalidateHandPotentials() {
+    if (static_cast<int>(_handPotentialCache.size()) != N_SEATS) {
+        _handPotentialCache.assign(N_SEATS, {0, 0});
+    }
+    _handPotentialDirty = N_SEATS >= Showdown::MAX_SEATS ? ~Showdown::SeatMask{0}
+                                                         : Showdown::seatBit(N_SEATS) - 1;
+}
 
-        if (!players[playerId] || players[playerId]->hand.size() < 2 ||
-            !players[playerId]->hand[0] || !players[playerId]->hand[1]) {
-            // 无效玩家或手牌不完整，设置为默认值
-            _handPotentialCache[playerId] = default_eval;
-            continue;
-        }
+const holdem_evaluation_t& PokerEnv::_handPotentialFor(int playerId) const {
+    if (_handPotentialDirty & Showdown::seatBit(playerId)) {
+        POKER_PERF_COUNT(PokerPerf::Counter::HandPotentialMiss);
+        POKER_PERF_SCOPE(PokerPerf::Timer::Equity);
+        _handPotentialCache[playerId] = _computeHandPotential(playerId);
+        _handPotentialDirty &= ~Showdown::seatBit(playerId);
+    } else {
+        POKER_PERF_COUNT(PokerPerf::Counter::HandPotentialHit);
+    }
+    return _handPotentialCache[playerId];
+}
 
-        if (currentRound == PREFLOP) {
-            // 翻牌前设置基线值（约50%胜率）
-            holdem_evaluation_t preflop_baseline = {0, 0}; // 50% in 0-10000 scale
-            _handPotentialCache[playerId] = preflop_baseline;
-        } else {
-            // 翻牌后计算多维度评估
-            if (communityCards.size() > 0) {
-                try {
-                    // 构建卡牌数组：底牌 + 公共牌
-                    std::vector<int> cards;
-
-                    // 添加底牌
-                    const Card* card1 = players[playerId]->hand[0];
-                    const Card* card2 = players[playerId]->hand[1];
-                    cards.push_back(Card::card2int(*card1));
-                    cards.push_back(Card::card2int(*card2));
-
-                    // 添加公共牌
-                    for (const Card* card : communityCards) {
-                        if (card != nullptr) {
-                            cards.push_back(Card::card2int(*card));
-                        }
-                    }
+holdem_evaluation_t PokerEnv::_computeHandPotential(int playerId) const {
+    if (!players[playerId] || players[playerId]->hand.size() < 2 ||
+        !players[playerId]->hand[0] || !players[playerId]->hand[1]) {
+        // 无效玩家或手牌不完整，使用默认值（全0）
+        return {0, 0};
+    }
 
-                    // 使用多维度评估函数
-                    holdem_evaluation_t evaluation = evaluate_holdem_multidimensional(cards.data(), cards.size());
+    if (currentRound == PREFLOP) {
+        // 翻牌前设置基线值
+        return {0, 0};
+    }
 
-                    // 验证结果有效性
-                    if (evaluation.equity_vs_all > 10000 || evaluation.equity_vs_pair_sets > 10000) {
-                        // 如果结果异常，使用基线值
-                        holdem_evaluation_t baseline = {5000, 5000};
-                        _handPotentialCache[playerId] = baseline;
-                    } else {
-                        _handPotentialCache[playerId] = evaluation;
-                    }
+    // 翻牌后计算多维度评估
+    if (communityCards.empty()) {
+        // 无公共牌时使用基线值
+        return {5000, 5000};
+    }
 
-#ifdef DEBUG_POKER_ENV
-                    std::cout << "Player " << playerId << " multi-dimensional evaluation: "
-                              << "vs_all=" << evaluation.equity_vs_all
-                              << ", vs_pair_sets=" << evaluation.equity_vs_pair_sets << std::endl;
-#endif
-                } catch (const std::exception& e) {
-                    // 异常情况使用基线值
-                    holdem_evaluation_t baseline = {5000, 5000};
-                    _handPotentialCache[playerId] = baseline;
-#ifdef DEBUG_POKER_ENV
-                    std::cout << "Exception in multi-dimensional evaluation for player " << playerId
-                              << ": " << e.what() << std::endl;
-#endif
-                }
-            } else {
-                // 无公共牌时使用基线值
-                holdem_evaluation_t baseline = {5000, 5000};
-                _handPotentialCache[playerId] = baseline;
+    try {
+        const CardId hole[N_HOLE_CARDS] = {cardIdOf(players[playerId]->hand[0]),
+                                           cardIdOf(players[playerId]->hand[1])};
+        CardId board[N_COMMUNITY_CARDS];
+        int n_board = 0;
+        for (const Card* card : communityCards) {
+            if (card != nullptr && n_board < N_COMMUNITY_CARDS) {
+                board[n_board++] = cardIdOf(card);
             }
         }
+
+        // 翻牌/转牌优先查离线生成的权益表（mmap，只读共享）
+        EquityTable::Entry tableEntry;
+        const EquityTable::Table* equityTable = EquityTable::shared();
+        if (equityTable && equityTable->find(hole, board, n_board, tableEntry)) {
+            POKER_PERF_COUNT(PokerPerf::Counter::EquityTableHit);
+            if (tableEntry.equityVsAll == EquityTable::INVALID_EQUITY) {
+                return {5000, 5000};
+            }
+            return {tableEntry.equityVsAll, tableEntry.equityVsPairSets};
+        }
+        if (equityTable) POKER_PERF_COUNT(PokerPerf::Counter::EquityTableMiss);
+
+        // 再查共享的花色同构缓存
+        EquityCache& equityCache = EquityCache::shared();
+        const EquityCache::Key key = EquityCache::makeKey(hole, N_HOLE_CARDS, board, n_board);
+        EquityCache::Value cached;
+        if (equityCache.find(key, cached)) {
+            POKER_PERF_COUNT(PokerPerf::Counter::EquityCacheHit);
+            return {cached.equityVsAll, cached.equityVsPairSets};
+        }
+        POKER_PERF_COUNT(PokerPerf::Counter::EquityCacheMiss);
+
+        // 构建卡牌数组：底牌 + 公共牌（定长数组，不分配堆内存）
+        int cards[N_HOLE_CARDS + N_COMMUNITY_CARDS];
+        int n_cards = 0;
+        for (CardId id : hole) cards[n_cards++] = card2intById(id);
+        for (int i = 0; i < n_board; ++i) cards[n_cards++] = card2intById(board[i]);
+
+        // 使用多维度评估函数
+        holdem_evaluation_t evaluation = evaluate_holdem_multidimensional(cards, n_cards);
+
+        POKER_LOG_DEBUG("Player " << playerId << " multi-dimensional evaluation: "
+                        << "vs_all=" << evaluation.equity_vs_all
+                        << ", vs_pair_sets=" << evaluation.equity_vs_pair_sets);
+
+        // 验证结果有效性，异常时使用基线值
+        if (evaluation.equity_vs_all > 10000 || evaluation.equity_vs_pair_sets > 10000) {
+            evaluation = {5000, 5000};
+        }
+        equityCache.insert(key, {static_cast<int32_t>(evaluation.equity_vs_all),
+                                 static_cast<int32_t>(evaluation.equity_vs_pair_sets)});
+        return evaluation;
+    } catch (const std::exception& e) {
+        // 异常情况使用基线值
+        POKER_LOG_DEBUG("Exception in multi-dimensional evaluation for player " << playerId
+                        << ": " << e.what());
+        return {5000, 5000};
     }
 }
 
@@ -5254,8 +5252,7 @@ void PokerEnv::_updatePrivateInfo(int player_id) {
     // } else {
     //     info.hand_strength = 0.0f;
     // }
-    int handRank = getHandValuebyPlayer(player_id);
-    info.hand_strength = static_cast<float>(170 - handRank) / 169.0f;
+    info.hand_strength = preflopStrengthOf(players[player_id]);
 
     // 标记为有效
     info.is_valid = (info.range_idx >= 0);
@@ -5266,63 +5263,53 @@ std::vector<float> PokerEnv::_getPrivateObservation(int player_id) {
         return std::vector<float>(4, 0.0f); // 返回空的私有信息
     }
 
-    // 更新私有信息
+    // 更新私有信息（cached_private_info 含手牌字符串）
     _updatePrivateInfo(player_id);
 
-    // 返回向量化的私有信息
-    return cached_private_info[player_id].toVector();
+    // 返回向量化的私有信息：与 getAllPlayersPrivateInfo_py 同一块缓存行
+    const size_t privateDim = ObservationLayout::PRIVATE_INFO_DIM;
+    const float* row = _privateInfoBlock() + static_cast<size_t>(player_id) * privateDim;
+    return std::vector<float>(row, row + privateDim);
 }
 
 std::vector<std::vector<float>> PokerEnv::_calculateCurrentObservationWithPrivateInfo() {
-        std::vector<std::vector<float>> all_observations;
-
-    // 获取基础观察向量（公共信息）
-    std::vector<float> base_obs = _calculateCurrentObservationSimplified();
-
-
-
-    // 为每个玩家生成包含私有信息的观察向量
+    const size_t publicDim = ObservationLayout::simplifiedDim(N_SEATS, N_ACTIONS, actionHistory.size());
+    const size_t privateDim = ObservationLayout::PRIVATE_INFO_DIM;
+    std::vector<std::vector<float>> all_observations(N_SEATS);
+
+    // 公共部分只算一次，每个座位复制后（debug_obs_flag 时）追加该座位的私有信息
+    std::vector<float> base_obs(publicDim);
+    _writeCurrentObservationSimplified(base_obs.data());
+    const float* privateBlock = debug_obs_flag ? _privateInfoBlock() : nullptr;
     for (int i = 0; i < N_SEATS; i++) {
-        std::vector<float> player_obs = base_obs;  // 复制基础观察向量
-
-        // 如果debug_obs_flag为true，添加该玩家的私有信息
-        if (debug_obs_flag && players[i]) {
-            std::vector<float> private_info = _getPrivateObservation(i);
-            // 将私有信息添加到观察向量末尾
-            player_obs.insert(player_obs.end(), private_info.begin(), private_info.end());
+        std::vector<float>& player_obs = all_observations[i];
+        const bool withPrivate = privateBlock && players[i];
+        player_obs.reserve(publicDim + (withPrivate ? privateDim : 0));
+        player_obs.assign(base_obs.begin(), base_obs.end());
+        if (withPrivate) {
+            const float* row = privateBlock + static_cast<size_t>(i) * privateDim;
+            player_obs.insert(player_obs.end(), row, row + privateDim);
         }
-
-        all_observations.push_back(player_obs);
-
     }
-
     return all_observations;
 }
 
-// Python接口方法：获取包含私有信息的观察向量（所有玩家）
+// Python接口方法：获取包含私有信息的观察向量（所有玩家，总是附带私有信息）
 std::vector<std::vector<float>> PokerEnv::getObservationWithPrivateInfo_py() {
-    std::vector<std::vector<float>> all_observations;
+    const size_t publicDim = ObservationLayout::simplifiedDim(N_SEATS, N_ACTIONS, actionHistory.size());
+    const size_t privateDim = ObservationLayout::PRIVATE_INFO_DIM;
+    std::vector<std::vector<float>> all_observations(N_SEATS);
 
-    // 获取基础观察向量（公共信息）
-    std::vector<float> base_obs = _calculateCurrentObservationSimplified();
-
-    // 为每个玩家生成包含私有信息的观察向量
+    std::vector<float> base_obs(publicDim);
+    _writeCurrentObservationSimplified(base_obs.data());
+    const float* privateBlock = _privateInfoBlock();
     for (int i = 0; i < N_SEATS; i++) {
-        std::vector<float> player_obs = base_obs;  // 复制基础观察向量
-
-        // 总是添加该玩家的私有信息（不依赖debug_obs_flag）
-        if (players[i]) {
-            std::vector<float> private_info = _getPrivateObservation(i);
-            // 将私有信息添加到观察向量末尾
-            player_obs.insert(player_obs.end(), private_info.begin(), private_info.end());
-        } else {
-            // 如果玩家不存在，添加空的私有信息
-            player_obs.insert(player_obs.end(), 4, 0.0f);
-        }
-
-        all_observations.push_back(player_obs);
+        std::vector<float>& player_obs = all_observations[i];
+        player_obs.reserve(publicDim + privateDim);
+        player_obs.assign(base_obs.begin(), base_obs.end());
+        const float* row = privateBlock + static_cast<size_t>(i) * privateDim;
+        player_obs.insert(player_obs.end(), row, row + privateDim);
     }
-
     return all_observations;
 }
 
@@ -5346,147 +5333,270 @@ std::vector<std::string> PokerEnv::getAllPlayersHandStrings_py() {
 
 // Python接口方法：获取所有玩家的私有信息
 std::vector<std::vector<float>> PokerEnv::getAllPlayersPrivateInfo_py() {
+    const size_t privateDim = ObservationLayout::PRIVATE_INFO_DIM;
+    const float* privateBlock = _privateInfoBlock();
     std::vector<std::vector<float>> all_private_info;
-
+    all_private_info.reserve(N_SEATS);
     for (int i = 0; i < N_SEATS; i++) {
-        // 更新该玩家的私有信息
-        _updatePrivateInfo(i);
-
-        // 获取该玩家的私有信息
-        std::vector<float> player_private_info = _getPrivateObservation(i);
-        all_private_info.push_back(player_private_info);
+        const float* row = privateBlock + static_cast<size_t>(i) * privateDim;
+        all_private_info.emplace_back(row, row + privateDim);
     }
-
     return all_private_info;
 }
 
-// 新增：为Transformer返回分离的观察数据
-std::tuple<std::vector<std::vector<float>>, std::vector<float>> PokerEnv::getObservationForTransformer() {
-    // === 1. Prepare the State Vector (Fixed-size features) ===
-    std::vector<float> state_features;
+// ================================
+// Private info block
+// ================================
+// PrivateInfo::toVector() of every seat as one [N_SEATS x PRIVATE_INFO_DIM]
+// block (ObservationLayout.h). It depends only on the hole cards and the
+// board: range_idx is the 169-class index preflop and afterwards the index of
+// the suit-canonical cards, whose suit map _getCanonicalSuitMap_static derives
+// from the board (see getRangeIdx). So a seat's row is rebuilt only when its
+// hole cards or the board changed since it was last built: once per seat and
+// street instead of on every request, and without building hand strings.
+// Seats without a player get zeros. Every reader of the private vector
+// (_getPrivateObservation included) goes through this block, so none of
+// them can see a stale row.
+
+// Board part of the cache key: the dealt board cards (they fix the canonical
+// suit map) plus whether range_idx uses the preflop encoding.
+uint64_t PokerEnv::_privateInfoBoardKey() const {
+    uint64_t key = 0;
+    int nBoard = 0;
+    for (const Card* c : communityCards) {
+        key = (key << 8) | (c ? static_cast<uint64_t>(cardIdOf(c)) + 1 : 0);
+        if (c) ++nBoard;
+    }
+    const bool preflopEncoding = nBoard == 0 || (end_with_round == 0 && currentRound == PREFLOP);
+    return (key << 1) | (preflopEncoding ? 1u : 0u);
+}
 
-    // 计算状态特征大小
-    int stateFeatureSize = N_SEATS + N_SEATS + 1 + 1; // 当前玩家位置 + 筹码量 + 有效筹码比例 + 未行动玩家比例
-    state_features.reserve(stateFeatureSize);
+// Hole-card part, per seat; values past 0xFFFF never match a computed row.
+uint32_t PokerEnv::_privateInfoSeatKey(int seat) const {
+    const PokerPlayer* p = players[seat];
+    if (!p) return 0x10000u;
+    if (p->hand.size() < 2 || !p->hand[0] || !p->hand[1]) return 0x10001u;
+    return (static_cast<uint32_t>(cardIdOf(p->hand[0])) << 8) | cardIdOf(p->hand[1]);
+}
 
-    // 1. 当前玩家位置 (N_SEATS个位置，one-hot编码)
-    std::vector<float> currentPlayerPos(N_SEATS, 0.0f);
-    if (currentPlayer >= 0 && currentPlayer < N_SEATS) {
-        // 计算当前玩家相对于按钮的位置
-        int relativePos = (currentPlayer - buttonPos + N_SEATS) % N_SEATS;
-        if (relativePos >= 0 && relativePos < N_SEATS) {
-            currentPlayerPos[relativePos] = 1.0f;
-        }
+const float* PokerEnv::_privateInfoBlock() {
+    const size_t privateDim = ObservationLayout::PRIVATE_INFO_DIM;
+    if (m_privateInfoRows.size() != static_cast<size_t>(N_SEATS) * privateDim) {
+        m_privateInfoRows.assign(static_cast<size_t>(N_SEATS) * privateDim, 0.0f);
+        m_privateInfoSeatKeys.assign(N_SEATS, PRIVATE_INFO_STALE);
     }
-    state_features.insert(state_features.end(), currentPlayerPos.begin(), currentPlayerPos.end());
-
-    // 2. 每个玩家的筹码量（相对于初始筹码量）
-    std::vector<float> stackSizes(N_SEATS, 0.0f);
-    for (int i = 0; i < N_SEATS; i++) {
-        if (players[i] && DEFAULT_STACK_SIZE > 0) {
-            // 计算当前总筹码量（包括已下注的筹码）
-            int totalChips = players[i]->stack + players[i]->currentBet;
-            stackSizes[i] = static_cast<float>(totalChips) / static_cast<float>(DEFAULT_STACK_SIZE);
-        }
+    const uint64_t boardKey = _privateInfoBoardKey();
+    if (boardKey != m_privateInfoBoardKey) {
+        std::fill(m_privateInfoSeatKeys.begin(), m_privateInfoSeatKeys.end(), PRIVATE_INFO_STALE);
+        m_privateInfoBoardKey = boardKey;
     }
-    state_features.insert(state_features.end(), stackSizes.begin(), stackSizes.end());
 
-    // 3. 有效筹码量与当前底池的比例
-    float effectiveStackToPotRatio = 0.0f;
-    if (currentPlayer >= 0 && currentPlayer < N_SEATS && players[currentPlayer]) {
-        // 使用getPotSize()方法获取当前底池大小，确保一致性
-        int currentPot = getPotSize();
-        if (currentPot == 0) currentPot = BIG_BLIND; // 避免除零
-
-        // 计算有效筹码量：当前玩家与所有未弃牌对手之间的最小筹码量
-        int currentPlayerTotalChips = players[currentPlayer]->stack + players[currentPlayer]->currentBet;
-        int effectiveStack = currentPlayerTotalChips;
-
-        // 找到最小对手筹码量
-        for (int i = 0; i < N_SEATS; i++) {
-            if (i != currentPlayer && players[i] && !players[i]->folded) {
-                int opponentTotalChips = players[i]->stack + players[i]->currentBet;
-                effectiveStack = std::min(effectiveStack, opponentTotalChips);
-            }
-        }
+    for (int i = 0; i < N_SEATS; ++i) {
+        const uint32_t seatKey = _privateInfoSeatKey(i);
+        if (seatKey == m_privateInfoSeatKeys[i]) continue;
+
+        float* row = m_privateInfoRows.data() + static_cast<size_t>(i) * privateDim;
+        if (!players[i]) {
+            std::fill(row, row + privateDim, 0.0f);
+        } else {
+            // 与 _updatePrivateInfo 相同的字段，只是不拼手牌字符串
+            PrivateInfo info;
+            info.range_idx = getRangeIdx(i);
+            info.hand_strength = preflopStrengthOf(players[i]);
+            info.is_valid = (info.range_idx >= 0);
+            const std::vector<float> values = info.toVector();
+            const size_t n = std::min(values.size(), privateDim);
+            std::copy(values.begin(), values.begin() + n, row);
+            std::fill(row + n, row + privateDim, 0.0f);
+        }
+        m_privateInfoSeatKeys[i] = seatKey;
+    }
+    return m_privateInfoRows.data();
+}
+
+// Shared public block (the simplified observation, observationSize-style
+// length for the current history) plus the private block, in one call.
+// Returns the number of floats written to publicDst.
+size_t PokerEnv::write_observation_with_private_info(float* publicDst, size_t publicCap,
+                                                     float* privateDst, size_t privateCap) {
+    const size_t publicDim = ObservationLayout::simplifiedDim(N_SEATS, N_ACTIONS, actionHistory.size());
+    const size_t privateDim = ObservationLayout::privateInfoDim(N_SEATS);
+    if (!publicDst || publicCap < publicDim) {
+        throw std::invalid_argument("write_observation_with_private_info: public buffer holds " +
+                                    std::to_string(publicCap) + " floats, observation needs " +
+                                    std::to_string(publicDim));
+    }
+    if (!privateDst || privateCap < privateDim) {
+        throw std::invalid_argument("write_observation_with_private_info: private buffer holds " +
+                                    std::to_string(privateCap) + " floats, private block needs " +
+                                    std::to_string(privateDim));
+    }
+    _writeCurrentObservationSimplified(publicDst);
+    const float* block = _privateInfoBlock();
+    std::copy(block, block + privateDim, privateDst);
+    return publicDim;
+}
 
-        effectiveStackToPotRatio = static_cast<float>(effectiveStack) / static_cast<float>(currentPot);
+size_t PokerEnv::write_private_info(float* dst, size_t cap) {
+    const size_t privateDim = ObservationLayout::privateInfoDim(N_SEATS);
+    if (!dst || cap < privateDim) {
+        throw std::invalid_argument("write_private_info: buffer holds " + std::to_string(cap) +
+                                    " floats, private block needs " + std::to_string(privateDim));
     }
-    state_features.push_back(effectiveStackToPotRatio);
+    const float* block = _privateInfoBlock();
+    std::copy(block, block + privateDim, dst);
+    return privateDim;
+}
 
-    // 4. 当前玩家之后还有多少人未行动
-    float playersToActRatio = 0.0f;
-    if (currentPlayer >= 0 && currentPlayer < N_SEATS) {
-        int playersToAct = 0;
+size_t PokerEnv::write_observation_with_private_info_py(uintptr_t publicAddress, size_t publicCap,
+                                                        uintptr_t privateAddress, size_t privateCap) {
+    return write_observation_with_private_info(reinterpret_cast<float*>(publicAddress), publicCap,
+                                               reinterpret_cast<float*>(privateAddress), privateCap);
+}
 
-        // 从当前玩家的下一个位置开始计算
-        for (int i = 1; i < N_SEATS; i++) {
-            int nextPlayerIdx = (currentPlayer + i) % N_SEATS;
-            if (players[nextPlayerIdx] && !players[nextPlayerIdx]->folded && !players[nextPlayerIdx]->isAllin) {
-                playersToAct++;
-            }
-        }
+size_t PokerEnv::write_private_info_py(uintptr_t address, size_t cap) {
+    return write_private_info(reinterpret_cast<float*>(address), cap);
+}
 
-        // 归一化：除以最大可能的未行动玩家数（N_SEATS - 1）
-        playersToActRatio = static_cast<float>(playersToAct) / static_cast<float>(N_SEATS - 1);
-    }
-    state_features.push_back(playersToActRatio);
+// 新增：为Transformer返回分离的观察数据
+std::tuple<std::vector<std::vector<float>>, std::vector<float>> PokerEnv::getObservationForTransformer() {
+    POKER_PERF_SCOPE(PokerPerf::Timer::TransformerObservation);
+    // === 1. Prepare the State Vector (Fixed-size features) ===
+    const int stateFeatureSize = static_cast<int>(ObservationLayout::stateDim(N_SEATS)); // 当前玩家位置 + 筹码量 + 有效筹码比例 + 未行动玩家比例
+    std::vector<float> state_features(stateFeatureSize);
+    _writeTransformerState(state_features.data());
 
     // === 2. Prepare the Sequence Data (Variable-length action history) ===
-    std::vector<std::vector<float>> sequence_features;
-    sequence_features.reserve(actionHistory.size());
-
-    const int actionFeatureSize = N_SEATS + N_ACTIONS + 1; // 玩家位置 + 固定动作向量 + 下注倍数
+    const int actionFeatureSize = static_cast<int>(ObservationLayout::rowDim(N_SEATS, N_ACTIONS)); // 玩家位置 + 固定动作向量 + 下注倍数
     ALL_FEATURE_SIZE = stateFeatureSize + actionFeatureSize;
 
+    std::vector<std::vector<float>> sequence_features;
+    sequence_features.reserve(actionHistory.size());
     for (const auto& record : actionHistory) {
-        // Create a feature vector for THIS action only
-        std::vector<float> single_action_feature_vector;
-        single_action_feature_vector.reserve(actionFeatureSize);
+        sequence_features.emplace_back(actionFeatureSize);
+        _writeActionRow(record, sequence_features.back().data());
+    }
 
-        // 玩家位置向量 (N_SEATS)
-        std::vector<float> playerPos(N_SEATS, 0.0f);
+    // === 3. Return both parts in a tuple ===
+    return std::make_tuple(std::move(sequence_features), std::move(state_features));
+}
 
-        // 固定大小的动作向量 (N_ACTIONS)
-        std::vector<float> actionTaken(N_ACTIONS, 0.0f);
+void PokerEnv::_writeTransformerState(float* dst) {
+    // 1-2. 当前玩家位置 (one-hot) + 每个玩家的筹码量（相对于初始筹码量）
+    _writeCurrentPlayerAndStacks(dst + ObservationLayout::stateCurrentPlayerOffset(N_SEATS));
 
-        // 下注倍数 (1)
-        float betMultiplier = 0.0f;
+    // 3. 有效筹码量与当前底池的比例
+    dst[ObservationLayout::stateEffectiveStackOffset(N_SEATS)] = _effectiveStackToPotRatio();
 
-        // 设置玩家位置（相对于按钮位置）
-        if (record.playerId >= 0 && record.playerId < N_SEATS) {
-            // 计算相对位置：button=0, sb=1, bb=2, utg=3, ...
-            int relativePos = (record.playerId - buttonPos + N_SEATS) % N_SEATS;
-            if (relativePos >= 0 && relativePos < N_SEATS) {
-                playerPos[relativePos] = 1.0f;
-            }
-        }
+    // 4. 当前玩家之后还有多少人未行动
+    // 归一化：除以最大可能的未行动玩家数（N_SEATS - 1）
+    dst[ObservationLayout::statePlayersToActOffset(N_SEATS)] = m_kernels->playersToActRatio(m_seats, currentPlayer);
+}
 
-        // 直接使用记录的actionInt，避免重新计算
-        int actionIndex = record.actionInt;
-        if (actionIndex >= 0 && actionIndex < N_ACTIONS) {
-            actionTaken[actionIndex] = 1.0f;
-        }
+// ================================
+// In-place observation writers
+// ================================
+// Same values as the vector-returning functions above, written into a caller
+// buffer of `cap` floats (layouts in ObservationLayout.h). A buffer that is too
+// small is rejected before anything is written.
 
-        // 统一的下注倍数计算：下注额 / 底池大小
-        if (record.betAmount > 0) {
-            int historicalPot = record.potAtActionTime > 0 ? record.potAtActionTime : BIG_BLIND;
-            // 对所有动作类型（跟注、加注）都使用相对于底池的比例
-            betMultiplier = static_cast<float>(record.betAmount) / static_cast<float>(historicalPot);
-        } else {
-            betMultiplier = 0.0f;
-        }
+size_t PokerEnv::observationSize() const {
+    if (use_simplified_observation) {
+        return ObservationLayout::simplifiedDim(N_SEATS, N_ACTIONS, actionHistory.size());
+    }
+    return ObservationLayout::fullDim(N_SEATS, N_ACTIONS);
+}
 
-        // 构建单个动作的特征向量
-        single_action_feature_vector.insert(single_action_feature_vector.end(), playerPos.begin(), playerPos.end());
-        single_action_feature_vector.insert(single_action_feature_vector.end(), actionTaken.begin(), actionTaken.end());
-        single_action_feature_vector.push_back(betMultiplier);
+size_t PokerEnv::write_observation(float* dst, size_t cap) {
+    const size_t needed = observationSize();
+    if (!dst || cap < needed) {
+        throw std::invalid_argument("write_observation: buffer holds " + std::to_string(cap) +
+                                    " floats, observation needs " + std::to_string(needed));
+    }
+    return use_simplified_observation ? _writeCurrentObservationSimplified(dst) : _writeCurrentObservation(dst);
+}
 
-        sequence_features.push_back(single_action_feature_vector);
+size_t PokerEnv::write_transformer_state(float* dst, size_t cap) {
+    const size_t needed = ObservationLayout::stateDim(N_SEATS);
+    if (!dst || cap < needed) {
+        throw std::invalid_argument("write_transformer_state: buffer holds " + std::to_string(cap) +
+                                    " floats, state needs " + std::to_string(needed));
     }
+    POKER_PERF_SCOPE(PokerPerf::Timer::TransformerObservation);
+    _writeTransformerState(dst);
+    return needed;
+}
 
-    // === 3. Return both parts in a tuple ===
-    return std::make_tuple(sequence_features, state_features);
+// Writes the most recent min(actionHistory.size(), cap / rowDim) action rows,
+// oldest first, and returns how many rows were written. The remainder of the
+// buffer is left untouched so a caller can keep its own padding.
+size_t PokerEnv::write_transformer_sequence(float* dst, size_t cap) const {
+    const size_t rowDim = ObservationLayout::rowDim(N_SEATS, N_ACTIONS);
+    if (!dst && cap > 0) {
+        throw std::invalid_argument("write_transformer_sequence: null buffer");
+    }
+    POKER_PERF_SCOPE(PokerPerf::Timer::TransformerObservation);
+    const size_t nRows = std::min(actionHistory.size(), cap / rowDim);
+    const size_t first = actionHistory.size() - nRows;
+    m_kernels->actionRows(actionHistory.data() + first, nRows, N_SEATS, N_ACTIONS, buttonPos, BIG_BLIND, dst);
+    return nRows;
+}
+
+// --- Python entry points ---
+// `address` is the data pointer of a writable, C-contiguous float32 buffer
+// (numpy: arr.ctypes.data, torch: t.data_ptr()) and `cap` its element count.
+size_t PokerEnv::write_observation_py(uintptr_t address, size_t cap) {
+    return write_observation(reinterpret_cast<float*>(address), cap);
+}
+
+bool PokerEnv::step_core_py(int actionInt, uintptr_t address, size_t cap) {
+    return step_core(actionInt, reinterpret_cast<float*>(address), cap);
+}
+
+size_t PokerEnv::write_transformer_state_py(uintptr_t address, size_t cap) {
+    return write_transformer_state(reinterpret_cast<float*>(address), cap);
+}
+
+size_t PokerEnv::write_transformer_sequence_py(uintptr_t address, size_t cap) const {
+    return write_transformer_sequence(reinterpret_cast<float*>(address), cap);
+}
+
+std::map<std::string, int> PokerEnv::getObservationLayout_py() const {
+    using namespace ObservationLayout;
+    const int n = N_SEATS;
+    const int a = N_ACTIONS;
+    return {
+        {"state_dim", static_cast<int>(stateDim(n))},
+        {"state_current_player", static_cast<int>(stateCurrentPlayerOffset(n))},
+        {"state_stacks", static_cast<int>(stateStacksOffset(n))},
+        {"state_effective_stack", static_cast<int>(stateEffectiveStackOffset(n))},
+        {"state_players_to_act", static_cast<int>(statePlayersToActOffset(n))},
+        {"row_dim", static_cast<int>(rowDim(n, a))},
+        {"row_player", static_cast<int>(rowPlayerOffset(n, a))},
+        {"row_action", static_cast<int>(rowActionOffset(n, a))},
+        {"row_bet", static_cast<int>(rowBetOffset(n, a))},
+        {"full_dim", static_cast<int>(fullDim(n, a))},
+        {"full_table", static_cast<int>(fullTableOffset(n))},
+        {"full_last_action_type", static_cast<int>(fullLastActionTypeOffset(n))},
+        {"full_last_actor", static_cast<int>(fullLastActorOffset(n))},
+        {"full_current_player", static_cast<int>(fullCurrentPlayerOffset(n))},
+        {"full_round", static_cast<int>(fullRoundOffset(n))},
+        {"full_button", static_cast<int>(fullButtonOffset(n))},
+        {"full_counts", static_cast<int>(fullCountsOffset(n))},
+        {"full_side_pots", static_cast<int>(fullSidePotsOffset(n))},
+        {"full_players", static_cast<int>(fullPlayersOffset(n))},
+        {"full_player_block_dim", static_cast<int>(fullPlayerBlockDim(n))},
+        {"full_board", static_cast<int>(fullBoardOffset(n))},
+        {"full_raise_amounts", static_cast<int>(fullRaiseAmountsOffset(n))},
+        {"full_advanced", static_cast<int>(fullAdvancedOffset(n, a))},
+        {"simple_current_player", static_cast<int>(simpleCurrentPlayerOffset(n))},
+        {"simple_stacks", static_cast<int>(simpleStacksOffset(n))},
+        {"simple_effective_stack", static_cast<int>(simpleEffectiveStackOffset(n))},
+        {"simple_history_length", static_cast<int>(simpleHistoryLengthOffset(n))},
+        {"simple_rows", static_cast<int>(simpleRowsOffset(n))},
+        {"private_info_dim", static_cast<int>(PRIVATE_INFO_DIM)},
+        {"private_block_dim", static_cast<int>(privateInfoDim(n))},
+    };
 }
 
 // ActionRecord的toString方法实现
@@ -0,0 +1,169 @@
+#include "PokerLog.h"
+
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+namespace PokerLog {
+
+namespace detail {
+#ifdef DEBUG_POKER_ENV
+std::atomic<int> runtimeLevel{static_cast<int>(Level::Trace)};
+#else
+std::atomic<int> runtimeLevel{static_cast<int>(Level::Warn)};
+#endif
+} // namespace detail
+
+namespace {
+
+std::atomic<int> rateLimitValue{DEFAULT_RATE_LIMIT};
+std::atomic<bool> bufferedValue{false};
+
+std::FILE* streamFor(Level level) { return level >= Level::Warn ? stderr : stdout; }
+
+void writeRaw(std::FILE* file, const std::string& text) {
+    if (!text.empty()) std::fwrite(text.data(), 1, text.size(), file);
+}
+
+// Lines of one thread waiting to be written; no locking, only this thread
+// touches them.
+struct ThreadBuffers {
+    std::string out;
+    std::string err;
+
+    void flush() {
+        writeRaw(stdout, out);
+        writeRaw(stderr, err);
+        out.clear();
+        err.clear();
+    }
+    ~ThreadBuffers() { flush(); }
+};
+
+ThreadBuffers& threadBuffers() {
+    thread_local ThreadBuffers buffers;
+    return buffers;
+}
+
+thread_local std::ostringstream lineStream;
+thread_local bool lineStreamBusy = false;
+
+// Applies POKER_LOG_LEVEL once, before main.
+[[maybe_unused]] const bool envLevelApplied = [] {
+    if (const char* name = std::getenv("POKER_LOG_LEVEL")) setLevel(std::string_view(name));
+    return true;
+}();
+
+} // namespace
+
+void setLevel(Level level) { detail::runtimeLevel.store(static_cast<int>(level), std::memory_order_relaxed); }
+
+Level level() { return static_cast<Level>(detail::runtimeLevel.load(std::memory_order_relaxed)); }
+
+bool setLevel(std::string_view name) {
+    std::string lower(name);
+    for (char& c : lower) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    if (lower == "trace") setLevel(Level::Trace);
+    else if (lower == "debug") setLevel(Level::Debug);
+    else if (lower == "info") setLevel(Level::Info);
+    else if (lower == "warn" || lower == "warning") setLevel(Level::Warn);
+    else if (lower == "error") setLevel(Level::Error);
+    else if (lower == "off") setLevel(Level::Off);
+    else return false;
+    return true;
+}
+
+const char* levelName(Level level) {
+    switch (level) {
+        case Level::Trace: return "trace";
+        case Level::Debug: return "debug";
+        case Level::Info: return "info";
+        case Level::Warn: return "warn";
+        case Level::Error: return "error";
+        case Level::Off: return "off";
+    }
+    return "unknown";
+}
+
+void setRateLimit(int linesPerSecond) { rateLimitValue.store(linesPerSecond, std::memory_order_relaxed); }
+
+int rateLimit() { return rateLimitValue.load(std::memory_order_relaxed); }
+
+void setThreadBuffered(bool buffered) { bufferedValue.store(buffered, std::memory_order_relaxed); }
+
+bool threadBuffered() { return bufferedValue.load(std::memory_order_relaxed); }
+
+void flushThread() { threadBuffers().flush(); }
+
+void write(Level level, std::string_view line) {
+    if (threadBuffered()) {
+        ThreadBuffers& buffers = threadBuffers();
+        std::string& buffer = level >= Level::Warn ? buffers.err : buffers.out;
+        buffer.append(line.data(), line.size());
+        buffer.push_back('\n');
+        if (buffer.size() >= THREAD_BUFFER_BYTES) {
+            writeRaw(streamFor(level), buffer);
+            buffer.clear();
+        }
+        return;
+    }
+    // One fwrite per line: stdio locks the stream once and lines from
+    // different threads never interleave.
+    thread_local std::string scratch;
+    scratch.assign(line.data(), line.size());
+    scratch.push_back('\n');
+    writeRaw(streamFor(level), scratch);
+}
+
+void print(std::string_view text) {
+    if (threadBuffered()) threadBuffers().flush(); // keep dumps after earlier lines
+    std::fwrite(text.data(), 1, text.size(), stdout);
+    std::fflush(stdout);
+}
+
+// Approximate under contention (a window reset can race with a few
+// increments), which only moves the cut-off by a line or two.
+bool RateLimit::allow(uint32_t& suppressed) {
+    const int limit = rateLimit();
+    if (limit > 0) {
+        const int64_t now = std::chrono::duration_cast<std::chrono::seconds>(
+                                std::chrono::steady_clock::now().time_since_epoch())
+                                .count();
+        int64_t start = windowStart_.load(std::memory_order_relaxed);
+        if (now != start && windowStart_.compare_exchange_strong(start, now, std::memory_order_relaxed)) {
+            inWindow_.store(0, std::memory_order_relaxed);
+        }
+        if (inWindow_.fetch_add(1, std::memory_order_relaxed) >= static_cast<uint32_t>(limit)) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+    }
+    suppressed = dropped_.exchange(0, std::memory_order_relaxed);
+    return true;
+}
+
+Line::Line(Level level, uint32_t suppressed) : level_(level), suppressed_(suppressed) {
+    if (!lineStreamBusy) {
+        lineStreamBusy = true;
+        lineStream.str(std::string());
+        lineStream.clear();
+        stream_ = &lineStream;
+        ownsStream_ = false;
+    } else {
+        stream_ = new std::ostringstream;
+        ownsStream_ = true;
+    }
+}
+
+Line::~Line() {
+    if (suppressed_ > 0) *stream_ << " [" << suppressed_ << " similar lines suppressed]";
+    write(level_, stream_->str());
+    if (ownsStream_) {
+        delete stream_;
+    } else {
+        lineStreamBusy = false;
+    }
+}
+
+} // namespace PokerLog
@@ -0,0 +1,172 @@
+#ifndef POKER_LOG_H
+#define POKER_LOG_H
+
+#include <atomic>
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <string_view>
+
+// ================================
+// Logging
+// ================================
+// Silent by default. Lines below POKER_LOG_COMPILE_LEVEL are compiled out
+// entirely (the streamed expression is not even evaluated); the rest are
+// filtered at runtime by PokerLog::setLevel (default Warn, or the
+// POKER_LOG_LEVEL environment variable: trace/debug/info/warn/error/off).
+//
+//     POKER_LOG_DEBUG("[DEBUG step] action " << action << " pot " << pot);
+//
+// Every call site is rate limited (setRateLimit lines per second, 0 for no
+// limit); the first line let through after a burst notes how many were
+// dropped. Lines go to stdout (Info and below) or stderr (Warn, Error), one
+// write per line, never flushed per line. With setThreadBuffered(true) each
+// thread appends to its own buffer without locking and writes it out when it
+// fills, on flushThread(), or when the thread exits.
+//
+// Defining DEBUG_POKER_ENV lowers both the compile-time threshold and the
+// default runtime level to Trace, so debug builds keep all of their output.
+namespace PokerLog {
+
+enum class Level : int {
+    Trace = 0,
+    Debug = 1,
+    Info = 2,
+    Warn = 3,
+    Error = 4,
+    Off = 5,
+};
+
+#define POKER_LOG_LEVEL_TRACE 0
+#define POKER_LOG_LEVEL_DEBUG 1
+#define POKER_LOG_LEVEL_INFO 2
+#define POKER_LOG_LEVEL_WARN 3
+#define POKER_LOG_LEVEL_ERROR 4
+#define POKER_LOG_LEVEL_OFF 5
+
+#ifndef POKER_LOG_COMPILE_LEVEL
+#ifdef DEBUG_POKER_ENV
+#define POKER_LOG_COMPILE_LEVEL POKER_LOG_LEVEL_TRACE
+#else
+#define POKER_LOG_COMPILE_LEVEL POKER_LOG_LEVEL_INFO
+#endif
+#endif
+
+constexpr int DEFAULT_RATE_LIMIT = 100;          // lines per second per call site
+constexpr size_t THREAD_BUFFER_BYTES = 64 * 1024; // flush threshold of a thread buffer
+
+namespace detail {
+extern std::atomic<int> runtimeLevel;
+} // namespace detail
+
+inline bool enabled(Level level) {
+    return static_cast<int>(level) >= detail::runtimeLevel.load(std::memory_order_relaxed);
+}
+
+void setLevel(Level level);
+Level level();
+// "trace", "debug", "info", "warn"/"warning", "error", "off" (any case);
+// false and no change for anything else.
+bool setLevel(std::string_view name);
+const char* levelName(Level level);
+
+void setRateLimit(int linesPerSecond);
+int rateLimit();
+
+void setThreadBuffered(bool buffered);
+bool threadBuffered();
+// Writes out the calling thread's buffered lines.
+void flushThread();
+
+// Writes a finished line (no trailing newline) to the sink.
+void write(Level level, std::string_view line);
+// Explicit dumps (printState and friends): always written, to stdout.
+void print(std::string_view text);
+
+// Per call site, 1-second windows.
+class RateLimit {
+public:
+    // True if this line may be written; suppressed is set to the number of
+    // lines dropped since the last one that was.
+    bool allow(uint32_t& suppressed);
+
+private:
+    std::atomic<int64_t> windowStart_{0};
+    std::atomic<uint32_t> inWindow_{0};
+    std::atomic<uint32_t> dropped_{0};
+};
+
+// Collects one line in a reused per-thread stream, written on destruction.
+class Line {
+public:
+    Line(Level level, uint32_t suppressed);
+    ~Line();
+    Line(const Line&) = delete;
+    Line& operator=(const Line&) = delete;
+
+    std::ostream& stream() { return *stream_; }
+
+private:
+    Level level_;
+    uint32_t suppressed_;
+    std::ostringstream* stream_;
+    bool ownsStream_; // nested line (logging while formatting a line)
+};
+
+} // namespace PokerLog
+
+#define POKER_LOG_AT(level, expr)                                                  \
+    do {                                                                           \
+        if (::PokerLog::enabled(level)) {                                          \
+            static ::PokerLog::RateLimit pokerLogRate_;                            \
+            uint32_t pokerLogSuppressed_ = 0;                                      \
+            if (pokerLogRate_.allow(pokerLogSuppressed_)) {                        \
+                ::PokerLog::Line pokerLogLine_((level), pokerLogSuppressed_);      \
+                pokerLogLine_.stream() << expr;                                    \
+            }                                                                      \
+        }                                                                          \
+    } while (0)
+
+#define POKER_LOG_DISABLED(expr) \
+    do {                         \
+    } while (0)
+
+#if POKER_LOG_COMPILE_LEVEL <= POKER_LOG_LEVEL_TRACE
+#define POKER_LOG_TRACE(expr) POKER_LOG_AT(::PokerLog::Level::Trace, expr)
+#else
+#define POKER_LOG_TRACE(expr) POKER_LOG_DISABLED(expr)
+#endif
+
+#if POKER_LOG_COMPILE_LEVEL <= POKER_LOG_LEVEL_DEBUG
+#define POKER_LOG_DEBUG(expr) POKER_LOG_AT(::PokerLog::Level::Debug, expr)
+#else
+#define POKER_LOG_DEBUG(expr) POKER_LOG_DISABLED(expr)
+#endif
+
+#if POKER_LOG_COMPILE_LEVEL <= POKER_LOG_LEVEL_INFO
+#define POKER_LOG_INFO(expr) POKER_LOG_AT(::PokerLog::Level::Info, expr)
+#else
+#define POKER_LOG_INFO(expr) POKER_LOG_DISABLED(expr)
+#endif
+
+#if POKER_LOG_COMPILE_LEVEL <= POKER_LOG_LEVEL_WARN
+#define POKER_LOG_WARN(expr) POKER_LOG_AT(::PokerLog::Level::Warn, expr)
+#else
+#define POKER_LOG_WARN(expr) POKER_LOG_DISABLED(expr)
+#endif
+
+#if POKER_LOG_COMPILE_LEVEL <= POKER_LOG_LEVEL_ERROR
+#define POKER_LOG_ERROR(expr) POKER_LOG_AT(::PokerLog::Level::Error, expr)
+#else
+#define POKER_LOG_ERROR(expr) POKER_LOG_DISABLED(expr)
+#endif
+
+// Unfiltered output for explicit dumps; still one write per call.
+#define POKER_LOG_PRINT(expr)                          \
+    do {                                               \
+        std::ostringstream pokerLogPrint_;             \
+        pokerLogPrint_ << expr;                        \
+        ::PokerLog::print(pokerLogPrint_.str());       \
+    } while (0)
+
+#endif // POKER_LOG_H
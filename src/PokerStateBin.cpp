@@ -0,0 +1,200 @@
+#include "PokerStateBin.h"
+#include "PokerEnv_notorch.h"
+#include "CardId.h"
+#include "LegalActions.h"
+
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+namespace PokerStateBin {
+
+size_t blobSize(const std::vector<const PokerEnv*>& envs) {
+    const size_t recSize = envs.empty() ? 0 : envs[0]->stateBinSize();
+    return sizeof(BlobHeader) + envs.size() * recSize;
+}
+
+size_t saveBlob(const std::vector<const PokerEnv*>& envs, uint8_t* dst, size_t cap) {
+    const size_t recSize = envs.empty() ? 0 : envs[0]->stateBinSize();
+    const size_t needed = blobSize(envs);
+    if (!dst || cap < needed) {
+        throw std::invalid_argument("PokerStateBin::saveBlob: buffer holds " + std::to_string(cap) +
+                                    " bytes, blob needs " + std::to_string(needed));
+    }
+    for (size_t i = 0; i < envs.size(); ++i) {
+        if (envs[i]->stateBinSize() != recSize) {
+            throw std::invalid_argument("PokerStateBin::saveBlob: env " + std::to_string(i) +
+                                        " has a different table configuration than env 0");
+        }
+    }
+
+    BlobHeader header{};
+    header.magic = BLOB_MAGIC;
+    header.version = VERSION;
+    header.byteOrder = BYTE_ORDER_MARK;
+    header.count = static_cast<uint32_t>(envs.size());
+    header.recordSize = static_cast<uint32_t>(recSize);
+    std::memcpy(dst, &header, sizeof(header));
+
+    for (size_t i = 0; i < envs.size(); ++i) {
+        envs[i]->save_state_bin(dst + sizeof(BlobHeader) + i * recSize, recSize);
+    }
+    return needed;
+}
+
+namespace {
+
+bool isSeat(int32_t v, int nSeats) { return v >= 0 && v < nSeats; }
+bool isSeatOrNone(int32_t v, int nSeats) { return v == -1 || isSeat(v, nSeats); }
+bool isCardOrNone(uint8_t id) { return id == NO_CARD || isValidCardId(id); }
+
+template <class T>
+std::vector<T> readArray(const uint8_t* src, size_t n) {
+    std::vector<T> out(n);
+    std::memcpy(out.data(), src, n * sizeof(T));
+    return out;
+}
+
+[[noreturn]] void corrupt(const std::string& what) {
+    throw std::invalid_argument("load_state_bin: corrupt snapshot (" + what + ")");
+}
+
+} // namespace
+
+Record decodeRecord(const uint8_t* src, size_t size, int nSeats, int nActions) {
+    Record r;
+    StateBinHeader& h = r.header;
+    if (!src || size < sizeof(h)) {
+        throw std::invalid_argument("load_state_bin: snapshot too small for its header");
+    }
+    std::memcpy(&h, src, sizeof(h));
+    if (h.magic != RECORD_MAGIC || h.byteOrder != BYTE_ORDER_MARK) {
+        throw std::invalid_argument("load_state_bin: not a state snapshot (bad magic or byte order)");
+    }
+    if (h.version != VERSION) {
+        throw std::invalid_argument("load_state_bin: unsupported snapshot version " + std::to_string(h.version));
+    }
+    if (h.nSeats != nSeats || h.nActions != nActions || h.recordSize != recordSize(nSeats, nActions)) {
+        throw std::invalid_argument("load_state_bin: snapshot is for a " + std::to_string(h.nSeats) + "-seat, " +
+                                    std::to_string(h.nActions) + "-action table, env has " + std::to_string(nSeats) +
+                                    " seats and " + std::to_string(nActions) + " actions");
+    }
+    if (size < h.recordSize || h.nSidePots > nSeats || h.deckCount > N_DECK_CARDS ||
+        h.nWinnings > maxWinnings(nSeats) || h.nMaxRaises > N_ROUNDS || h.nActionRecords > MAX_ACTION_RECORDS) {
+        throw std::invalid_argument("load_state_bin: corrupt or truncated snapshot");
+    }
+
+    // Header fields that index seats, rounds or cards
+    if (!isSeat(h.buttonPos, nSeats) || !isSeat(h.sbPos, nSeats) || !isSeat(h.bbPos, nSeats)) corrupt("button or blind seat");
+    if (!isSeatOrNone(h.currentPlayer, nSeats)) corrupt("currentPlayer " + std::to_string(h.currentPlayer));
+    if (!isSeatOrNone(h.lastRaiser, nSeats) || !isSeatOrNone(h.lastAction[2], nSeats)) corrupt("last raiser or actor");
+    if (h.currentRound < 0 || h.currentRound >= N_ROUNDS) corrupt("currentRound " + std::to_string(h.currentRound));
+    // Every dealt or undealt card is in exactly one place: the board, one
+    // hand, or the deck (winner records repeat hole cards and are not counted).
+    uint64_t used = 0;
+    auto claim = [&used](uint8_t id, const char* where) {
+        if (used & cardIdBit(id)) corrupt(std::string("duplicate card ") + std::to_string(id) + " in " + where);
+        used |= cardIdBit(id);
+    };
+    for (uint8_t id : h.board) {
+        if (!isCardOrNone(id)) corrupt("board card " + std::to_string(id));
+        if (id != NO_CARD) claim(id, "board");
+    }
+
+    r.betSizes = readArray<float>(src + betSizesOffset(), static_cast<size_t>(nActions - 2));
+    r.sidePots = readArray<int32_t>(src + sidePotsOffset(nSeats, nActions), h.nSidePots);
+
+    r.players = readArray<StateBinPlayer>(src + playersOffset(nSeats, nActions), static_cast<size_t>(nSeats));
+    for (int i = 0; i < nSeats; ++i) {
+        const StateBinPlayer& p = r.players[i];
+        // save_state_bin writes seat i's player at index i
+        if (p.seatId != i || p.nHandCards > 2) corrupt("player record " + std::to_string(i));
+        for (int c = 0; c < p.nHandCards; ++c) {
+            if (!isCardOrNone(p.hand[c])) corrupt("hole card " + std::to_string(p.hand[c]));
+            if (p.hand[c] != NO_CARD) claim(p.hand[c], "a hand");
+        }
+    }
+
+    r.winnings = readArray<StateBinWinning>(src + winningsOffset(nSeats, nActions), h.nWinnings);
+    for (const StateBinWinning& w : r.winnings) {
+        if (!isSeat(w.seatId, nSeats) || w.nHoleCards > 2) corrupt("winning record");
+        if (w.potIndex != DESC_UNKNOWN && w.potIndex > HandDescription::MAX_POT_INDEX) corrupt("pot index");
+        if (w.handDescription != DESC_UNKNOWN && w.handDescription >= HandDescription::N_IDS) corrupt("hand description");
+        for (int c = 0; c < w.nHoleCards; ++c) {
+            if (!isCardOrNone(w.holeCards[c])) corrupt("winner card " + std::to_string(w.holeCards[c]));
+        }
+    }
+
+    r.deck = readArray<uint8_t>(src + deckOffset(nSeats, nActions), h.deckCount);
+    for (uint8_t id : r.deck) {
+        if (!isValidCardId(id)) corrupt("deck card " + std::to_string(id));
+        claim(id, "the deck");
+    }
+
+    r.actionsThisStreet = readArray<int32_t>(src + actionsThisStreetOffset(nSeats, nActions), static_cast<size_t>(nSeats));
+    for (int32_t n : r.actionsThisStreet) {
+        if (n < 0) corrupt("actions this street");
+    }
+
+    r.actions = readArray<StateBinAction>(src + actionsOffset(nSeats, nActions), h.nActionRecords);
+    for (const StateBinAction& a : r.actions) {
+        if (!isSeat(a.playerId, nSeats) || a.actionType < 0 || a.actionType >= N_RESOLVED_ACTION_TYPES ||
+            a.round < 0 || a.round >= N_ROUNDS || a.actionInt < -1 || a.actionInt >= nActions) {
+            corrupt("action record");
+        }
+    }
+    return r;
+}
+
+std::vector<uint8_t> saveBlob(const std::vector<const PokerEnv*>& envs) {
+    std::vector<uint8_t> blob(blobSize(envs));
+    saveBlob(envs, blob.data(), blob.size());
+    return blob;
+}
+
+namespace {
+
+BlobHeader readHeader(const uint8_t* blob, size_t size) {
+    BlobHeader header;
+    if (!blob || size < sizeof(header)) {
+        throw std::invalid_argument("PokerStateBin: blob too small for its header");
+    }
+    std::memcpy(&header, blob, sizeof(header));
+    if (header.magic != BLOB_MAGIC || header.byteOrder != BYTE_ORDER_MARK) {
+        throw std::invalid_argument("PokerStateBin: not a state blob (bad magic or byte order)");
+    }
+    if (header.version != VERSION) {
+        throw std::invalid_argument("PokerStateBin: unsupported blob version " + std::to_string(header.version));
+    }
+    if (size < sizeof(header) + static_cast<size_t>(header.count) * header.recordSize) {
+        throw std::invalid_argument("PokerStateBin: blob truncated");
+    }
+    return header;
+}
+
+} // namespace
+
+const uint8_t* blobRecord(const uint8_t* blob, size_t size, size_t i) {
+    const BlobHeader header = readHeader(blob, size);
+    if (i >= header.count) {
+        throw std::out_of_range("PokerStateBin: record " + std::to_string(i) + " out of range (" +
+                                std::to_string(header.count) + " records)");
+    }
+    return blob + sizeof(header) + i * header.recordSize;
+}
+
+void loadBlob(const uint8_t* blob, size_t size, const std::vector<PokerEnv*>& envs) {
+    const BlobHeader header = readHeader(blob, size);
+    if (header.count != envs.size()) {
+        throw std::invalid_argument("PokerStateBin::loadBlob: blob has " + std::to_string(header.count) +
+                                    " records for " + std::to_string(envs.size()) + " envs");
+    }
+    std::vector<Record> records;
+    records.reserve(envs.size());
+    for (size_t i = 0; i < envs.size(); ++i) {
+        records.push_back(envs[i]->decode_state_bin(blob + sizeof(header) + i * header.recordSize, header.recordSize));
+    }
+    for (size_t i = 0; i < envs.size(); ++i) envs[i]->load_state_bin(records[i]);
+}
+
+} // namespace PokerStateBin
@@ -0,0 +1,206 @@
+#ifndef POKER_STATE_BIN_H
+#define POKER_STATE_BIN_H
+
+#include "HandDescription.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class PokerEnv;
+
+// ================================
+// Binary state snapshot
+// ================================
+// Fixed-layout, versioned alternative to state_dict()/load_state_dict() for
+// checkpointing large numbers of tables. It covers the same game fields as the
+// JSON form. args_config is the exception: a snapshot is loaded into an env
+// already built with the same table configuration (N_SEATS, N_ACTIONS).
+//
+// One record (PokerEnv::save_state_bin) is, in order:
+//   StateBinHeader
+//   float   betSizes[N_ACTIONS - 2]
+//   int32_t sidePots[N_SEATS]              (header.nSidePots used)
+//   StateBinPlayer players[N_SEATS]
+//   StateBinWinning winnings[N_SEATS * N_SEATS]   (header.nWinnings used; a
+//                                           hand has at most N_SEATS pots, each
+//                                           split at most N_SEATS ways)
+//   uint8_t deck[52]                       (header.deckCount used, dealing order)
+//   int32_t actionsThisStreet[N_SEATS]
+//   StateBinAction actions[MAX_ACTION_RECORDS]    (header.nActionRecords used,
+//                                           oldest first)
+// padded to a multiple of 8 bytes. Unused slots are zero, so one configuration
+// always produces records of the same size (recordSize(), PokerEnv::stateBinSize()).
+//
+// Values are stored in host byte order. The header carries a byte-order mark,
+// and a snapshot from a machine of different endianness is rejected.
+//
+// The action history is kept so sequence features (write_transformer_sequence,
+// the simplified observation) and the per-street action limit continue the
+// saved hand. Only the last MAX_ACTION_RECORDS actions fit; a longer hand
+// loads with the older ones dropped. The observation history is not stored:
+// loading restarts it with the loaded decision point's observation.
+namespace PokerStateBin {
+
+constexpr uint32_t RECORD_MAGIC = 0x42534B50; // "PKSB"
+constexpr uint32_t BLOB_MAGIC = 0x4E534B50;   // "PKSN"
+constexpr uint16_t VERSION = 2;
+constexpr uint16_t BYTE_ORDER_MARK = 0x0102;
+
+constexpr int N_ROUNDS = 4;
+constexpr int N_BOARD_CARDS = 5;
+constexpr int N_DECK_CARDS = 52;
+constexpr int MAX_ACTION_RECORDS = 64;
+
+// Pot and hand descriptions are stored as their HandDescription ids; an id
+// naming nothing is saved as DESC_UNKNOWN and loads back empty.
+constexpr uint8_t DESC_UNKNOWN = HandDescription::UNKNOWN;
+
+enum StateFlags : uint32_t {
+    FLAG_IS_EVALUATING = 1u << 0,
+    FLAG_HAND_IS_OVER = 1u << 1,
+    FLAG_UNIFORM_INTERPOLATION = 1u << 2,
+    FLAG_FIRST_ACTION_NO_CALL = 1u << 3,
+    FLAG_FIXED_LIMIT = 1u << 4,
+    FLAG_CAPPED_RAISE_THIS_ROUND = 1u << 5,
+};
+
+struct StateBinHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t byteOrder;
+    uint32_t recordSize;
+    uint8_t nSeats;
+    uint8_t nActions;
+    uint8_t nSidePots;
+    uint8_t deckCount;
+    uint16_t nWinnings;
+    uint8_t nMaxRaises;                 // entries used in maxRaisesPerRound
+    uint8_t board[N_BOARD_CARDS];       // card ids, NO_CARD for empty slots
+    uint32_t flags;                     // StateFlags
+
+    int32_t smallBlind, bigBlind, ante, defaultStackSize;
+    float rewardScalar;
+    int32_t buttonPos, sbPos, bbPos, currentPlayer, currentRound;
+    int32_t mainPot;
+    int32_t lastAction[3];              // type, amount, player
+    int32_t lastRaiser, nRaisesThisRound, nActionsThisEpisode;
+    int32_t cappedRaisePlayerThatRaised, cappedRaisePlayerThatCantReopen;
+    int32_t fixUtgPosition;
+    int32_t maxRaisesPerRound[N_ROUNDS];
+    uint16_t nActionRecords;            // entries used in actions
+    uint16_t pad;
+};
+
+struct StateBinPlayer {
+    int32_t seatId, stack, startingStack, currentBet, totalInvestedThisHand;
+    float investedThisRound;
+    int32_t sidePotRank, currentSidePotRank;
+    uint8_t folded, isAllin, hasActed, nHandCards;
+    uint8_t hand[2];                    // card ids
+    uint8_t pad[2];
+};
+
+struct StateBinWinning {
+    int32_t amountWon;
+    int8_t seatId;
+    uint8_t potIndex;                   // 0 = "Main Pot", k = "Side Pot k", DESC_UNKNOWN otherwise
+    uint8_t handDescription;            // HandDescription::Id or DESC_UNKNOWN
+    uint8_t nHoleCards;
+    uint8_t holeCards[2];
+    uint8_t pad[2];
+};
+
+// One PokerEnv::ActionRecord.
+struct StateBinAction {
+    int32_t betAmount, potAtActionTime, playerStackAtActionTime;
+    int8_t playerId, actionType, round, actionInt;
+};
+
+static_assert(sizeof(StateBinHeader) % 4 == 0, "StateBinHeader must stay 4-byte aligned");
+static_assert(sizeof(StateBinPlayer) == 40, "StateBinPlayer layout changed; bump VERSION");
+static_assert(sizeof(StateBinWinning) == 12, "StateBinWinning layout changed; bump VERSION");
+static_assert(sizeof(StateBinAction) == 16, "StateBinAction layout changed; bump VERSION");
+
+constexpr size_t alignUp8(size_t n) { return (n + 7) & ~static_cast<size_t>(7); }
+
+constexpr size_t betSizesOffset() { return sizeof(StateBinHeader); }
+constexpr size_t sidePotsOffset(int, int nActions) {
+    return betSizesOffset() + sizeof(float) * static_cast<size_t>(nActions - 2);
+}
+constexpr size_t playersOffset(int nSeats, int nActions) {
+    return sidePotsOffset(nSeats, nActions) + sizeof(int32_t) * static_cast<size_t>(nSeats);
+}
+constexpr size_t winningsOffset(int nSeats, int nActions) {
+    return playersOffset(nSeats, nActions) + sizeof(StateBinPlayer) * static_cast<size_t>(nSeats);
+}
+constexpr size_t maxWinnings(int nSeats) { return static_cast<size_t>(nSeats) * nSeats; }
+constexpr size_t deckOffset(int nSeats, int nActions) {
+    return winningsOffset(nSeats, nActions) + sizeof(StateBinWinning) * maxWinnings(nSeats);
+}
+constexpr size_t actionsThisStreetOffset(int nSeats, int nActions) {
+    return deckOffset(nSeats, nActions) + N_DECK_CARDS;
+}
+constexpr size_t actionsOffset(int nSeats, int nActions) {
+    return actionsThisStreetOffset(nSeats, nActions) + sizeof(int32_t) * static_cast<size_t>(nSeats);
+}
+constexpr size_t recordSize(int nSeats, int nActions) {
+    return alignUp8(actionsOffset(nSeats, nActions) + sizeof(StateBinAction) * MAX_ACTION_RECORDS);
+}
+
+// ================================
+// Decoded record
+// ================================
+// One record copied out of the snapshot and checked against a table
+// configuration: counts within their slots, seats (currentPlayer, buttonPos,
+// sbPos, bbPos, lastRaiser, every per-record seat id) within nSeats, rounds,
+// action types and ints, card ids and description ids within their ranges,
+// player i stored at index i, and no card in more than one of the board, the
+// hands and the deck. Loading decodes first and only then writes
+// to the env (PokerEnv::load_state_bin(const Record&)), so a snapshot that
+// fails any check leaves the env untouched.
+struct Record {
+    StateBinHeader header;
+    std::vector<float> betSizes;            // N_ACTIONS - 2
+    std::vector<int32_t> sidePots;          // header.nSidePots
+    std::vector<StateBinPlayer> players;    // N_SEATS
+    std::vector<StateBinWinning> winnings;  // header.nWinnings
+    std::vector<uint8_t> deck;              // header.deckCount, dealing order
+    std::vector<int32_t> actionsThisStreet; // N_SEATS
+    std::vector<StateBinAction> actions;    // header.nActionRecords, oldest first
+};
+
+// Throws std::invalid_argument when the snapshot is not a valid record for
+// an nSeats-seat, nActions-action table.
+Record decodeRecord(const uint8_t* src, size_t size, int nSeats, int nActions);
+
+// ================================
+// Batch blob
+// ================================
+// BlobHeader followed by `count` records of `recordSize` bytes each, so record
+// i starts at sizeof(BlobHeader) + i * recordSize and a file holding a blob
+// can be mmapped and indexed directly.
+struct BlobHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t byteOrder;
+    uint32_t count;
+    uint32_t recordSize;
+};
+static_assert(sizeof(BlobHeader) == 16, "BlobHeader layout changed; bump VERSION");
+
+// All envs must share one table configuration (same record size).
+size_t blobSize(const std::vector<const PokerEnv*>& envs);
+size_t saveBlob(const std::vector<const PokerEnv*>& envs, uint8_t* dst, size_t cap);
+std::vector<uint8_t> saveBlob(const std::vector<const PokerEnv*>& envs);
+// Loads record i into envs[i]; envs.size() must equal the blob's count.
+// Every record is decoded before any env is written, so a bad record leaves
+// all of them untouched.
+void loadBlob(const uint8_t* blob, size_t size, const std::vector<PokerEnv*>& envs);
+
+// Validates the blob header and returns record i (throws on a bad blob or index).
+const uint8_t* blobRecord(const uint8_t* blob, size_t size, size_t i);
+
+} // namespace PokerStateBin
+
+#endif // POKER_STATE_BIN_H
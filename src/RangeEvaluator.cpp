@@ -0,0 +1,150 @@
+#include "RangeEvaluator.h"
+#include "HandEvalBatch.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+
+namespace RangeEvaluator {
+
+namespace {
+
+uint64_t boardMask(const CardId board[BOARD_CARDS]) {
+    uint64_t mask = 0;
+    for (int i = 0; i < BOARD_CARDS; ++i) {
+        if (!isValidCardId(board[i]) || (mask & cardIdBit(board[i]))) {
+            throw std::invalid_argument("RangeEvaluator: invalid or repeated board card id " +
+                                        std::to_string(board[i]));
+        }
+        mask |= cardIdBit(board[i]);
+    }
+    return mask;
+}
+
+void checkRange(const std::vector<float>& range, const char* name) {
+    if (range.size() != static_cast<size_t>(RangeLut::N_RANGE_IDX)) {
+        throw std::invalid_argument(std::string("RangeEvaluator: ") + name + " has " + std::to_string(range.size()) +
+                                    " weights, expected " + std::to_string(RangeLut::N_RANGE_IDX));
+    }
+    for (float w : range) {
+        if (!(w >= 0.0f) || std::isinf(w)) {
+            throw std::invalid_argument(std::string("RangeEvaluator: ") + name + " has a negative or non-finite weight");
+        }
+    }
+}
+
+// Live hands sorted by rank, strongest first.
+struct SortedHands {
+    std::vector<int16_t> ranks;  // per range index
+    std::vector<uint16_t> order; // live range indices
+};
+
+SortedHands sortHands(const CardId board[BOARD_CARDS]) {
+    SortedHands sorted;
+    sorted.ranks.resize(RangeLut::N_RANGE_IDX);
+    rankAllHands(board, sorted.ranks.data());
+    for (int idx = 0; idx < RangeLut::N_RANGE_IDX; ++idx) {
+        if (sorted.ranks[idx] != BLOCKED_RANK) sorted.order.push_back(static_cast<uint16_t>(idx));
+    }
+    std::stable_sort(sorted.order.begin(), sorted.order.end(),
+                     [&sorted](uint16_t a, uint16_t b) { return sorted.ranks[a] < sorted.ranks[b]; });
+    return sorted;
+}
+
+// value[h] = (opponent weight h beats) - (opponent weight that beats h), over
+// opponent hands sharing no card with h.
+void sweep(const SortedHands& sorted, const std::vector<float>& opponent, std::vector<double>& value) {
+    value.assign(RangeLut::N_RANGE_IDX, 0.0);
+    const std::vector<uint16_t>& order = sorted.order;
+    const size_t n = order.size();
+
+    // One pass per direction: weaker-than (walking from the weakest end) adds,
+    // stronger-than (from the strongest end) subtracts. Hands of equal rank
+    // are scored before any of them is added, so ties count for neither side.
+    for (int direction = 0; direction < 2; ++direction) {
+        double total = 0.0;
+        double perCard[N_CARD_IDS] = {};
+        const double sign = direction == 0 ? 1.0 : -1.0;
+        size_t i = 0;
+        while (i < n) {
+            size_t groupEnd = i;
+            const auto at = [&](size_t k) { return direction == 0 ? order[n - 1 - k] : order[k]; };
+            while (groupEnd < n && sorted.ranks[at(groupEnd)] == sorted.ranks[at(i)]) ++groupEnd;
+            for (size_t k = i; k < groupEnd; ++k) {
+                const int h = at(k);
+                // h itself has h's rank, so it is never in the accumulated set
+                // and inclusion-exclusion needs no add-back.
+                value[h] += sign * (total - perCard[RangeLut::rangeCard1(h)] - perCard[RangeLut::rangeCard2(h)]);
+            }
+            for (size_t k = i; k < groupEnd; ++k) {
+                const int h = at(k);
+                const double w = opponent[h];
+                total += w;
+                perCard[RangeLut::rangeCard1(h)] += w;
+                perCard[RangeLut::rangeCard2(h)] += w;
+            }
+            i = groupEnd;
+        }
+    }
+}
+
+} // namespace
+
+void rankAllHands(const CardId board[BOARD_CARDS], int16_t ranks[RangeLut::N_RANGE_IDX]) {
+    const uint64_t dead = boardMask(board);
+
+    std::vector<CardId> cards;
+    std::vector<int> live;
+    cards.reserve(static_cast<size_t>(RangeLut::N_RANGE_IDX) * HandEvalBatch::CARDS_PER_HAND);
+    live.reserve(RangeLut::N_RANGE_IDX);
+    for (int idx = 0; idx < RangeLut::N_RANGE_IDX; ++idx) {
+        const CardId c1 = RangeLut::rangeCard1(idx);
+        const CardId c2 = RangeLut::rangeCard2(idx);
+        if ((cardIdBit(c1) | cardIdBit(c2)) & dead) {
+            ranks[idx] = BLOCKED_RANK;
+            continue;
+        }
+        live.push_back(idx);
+        cards.push_back(c1);
+        cards.push_back(c2);
+        cards.insert(cards.end(), board, board + BOARD_CARDS);
+    }
+
+    std::vector<int32_t> liveRanks(live.size());
+    HandEvalBatch::evaluate7(cards.data(), live.size(), liveRanks.data());
+    for (size_t i = 0; i < live.size(); ++i) ranks[live[i]] = static_cast<int16_t>(liveRanks[i]);
+}
+
+RangeVsRange rangeVsRange(const CardId board[BOARD_CARDS], const std::vector<float>& rangeA,
+                          const std::vector<float>& rangeB) {
+    checkRange(rangeA, "rangeA");
+    checkRange(rangeB, "rangeB");
+    const SortedHands sorted = sortHands(board);
+
+    RangeVsRange result;
+    sweep(sorted, rangeB, result.valueA);
+    sweep(sorted, rangeA, result.valueB);
+
+    // Weight of compatible (a, b) deals: for each a, all of B minus the hands
+    // sharing a card with a (the identical hand is subtracted twice).
+    double totalB = 0.0;
+    double perCardB[N_CARD_IDS] = {};
+    for (uint16_t h : sorted.order) {
+        totalB += rangeB[h];
+        perCardB[RangeLut::rangeCard1(h)] += rangeB[h];
+        perCardB[RangeLut::rangeCard2(h)] += rangeB[h];
+    }
+    double dealWeight = 0.0;
+    double payoff = 0.0;
+    for (uint16_t h : sorted.order) {
+        const double wA = rangeA[h];
+        if (wA == 0.0) continue;
+        dealWeight += wA * (totalB - perCardB[RangeLut::rangeCard1(h)] - perCardB[RangeLut::rangeCard2(h)] + rangeB[h]);
+        payoff += wA * result.valueA[h];
+    }
+    result.evA = dealWeight > 0.0 ? payoff / dealWeight : 0.0;
+    return result;
+}
+
+} // namespace RangeEvaluator
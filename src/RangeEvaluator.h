@@ -0,0 +1,45 @@
+#ifndef RANGE_EVALUATOR_H
+#define RANGE_EVALUATOR_H
+
+#include "CardId.h"
+#include "RangeLut.h"
+
+#include <cstdint>
+#include <vector>
+
+// ================================
+// Range-vs-range showdown on a river board
+// ================================
+// All 1326 hole pairs (RangeLut order) ranked on one 5-card board with a
+// single HandEvalBatch call, and the showdown value of every hand of one
+// range against another. Values are in pot-free units: a win against an
+// opponent hand counts +weight, a loss -weight, a tie 0. Opponent hands that
+// share a card with the hand are excluded, as are hands the board blocks.
+//
+// rangeVsRange sorts the live hands by rank once and sweeps them, keeping the
+// opponent weight seen so far in total and per card; the weight a hand beats
+// is the total minus what its two cards block (inclusion-exclusion). That is
+// O(n log n) instead of comparing all n^2 pairs.
+namespace RangeEvaluator {
+
+constexpr int BOARD_CARDS = 5;
+constexpr int16_t BLOCKED_RANK = 0; // like getHandRank's "unrankable"
+
+// ranks[i] = phevaluator rank (1 = best ... 7462) of range index i on board,
+// BLOCKED_RANK if the hand shares a card with the board. board must hold 5
+// distinct valid ids.
+void rankAllHands(const CardId board[BOARD_CARDS], int16_t ranks[RangeLut::N_RANGE_IDX]);
+
+struct RangeVsRange {
+    std::vector<double> valueA;  // per range index: A's hand against range B
+    std::vector<double> valueB;  // per range index: B's hand against range A
+    double evA = 0.0;            // A's expected result per compatible (a, b) deal; evB = -evA
+};
+
+// rangeA and rangeB hold RangeLut::N_RANGE_IDX non-negative weights.
+RangeVsRange rangeVsRange(const CardId board[BOARD_CARDS], const std::vector<float>& rangeA,
+                          const std::vector<float>& rangeB);
+
+} // namespace RangeEvaluator
+
+#endif // RANGE_EVALUATOR_H
@@ -0,0 +1,54 @@
+#include "RangeLut.h"
+
+namespace RangeLut {
+
+namespace {
+
+template <bool SUITS_MATTER>
+struct PrivObsTable {
+    static constexpr int DIM = privObsDim(SUITS_MATTER);
+    static constexpr int PER_CARD = DIM / 2;
+    float rows[N_RANGE_IDX][DIM];
+};
+
+template <bool SUITS_MATTER>
+constexpr PrivObsTable<SUITS_MATTER> buildPrivObsTable() {
+    using Table = PrivObsTable<SUITS_MATTER>;
+    Table t{};
+    for (int idx = 0; idx < N_RANGE_IDX; ++idx) {
+        const CardId cards[2] = {rangeCard1(idx), rangeCard2(idx)};
+        for (int slot = 0; slot < 2; ++slot) {
+            const int offset = slot * Table::PER_CARD;
+            t.rows[idx][offset + cardIdValue(cards[slot])] = 1.0f;
+            if (SUITS_MATTER) {
+                t.rows[idx][offset + NUM_RANKS + cardIdSuit(cards[slot])] = 1.0f;
+            }
+        }
+    }
+    return t;
+}
+
+constexpr PrivObsTable<true> PRIV_OBS_SUITED = buildPrivObsTable<true>();
+constexpr PrivObsTable<false> PRIV_OBS_SUITLESS = buildPrivObsTable<false>();
+
+constexpr float ZERO_ROW[privObsDim(true)] = {};
+
+} // namespace
+
+FloatSpan privObs(int64_t idx, bool suitsMatter) {
+    const size_t dim = static_cast<size_t>(privObsDim(suitsMatter));
+    if (!isValidRangeIdx(idx)) {
+        return FloatSpan{ZERO_ROW, dim};
+    }
+    const float* row = suitsMatter ? PRIV_OBS_SUITED.rows[idx] : PRIV_OBS_SUITLESS.rows[idx];
+    return FloatSpan{row, dim};
+}
+
+FloatSpan privObsTable(bool suitsMatter) {
+    if (suitsMatter) {
+        return FloatSpan{&PRIV_OBS_SUITED.rows[0][0], static_cast<size_t>(N_RANGE_IDX) * privObsDim(true)};
+    }
+    return FloatSpan{&PRIV_OBS_SUITLESS.rows[0][0], static_cast<size_t>(N_RANGE_IDX) * privObsDim(false)};
+}
+
+} // namespace RangeLut
@@ -0,0 +1,90 @@
+#ifndef RANGE_LUT_H
+#define RANGE_LUT_H
+
+#include "CardId.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// ================================
+// Range index lookup tables
+// ================================
+// A range index enumerates the 1326 two-card hands in (c1 < c2) order of card
+// id: (0,1) -> 0, (0,2) -> 1, ..., (50,51) -> 1325. These tables are
+// process-wide and immutable; the index tables are constexpr and live in
+// this header, the private-observation blocks are built at compile time in
+// RangeLut.cpp. Nothing is copied per PokerEnv.
+namespace RangeLut {
+
+constexpr int N_RANGE_IDX = N_CARD_IDS * (N_CARD_IDS - 1) / 2; // 1326
+
+constexpr int NUM_RANKS = 13;
+constexpr int NUM_SUITS = 4;
+
+// Private observation of a hand: per card (lower id first) a 13-wide rank
+// one-hot, followed by a 4-wide suit one-hot when suits matter.
+constexpr int privObsDim(bool suitsMatter) {
+    return 2 * (suitsMatter ? NUM_RANKS + NUM_SUITS : NUM_RANKS);
+}
+
+// Read-only view into one of the tables.
+struct FloatSpan {
+    const float* data = nullptr;
+    size_t size = 0;
+
+    const float* begin() const { return data; }
+    const float* end() const { return data + size; }
+    float operator[](size_t i) const { return data[i]; }
+    bool empty() const { return size == 0; }
+};
+
+namespace detail {
+
+struct IndexTables {
+    int16_t pairToIdx[N_CARD_IDS][N_CARD_IDS]; // symmetric, -1 on the diagonal
+    uint8_t idxToPair[N_RANGE_IDX][2];          // lower id first
+};
+
+constexpr IndexTables buildIndexTables() {
+    IndexTables t{};
+    int idx = 0;
+    for (int c1 = 0; c1 < N_CARD_IDS; ++c1) {
+        t.pairToIdx[c1][c1] = -1;
+        for (int c2 = c1 + 1; c2 < N_CARD_IDS; ++c2) {
+            t.pairToIdx[c1][c2] = static_cast<int16_t>(idx);
+            t.pairToIdx[c2][c1] = static_cast<int16_t>(idx);
+            t.idxToPair[idx][0] = static_cast<uint8_t>(c1);
+            t.idxToPair[idx][1] = static_cast<uint8_t>(c2);
+            ++idx;
+        }
+    }
+    return t;
+}
+
+inline constexpr IndexTables INDEX_TABLES = buildIndexTables();
+
+} // namespace detail
+
+// Range index of two card ids in either order; -1 if either id is invalid or
+// both are the same card.
+constexpr int rangeIdx(int c1, int c2) {
+    return (isValidCardId(c1) && isValidCardId(c2)) ? detail::INDEX_TABLES.pairToIdx[c1][c2] : -1;
+}
+
+constexpr bool isValidRangeIdx(int64_t idx) { return idx >= 0 && idx < N_RANGE_IDX; }
+
+// Card ids of a range index (lower first). idx must be valid.
+constexpr CardId rangeCard1(int idx) { return detail::INDEX_TABLES.idxToPair[idx][0]; }
+constexpr CardId rangeCard2(int idx) { return detail::INDEX_TABLES.idxToPair[idx][1]; }
+
+// privObsDim(suitsMatter) floats for a valid idx; an all-zero row of the same
+// width for an invalid one.
+FloatSpan privObs(int64_t idx, bool suitsMatter);
+
+// The whole [N_RANGE_IDX x privObsDim(suitsMatter)] block, row-major.
+FloatSpan privObsTable(bool suitsMatter);
+
+} // namespace RangeLut
+
+#endif // RANGE_LUT_H
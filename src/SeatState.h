@@ -0,0 +1,67 @@
+#ifndef SEAT_STATE_H
+#define SEAT_STATE_H
+
+#include "Showdown.h"
+
+#include <cstdint>
+
+// ================================
+// Per-seat hot fields, structure of arrays
+// ================================
+// The fields the observation builders read for every seat (stack, bet on the
+// table, chips invested this hand, folded / all-in), copied out of the
+// separately allocated PokerPlayer objects into contiguous arrays, one per
+// field. Loops over seats become plain array loops without pointer chasing
+// and without branches, which the compiler can vectorize; PokerEnvBatch
+// stacks the same arrays of every table into [tables x seats] buffers.
+//
+// PokerEnv refreshes it (_syncSeatState) at the end of every step, reset,
+// state load and copy, the only places seat fields change, so it always
+// describes the current decision. Flags are 0/1 bytes rather than bits so
+// they can be summed and masked lane by lane.
+struct SeatState {
+    static constexpr int MAX_SEATS = Showdown::MAX_SEATS;
+
+    int nSeats = 0;
+    alignas(64) int32_t stack[MAX_SEATS] = {};
+    alignas(64) int32_t currentBet[MAX_SEATS] = {};
+    alignas(64) int32_t chips[MAX_SEATS] = {};    // stack + currentBet
+    alignas(64) int32_t invested[MAX_SEATS] = {}; // totalInvestedThisHand
+    alignas(64) uint8_t folded[MAX_SEATS] = {};
+    alignas(64) uint8_t allin[MAX_SEATS] = {};
+
+    // Seats still able to act: not folded, not all-in, chips behind.
+    int countCanAct() const {
+        int n = 0;
+        for (int i = 0; i < nSeats; ++i) n += (1 - folded[i]) & (1 - allin[i]) & (stack[i] > 0);
+        return n;
+    }
+
+    int countFolded() const {
+        int n = 0;
+        for (int i = 0; i < nSeats; ++i) n += folded[i];
+        return n;
+    }
+
+    // All-in and not folded.
+    int countAllin() const {
+        int n = 0;
+        for (int i = 0; i < nSeats; ++i) n += (1 - folded[i]) & allin[i];
+        return n;
+    }
+
+    // min(start, values[i]) over the unfolded seats other than `seat`, for
+    // values one of the arrays above.
+    int minOverOpponents(const int32_t* values, int seat, int start) const {
+        int m = start;
+        for (int i = 0; i < nSeats; ++i) {
+            // Skipped seats contribute start, which never lowers m: a plain
+            // min reduction.
+            const int v = (folded[i] | (i == seat)) ? start : values[i];
+            m = v < m ? v : m;
+        }
+        return m;
+    }
+};
+
+#endif // SEAT_STATE_H
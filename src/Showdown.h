@@ -0,0 +1,61 @@
+#ifndef SHOWDOWN_H
+#define SHOWDOWN_H
+
+#include <cstdint>
+
+// ================================
+// Showdown ranks and seat masks
+// ================================
+// At showdown every live seat's 7-card rank is evaluated once into a
+// SeatRanks, and each pot is settled from that array and a bit mask of the
+// seats contending for it (bit i = seat i). Ranks are phevaluator's, smaller
+// is stronger. A 52-card deck cannot seat more than 23 players with a full
+// board, so a 32-bit mask covers every table.
+namespace Showdown {
+
+constexpr int MAX_SEATS = 32;
+
+using SeatMask = uint32_t;
+
+constexpr SeatMask seatBit(int seat) { return SeatMask{1} << seat; }
+
+// Lowest seat in a non-empty mask, and the mask without it.
+constexpr int lowestSeat(SeatMask m) {
+    int seat = 0;
+    while (!(m & 1u)) {
+        m >>= 1;
+        ++seat;
+    }
+    return seat;
+}
+constexpr SeatMask dropLowest(SeatMask m) { return m & (m - 1); }
+
+constexpr int seatCount(SeatMask m) {
+    int n = 0;
+    for (; m; m = dropLowest(m)) ++n;
+    return n;
+}
+
+struct SeatRanks {
+    int rank[MAX_SEATS];
+};
+
+// Seats of `contenders` holding the best (smallest) rank; 0 if contenders is empty.
+inline SeatMask bestSeats(const SeatRanks& ranks, SeatMask contenders) {
+    SeatMask best = 0;
+    int bestRank = 0;
+    for (SeatMask m = contenders; m; m = dropLowest(m)) {
+        const int seat = lowestSeat(m);
+        if (!best || ranks.rank[seat] < bestRank) {
+            best = seatBit(seat);
+            bestRank = ranks.rank[seat];
+        } else if (ranks.rank[seat] == bestRank) {
+            best |= seatBit(seat);
+        }
+    }
+    return best;
+}
+
+} // namespace Showdown
+
+#endif // SHOWDOWN_H
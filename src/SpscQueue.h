@@ -0,0 +1,104 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <thread>
+#include <utility>
+
+// ================================
+// SpscQueue
+// ================================
+// Bounded lock-free queue for exactly one producer thread and one consumer
+// thread. Capacity is rounded up to a power of two; slots are constructed
+// once and reused by move assignment, so pushing and popping never allocate
+// (beyond what T's own move does). Head and tail live on separate cache
+// lines, and each side keeps a cached copy of the other's index so the
+// shared line is only read when the queue looks full / empty.
+//
+// try_push / try_pop never block; callers decide how to wait when they fail
+// (SpscBackoff below, or a plain yield).
+template <class T>
+class SpscQueue {
+public:
+    explicit SpscQueue(size_t capacity) {
+        size_t cap = 2;
+        while (cap < capacity) cap <<= 1;
+        mask_ = cap - 1;
+        slots_.reset(new T[cap]);
+    }
+
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    size_t capacity() const { return mask_ + 1; }
+
+    // Producer only. False (value untouched) if the queue is full.
+    bool try_push(T&& value) {
+        const size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - headCache_ > mask_) {
+            headCache_ = head_.load(std::memory_order_acquire);
+            if (tail - headCache_ > mask_) return false;
+        }
+        slots_[tail & mask_] = std::move(value);
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer only. False if the queue is empty.
+    bool try_pop(T& out) {
+        const size_t head = head_.load(std::memory_order_relaxed);
+        if (head == tailCache_) {
+            tailCache_ = tail_.load(std::memory_order_acquire);
+            if (head == tailCache_) return false;
+        }
+        out = std::move(slots_[head & mask_]);
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Approximate when called while the other side is running.
+    size_t size() const {
+        return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire);
+    }
+    bool empty() const { return size() == 0; }
+
+private:
+    std::unique_ptr<T[]> slots_;
+    size_t mask_ = 0;
+
+    alignas(64) std::atomic<size_t> head_{0}; // next slot to pop
+    size_t tailCache_ = 0;                     // consumer's view of tail_
+    alignas(64) std::atomic<size_t> tail_{0}; // next slot to push
+    size_t headCache_ = 0;                     // producer's view of head_
+};
+
+// Waiting policy for a side whose try_push / try_pop failed: a few pause
+// rounds, then yields, then short sleeps, so a wait that turns out long
+// costs no core. reset() after every success.
+class SpscBackoff {
+public:
+    void wait() {
+        if (rounds_ < SPIN_ROUNDS) {
+            ++rounds_;
+#if defined(__x86_64__) || defined(__i386__)
+            __builtin_ia32_pause();
+#endif
+        } else if (rounds_ < SPIN_ROUNDS + YIELD_ROUNDS) {
+            ++rounds_;
+            std::this_thread::yield();
+        } else {
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+    }
+    void reset() { rounds_ = 0; }
+
+private:
+    static constexpr int SPIN_ROUNDS = 64;
+    static constexpr int YIELD_ROUNDS = 64;
+    int rounds_ = 0;
+};
+
+#endif // SPSC_QUEUE_H
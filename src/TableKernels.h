@@ -0,0 +1,170 @@
+#ifndef TABLE_KERNELS_H
+#define TABLE_KERNELS_H
+
+#include "SeatState.h"
+
+#include <cstddef>
+
+// ================================
+// Table-size specialized observation kernels
+// ================================
+// The per-step transformer observation (ObservationLayout.h: state vector
+// and action rows) written by loops whose trip counts are template
+// parameters: Seats and Actions (= 2 + bet sizes) fixed at compile time give
+// straight-line code with constant offsets and no division for relative
+// positions. TableKernels<0, 0> is the same code with both read at runtime,
+// the fallback for every configuration without a specialization.
+//
+// selectTableKernels(nSeats, nActions) picks the specialization once per env
+// (PokerEnv's constructor); the list at the bottom is what is compiled in.
+// Each kernel writes exactly what the PokerEnv code it replaced wrote, so
+// specialized and generic output are identical.
+//
+// Only these four observation kernels are specialized. Legal-action
+// resolution (legalActionSet, _resolveAction) and the other per-seat loops of
+// PokerEnv (betting, side pots, showdown) run the same dynamic code for every
+// configuration. The key is the action count, not the bet menu itself: the
+// bet fractions only enter these kernels through how many actions there are,
+// so two menus of the same length share a specialization.
+namespace TableKernelsDetail {
+
+// (seat - buttonPos + n) % n for seat, buttonPos in [0, n).
+inline int relativeSeat(int seat, int buttonPos, int n) {
+    const int d = seat - buttonPos;
+    return d < 0 ? d + n : d;
+}
+
+inline float* oneHot(float* out, int n, int idx) {
+    for (int i = 0; i < n; ++i) out[i] = 0.0f;
+    if (idx >= 0 && idx < n) out[idx] = 1.0f;
+    return out + n;
+}
+
+} // namespace TableKernelsDetail
+
+template <int Seats, int Actions>
+struct TableKernels {
+    static_assert(Seats >= 0 && Seats <= SeatState::MAX_SEATS, "Seats out of range");
+    static_assert(Actions >= 0, "Actions out of range");
+
+    static int seats(int nSeats) { return Seats > 0 ? Seats : nSeats; }
+    static int actions(int nActions) { return Actions > 0 ? Actions : nActions; }
+
+    // Current player one-hot by relative position, then (stack + currentBet)
+    // / defaultStack per absolute seat (0 if defaultStack <= 0): 2 * seats floats.
+    // A true division, not a multiply by the reciprocal, which can differ in
+    // the last bit from the stacks the observation has always carried.
+    static void currentPlayerAndStacks(const SeatState& s, int currentPlayer, int buttonPos, int defaultStack,
+                                       float* dst) {
+        const int n = seats(s.nSeats);
+        const int rel = (currentPlayer >= 0 && currentPlayer < n)
+            ? TableKernelsDetail::relativeSeat(currentPlayer, buttonPos, n)
+            : -1;
+        float* stacks = TableKernelsDetail::oneHot(dst, n, rel);
+        if (defaultStack <= 0) {
+            for (int i = 0; i < n; ++i) stacks[i] = 0.0f;
+            return;
+        }
+        const float norm = static_cast<float>(defaultStack);
+        for (int i = 0; i < n; ++i) stacks[i] = static_cast<float>(s.chips[i]) / norm;
+    }
+
+    // Smallest stack + currentBet among the current player and the unfolded
+    // others, over pot (> 0); 0 without a current player.
+    static float effectiveStackToPot(const SeatState& s, int currentPlayer, int pot) {
+        const int n = seats(s.nSeats);
+        if (currentPlayer < 0 || currentPlayer >= n) return 0.0f;
+        int m = s.chips[currentPlayer];
+        for (int i = 0; i < n; ++i) {
+            const int v = (s.folded[i] | (i == currentPlayer)) ? s.chips[currentPlayer] : s.chips[i];
+            m = v < m ? v : m;
+        }
+        return static_cast<float>(m) / static_cast<float>(pot);
+    }
+
+    // Seats other than the current player neither folded nor all-in, over
+    // seats - 1; 0 without a current player.
+    static float playersToActRatio(const SeatState& s, int currentPlayer) {
+        const int n = seats(s.nSeats);
+        if (currentPlayer < 0 || currentPlayer >= n) return 0.0f;
+        int count = 0;
+        for (int i = 0; i < n; ++i) count += (1 - s.folded[i]) & (1 - s.allin[i]) & (i != currentPlayer);
+        return static_cast<float>(count) / static_cast<float>(n - 1);
+    }
+
+    // One row per record (rowDim = seats + actions + 1 floats each): actor
+    // one-hot by relative position, actionInt one-hot, betAmount over the pot
+    // at action time (0 -> bigBlind). Record needs playerId, actionInt,
+    // betAmount and potAtActionTime.
+    template <class Record>
+    static void actionRows(const Record* records, size_t nRecords, int nSeats, int nActions, int buttonPos,
+                           int bigBlind, float* dst) {
+        const int n = seats(nSeats);
+        const int a = actions(nActions);
+        const size_t rowDim = static_cast<size_t>(n) + a + 1;
+        for (size_t r = 0; r < nRecords; ++r) {
+            const Record& rec = records[r];
+            float* out = dst + r * rowDim;
+            const int rel = (rec.playerId >= 0 && rec.playerId < n)
+                ? TableKernelsDetail::relativeSeat(rec.playerId, buttonPos, n)
+                : -1;
+            out = TableKernelsDetail::oneHot(out, n, rel);
+            out = TableKernelsDetail::oneHot(out, a, rec.actionInt);
+            float betMultiplier = 0.0f;
+            if (rec.betAmount > 0) {
+                const int pot = rec.potAtActionTime > 0 ? rec.potAtActionTime : bigBlind;
+                betMultiplier = static_cast<float>(rec.betAmount) / static_cast<float>(pot);
+            }
+            *out = betMultiplier;
+        }
+    }
+};
+
+// One env's kernels, chosen once.
+template <class Record>
+struct TableKernelSet {
+    int seats;   // 0 for the generic set
+    int actions;
+    void (*currentPlayerAndStacks)(const SeatState&, int, int, int, float*);
+    float (*effectiveStackToPot)(const SeatState&, int, int);
+    float (*playersToActRatio)(const SeatState&, int);
+    void (*actionRows)(const Record*, size_t, int, int, int, int, float*);
+
+    bool specialized() const { return seats > 0; }
+};
+
+namespace TableKernelsDetail {
+
+template <class Record, int Seats, int Actions>
+constexpr TableKernelSet<Record> makeSet() {
+    using K = TableKernels<Seats, Actions>;
+    return {Seats, Actions, &K::currentPlayerAndStacks, &K::effectiveStackToPot, &K::playersToActRatio,
+            &K::template actionRows<Record>};
+}
+
+template <class Record, int Seats, int... Actions>
+const TableKernelSet<Record>* findActions(int nActions) {
+    static const TableKernelSet<Record> sets[] = {makeSet<Record, Seats, Actions>()...};
+    for (const auto& set : sets) {
+        if (set.actions == nActions) return &set;
+    }
+    return nullptr;
+}
+
+} // namespace TableKernelsDetail
+
+// Compiled-in specializations: heads-up and 6-max, each with one to six bet
+// sizes (3 to 8 actions). Add a configuration here to specialize it.
+template <class Record>
+const TableKernelSet<Record>& selectTableKernels(int nSeats, int nActions) {
+    static const TableKernelSet<Record> generic = TableKernelsDetail::makeSet<Record, 0, 0>();
+    const TableKernelSet<Record>* found = nullptr;
+    if (nSeats == 2) {
+        found = TableKernelsDetail::findActions<Record, 2, 3, 4, 5, 6, 7, 8>(nActions);
+    } else if (nSeats == 6) {
+        found = TableKernelsDetail::findActions<Record, 6, 3, 4, 5, 6, 7, 8>(nActions);
+    }
+    return found ? *found : generic;
+}
+
+#endif // TABLE_KERNELS_H
@@ -0,0 +1,202 @@
+#include "WorkStealingPool.h"
+
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+constexpr uint64_t LO_MASK = 0xFFFFFFFFull;
+
+inline uint64_t packRange(uint32_t lo, uint32_t hi) {
+    return static_cast<uint64_t>(lo) | (static_cast<uint64_t>(hi) << 32);
+}
+
+inline uint32_t rangeLo(uint64_t r) { return static_cast<uint32_t>(r & LO_MASK); }
+inline uint32_t rangeHi(uint64_t r) { return static_cast<uint32_t>(r >> 32); }
+
+} // namespace
+
+WorkStealingPool::WorkStealingPool(int nThreads, bool pinThreads, int firstCore)
+    : pinThreads_(pinThreads), firstCore_(firstCore)
+{
+    if (nThreads <= 0) {
+        nThreads = static_cast<int>(std::thread::hardware_concurrency());
+        if (nThreads <= 0) nThreads = 1;
+    }
+
+    slotStorage.reset(new Slot[nThreads]);
+    slots.reserve(nThreads);
+    for (int i = 0; i < nThreads; ++i) {
+        slots.push_back(&slotStorage[i]);
+    }
+
+    workers.reserve(nThreads - 1);
+    for (int p = 1; p < nThreads; ++p) {
+        workers.emplace_back(&WorkStealingPool::_workerLoop, this, p);
+    }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    {
+        std::lock_guard<std::mutex> lock(jobMutex);
+        stopping = true;
+    }
+    jobCv.notify_all();
+    for (auto& t : workers) {
+        if (t.joinable()) t.join();
+    }
+}
+
+void WorkStealingPool::_run(size_t n, Task task, void* ctx) {
+    if (n > std::numeric_limits<uint32_t>::max()) {
+        throw std::invalid_argument("WorkStealingPool::parallel_for: range too large (" + std::to_string(n) + ")");
+    }
+
+    const size_t nParticipants = slots.size();
+    for (size_t p = 0; p < nParticipants; ++p) {
+        const uint32_t lo = static_cast<uint32_t>(n * p / nParticipants);
+        const uint32_t hi = static_cast<uint32_t>(n * (p + 1) / nParticipants);
+        slots[p]->range.store(packRange(lo, hi), std::memory_order_relaxed);
+    }
+    remaining.store(n, std::memory_order_relaxed);
+    hasError.store(false, std::memory_order_relaxed);
+    firstError = nullptr;
+    activeWorkers.store(static_cast<int>(workers.size()), std::memory_order_relaxed);
+
+    {
+        std::lock_guard<std::mutex> lock(jobMutex);
+        jobTask = task;
+        jobCtx = ctx;
+        ++jobGeneration;
+    }
+    jobCv.notify_all();
+
+    _participate(0);
+
+    // Workers may still be scanning for work after the last index finished;
+    // wait for all of them so ctx is not touched once we return.
+    {
+        std::unique_lock<std::mutex> lock(doneMutex);
+        doneCv.wait(lock, [this] { return activeWorkers.load(std::memory_order_acquire) == 0; });
+    }
+
+    if (firstError) {
+        std::exception_ptr err = firstError;
+        firstError = nullptr;
+        std::rethrow_exception(err);
+    }
+}
+
+void WorkStealingPool::_workerLoop(int participant) {
+    if (pinThreads_) {
+        _pinToCore(firstCore_ + participant);
+    }
+
+    uint64_t seenGeneration = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(jobMutex);
+            jobCv.wait(lock, [&] { return stopping || jobGeneration != seenGeneration; });
+            if (stopping) return;
+            seenGeneration = jobGeneration;
+        }
+
+        _participate(participant);
+
+        if (activeWorkers.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            std::lock_guard<std::mutex> lock(doneMutex);
+            doneCv.notify_one();
+        }
+    }
+}
+
+void WorkStealingPool::_participate(int participant) {
+    uint32_t index;
+    while (remaining.load(std::memory_order_acquire) > 0) {
+        if (_popLocal(participant, index) || _steal(participant, index)) {
+            _execute(index);
+        } else {
+            // Every range is empty; whatever is left is already running.
+            break;
+        }
+    }
+}
+
+bool WorkStealingPool::_popLocal(int participant, uint32_t& index) {
+    std::atomic<uint64_t>& range = slots[participant]->range;
+    uint64_t r = range.load(std::memory_order_acquire);
+    while (true) {
+        const uint32_t lo = rangeLo(r);
+        const uint32_t hi = rangeHi(r);
+        if (lo >= hi) return false;
+        if (range.compare_exchange_weak(r, packRange(lo + 1, hi), std::memory_order_acq_rel)) {
+            index = lo;
+            return true;
+        }
+    }
+}
+
+bool WorkStealingPool::_steal(int thief, uint32_t& index) {
+    const int nParticipants = static_cast<int>(slots.size());
+    for (int k = 1; k < nParticipants; ++k) {
+        const int victim = (thief + k) % nParticipants;
+        std::atomic<uint64_t>& range = slots[victim]->range;
+        uint64_t r = range.load(std::memory_order_acquire);
+        while (true) {
+            const uint32_t lo = rangeLo(r);
+            const uint32_t hi = rangeHi(r);
+            if (lo >= hi) break;
+
+            if (hi - lo == 1) {
+                if (range.compare_exchange_weak(r, packRange(lo + 1, hi), std::memory_order_acq_rel)) {
+                    index = lo;
+                    return true;
+                }
+                continue;
+            }
+
+            const uint32_t mid = lo + (hi - lo) / 2;
+            if (range.compare_exchange_weak(r, packRange(lo, mid), std::memory_order_acq_rel)) {
+                // Our own range is empty (the local pop just failed) and only
+                // the owner ever grows a range, so a plain store is enough.
+                index = mid;
+                slots[thief]->range.store(packRange(mid + 1, hi), std::memory_order_release);
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void WorkStealingPool::_execute(uint32_t index) {
+    if (!hasError.load(std::memory_order_relaxed)) {
+        try {
+            jobTask(jobCtx, index);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(errorMutex);
+            if (!firstError) firstError = std::current_exception();
+            hasError.store(true, std::memory_order_relaxed);
+        }
+    }
+    remaining.fetch_sub(1, std::memory_order_acq_rel);
+}
+
+void WorkStealingPool::_pinToCore(int core) {
+#ifdef __linux__
+    const long nCores = sysconf(_SC_NPROCESSORS_ONLN);
+    if (nCores <= 0) return;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(static_cast<int>(core % nCores), &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+    (void)core;
+#endif
+}
@@ -0,0 +1,109 @@
+#ifndef WORK_STEALING_POOL_H
+#define WORK_STEALING_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// ================================
+// WorkStealingPool
+// ================================
+// Persistent worker threads for data-parallel loops such as
+// PokerEnvBatch::step_batch(). Threads are started once and parked between
+// jobs, so a step costs one wake-up instead of a thread spawn.
+//
+// parallel_for(n, fn) splits [0, n) into one contiguous range per
+// participant (the calling thread takes part as participant 0). Each
+// participant consumes its own range from the front; once it runs dry it
+// scans the other participants and steals the back half of the first
+// non-empty range it finds. A range is a
+// single packed 64-bit word {lo, hi} updated by CAS, so owner pops and thief
+// steals never need a lock.
+//
+// Nothing here touches Python: the binding layer is expected to release the
+// GIL (py::gil_scoped_release) around calls that end up in parallel_for.
+class WorkStealingPool {
+public:
+    // nThreads <= 0 picks std::thread::hardware_concurrency(). nThreads counts
+    // the calling thread, so nThreads == 1 runs everything inline.
+    // With pinThreads, worker thread k (1-based; the caller is never pinned)
+    // is bound to core (firstCore + k) modulo the number of online cores
+    // (Linux only; ignored elsewhere).
+    explicit WorkStealingPool(int nThreads = 0, bool pinThreads = false, int firstCore = 0);
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    int numThreads() const { return static_cast<int>(slots.size()); }
+
+    // Runs fn(i) for every i in [0, n). Blocks until all indices are done.
+    // If any invocation throws, the first exception is rethrown here after
+    // the remaining work has drained. Not reentrant: fn must not call back
+    // into the same pool.
+    template <typename Fn>
+    void parallel_for(size_t n, Fn&& fn) {
+        if (n == 0) return;
+        if (slots.size() == 1 || n == 1) {
+            for (size_t i = 0; i < n; ++i) fn(i);
+            return;
+        }
+        using FnT = typename std::remove_reference<Fn>::type;
+        _run(n, &WorkStealingPool::_invoke<FnT>, static_cast<void*>(&fn));
+    }
+
+private:
+    using Task = void (*)(void* ctx, size_t index);
+
+    template <typename FnT>
+    static void _invoke(void* ctx, size_t index) {
+        (*static_cast<FnT*>(ctx))(index);
+    }
+
+    // One cache line per participant so owner/thief CAS traffic on different
+    // ranges does not false-share.
+    struct alignas(64) Slot {
+        std::atomic<uint64_t> range{0}; // lo in the low 32 bits, hi in the high 32 bits
+    };
+
+    void _run(size_t n, Task task, void* ctx);
+    void _workerLoop(int participant);
+    void _participate(int participant);
+    bool _popLocal(int participant, uint32_t& index);
+    bool _steal(int thief, uint32_t& index);
+    void _execute(uint32_t index);
+    static void _pinToCore(int core);
+
+    std::unique_ptr<Slot[]> slotStorage;
+    std::vector<Slot*> slots;
+    std::vector<std::thread> workers;
+
+    bool pinThreads_;
+    int firstCore_;
+
+    // Job state, published under jobMutex and read by workers after wake-up.
+    Task jobTask = nullptr;
+    void* jobCtx = nullptr;
+    uint64_t jobGeneration = 0;
+    bool stopping = false;
+    std::mutex jobMutex;
+    std::condition_variable jobCv;
+
+    std::atomic<size_t> remaining{0};
+    std::atomic<int> activeWorkers{0};
+    std::mutex doneMutex;
+    std::condition_variable doneCv;
+
+    std::atomic<bool> hasError{false};
+    std::exception_ptr firstError;
+    std::mutex errorMutex;
+};
+
+#endif // WORK_STEALING_POOL_H
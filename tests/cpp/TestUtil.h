@@ -0,0 +1,131 @@
+#ifndef POKER_TEST_UTIL_H
+#define POKER_TEST_UTIL_H
+
+// Shared helpers for the C++ regression tests. Every tests/cpp/test_*.cpp is
+// its own executable, built against the same sources as the env, e.g.
+//   g++ -O1 -g -std=c++17 -Isrc -Itests/cpp tests/cpp/test_state_bin.cpp src/*.cpp <phevaluator> -lpthread
+// It prints one line per failed CHECK and exits non-zero if there was any.
+// tests/cpp/run_tests.sh builds and runs all of them.
+#include "PokerEnv_notorch.h"
+#include "FastRng.h"
+#include "ObservationLayout.h"
+
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <tuple>
+#include <vector>
+
+namespace PokerTest {
+
+inline int& failures() {
+    static int count = 0;
+    return count;
+}
+
+inline void fail(const char* file, int line, const std::string& what) {
+    ++failures();
+    std::cerr << file << ":" << line << ": CHECK failed: " << what << std::endl;
+}
+
+// Summary line and process exit code.
+inline int finish(const char* name) {
+    if (failures() == 0) {
+        std::cout << name << ": OK" << std::endl;
+        return 0;
+    }
+    std::cout << name << ": " << failures() << " check(s) failed" << std::endl;
+    return 1;
+}
+
+// ================================
+// Env helpers
+// ================================
+constexpr int SMALL_BLIND = 1;
+constexpr int BIG_BLIND = 2;
+constexpr int STACK = 200;
+
+inline const std::vector<float>& betMenu() {
+    static const std::vector<float> menu = {0.5f, 1.0f, 2.0f};
+    return menu;
+}
+
+// Seeded env. `stacks`, when given, are the per-seat starting stacks of every
+// full reset (starting_stack_sizes_list, which only evaluation mode honours).
+inline std::unique_ptr<PokerEnv> makeEnv(int nSeats, uint64_t seed, const std::vector<int>& stacks = {}) {
+    nlohmann::json config;
+    config["game_settings"]["seed"] = seed;
+    if (!stacks.empty()) {
+        config["game_settings"]["starting_stack_sizes_list"] = stacks;
+        config["mode_settings"]["is_evaluating"] = true;
+    }
+    return std::unique_ptr<PokerEnv>(
+        new PokerEnv(config, nSeats, betMenu(), false, SMALL_BLIND, BIG_BLIND, 0, STACK));
+}
+
+// Uniformly random legal action index.
+inline int randomLegalAction(PokerEnv& env, FastRng& rng) {
+    const std::vector<int> legal = env.getLegalActions();
+    if (legal.empty()) return 1;
+    return legal[rng.uniformInt(0, static_cast<int>(legal.size()) - 1)];
+}
+
+// Plays random legal actions until the hand ends; returns the final rewards.
+inline std::vector<float> playRandomHand(PokerEnv& env, FastRng& rng) {
+    for (;;) {
+        auto result = env.step(randomLegalAction(env, rng));
+        if (std::get<3>(result)) return std::get<2>(result);
+    }
+}
+
+// The transformer state and the zero-padded [maxSeqLen x rowDim] sequence
+// block, as a PokerEnvBatch row holds them.
+struct TransformerObs {
+    std::vector<float> state;
+    std::vector<float> sequence;
+    size_t rows = 0;
+};
+
+inline TransformerObs transformerObs(PokerEnv& env, int maxSeqLen) {
+    const int nSeats = env.getNumPlayers();
+    const int nActions = static_cast<int>(betMenu().size()) + 2;
+    TransformerObs obs;
+    obs.state.assign(ObservationLayout::stateDim(nSeats), 0.0f);
+    obs.sequence.assign(static_cast<size_t>(maxSeqLen) * ObservationLayout::rowDim(nSeats, nActions), 0.0f);
+    env.write_transformer_state(obs.state.data(), obs.state.size());
+    obs.rows = env.write_transformer_sequence(obs.sequence.data(), obs.sequence.size());
+    return obs;
+}
+
+} // namespace PokerTest
+
+#define CHECK(cond)                                                              \
+    do {                                                                         \
+        if (!(cond)) PokerTest::fail(__FILE__, __LINE__, #cond);                 \
+    } while (0)
+
+#define CHECK_EQ(a, b)                                                           \
+    do {                                                                         \
+        const auto& check_a_ = (a);                                              \
+        const auto& check_b_ = (b);                                              \
+        if (!(check_a_ == check_b_)) {                                           \
+            std::ostringstream check_os_;                                        \
+            check_os_ << #a " == " #b " (" << check_a_ << " vs " << check_b_ << ")"; \
+            PokerTest::fail(__FILE__, __LINE__, check_os_.str());                \
+        }                                                                        \
+    } while (0)
+
+#define CHECK_NEAR(a, b, tol)                                                    \
+    do {                                                                         \
+        const double check_a_ = (a);                                             \
+        const double check_b_ = (b);                                             \
+        if (!(std::fabs(check_a_ - check_b_) <= (tol))) {                        \
+            std::ostringstream check_os_;                                        \
+            check_os_ << #a " ~= " #b " (" << check_a_ << " vs " << check_b_ << ")"; \
+            PokerTest::fail(__FILE__, __LINE__, check_os_.str());                \
+        }                                                                        \
+    } while (0)
+
+#endif // POKER_TEST_UTIL_H
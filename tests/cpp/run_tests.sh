@@ -0,0 +1,29 @@
+#!/usr/bin/env bash
+# Builds and runs every C++ regression test (tests/cpp/test_*.cpp).
+#
+#   tests/cpp/run_tests.sh [test_name ...]
+#
+# Run from the repository root. PHEVAL_FLAGS supplies the phevaluator include
+# and link flags. The default expects the sibling PokerHandEvaluator checkout
+# that src/PokerEnv_notorch.cpp already includes from, built in cpp/build.
+set -euo pipefail
+
+CXX=${CXX:-g++}
+PHEVAL_FLAGS=${PHEVAL_FLAGS:-"-I../PokerHandEvaluator/cpp/include -L../PokerHandEvaluator/cpp/build -lpheval"}
+OUT=${OUT:-build/tests}
+mkdir -p "$OUT"
+
+if [ "$#" -gt 0 ]; then
+    tests=("$@")
+else
+    tests=()
+    for f in tests/cpp/test_*.cpp; do tests+=("$(basename "$f" .cpp)"); done
+fi
+
+failed=0
+for t in "${tests[@]}"; do
+    # shellcheck disable=SC2086
+    "$CXX" -O1 -g -std=c++17 -Isrc -Itests/cpp "tests/cpp/$t.cpp" src/*.cpp $PHEVAL_FLAGS -lpthread -o "$OUT/$t"
+    if ! "$OUT/$t"; then failed=1; fi
+done
+exit "$failed"
@@ -0,0 +1,82 @@
+// PokerEnvBatch against the same tables stepped one by one: seeded with
+// seed_batch(base) a batch must reproduce standalone envs seeded with
+// FastRng::streamSeed(base, i), buffer for buffer, with one worker thread or
+// several, across auto-resets.
+#include "TestUtil.h"
+#include "PokerEnvBatch.h"
+
+#include <algorithm>
+
+namespace {
+
+constexpr uint64_t BASE_SEED = 7101;
+constexpr int N_TABLES = 5;
+constexpr int N_SEATS = 3;
+constexpr int MAX_SEQ = PokerEnvBatch::DEFAULT_MAX_SEQUENCE_LENGTH;
+constexpr int STEPS = 400;
+
+void compareWithStandalone(int nThreads) {
+    PokerEnvBatch batch(N_TABLES, nlohmann::json::object(), N_SEATS, PokerTest::betMenu(), false,
+                        PokerTest::SMALL_BLIND, PokerTest::BIG_BLIND, 0, PokerTest::STACK,
+                        MAX_SEQ, true, nThreads);
+    batch.seed_batch(BASE_SEED);
+    batch.reset_batch();
+
+    std::vector<std::unique_ptr<PokerEnv>> refs;
+    for (int i = 0; i < N_TABLES; ++i) {
+        refs.push_back(PokerTest::makeEnv(N_SEATS, 0));
+        refs.back()->seed(FastRng::streamSeed(BASE_SEED, static_cast<uint64_t>(i)));
+        refs.back()->reset();
+    }
+
+    const int nActions = batch.numActions();
+    const int stateDim = batch.stateDim();
+    const size_t seqBlock = static_cast<size_t>(MAX_SEQ) * batch.actionFeatureDim();
+    FastRng rng(99);
+    std::vector<int> actions(N_TABLES);
+    std::vector<float> refRewards(static_cast<size_t>(N_TABLES) * N_SEATS, 0.0f);
+    std::vector<float> refDones(N_TABLES, 0.0f);
+
+    for (int step = 0; step <= STEPS; ++step) {
+        for (int i = 0; i < N_TABLES; ++i) {
+            PokerEnv& ref = *refs[i];
+            const PokerTest::TransformerObs obs = PokerTest::transformerObs(ref, MAX_SEQ);
+            CHECK(std::equal(obs.state.begin(), obs.state.end(), batch.stateFeatures() + i * stateDim));
+            CHECK(std::equal(obs.sequence.begin(), obs.sequence.end(), batch.sequenceFeatures() + i * seqBlock));
+            CHECK_EQ(static_cast<size_t>(batch.sequenceLengths()[i]), obs.rows);
+            CHECK_EQ(batch.currentPlayers()[i], ref.getCurrentPlayer());
+            CHECK_EQ(batch.dones()[i], refDones[i]);
+            for (int s = 0; s < N_SEATS; ++s) {
+                CHECK_EQ(batch.rewards()[i * N_SEATS + s], refRewards[i * N_SEATS + s]);
+                CHECK_EQ(batch.seatStacks()[i * N_SEATS + s], ref.seatState().stack[s]);
+            }
+
+            std::vector<int> legal;
+            for (int a = 0; a < nActions; ++a) {
+                if (batch.legalActionMasks()[i * nActions + a] != 0.0f) legal.push_back(a);
+            }
+            CHECK(legal == ref.getLegalActions());
+            actions[i] = legal.empty() ? 1 : legal[rng.uniformInt(0, static_cast<int>(legal.size()) - 1)];
+        }
+        if (PokerTest::failures() > 0) return; // one diverged step says it all
+
+        batch.step_batch(actions);
+        for (int i = 0; i < N_TABLES; ++i) {
+            auto result = refs[i]->step(actions[i]);
+            const std::vector<float>& rewards = std::get<2>(result);
+            for (int s = 0; s < N_SEATS; ++s) {
+                refRewards[i * N_SEATS + s] = s < static_cast<int>(rewards.size()) ? rewards[s] : 0.0f;
+            }
+            refDones[i] = std::get<3>(result) ? 1.0f : 0.0f;
+            if (std::get<3>(result)) refs[i]->reset();
+        }
+    }
+}
+
+} // namespace
+
+int main() {
+    compareWithStandalone(1);
+    compareWithStandalone(3);
+    return PokerTest::finish("test_env_batch");
+}
@@ -0,0 +1,92 @@
+// HandEvalBatch against phevaluator: evaluate_hands_batch must give every hand
+// the rank evaluate_7cards gives it, whatever the batch length (full blocks of
+// LANES and a ragged tail), for random hands and for hand-picked ones of every
+// category, and the single-hand and _py entry points must agree with it.
+#include "TestUtil.h"
+#include "HandEvalBatch.h"
+
+#include <phevaluator/phevaluator.h>
+
+#include <array>
+#include <utility>
+
+namespace {
+
+using Hand = std::array<CardId, HandEvalBatch::CARDS_PER_HAND>;
+
+int referenceRank(const Hand& h) {
+    return evaluate_7cards(h[0], h[1], h[2], h[3], h[4], h[5], h[6]);
+}
+
+Hand randomHand(FastRng& rng) {
+    CardId deck[N_CARD_IDS];
+    for (int i = 0; i < N_CARD_IDS; ++i) deck[i] = static_cast<CardId>(i);
+    Hand hand;
+    for (int j = 0; j < HandEvalBatch::CARDS_PER_HAND; ++j) {
+        const int k = rng.uniformInt(j, N_CARD_IDS - 1);
+        std::swap(deck[j], deck[k]);
+        hand[j] = deck[j];
+    }
+    return hand;
+}
+
+// value: 0 = Two .. 12 = Ace; suit: 0 D, 1 C, 2 H, 3 S.
+constexpr CardId c(int value, int suit) { return makeCardId(value, suit); }
+
+const std::vector<Hand>& namedHands() {
+    static const std::vector<Hand> hands = {
+        {c(12, 3), c(11, 3), c(10, 3), c(9, 3), c(8, 3), c(0, 0), c(1, 1)}, // royal flush
+        {c(3, 2), c(2, 2), c(1, 2), c(0, 2), c(12, 2), c(12, 0), c(5, 1)},  // steel wheel
+        {c(7, 0), c(7, 1), c(7, 2), c(7, 3), c(12, 0), c(11, 1), c(2, 2)},  // quads
+        {c(4, 0), c(4, 1), c(4, 2), c(9, 3), c(9, 0), c(9, 1), c(2, 2)},    // two trips -> full house
+        {c(12, 1), c(9, 1), c(6, 1), c(4, 1), c(1, 1), c(0, 1), c(11, 2)}, // six-card flush
+        {c(3, 0), c(2, 1), c(1, 2), c(0, 3), c(12, 0), c(8, 1), c(6, 2)},  // wheel straight
+        {c(8, 0), c(7, 1), c(6, 2), c(5, 3), c(4, 0), c(3, 1), c(2, 2)},   // seven in a row
+        {c(10, 0), c(10, 1), c(10, 2), c(3, 3), c(12, 0), c(6, 1), c(0, 2)}, // trips
+        {c(5, 0), c(5, 1), c(2, 2), c(2, 3), c(11, 0), c(11, 1), c(0, 2)},   // three pairs
+        {c(9, 0), c(9, 1), c(12, 2), c(6, 3), c(4, 0), c(2, 1), c(0, 2)},    // one pair
+        {c(5, 0), c(3, 1), c(2, 2), c(1, 3), c(0, 0), c(8, 1), c(10, 2)},    // high card
+    };
+    return hands;
+}
+
+void checkBatch(const std::vector<Hand>& hands) {
+    std::vector<int32_t> ranks(hands.size(), -1);
+    PokerEnv::evaluate_hands_batch(hands.empty() ? nullptr : hands[0].data(), hands.size(), ranks.data());
+
+    std::vector<int> ids;
+    for (size_t i = 0; i < hands.size(); ++i) {
+        const int expected = referenceRank(hands[i]);
+        CHECK_EQ(ranks[i], expected);
+        CHECK_EQ(HandEvalBatch::evaluate7(hands[i].data()), expected);
+        ids.insert(ids.end(), hands[i].begin(), hands[i].end());
+    }
+    CHECK(PokerEnv::evaluate_hands_batch_py(ids) == std::vector<int>(ranks.begin(), ranks.end()));
+}
+
+void invalidInputThrows() {
+    bool threw = false;
+    try {
+        PokerEnv::evaluate_hands_batch_py({0, 1, 2, 3, 4, 5, 5});
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    CHECK(threw);
+}
+
+} // namespace
+
+int main() {
+    std::cout << "kernel: " << HandEvalBatch::kernelName() << std::endl;
+    checkBatch(namedHands());
+
+    FastRng rng(12);
+    for (size_t n : {size_t{1}, size_t{7}, size_t{8}, size_t{9}, size_t{63}, size_t{20000}}) {
+        std::vector<Hand> hands;
+        for (size_t i = 0; i < n; ++i) hands.push_back(randomHand(rng));
+        checkBatch(hands);
+        if (PokerTest::failures() > 0) break;
+    }
+    invalidInputThrows();
+    return PokerTest::finish("test_hand_eval_batch");
+}
@@ -0,0 +1,158 @@
+// Range indices: getRawRangeIdx must be the RangeLut index of the cards the
+// seat actually holds, so that decoding it (rangeCard1/2, getHandRank(rangeIdx,
+// board), rank_all_hands) sees those same cards. getRangeIdx, the private
+// observation feature, is the 169-class index preflop and the suit-canonical
+// colex index of getHandByPid's cards once the board is out.
+// RangeEvaluator::rangeVsRange must match an O(n^2) pass over every pair of
+// hands.
+#include "TestUtil.h"
+#include "RangeEvaluator.h"
+#include "RangeLut.h"
+
+#include <phevaluator/phevaluator.h>
+
+#include <algorithm>
+#include <utility>
+
+namespace {
+
+constexpr int N_SEATS = 3;
+
+// 2 * N_SEATS hole cards followed by 5 board cards, all distinct.
+std::vector<int> randomDeal(FastRng& rng) {
+    std::vector<int> deck(N_CARD_IDS);
+    for (int i = 0; i < N_CARD_IDS; ++i) deck[i] = i;
+    const int n = 2 * N_SEATS + 5;
+    for (int j = 0; j < n; ++j) std::swap(deck[j], deck[rng.uniformInt(j, N_CARD_IDS - 1)]);
+    deck.resize(n);
+    return deck;
+}
+
+int referenceRank(const std::vector<int>& ids) {
+    switch (ids.size()) {
+    case 5: return evaluate_5cards(ids[0], ids[1], ids[2], ids[3], ids[4]);
+    case 6: return evaluate_6cards(ids[0], ids[1], ids[2], ids[3], ids[4], ids[5]);
+    default: return evaluate_7cards(ids[0], ids[1], ids[2], ids[3], ids[4], ids[5], ids[6]);
+    }
+}
+
+void checkSeat(PokerEnv& env, int seat, int hole1, int hole2) {
+    const int64_t idx = env.getRawRangeIdx(seat);
+    const int64_t obsIdx = env.getRangeIdx(seat);
+    const std::vector<int> board = env.getCommunityCards_py();
+    if (board.empty()) {
+        CHECK(obsIdx >= 0 && obsIdx < 169);
+        CHECK_EQ(obsIdx, int64_t{env.getHandValuebyPlayer(seat) - 1});
+    } else {
+        const std::vector<int> canon = env.getHandByPid(seat);
+        const int c1 = std::max(canon[0], canon[1]);
+        const int c2 = std::min(canon[0], canon[1]);
+        CHECK_EQ(obsIdx, int64_t{c1 * (c1 - 1) / 2 + c2});
+    }
+
+    CHECK_EQ(idx, int64_t{RangeLut::rangeIdx(hole1, hole2)});
+    if (!RangeLut::isValidRangeIdx(idx)) return;
+    CHECK_EQ(int(RangeLut::rangeCard1(static_cast<int>(idx))), std::min(hole1, hole2));
+    CHECK_EQ(int(RangeLut::rangeCard2(static_cast<int>(idx))), std::max(hole1, hole2));
+    if (board.empty()) return;
+
+    std::vector<int> cards = {hole1, hole2};
+    cards.insert(cards.end(), board.begin(), board.end());
+    CHECK_EQ(env.getHandRank(idx, env.getCommunityCards()), referenceRank(cards));
+    if (board.size() == 5) CHECK_EQ(int(PokerEnv::rank_all_hands_py(board)[idx]), referenceRank(cards));
+}
+
+// Check/call every hand down to the river, checking every seat at each
+// decision and once more after the showdown.
+void rangeIdxRoundTrip(uint64_t seed) {
+    FastRng rng(seed);
+    auto env = PokerTest::makeEnv(N_SEATS, seed);
+    for (int hand = 0; hand < 10; ++hand) {
+        const std::vector<int> deal = randomDeal(rng);
+        std::vector<std::vector<int>> hole;
+        for (int s = 0; s < N_SEATS; ++s) hole.push_back({deal[2 * s], deal[2 * s + 1]});
+        env->reset(false, hole, std::vector<int>(deal.end() - 5, deal.end()));
+
+        for (int guard = 0; guard < 100; ++guard) {
+            for (int s = 0; s < N_SEATS; ++s) checkSeat(*env, s, hole[s][0], hole[s][1]);
+            if (std::get<3>(env->step(1))) break;
+        }
+        for (int s = 0; s < N_SEATS; ++s) checkSeat(*env, s, hole[s][0], hole[s][1]);
+        CHECK_EQ(env->getCommunityCards_py().size(), size_t{5});
+    }
+}
+
+// Brute force: every (a, b) pair of live hands sharing no card, ranked with
+// phevaluator directly.
+RangeEvaluator::RangeVsRange bruteForce(const std::vector<int>& board, const std::vector<float>& rangeA,
+                                        const std::vector<float>& rangeB) {
+    uint64_t dead = 0;
+    for (int c : board) dead |= uint64_t{1} << c;
+    std::vector<int> rank(RangeLut::N_RANGE_IDX, 0);
+    for (int h = 0; h < RangeLut::N_RANGE_IDX; ++h) {
+        const int c1 = RangeLut::rangeCard1(h);
+        const int c2 = RangeLut::rangeCard2(h);
+        if (((uint64_t{1} << c1) | (uint64_t{1} << c2)) & dead) continue;
+        rank[h] = referenceRank({c1, c2, board[0], board[1], board[2], board[3], board[4]});
+    }
+
+    RangeEvaluator::RangeVsRange result;
+    result.valueA.assign(RangeLut::N_RANGE_IDX, 0.0);
+    result.valueB.assign(RangeLut::N_RANGE_IDX, 0.0);
+    double payoff = 0.0;
+    double dealWeight = 0.0;
+    for (int a = 0; a < RangeLut::N_RANGE_IDX; ++a) {
+        if (rank[a] == 0) continue;
+        const uint64_t aCards = (uint64_t{1} << RangeLut::rangeCard1(a)) | (uint64_t{1} << RangeLut::rangeCard2(a));
+        for (int b = 0; b < RangeLut::N_RANGE_IDX; ++b) {
+            if (rank[b] == 0) continue;
+            const uint64_t bCards = (uint64_t{1} << RangeLut::rangeCard1(b)) | (uint64_t{1} << RangeLut::rangeCard2(b));
+            if (aCards & bCards) continue;
+            const double sign = rank[a] < rank[b] ? 1.0 : (rank[a] > rank[b] ? -1.0 : 0.0);
+            result.valueA[a] += sign * rangeB[b];
+            result.valueB[b] -= sign * rangeA[a];
+            payoff += sign * rangeA[a] * rangeB[b];
+            dealWeight += double{rangeA[a]} * rangeB[b];
+        }
+    }
+    result.evA = dealWeight > 0.0 ? payoff / dealWeight : 0.0;
+    return result;
+}
+
+// Dense random weights, or a sparse range with most hands at zero.
+std::vector<float> randomRange(FastRng& rng, bool sparse) {
+    std::vector<float> range(RangeLut::N_RANGE_IDX, 0.0f);
+    for (float& w : range) {
+        if (!sparse || rng.uniformInt(0, 9) == 0) w = static_cast<float>(rng.uniformInt(0, 1000)) / 1000.0f;
+    }
+    return range;
+}
+
+void rangeVsRangeMatchesBruteForce(uint64_t seed) {
+    FastRng rng(seed);
+    const std::vector<int> deal = randomDeal(rng);
+    const std::vector<int> board(deal.end() - 5, deal.end());
+    const std::vector<float> rangeA = randomRange(rng, seed % 2 == 0);
+    const std::vector<float> rangeB = randomRange(rng, seed % 3 == 0);
+
+    CardId boardIds[RangeEvaluator::BOARD_CARDS];
+    for (int i = 0; i < RangeEvaluator::BOARD_CARDS; ++i) boardIds[i] = static_cast<CardId>(board[i]);
+    const RangeEvaluator::RangeVsRange fast = RangeEvaluator::rangeVsRange(boardIds, rangeA, rangeB);
+    const RangeEvaluator::RangeVsRange slow = bruteForce(board, rangeA, rangeB);
+
+    CHECK_EQ(fast.valueA.size(), slow.valueA.size());
+    CHECK_EQ(fast.valueB.size(), slow.valueB.size());
+    for (int h = 0; h < RangeLut::N_RANGE_IDX && h < static_cast<int>(fast.valueA.size()); ++h) {
+        CHECK_NEAR(fast.valueA[h], slow.valueA[h], 1e-6);
+        CHECK_NEAR(fast.valueB[h], slow.valueB[h], 1e-6);
+    }
+    CHECK_NEAR(fast.evA, slow.evA, 1e-9);
+}
+
+} // namespace
+
+int main() {
+    for (uint64_t seed = 1; seed <= 20; ++seed) rangeIdxRoundTrip(seed);
+    for (uint64_t seed = 1; seed <= 12; ++seed) rangeVsRangeMatchesBruteForce(seed);
+    return PokerTest::finish("test_range");
+}
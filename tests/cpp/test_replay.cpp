@@ -0,0 +1,69 @@
+// HandHistoryReplay over tests/test_files/pluribus_logs.json (6 seats, blinds
+// 50/100, 10000 stacks): every hand must parse, nearly all must replay with
+// the logged chip results, and every row must be a well-formed decision: a
+// recorded action index, the acting seat and sequence length in range, a
+// non-empty legal mask, rows grouped by hand in file order. Run from the
+// repository root or pass the log path as the first argument.
+#include "TestUtil.h"
+#include "HandHistoryReplay.h"
+
+#include <algorithm>
+
+namespace {
+
+constexpr int N_SEATS = 6;
+constexpr int SMALL_BLIND = 50;
+constexpr int BIG_BLIND = 100;
+constexpr int STACK = 10000;
+constexpr int BATCH_SIZE = 512;
+
+// Tolerated share of hands the env plays differently from the log (dropped)
+// and of replayed hands whose chip results differ from it.
+constexpr double MAX_REJECTED_SHARE = 0.05;
+constexpr double MAX_MISMATCH_SHARE = 0.01;
+
+void replay(const std::string& path) {
+    HandHistoryReplay replay(path, nlohmann::json::object(), N_SEATS, PokerTest::betMenu(), false,
+                             SMALL_BLIND, BIG_BLIND, 0, STACK, BATCH_SIZE);
+    const int nActions = replay.numActions();
+    const int maxSeq = replay.maxSequenceLength();
+
+    uint64_t rows = 0;
+    int lastHand = -1;
+    for (size_t n; (n = replay.next_batch()) > 0;) {
+        CHECK_EQ(n, replay.rows());
+        CHECK(n <= replay.capacity());
+        for (size_t r = 0; r < n; ++r) {
+            const int action = replay.actions()[r];
+            CHECK(action >= 0 && action < nActions);
+            const float* mask = replay.legalActionMasks() + r * nActions;
+            CHECK(std::find(mask, mask + nActions, 1.0f) != mask + nActions);
+            CHECK(replay.players()[r] >= 0 && replay.players()[r] < N_SEATS);
+            CHECK(replay.sequenceLengths()[r] >= 0 && replay.sequenceLengths()[r] <= maxSeq);
+            CHECK(replay.hands()[r] >= lastHand);
+            lastHand = replay.hands()[r];
+        }
+        rows += n;
+        if (PokerTest::failures() > 0) return;
+    }
+    CHECK(replay.finished());
+
+    const HandHistoryReplay::Stats stats = replay.stats();
+    std::cout << "hands read " << stats.handsRead << ", replayed " << stats.handsReplayed << ", rejected "
+              << stats.handsRejected << ", reward mismatches " << stats.rewardMismatches << ", rows " << stats.rows
+              << std::endl;
+    CHECK(stats.handsRead > 0);
+    CHECK_EQ(stats.parseErrors, uint64_t{0});
+    CHECK_EQ(stats.handsReplayed + stats.handsRejected, stats.handsRead);
+    CHECK(stats.rows > 0);
+    CHECK_EQ(stats.rows, rows);
+    CHECK(stats.handsRejected <= MAX_REJECTED_SHARE * stats.handsRead);
+    CHECK(stats.rewardMismatches <= MAX_MISMATCH_SHARE * stats.handsReplayed);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    replay(argc > 1 ? argv[1] : "tests/test_files/pluribus_logs.json");
+    return PokerTest::finish("test_replay");
+}
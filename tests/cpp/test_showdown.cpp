@@ -0,0 +1,94 @@
+// Showdown settlement with fixed cards: side pots built from unequal all-ins,
+// the odd chip of a split pot, and the running pot total staying equal to the
+// chips that left the stacks on every decision of random hands.
+#include "TestUtil.h"
+
+#include <numeric>
+
+namespace {
+
+constexpr int N_SEATS = 3;
+
+// Board 2c 7d 9h Js 3s: no straight or flush, pocket pairs and kickers decide.
+const std::vector<int> BOARD = {1, 20, 30, 39, 7};
+
+int totalStacks(const PokerEnv& env) {
+    const SeatState& seats = env.seatState();
+    return std::accumulate(seats.stack, seats.stack + seats.nSeats, 0);
+}
+
+// Every seat shoves (or calls the shove) until the hand is over.
+void allIn(PokerEnv& env) {
+    for (int guard = 0; guard < 50; ++guard) {
+        if (std::get<3>(env.step(BET_RAISE, 1e6f))) return;
+    }
+    CHECK(!"hand did not finish");
+}
+
+void checkStacks(const PokerEnv& env, const std::vector<int>& expected) {
+    for (int s = 0; s < N_SEATS; ++s) CHECK_EQ(env.seatState().stack[s], expected[s]);
+}
+
+// Seat 0 (50) holds AA, seat 1 (100) KK, seat 2 (200) QQ: the main pot of 150
+// goes to AA, the side pot of 100 to KK, and QQ gets back its uncalled 100.
+void sidePots() {
+    auto env = PokerTest::makeEnv(N_SEATS, 1, {50, 100, 200});
+    env->reset(false, {{48, 49}, {44, 45}, {40, 41}}, BOARD);
+    allIn(*env);
+    checkStacks(*env, {150, 100, 100});
+
+    bool mainPotToAces = false;
+    bool sidePotToKings = false;
+    for (const PlayerWinningInfo& win : env->getLastHandWinnings()) {
+        if (win.seatId == 0) {
+            CHECK_EQ(int(win.potIndex), int(HandDescription::MAIN_POT));
+            CHECK_EQ(int(win.handDescriptionId), int(HandDescription::ONE_PAIR));
+            mainPotToAces = win.amountWon == 150;
+        }
+        if (win.seatId == 1 && win.potIndex != HandDescription::MAIN_POT) sidePotToKings = win.amountWon == 100;
+    }
+    CHECK(mainPotToAces);
+    CHECK(sidePotToKings);
+}
+
+// The same stacks with AA on the deepest seat: it takes every pot.
+void deepestSeatWins() {
+    auto env = PokerTest::makeEnv(N_SEATS, 2, {50, 100, 200});
+    env->reset(false, {{40, 41}, {44, 45}, {48, 49}}, BOARD);
+    allIn(*env);
+    checkStacks(*env, {0, 0, 350});
+}
+
+// AK vs AK chop a 153 pot (51 + 51 + the 51 of seat 2's 52 that is called);
+// the odd chip goes to the lowest winning seat, seat 2 keeps its uncalled 1.
+void oddChip() {
+    auto env = PokerTest::makeEnv(N_SEATS, 3, {51, 51, 52});
+    env->reset(false, {{50, 44}, {51, 45}, {40, 33}}, BOARD);
+    allIn(*env);
+    checkStacks(*env, {77, 76, 1});
+}
+
+// Chips in the stacks plus the pot never change within a hand.
+void potConservation(uint64_t seed) {
+    FastRng rng(seed);
+    auto env = PokerTest::makeEnv(N_SEATS, seed);
+    for (int hand = 0; hand < 20; ++hand) {
+        env->reset();
+        const int total = totalStacks(*env) + env->getPotSize();
+        for (int guard = 0; guard < 500; ++guard) {
+            CHECK_EQ(totalStacks(*env) + env->getPotSize(), total);
+            if (std::get<3>(env->step(PokerTest::randomLegalAction(*env, rng)))) break;
+        }
+        CHECK_EQ(totalStacks(*env), total);
+    }
+}
+
+} // namespace
+
+int main() {
+    sidePots();
+    deepestSeatWins();
+    oddChip();
+    for (uint64_t seed = 1; seed <= 10; ++seed) potConservation(seed);
+    return PokerTest::finish("test_showdown");
+}
@@ -0,0 +1,270 @@
+// Binary snapshots (save_state_bin / load_state_bin, PokerStateBin blobs) and
+// the JSON state dict: a mid-hand state loaded into a "dirty" env - one that
+// is partway through a different hand - must come back byte for byte, give
+// the same observations, masks and action history, and play the rest of the
+// hand exactly like the original.
+#include "TestUtil.h"
+#include "PokerEnvBatch.h"
+#include "PokerStateBin.h"
+#include "HandDescription.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+
+namespace {
+
+constexpr int MAX_SEQ = 25;
+
+// Plays `nActions` random legal actions of a fresh hand (restarting any hand
+// that ends first).
+void advance(PokerEnv& env, FastRng& rng, int nActions) {
+    env.reset();
+    for (int i = 0; i < nActions; ++i) {
+        if (std::get<3>(env.step(PokerTest::randomLegalAction(env, rng)))) env.reset();
+    }
+}
+
+std::vector<float> fullObservation(PokerEnv& env) {
+    std::vector<float> obs(env.observationSize());
+    env.write_observation(obs.data(), obs.size());
+    return obs;
+}
+
+void checkSameDecision(PokerEnv& a, PokerEnv& b) {
+    const PokerTest::TransformerObs oa = PokerTest::transformerObs(a, MAX_SEQ);
+    const PokerTest::TransformerObs ob = PokerTest::transformerObs(b, MAX_SEQ);
+    CHECK(oa.state == ob.state);
+    CHECK(oa.sequence == ob.sequence);
+    CHECK_EQ(oa.rows, ob.rows);
+    CHECK(fullObservation(a) == fullObservation(b));
+    CHECK(a.getLegalActions() == b.getLegalActions());
+    CHECK_EQ(a.getCurrentPlayer(), b.getCurrentPlayer());
+    CHECK_EQ(a.getActionHistory().size(), b.getActionHistory().size());
+}
+
+// The loaded env's observation history restarts at the loaded decision: one
+// row, equal to the original's newest row.
+void checkRestartedHistory(const PokerEnv& original, const PokerEnv& loaded) {
+    const ObservationRing::View o = original.getPublicObservationView();
+    const ObservationRing::View l = loaded.getPublicObservationView();
+    CHECK_EQ(l.rows, size_t{1});
+    if (o.rows == 0 || l.rows != 1) return;
+    CHECK_EQ(l.lengths[0], o.lengths[o.rows - 1]);
+    CHECK(std::equal(l.row(0), l.row(0) + l.lengths[0], o.row(o.rows - 1)));
+}
+
+// Finishes the hand on both envs with the same actions; rewards must match.
+void checkSameContinuation(PokerEnv& a, PokerEnv& b, FastRng& rng) {
+    for (int guard = 0; guard < 500; ++guard) {
+        checkSameDecision(a, b);
+        const int action = PokerTest::randomLegalAction(a, rng);
+        auto ra = a.step(action);
+        auto rb = b.step(action);
+        CHECK(std::get<2>(ra) == std::get<2>(rb));
+        CHECK_EQ(std::get<3>(ra), std::get<3>(rb));
+        if (std::get<3>(ra) || std::get<3>(rb)) return;
+    }
+    CHECK(!"hand did not finish");
+}
+
+void binRoundTrip(int nSeats, uint64_t seed) {
+    FastRng rng(seed);
+    auto original = PokerTest::makeEnv(nSeats, seed);
+    advance(*original, rng, 1 + static_cast<int>(seed % 7));
+    const std::vector<uint8_t> snapshot = original->save_state_bin();
+    CHECK_EQ(snapshot.size(), original->stateBinSize());
+
+    auto dirty = PokerTest::makeEnv(nSeats, seed + 1000);
+    FastRng other(seed + 1000);
+    advance(*dirty, other, 9);
+    dirty->load_state_bin(snapshot.data(), snapshot.size());
+
+    CHECK(dirty->save_state_bin() == snapshot);
+    checkRestartedHistory(*original, *dirty);
+    checkSameContinuation(*original, *dirty, rng);
+}
+
+void jsonRoundTrip(int nSeats, uint64_t seed) {
+    FastRng rng(seed);
+    auto original = PokerTest::makeEnv(nSeats, seed);
+    advance(*original, rng, 2 + static_cast<int>(seed % 5));
+
+    auto dirty = PokerTest::makeEnv(nSeats, seed + 2000);
+    FastRng other(seed + 2000);
+    advance(*dirty, other, 7);
+    dirty->load_state_dict(original->state_dict());
+
+    CHECK(dirty->save_state_bin() == original->save_state_bin());
+    checkRestartedHistory(*original, *dirty);
+    checkSameContinuation(*original, *dirty, rng);
+}
+
+// Overwrites the T at byte `offset` of a snapshot.
+template <class T>
+void patch(std::vector<uint8_t>& bytes, size_t offset, T value) {
+    std::memcpy(bytes.data() + offset, &value, sizeof(value));
+}
+
+// Loads `snapshot` into `env`, which must reject it and keep its own state.
+void checkRejected(PokerEnv& env, const std::vector<uint8_t>& snapshot) {
+    const std::vector<uint8_t> before = env.save_state_bin();
+    bool threw = false;
+    try {
+        env.load_state_bin(snapshot.data(), snapshot.size());
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    CHECK(threw);
+    CHECK(env.save_state_bin() == before);
+}
+
+// Out-of-range or misplaced seats, a card in two places, and a bad record
+// anywhere in the snapshot are rejected before anything is loaded.
+void corruptSnapshots() {
+    using namespace PokerStateBin;
+    constexpr int N_SEATS = 3;
+    auto source = PokerTest::makeEnv(N_SEATS, 11);
+    source->reset();
+    source->step(1); // a preflop call: one action record, hand still running
+    const std::vector<uint8_t> good = source->save_state_bin();
+
+    auto target = PokerTest::makeEnv(N_SEATS, 12);
+    FastRng other(12);
+    advance(*target, other, 3);
+
+    std::vector<uint8_t> bad = good;
+    patch<int32_t>(bad, offsetof(StateBinHeader, currentPlayer), N_SEATS);
+    checkRejected(*target, bad);
+
+    bad = good;
+    patch<int32_t>(bad, offsetof(StateBinHeader, buttonPos), -1);
+    checkRejected(*target, bad);
+
+    StateBinHeader h;
+    std::memcpy(&h, good.data(), sizeof(h));
+    const size_t seat0 = playersOffset(N_SEATS, h.nActions);
+    const size_t seat1 = seat0 + sizeof(StateBinPlayer);
+
+    // Seat 1 holding seat 0's first hole card.
+    bad = good;
+    bad[seat1 + offsetof(StateBinPlayer, hand)] = good[seat0 + offsetof(StateBinPlayer, hand)];
+    checkRejected(*target, bad);
+
+    // Seat 1's record claiming to be seat 0.
+    bad = good;
+    patch<int32_t>(bad, seat1 + offsetof(StateBinPlayer, seatId), 0);
+    checkRejected(*target, bad);
+
+    // The last action record is decoded after every other part.
+    CHECK_EQ(int(h.nActionRecords), 1);
+    bad = good;
+    patch<int8_t>(bad, actionsOffset(N_SEATS, h.nActions) +
+                           (h.nActionRecords - 1) * sizeof(StateBinAction) + offsetof(StateBinAction, playerId),
+                  int8_t{N_SEATS});
+    checkRejected(*target, bad);
+
+    // A blob whose last record is bad leaves every table as it was.
+    PokerEnvBatch batch(2, nlohmann::json::object(), N_SEATS, PokerTest::betMenu(), false,
+                        PokerTest::SMALL_BLIND, PokerTest::BIG_BLIND, 0, PokerTest::STACK, MAX_SEQ);
+    batch.seed_batch(5);
+    batch.reset_batch();
+    batch.step_batch(std::vector<int>(2, 1));
+    const std::vector<uint8_t> before = batch.save_states_bin();
+    CHECK_EQ(good.size(), batch.env(0).stateBinSize());
+    if (good.size() != batch.env(0).stateBinSize()) return;
+    std::vector<uint8_t> blob = before;
+    std::copy(good.begin(), good.end(), blob.begin() + sizeof(BlobHeader));
+    std::copy(bad.begin(), bad.end(), blob.begin() + sizeof(BlobHeader) + good.size());
+    bool threw = false;
+    try {
+        batch.load_states_bin(blob.data(), blob.size());
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    CHECK(threw);
+    CHECK(batch.save_states_bin() == before);
+}
+
+// A state dict from an older build spells the uncontested win "Won by
+// default"; it must load as WON_BY_DEFAULT and survive a binary round trip.
+void legacyWonByDefault() {
+    CHECK_EQ(int(HandDescription::idOf("Won by default")), int(HandDescription::WON_BY_DEFAULT));
+
+    auto env = PokerTest::makeEnv(3, 7);
+    nlohmann::json state = env->state_dict();
+    nlohmann::json winning;
+    winning["seatId"] = 1;
+    winning["amountWon"] = 3;
+    winning["potDescription"] = "Main Pot";
+    winning["handDescription"] = "Won by default";
+    winning["holeCards"] = nlohmann::json::array();
+    state["lastHandWinnings"] = nlohmann::json::array({winning});
+    env->load_state_dict(state);
+
+    auto loaded = PokerTest::makeEnv(3, 8);
+    const std::vector<uint8_t> snapshot = env->save_state_bin();
+    loaded->load_state_bin(snapshot.data(), snapshot.size());
+    const std::vector<PlayerWinningInfo>& winnings = loaded->getLastHandWinnings();
+    CHECK_EQ(winnings.size(), size_t{1});
+    if (winnings.empty()) return;
+    CHECK_EQ(int(winnings[0].handDescriptionId), int(HandDescription::WON_BY_DEFAULT));
+    CHECK(winnings[0].handDescription() == HandDescription::NAMES[HandDescription::WON_BY_DEFAULT]);
+    CHECK_EQ(loaded->state_dict()["lastHandWinnings"][0]["handDescription"].get<std::string>(),
+             std::string(HandDescription::NAMES[HandDescription::WON_BY_DEFAULT]));
+}
+
+// PokerEnvBatch::load_states_bin republishes every row from the loaded state.
+void batchBlob() {
+    constexpr int N_TABLES = 4;
+    constexpr int N_SEATS = 3;
+    PokerEnvBatch saved(N_TABLES, nlohmann::json::object(), N_SEATS, PokerTest::betMenu(), false,
+                        PokerTest::SMALL_BLIND, PokerTest::BIG_BLIND, 0, PokerTest::STACK, MAX_SEQ);
+    PokerEnvBatch loaded(N_TABLES, nlohmann::json::object(), N_SEATS, PokerTest::betMenu(), false,
+                         PokerTest::SMALL_BLIND, PokerTest::BIG_BLIND, 0, PokerTest::STACK, MAX_SEQ);
+    saved.seed_batch(1);
+    saved.reset_batch();
+    loaded.seed_batch(2);
+    loaded.reset_batch();
+    for (int step = 0; step < 5; ++step) {
+        saved.step_batch(std::vector<int>(N_TABLES, 1));
+        loaded.step_batch(std::vector<int>(N_TABLES, 2));
+    }
+
+    const std::vector<uint8_t> blob = saved.save_states_bin();
+    CHECK_EQ(blob.size(), saved.stateBlobSize());
+    loaded.load_states_bin(blob.data(), blob.size());
+    CHECK(loaded.save_states_bin() == blob);
+
+    const size_t stateFloats = static_cast<size_t>(N_TABLES) * saved.stateDim();
+    const size_t seqFloats = static_cast<size_t>(N_TABLES) * MAX_SEQ * saved.actionFeatureDim();
+    const size_t maskFloats = static_cast<size_t>(N_TABLES) * saved.numActions();
+    CHECK(std::equal(saved.stateFeatures(), saved.stateFeatures() + stateFloats, loaded.stateFeatures()));
+    CHECK(std::equal(saved.sequenceFeatures(), saved.sequenceFeatures() + seqFloats, loaded.sequenceFeatures()));
+    CHECK(std::equal(saved.sequenceLengths(), saved.sequenceLengths() + N_TABLES, loaded.sequenceLengths()));
+    CHECK(std::equal(saved.legalActionMasks(), saved.legalActionMasks() + maskFloats, loaded.legalActionMasks()));
+    CHECK(std::equal(saved.currentPlayers(), saved.currentPlayers() + N_TABLES, loaded.currentPlayers()));
+
+    // A record for another table configuration is rejected.
+    auto sixSeats = PokerTest::makeEnv(6, 3);
+    bool threw = false;
+    try {
+        sixSeats->load_state_bin(PokerStateBin::blobRecord(blob.data(), blob.size(), 0), saved.env(0).stateBinSize());
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    CHECK(threw);
+}
+
+} // namespace
+
+int main() {
+    for (uint64_t seed = 1; seed <= 40; ++seed) {
+        binRoundTrip(seed % 2 ? 2 : 6, seed);
+        jsonRoundTrip(seed % 2 ? 6 : 3, seed);
+    }
+    batchBlob();
+    legacyWonByDefault();
+    corruptSnapshots();
+    return PokerTest::finish("test_state_bin");
+}
@@ -0,0 +1,99 @@
+// Specialized observation kernels against the generic ones: for every
+// compiled-in TableKernels<2, N> and <6, N>, random seat states and action
+// records must produce bit-identical output to TableKernels<0, 0>, including
+// "no current player" and zero-pot records. selectTableKernels must pick the
+// specialization exactly for the configurations it lists.
+#include "TestUtil.h"
+#include "TableKernels.h"
+
+#include <cstring>
+#include <utility>
+
+namespace {
+
+struct Record {
+    int playerId;
+    int actionInt;
+    int betAmount;
+    int potAtActionTime;
+};
+
+constexpr int DEFAULT_STACK = 200;
+constexpr int BIG_BLIND = 2;
+
+using Generic = TableKernels<0, 0>;
+
+bool sameBits(const std::vector<float>& a, const std::vector<float>& b) {
+    return a.size() == b.size() && std::memcmp(a.data(), b.data(), a.size() * sizeof(float)) == 0;
+}
+
+bool sameBits(float a, float b) { return std::memcmp(&a, &b, sizeof(float)) == 0; }
+
+SeatState randomSeats(FastRng& rng, int nSeats) {
+    SeatState s;
+    s.nSeats = nSeats;
+    for (int i = 0; i < nSeats; ++i) {
+        s.stack[i] = rng.uniformInt(0, 3 * DEFAULT_STACK);
+        s.currentBet[i] = rng.uniformInt(0, 50);
+        s.chips[i] = s.stack[i] + s.currentBet[i];
+        s.invested[i] = s.currentBet[i] + rng.uniformInt(0, 100);
+        s.folded[i] = rng.uniformInt(0, 3) == 0;
+        s.allin[i] = !s.folded[i] && rng.uniformInt(0, 4) == 0;
+    }
+    return s;
+}
+
+void compareSet(const TableKernelSet<Record>& set, int nSeats, int nActions, FastRng& rng) {
+    const size_t rowDim = static_cast<size_t>(nSeats) + nActions + 1;
+    for (int trial = 0; trial < 200; ++trial) {
+        const SeatState s = randomSeats(rng, nSeats);
+        const int button = rng.uniformInt(0, nSeats - 1);
+        const int current = rng.uniformInt(-1, nSeats - 1); // -1: no current player
+        const int pot = rng.uniformInt(1, 2000);
+
+        std::vector<float> fast(2 * nSeats, -7.0f), slow(2 * nSeats, -7.0f);
+        set.currentPlayerAndStacks(s, current, button, DEFAULT_STACK, fast.data());
+        Generic::currentPlayerAndStacks(s, current, button, DEFAULT_STACK, slow.data());
+        CHECK(sameBits(fast, slow));
+        for (int i = 0; i < nSeats; ++i) {
+            CHECK(sameBits(slow[nSeats + i], static_cast<float>(s.chips[i]) / static_cast<float>(DEFAULT_STACK)));
+        }
+
+        CHECK(sameBits(set.effectiveStackToPot(s, current, pot), Generic::effectiveStackToPot(s, current, pot)));
+        CHECK(sameBits(set.playersToActRatio(s, current), Generic::playersToActRatio(s, current)));
+
+        std::vector<Record> records(rng.uniformInt(0, 12));
+        for (Record& r : records) {
+            r.playerId = rng.uniformInt(0, nSeats - 1);
+            r.actionInt = rng.uniformInt(0, nActions - 1);
+            r.betAmount = rng.uniformInt(0, 3) == 0 ? 0 : rng.uniformInt(1, 400);
+            r.potAtActionTime = rng.uniformInt(0, 4) == 0 ? 0 : rng.uniformInt(1, 800);
+        }
+        std::vector<float> fastRows(records.size() * rowDim, -7.0f), slowRows(records.size() * rowDim, -7.0f);
+        set.actionRows(records.data(), records.size(), nSeats, nActions, button, BIG_BLIND, fastRows.data());
+        Generic::actionRows(records.data(), records.size(), nSeats, nActions, button, BIG_BLIND, slowRows.data());
+        CHECK(sameBits(fastRows, slowRows));
+    }
+}
+
+} // namespace
+
+int main() {
+    FastRng rng(24);
+    for (int nSeats : {2, 6}) {
+        for (int nActions = 3; nActions <= 8; ++nActions) {
+            const TableKernelSet<Record>& set = selectTableKernels<Record>(nSeats, nActions);
+            CHECK(set.specialized());
+            CHECK_EQ(set.seats, nSeats);
+            CHECK_EQ(set.actions, nActions);
+            compareSet(set, nSeats, nActions, rng);
+        }
+    }
+    // Everything else runs the generic kernels.
+    for (auto config : {std::make_pair(3, 5), std::make_pair(2, 9), std::make_pair(6, 2), std::make_pair(9, 5)}) {
+        const TableKernelSet<Record>& set = selectTableKernels<Record>(config.first, config.second);
+        CHECK(!set.specialized());
+        compareSet(set, config.first, config.second, rng);
+    }
+    return PokerTest::finish("test_table_kernels");
+}
@@ -0,0 +1,50 @@
+// Offline generator for the flop/turn equity table (src/EquityTable.h).
+//
+//   gen_equity_table <out.bin> [--turn] [--threads N]
+//
+// Built against the same sources as the env, e.g.
+//   g++ -O2 -std=c++17 -Isrc tools/gen_equity_table.cpp src/*.cpp <phevaluator> -lpthread
+// The flop street has 1,286,792 classes (about 15 MB); --turn adds
+// 55,190,538 more (about 660 MB). Point game_settings.equity_table_path at
+// the result.
+#include "PokerEnv_notorch.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <thread>
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cerr << "usage: " << argv[0] << " <out.bin> [--turn] [--threads N]" << std::endl;
+        return 2;
+    }
+    const std::string path = argv[1];
+    bool includeTurn = false;
+    int nThreads = static_cast<int>(std::thread::hardware_concurrency());
+    for (int i = 2; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--turn") == 0) {
+            includeTurn = true;
+        } else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            nThreads = std::atoi(argv[++i]);
+        } else {
+            std::cerr << "unknown argument: " << argv[i] << std::endl;
+            return 2;
+        }
+    }
+    if (nThreads < 1) nThreads = 1;
+
+    try {
+        const auto start = std::chrono::steady_clock::now();
+        const size_t classes = PokerEnv::generate_equity_table_py(path, includeTurn, nThreads);
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "wrote " << classes << " classes to " << path << " in " << seconds << " s" << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "gen_equity_table: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}